@@ -0,0 +1,10 @@
+-- Add fragmented MP4 recording mode
+
+-- migrate:up
+
+-- Fragmented recordings are written once, sequentially, and are playable while recording
+ALTER TABLE streams ADD COLUMN fragmented_mp4 INTEGER DEFAULT 0;
+
+-- migrate:down
+
+SELECT 1;
@@ -42,6 +42,7 @@ typedef struct {
     bool streaming_enabled; // Whether HLS streaming is enabled for this stream
     stream_protocol_t protocol; // Stream protocol (TCP, UDP, or ONVIF)
     bool record_audio; // Whether to record audio with video
+    bool fragmented_mp4; // Record fragmented MP4 (no faststart rewrite, playable while recording)
 
     // ONVIF specific fields
     char onvif_username[64];
@@ -72,6 +73,7 @@ typedef struct {
     char pid_file[MAX_PATH_LENGTH];
     char log_file[MAX_PATH_LENGTH];
     int log_level; // 0=ERROR, 1=WARN, 2=INFO, 3=DEBUG
+    bool log_async;                // Write log output on a background thread
 
     // Syslog settings
     bool syslog_enabled;           // Whether to log to syslog
@@ -114,6 +116,9 @@ typedef struct {
     char web_password[32]; // Stored as hash in actual implementation
     bool webrtc_disabled;  // Whether WebRTC is disabled (use HLS only)
     int auth_timeout_hours; // Session timeout in hours (default: 24)
+    int web_thread_pool_size;    // Worker threads for offloaded HTTP requests (default: 8)
+    int web_max_queued_requests; // Requests waiting for a worker before 503 responses (default: 64)
+    int remux_workers;           // Threads for clip/export/playback remux jobs (default: 2)
     
     // Web optimization settings
     bool web_compression_enabled;    // Whether to enable gzip compression for text-based responses
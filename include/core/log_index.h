@@ -0,0 +1,99 @@
+/**
+ * @file log_index.h
+ * @brief Sparse timestamp index of JSON log files
+ *
+ * Every JSON log file has a sidecar "<file>.idx" of fixed-size records mapping
+ * the timestamp of a line to its byte offset, written about every
+ * LOG_INDEX_INTERVAL_BYTES. Finding the lines around a timestamp is a binary
+ * search over the records plus reading one interval of the file.
+ */
+
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// Bytes of log between two index records
+#define LOG_INDEX_INTERVAL_BYTES (16 * 1024)
+
+// Size of the timestamp field of a record ("YYYY-MM-DDTHH:MM:SS" plus padding)
+#define LOG_INDEX_TIMESTAMP_SIZE 24
+
+/**
+ * @brief Index record, stored as is in the sidecar file
+ */
+typedef struct {
+    char timestamp[LOG_INDEX_TIMESTAMP_SIZE];   // Timestamp of the line, NUL padded
+    uint64_t offset;                            // Byte offset of the line in the log file
+} log_index_record_t;
+
+/**
+ * @brief Index of one log file, ordered by offset (and so by timestamp)
+ */
+typedef struct {
+    log_index_record_t *records;
+    int count;
+    int capacity;
+} log_index_t;
+
+/**
+ * @brief Get the sidecar path of a log file
+ *
+ * @param log_path Path of the log file
+ * @param path Buffer for the sidecar path
+ * @param size Size of the buffer
+ */
+void log_index_path(const char *log_path, char *path, size_t size);
+
+/**
+ * @brief Extract the timestamp of a JSON log line
+ *
+ * @param line NUL-terminated line
+ * @param timestamp Buffer of LOG_INDEX_TIMESTAMP_SIZE bytes
+ * @return int 0 on success, -1 if the line has no timestamp
+ */
+int log_index_line_timestamp(const char *line, char *timestamp);
+
+/**
+ * @brief Append a record to an index
+ *
+ * @param index Index
+ * @param timestamp Timestamp of the line
+ * @param offset Byte offset of the line
+ * @return int 0 on success, -1 on allocation failure
+ */
+int log_index_add(log_index_t *index, const char *timestamp, uint64_t offset);
+
+/**
+ * @brief Load the index of a log file
+ *
+ * Reads the sidecar and checks it against the log file. A missing or invalid
+ * sidecar is rebuilt by scanning the log file.
+ *
+ * @param log_path Path of the log file
+ * @param index Index to fill, free with log_index_free()
+ * @param persist Write a rebuilt index back to the sidecar; must be false for
+ *                a file whose sidecar is open for appending
+ * @return int 0 on success, -1 if the log file cannot be read
+ */
+int log_index_load(const char *log_path, log_index_t *index, bool persist);
+
+/**
+ * @brief Find the first record whose timestamp is not before a timestamp
+ *
+ * @param index Index
+ * @param timestamp Timestamp to look for
+ * @return int Record position, index->count if all records are earlier
+ */
+int log_index_find(const log_index_t *index, const char *timestamp);
+
+/**
+ * @brief Free the records of an index
+ *
+ * @param index Index
+ */
+void log_index_free(log_index_t *index);
+
+#endif /* LOG_INDEX_H */
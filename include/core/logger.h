@@ -3,6 +3,7 @@
 
 #include <stdarg.h>
 #include <stddef.h>
+#include <stdint.h>
 
 // Log levels
 // Change your logger.h enum to avoid conflicting with syslog.h
@@ -13,6 +14,24 @@ typedef enum {
     LOG_LEVEL_DEBUG = 3
 } log_level_t;
 
+// Async logging: each thread queues messages in its own ring of
+// LOG_ASYNC_RING_ENTRIES, a writer thread drains all rings every
+// LOG_ASYNC_FLUSH_MS (or at once for errors) and writes them in batches
+#define LOG_ASYNC_MAX_THREADS 128
+#define LOG_ASYNC_RING_ENTRIES 128
+#define LOG_ASYNC_MESSAGE_SIZE 1024
+#define LOG_ASYNC_FLUSH_MS 50
+
+/**
+ * Async logging statistics
+ */
+typedef struct {
+    int enabled;                // Whether the writer thread is running
+    int threads;                // Threads with a message ring
+    uint64_t written;           // Messages written by the writer thread
+    uint64_t dropped;           // Messages dropped because a thread's ring was full
+} log_async_stats_t;
+
 /**
  * Initialize the logging system
  * 
@@ -138,4 +157,44 @@ void disable_syslog(void);
  */
 int is_syslog_enabled(void);
 
+/**
+ * Enable async logging
+ *
+ * Messages are queued in a lock-free ring per thread and written by a
+ * background thread. When a ring is full its oldest message is dropped.
+ * Also installs handlers for fatal signals that write out queued messages
+ * before the process dies.
+ *
+ * @return 0 on success, non-zero on failure
+ */
+int enable_async_logging(void);
+
+/**
+ * Disable async logging, writing all queued messages first
+ */
+void disable_async_logging(void);
+
+/**
+ * Write all queued log messages now
+ *
+ * Safe to call whether or not async logging is enabled.
+ */
+void log_flush(void);
+
+/**
+ * Write all queued log messages using only write(2)
+ *
+ * For signal handlers that are about to end the process. It takes no locks,
+ * so it cannot deadlock on a thread that was interrupted while logging.
+ * Timestamps are written in UTC.
+ */
+void log_emergency_flush(void);
+
+/**
+ * Get async logging statistics
+ *
+ * @param stats Structure to fill
+ */
+void get_async_log_stats(log_async_stats_t *stats);
+
 #endif // LIGHTNVR_LOGGER_H
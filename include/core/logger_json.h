@@ -9,6 +9,21 @@
 #include <time.h>
 #include "core/logger.h"
 
+// Recent entries kept in memory for the logs API
+#define JSON_LOG_RING_ENTRIES 2000
+
+// Rotated files searched when paging back (<file>.1 to <file>.N)
+#define JSON_LOG_MAX_ROTATED_FILES 32
+
+/**
+ * @brief Structured log entry returned by the JSON log queries
+ */
+typedef struct {
+    char timestamp[32];     // ISO 8601 local time
+    log_level_t level;
+    char *message;
+} json_log_entry_t;
+
 /**
  * @brief Initialize the JSON logger
  * 
@@ -43,6 +58,54 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
  */
 int get_json_logs(const char *min_level, const char *last_timestamp, char ***logs, int *count);
 
+/**
+ * @brief Get the newest log entries after a timestamp
+ *
+ * Served from the in-memory ring of the last JSON_LOG_RING_ENTRIES entries,
+ * older entries are read with json_log_query_before().
+ *
+ * @param since_timestamp Only return entries after this timestamp, NULL for all
+ * @param max_level Least severe level to include (LOG_LEVEL_DEBUG for all)
+ * @param limit Maximum number of entries
+ * @param entries Set to the entries, newest first; free with json_log_free_entries()
+ * @param count Set to the number of entries
+ * @return int 0 on success, non-zero if the JSON logger is not running
+ */
+int json_log_query_since(const char *since_timestamp, log_level_t max_level, int limit,
+                         json_log_entry_t **entries, int *count);
+
+/**
+ * @brief Get the log entries before a timestamp
+ *
+ * Pages back through the current and rotated JSON log files using their
+ * timestamp indexes. A page can exceed the limit so that entries sharing the
+ * oldest timestamp are never split between two pages.
+ *
+ * @param before_timestamp Only return entries before this timestamp, NULL for the newest
+ * @param max_level Least severe level to include (LOG_LEVEL_DEBUG for all)
+ * @param limit Maximum number of entries
+ * @param entries Set to the entries, newest first; free with json_log_free_entries()
+ * @param count Set to the number of entries
+ * @return int 0 on success, non-zero if the JSON logger is not running or on error
+ */
+int json_log_query_before(const char *before_timestamp, log_level_t max_level, int limit,
+                          json_log_entry_t **entries, int *count);
+
+/**
+ * @brief Free entries returned by the JSON log queries
+ *
+ * @param entries Entries
+ * @param count Number of entries
+ */
+void json_log_free_entries(json_log_entry_t *entries, int count);
+
+/**
+ * @brief Clear the current JSON log file and the in-memory entries
+ *
+ * @return int 0 on success, non-zero on error
+ */
+int json_log_clear(void);
+
 /**
  * @brief Rotate JSON log file if it exceeds a certain size
  * 
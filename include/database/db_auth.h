@@ -103,6 +103,9 @@ int db_auth_delete_user(int64_t user_id);
 /**
  * @brief Get a user by ID
  * 
+ * The API key is not returned (api_key is left empty); look the user up by
+ * username to read it.
+ *
  * @param user_id User ID
  * @param user Pointer to store the user information
  * @return 0 on success, non-zero on failure
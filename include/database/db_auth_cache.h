@@ -0,0 +1,134 @@
+/**
+ * @file db_auth_cache.h
+ * @brief In-memory cache of verified credentials, sessions and users
+ *
+ * Verifying a password costs a PBKDF2 derivation and every session or API key
+ * check a database query, which adds up when a viewer authenticates every HLS
+ * segment request. Successful checks are cached for AUTH_CACHE_TTL_SECONDS.
+ * Entries are keyed by an HMAC-SHA256 of the credentials under a random
+ * per-process key, so no password, token or API key is kept in memory.
+ * Changes to users and sessions invalidate the affected entries explicitly.
+ *
+ * Callers read auth_cache_generation() before checking the database and pass
+ * it to the put function, which drops the entry if anything was invalidated
+ * meanwhile, so a check racing with a password change is never cached.
+ */
+
+#ifndef LIGHTNVR_DB_AUTH_CACHE_H
+#define LIGHTNVR_DB_AUTH_CACHE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "database/db_auth.h"
+
+// Number of cached entries
+#define AUTH_CACHE_SIZE 512
+
+// Lifetime of a cached entry
+#define AUTH_CACHE_TTL_SECONDS 60
+
+/**
+ * @brief Get the invalidation generation of the cache
+ *
+ * @return Current generation
+ */
+uint64_t auth_cache_generation(void);
+
+/**
+ * @brief Look up verified username and password credentials
+ *
+ * @param username Username
+ * @param password Password
+ * @param user_id Set to the user ID on a hit
+ * @return true on a hit
+ */
+bool auth_cache_get_credentials(const char *username, const char *password, int64_t *user_id);
+
+/**
+ * @brief Cache verified username and password credentials
+ *
+ * @param username Username
+ * @param password Password
+ * @param user_id User ID
+ * @param generation Generation read before the credentials were verified
+ */
+void auth_cache_put_credentials(const char *username, const char *password, int64_t user_id,
+                                uint64_t generation);
+
+/**
+ * @brief Look up a validated session token
+ *
+ * @param token Session token
+ * @param user_id Set to the user ID on a hit
+ * @return true on a hit
+ */
+bool auth_cache_get_session(const char *token, int64_t *user_id);
+
+/**
+ * @brief Cache a validated session token
+ *
+ * @param token Session token
+ * @param user_id User ID
+ * @param expires_at Expiry of the session; the entry never outlives it
+ * @param generation Generation read before the session was validated
+ */
+void auth_cache_put_session(const char *token, int64_t user_id, time_t expires_at,
+                            uint64_t generation);
+
+/**
+ * @brief Look up a user by API key
+ *
+ * @param api_key API key
+ * @param user Filled with the user on a hit
+ * @return true on a hit
+ */
+bool auth_cache_get_api_key(const char *api_key, user_t *user);
+
+/**
+ * @brief Cache the user of an API key
+ *
+ * @param api_key API key
+ * @param user User
+ * @param generation Generation read before the user was loaded
+ */
+void auth_cache_put_api_key(const char *api_key, const user_t *user, uint64_t generation);
+
+/**
+ * @brief Look up a user by ID
+ *
+ * @param user_id User ID
+ * @param user Filled with the user on a hit, with an empty api_key
+ * @return true on a hit
+ */
+bool auth_cache_get_user(int64_t user_id, user_t *user);
+
+/**
+ * @brief Cache a user
+ *
+ * @param user User
+ * @param generation Generation read before the user was loaded
+ */
+void auth_cache_put_user(const user_t *user, uint64_t generation);
+
+/**
+ * @brief Drop a session token from the cache
+ *
+ * @param token Session token
+ */
+void auth_cache_invalidate_session(const char *token);
+
+/**
+ * @brief Drop every entry of a user (credentials, sessions, API key and user)
+ *
+ * @param user_id User ID
+ */
+void auth_cache_invalidate_user(int64_t user_id);
+
+/**
+ * @brief Drop all entries
+ */
+void auth_cache_clear(void);
+
+#endif /* LIGHTNVR_DB_AUTH_CACHE_H */
@@ -4,6 +4,12 @@
 #include <sqlite3.h>
 #include <pthread.h>
 
+// Prepared statements cached per connection
+#define DB_STMT_CACHE_SIZE 32
+
+// Number of read-only connections opened in WAL mode
+#define DB_READER_POOL_SIZE 3
+
 // Include other database module headers
 #include "database/db_transaction.h"
 #include "database/db_maintenance.h"
@@ -36,6 +42,48 @@ sqlite3 *get_db_handle(void);
  */
 pthread_mutex_t *get_db_mutex(void);
 
+/**
+ * Get a prepared statement for a connection, reusing a cached one for the same
+ * SQL text when possible. The caller must hold the connection (the database
+ * mutex for the main connection, a lease for a reader) until the statement is
+ * released with db_release_statement(), and must not finalize it. A statement
+ * is handed out to one caller at a time: while it is held, the same SQL gets a
+ * new uncached statement, and held statements are never evicted.
+ *
+ * @param conn Connection the statement is prepared on
+ * @param sql SQL text
+ * @param stmt Receives the statement
+ * @return SQLITE_OK on success, an SQLite error code otherwise
+ */
+int db_prepare_cached(sqlite3 *conn, const char *sql, sqlite3_stmt **stmt);
+
+/**
+ * Release a statement obtained from db_prepare_cached(). Cached statements are
+ * reset and their bindings cleared, other statements are finalized.
+ *
+ * @param stmt Statement to release (may be NULL)
+ */
+void db_release_statement(sqlite3_stmt *stmt);
+
+/**
+ * Lease a connection for read-only queries.
+ *
+ * In WAL mode this is one of a small pool of read-only connections, so queries
+ * run concurrently with writes on the main connection. Without the pool the main
+ * connection is returned with the database mutex held. Either way the caller
+ * must return it with db_release_reader().
+ *
+ * @return Connection to use, or NULL if the database is not initialized
+ */
+sqlite3 *db_acquire_reader(void);
+
+/**
+ * Return a connection obtained from db_acquire_reader()
+ *
+ * @param conn Connection to return (may be NULL)
+ */
+void db_release_reader(sqlite3 *conn);
+
 /**
  * Checkpoint the database WAL file
  * This ensures all changes are written to the main database file
@@ -0,0 +1,79 @@
+/**
+ * Detection Ingest Queue Header
+ *
+ * Detection results are queued in memory and written by a background thread,
+ * coalescing rows from all streams into one transaction per batch so detection
+ * threads never wait on the database.
+ */
+
+#ifndef DB_DETECTION_INGEST_H
+#define DB_DETECTION_INGEST_H
+
+#include <stdint.h>
+#include <time.h>
+#include "video/detection_result.h"
+
+// Maximum number of detection rows held in memory
+#define DETECTION_INGEST_MAX_ROWS 2048
+
+// A batch is written as soon as this many rows are queued...
+#define DETECTION_INGEST_BATCH_ROWS 256
+
+// ...or once the oldest queued row is this old
+#define DETECTION_INGEST_FLUSH_MS 500
+
+/**
+ * Detection ingest metrics
+ */
+typedef struct {
+    int running;                // Non-zero while the ingest thread is running
+    int queued_rows;            // Rows waiting to be written
+    int max_rows;               // Queue capacity
+    uint64_t rows_written;      // Rows committed to the database
+    uint64_t batches_written;   // Transactions committed
+    uint64_t failed_batches;    // Batches that could not be written (rows dropped)
+    uint64_t overflow_rows;     // Rows written synchronously because the queue was full
+    int last_batch_rows;        // Size of the last batch
+    int max_batch_rows;         // Largest batch written
+    double avg_batch_rows;      // Average batch size
+    double lag_ms;              // Age of the oldest queued row
+    double last_lag_ms;         // Queue-to-commit time of the oldest row of the last batch
+    double max_lag_ms;          // Largest queue-to-commit time seen
+    double last_commit_ms;      // Time taken to write the last batch
+} detection_ingest_stats_t;
+
+/**
+ * Start the detection ingest thread. Must be called after the database and the
+ * shutdown coordinator are initialized.
+ *
+ * @return 0 on success, -1 on error
+ */
+int start_detection_ingest_thread(void);
+
+/**
+ * Stop the detection ingest thread, writing all queued rows first.
+ * Must be called before the database is shut down.
+ *
+ * @return 0 on success, -1 on error
+ */
+int stop_detection_ingest_thread(void);
+
+/**
+ * Queue detection results for writing
+ *
+ * @param stream_name Stream name
+ * @param result Detection results
+ * @param timestamp Timestamp of the detection
+ * @return 0 if queued, -1 if the caller must write the rows itself (thread not
+ *         running, queue full or stream name too long)
+ */
+int detection_ingest_enqueue(const char *stream_name, const detection_result_t *result, time_t timestamp);
+
+/**
+ * Get detection ingest metrics
+ *
+ * @param stats Structure to fill
+ */
+void get_detection_ingest_stats(detection_ingest_stats_t *stats);
+
+#endif // DB_DETECTION_INGEST_H
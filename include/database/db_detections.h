@@ -5,8 +5,20 @@
 #include <time.h>
 #include "video/detection_result.h"
 
+/**
+ * A single detection row, as queued by the detection ingest thread
+ */
+typedef struct {
+    char stream_name[64];
+    time_t timestamp;
+    detection_t detection;
+} detection_row_t;
+
 /**
  * Store detection results in the database
+ *
+ * The results are handed to the detection ingest thread when it is running and
+ * written in a later batch; otherwise they are written before returning.
  * 
  * @param stream_name Stream name
  * @param result Detection results
@@ -15,6 +27,15 @@
  */
 int store_detections_in_db(const char *stream_name, const detection_result_t *result, time_t timestamp);
 
+/**
+ * Write detection rows to the database in a single transaction
+ *
+ * @param rows Rows to write
+ * @param count Number of rows
+ * @return 0 on success, -1 on error
+ */
+int store_detection_rows_in_db(const detection_row_t *rows, int count);
+
 /**
  * Get detection results from the database with time range filtering
  * 
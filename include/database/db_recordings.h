@@ -24,6 +24,29 @@ typedef struct {
                                // stream default)
 } recording_metadata_t;
 
+// Recordings visited by get_retention_batch()
+typedef enum {
+  RETENTION_SCAN_REGULAR,   // Non-detection recordings past their retention
+  RETENTION_SCAN_DETECTION, // Detection recordings past their retention
+  RETENTION_SCAN_QUOTA      // All recordings, for storage quota enforcement
+} retention_scan_t;
+
+// Position of a retention scan, zero-initialize to start from the oldest
+typedef struct {
+  time_t start_time;
+  uint64_t id;
+} retention_cursor_t;
+
+// The fields of a recording retention needs
+typedef struct {
+  uint64_t id;
+  char file_path[256];
+  time_t start_time;
+  time_t end_time;
+  uint64_t size_bytes;
+  bool deleted;             // Set by delete_recordings_batch
+} retention_candidate_t;
+
 /**
  * Add recording metadata to the database
  *
@@ -145,24 +168,6 @@ int set_recording_protected(uint64_t id, bool protected);
  */
 int set_recording_retention_override(uint64_t id, int days);
 
-/**
- * Get recordings eligible for deletion based on retention policy
- * Priority 1: Regular recordings past retention period
- * Priority 2: Detection recordings past detection retention period
- * Protected recordings are never returned
- *
- * @param stream_name Stream name to filter
- * @param retention_days Regular recordings retention in days
- * @param detection_retention_days Detection recordings retention in days
- * @param recordings Array to fill with recording metadata
- * @param max_count Maximum number of recordings to return
- * @return Number of recordings found, or -1 on error
- */
-int get_recordings_for_retention(const char *stream_name, int retention_days,
-                                 int detection_retention_days,
-                                 recording_metadata_t *recordings,
-                                 int max_count);
-
 /**
  * Get count of protected recordings for a stream
  *
@@ -172,16 +177,41 @@ int get_recordings_for_retention(const char *stream_name, int retention_days,
 int get_protected_recordings_count(const char *stream_name);
 
 /**
- * Get recordings for quota enforcement (oldest unprotected first)
+ * Get a batch of recordings eligible for retention, oldest first
+ *
+ * Walks the recordings of a stream in (start_time, id) order from a cursor, so
+ * a whole archive is visited batch by batch with each query starting where the
+ * previous one stopped. Protected and incomplete recordings are never returned.
  *
  * @param stream_name Stream name
- * @param recordings Array to fill with recording metadata
+ * @param scan Which recordings to return
+ * @param cutoff Only recordings that started before this time are returned
+ *               (ignored for RETENTION_SCAN_QUOTA)
+ * @param cursor Position to continue from, advanced past the returned rows
+ * @param candidates Array to fill
  * @param max_count Maximum number of recordings to return
  * @return Number of recordings found, or -1 on error
  */
-int get_recordings_for_quota_enforcement(const char *stream_name,
-                                         recording_metadata_t *recordings,
-                                         int max_count);
+int get_retention_batch(const char *stream_name, retention_scan_t scan,
+                        time_t cutoff, retention_cursor_t *cursor,
+                        retention_candidate_t *candidates, int max_count);
+
+/**
+ * Delete the rows of a batch of recordings in one transaction
+ *
+ * A row is only deleted if it is still unprotected and complete, so a
+ * recording protected after it was selected is kept. Each candidate's
+ * deleted flag tells whether its row was removed; the files are left alone
+ * and the caller deletes only those of removed rows once this succeeds.
+ *
+ * @param stream_name Stream the recordings belong to
+ * @param candidates Recordings to delete, their deleted flags are set
+ * @param count Number of recordings
+ * @return Number of rows deleted, or -1 on error (nothing is deleted)
+ */
+int delete_recordings_batch(const char *stream_name,
+                            retention_candidate_t *candidates,
+                            int count);
 
 /**
  * Get orphaned recording entries (DB entries without files)
@@ -11,6 +11,9 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+// Recordings tracked between syncs; more fall back to the reconciliation pass
+#define RECORDING_SYNC_MAX_DIRTY 1024
+
 /**
  * Start the recording sync thread
  * 
@@ -29,9 +32,27 @@ int stop_recording_sync_thread(void);
 /**
  * Force an immediate sync of all recordings
  * 
+ * Checks the dirty recordings and then walks the whole table in chunks.
+ * 
  * @return Number of recordings updated, or -1 on error
  */
 int force_recording_sync(void);
 
+/**
+ * Mark a recording whose file size may differ from the database, so the next
+ * sync checks it
+ * 
+ * @param recording_id Recording ID
+ */
+void recording_sync_mark_dirty(uint64_t recording_id);
+
+/**
+ * Mark a recording whose file size in the database is known to be current,
+ * such as one whose writer reported the final size
+ * 
+ * @param recording_id Recording ID
+ */
+void recording_sync_mark_clean(uint64_t recording_id);
+
 #endif // DB_RECORDINGS_SYNC_H
 
@@ -0,0 +1,118 @@
+/**
+ * Timeline Index Header
+ *
+ * In-memory index of recording coverage and detection density used by the
+ * timeline API. Each cached stream-day holds a one-bit-per-second bitmap of the
+ * seconds covered by complete recordings and per-minute detection counts. A day
+ * is loaded from the database the first time it is queried and then kept up to
+ * date as recordings complete and detections are written, so timeline queries
+ * for cached days run no SQL.
+ */
+
+#ifndef DB_TIMELINE_INDEX_H
+#define DB_TIMELINE_INDEX_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+// Number of stream-days kept in memory (about 14 KB each)
+#define TIMELINE_INDEX_MAX_DAYS 256
+
+// Resolution of the detection counts
+#define TIMELINE_DETECTION_BUCKET_SECONDS 60
+
+/**
+ * Covered time range, end exclusive
+ */
+typedef struct {
+    time_t start;
+    time_t end;
+} timeline_interval_t;
+
+/**
+ * Get the time ranges of a stream covered by complete recordings
+ *
+ * @param stream_name Stream name
+ * @param start_time Start of the range
+ * @param end_time End of the range (exclusive)
+ * @param max_gap Gaps of up to this many seconds are merged into one interval
+ * @param intervals Set to the intervals, in time order; free with free()
+ * @param count Set to the number of intervals
+ * @return 0 on success, -1 on error
+ */
+int timeline_index_get_coverage(const char *stream_name, time_t start_time, time_t end_time,
+                                int max_gap, timeline_interval_t **intervals, int *count);
+
+/**
+ * Get detection counts of a stream in equal buckets
+ *
+ * @param stream_name Stream name
+ * @param start_time Start of the range
+ * @param end_time End of the range (exclusive)
+ * @param bucket_seconds Bucket size, rounded up to a multiple of
+ *                       TIMELINE_DETECTION_BUCKET_SECONDS
+ * @param counts Array of bucket counts to fill
+ * @param max_buckets Size of the array
+ * @return Number of buckets filled, or -1 on error
+ */
+int timeline_index_get_detection_counts(const char *stream_name, time_t start_time, time_t end_time,
+                                        int bucket_seconds, uint32_t *counts, int max_buckets);
+
+/**
+ * Check whether a stream has detections in a time range
+ *
+ * Works at TIMELINE_DETECTION_BUCKET_SECONDS resolution.
+ *
+ * @param stream_name Stream name
+ * @param start_time Start of the range
+ * @param end_time End of the range (inclusive)
+ * @return true if there are detections
+ */
+bool timeline_index_has_detection(const char *stream_name, time_t start_time, time_t end_time);
+
+/**
+ * Record a completed recording
+ *
+ * @param stream_name Stream name
+ * @param start_time Start of the recording
+ * @param end_time End of the recording
+ */
+void timeline_index_add_recording(const char *stream_name, time_t start_time, time_t end_time);
+
+/**
+ * Record a detection
+ *
+ * @param stream_name Stream name
+ * @param timestamp Time of the detection
+ */
+void timeline_index_add_detection(const char *stream_name, time_t timestamp);
+
+/**
+ * Drop the cached days of a stream overlapping a time range, for example after
+ * a recording was deleted. They are reloaded when next queried.
+ *
+ * @param stream_name Stream name
+ * @param start_time Start of the range
+ * @param end_time End of the range
+ */
+void timeline_index_invalidate(const char *stream_name, time_t start_time, time_t end_time);
+
+/**
+ * Drop all cached days
+ */
+void timeline_index_invalidate_all(void);
+
+/**
+ * Get the recording generation of a stream
+ *
+ * The generation changes whenever a recording of the stream completes or is
+ * deleted, so data derived from its recordings can be cached against it. It is
+ * shared by streams whose names hash alike, which only costs extra rebuilds.
+ *
+ * @param stream_name Stream name
+ * @return Current generation
+ */
+uint64_t timeline_index_get_recording_generation(const char *stream_name);
+
+#endif /* DB_TIMELINE_INDEX_H */
@@ -0,0 +1,51 @@
+/**
+ * @file storage_delete_queue.h
+ * @brief Background deletion of recording files
+ *
+ * Retention removes recordings from the database in batches and hands their
+ * files to a small pool of threads that unlink them, so slow unlinks on large
+ * archives never hold up the retention pass or the database. The queue is
+ * bounded; pushing to a full queue waits for room.
+ */
+
+#ifndef LIGHTNVR_STORAGE_DELETE_QUEUE_H
+#define LIGHTNVR_STORAGE_DELETE_QUEUE_H
+
+#include <stdint.h>
+
+// Maximum number of files waiting to be deleted
+#define STORAGE_DELETE_QUEUE_SIZE 2048
+
+// Number of threads deleting files
+#define STORAGE_DELETE_THREADS 2
+
+/**
+ * Start the deletion threads
+ *
+ * @return 0 on success, -1 on error
+ */
+int init_storage_delete_queue(void);
+
+/**
+ * Delete the queued files and stop the deletion threads
+ */
+void shutdown_storage_delete_queue(void);
+
+/**
+ * Queue a recording file for deletion
+ *
+ * Once the file is gone its size is taken off the stream storage cache. When
+ * the queue is not running the file is deleted before this returns.
+ *
+ * @param file_path Path to the file
+ * @param size_bytes Size of the file as recorded in the database
+ * @return 0 on success, -1 on error
+ */
+int storage_delete_queue_push(const char *file_path, uint64_t size_bytes);
+
+/**
+ * Wait until every queued file has been deleted
+ */
+void storage_delete_queue_wait_idle(void);
+
+#endif // LIGHTNVR_STORAGE_DELETE_QUEUE_H
@@ -6,6 +6,7 @@
 #ifndef LIGHTNVR_STORAGE_MANAGER_STREAMS_H
 #define LIGHTNVR_STORAGE_MANAGER_STREAMS_H
 
+#include <stdint.h>
 #include <cjson/cJSON.h>
 
 /**
@@ -13,7 +14,7 @@
  */
 typedef struct {
     char name[64];
-    unsigned long size_bytes;
+    uint64_t size_bytes;
     int recording_count;
 } stream_storage_info_t;
 
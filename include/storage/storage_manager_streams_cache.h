@@ -50,6 +50,24 @@ int invalidate_stream_storage_cache(void);
 
 // Cache priming is now handled by the storage manager thread
 
+/**
+ * Account for a recording file that was completed, without rescanning the disk.
+ * Files outside <storage_path>/mp4/<stream>/ are ignored.
+ *
+ * @param file_path Path of the file
+ * @param size_bytes Size of the file in bytes
+ */
+void stream_storage_cache_add_file(const char *file_path, uint64_t size_bytes);
+
+/**
+ * Account for a recording file that was deleted, without rescanning the disk.
+ * Files outside <storage_path>/mp4/<stream>/ are ignored.
+ *
+ * @param file_path Path of the file
+ * @param size_bytes Size of the file in bytes
+ */
+void stream_storage_cache_remove_file(const char *file_path, uint64_t size_bytes);
+
 /**
  * Force a refresh of the cache
  *
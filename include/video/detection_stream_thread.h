@@ -11,6 +11,9 @@
 // Maximum number of streams we can handle
 #define MAX_STREAM_THREADS 32
 
+// Persistent decode pipeline for a stream's HLS segments (private to the detection thread)
+typedef struct segment_decoder segment_decoder_t;
+
 // Stream detection thread structure
 typedef struct {
     pthread_t thread;
@@ -27,6 +30,7 @@ typedef struct {
     time_t last_detection_time;
     int component_id;
     atomic_int detection_in_progress; // Atomic flag to track if a detection is currently running
+    segment_decoder_t *decoder;       // Reused across segments, rebuilt when codec parameters change
 } stream_detection_thread_t;
 
 // Global variable for startup delay
@@ -0,0 +1,45 @@
+/**
+ * @file go2rtc_client.h
+ * @brief Shared HTTP client for the go2rtc API
+ *
+ * All requests to go2rtc go through a small pool of curl handles attached to a
+ * curl share object holding one connection cache. Connections to go2rtc are
+ * kept alive and reused by every caller instead of paying a TCP handshake per
+ * request.
+ */
+
+#ifndef GO2RTC_CLIENT_H
+#define GO2RTC_CLIENT_H
+
+#include <curl/curl.h>
+
+// Maximum number of idle handles kept for reuse
+#define GO2RTC_CLIENT_POOL_SIZE 16
+
+/**
+ * @brief Take a handle for a request to go2rtc
+ *
+ * The handle has its default options apart from the shared connection cache,
+ * TCP keep-alive and CURLOPT_NOSIGNAL. It may be used from any thread but by
+ * one thread at a time.
+ *
+ * @return Handle, or NULL on failure
+ */
+CURL *go2rtc_client_acquire(void);
+
+/**
+ * @brief Return a handle taken with go2rtc_client_acquire
+ *
+ * The handle's options are reset, so memory they point to (headers, request
+ * bodies, callback data) may be freed once this returns.
+ *
+ * @param curl Handle, may be NULL
+ */
+void go2rtc_client_release(CURL *curl);
+
+/**
+ * @brief Free the idle handles and the shared connection cache
+ */
+void go2rtc_client_cleanup(void);
+
+#endif /* GO2RTC_CLIENT_H */
@@ -8,6 +8,8 @@
 #include <libavformat/avformat.h>
 #include <libavcodec/avcodec.h>
 
+#include "video/packet_pool.h"
+
 /**
  * Motion Buffer Module
  * 
@@ -17,7 +19,8 @@
  * Features:
  * - Circular buffer with configurable size
  * - Stores AVPacket data with timestamps
- * - Memory-efficient packet storage
+ * - Zero-copy packet storage: packets are referenced, not cloned, and payloads
+ *   that must be copied come from a per-stream packet pool
  * - Thread-safe operations
  * - Optional disk-based fallback for resource-constrained systems
  */
@@ -36,7 +39,7 @@ typedef enum {
 
 // Buffered packet structure
 typedef struct {
-    AVPacket *packet;           // The actual packet (NULL if slot is empty)
+    AVPacket *packet;           // The actual packet, blank if the slot is empty (reused)
     time_t timestamp;           // When this packet was captured
     int64_t pts;                // Presentation timestamp
     int64_t dts;                // Decode timestamp
@@ -59,6 +62,7 @@ typedef struct {
     int head;                   // Write position
     int tail;                   // Read position
     int count;                  // Number of packets in buffer
+    packet_pool_t *pool;        // Payload buffers for packets that cannot be shared
     
     // Statistics
     uint64_t total_packets_buffered;    // Total packets buffered
@@ -123,7 +127,8 @@ void destroy_motion_buffer(motion_buffer_t *buffer);
  * Add a packet to the buffer
  * 
  * @param buffer Buffer to add to
- * @param packet Packet to add (will be cloned)
+ * @param packet Packet to add (a reference is taken, the payload is not copied
+ *               unless it cannot be shared)
  * @param timestamp Timestamp of the packet
  * @return 0 on success, non-zero on failure
  */
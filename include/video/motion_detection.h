@@ -2,6 +2,7 @@
 #define MOTION_DETECTION_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <time.h>
 #include "../video/detection_result.h"
@@ -46,6 +47,35 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
                  int width, int height, int channels, time_t frame_time,
                  detection_result_t *result);
 
+/**
+ * Process the luma (Y) plane of a decoded YUV frame for motion detection.
+ * The plane is used directly as the grayscale image, so no RGB conversion is needed.
+ *
+ * @param stream_name The name of the stream
+ * @param y_plane Luma plane of the frame (AVFrame data[0])
+ * @param line_size Bytes between the starts of consecutive rows (AVFrame linesize[0])
+ * @param width Frame width
+ * @param height Frame height
+ * @param prescale_factor Downscaling already applied by the decoder (1 if none)
+ * @param frame_time Timestamp of the frame
+ * @param result Pointer to detection result structure to fill
+ * @return 0 on success, non-zero on failure
+ */
+int detect_motion_luma(const char *stream_name, const unsigned char *y_plane, int line_size,
+                       int width, int height, int prescale_factor, time_t frame_time,
+                       detection_result_t *result);
+
+/**
+ * Get the decoder lowres level to request when decoding frames only for motion
+ * detection. The frame is then downscaled by 1 << lowres inside the decoder and
+ * should be passed to detect_motion_luma() with that prescale factor.
+ *
+ * @param stream_name The name of the stream
+ * @param max_lowres Maximum lowres level supported by the decoder (AVCodec max_lowres)
+ * @return Lowres level in the range 0 to max_lowres
+ */
+int get_motion_detection_decoder_lowres(const char *stream_name, int max_lowres);
+
 /**
  * Configure advanced motion detection parameters
  * 
@@ -54,7 +84,7 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
  * @param noise_threshold Threshold for noise filtering (0-50)
  * @param use_grid_detection Whether to use grid-based detection
  * @param grid_size Size of detection grid (2-32)
- * @param history_size Size of frame history buffer (1-10)
+ * @param history_size Frame history length (1-10), kept for compatibility; no frames are stored
  * @return 0 on success, non-zero on failure
  */
 int configure_advanced_motion_detection(const char *stream_name, int blur_radius,
@@ -71,6 +101,23 @@ int configure_advanced_motion_detection(const char *stream_name, int blur_radius
  */
 int configure_motion_detection_optimizations(const char *stream_name, bool downscale_enabled, int downscale_factor);
 
+/**
+ * Enable or disable the summed-area table (integral image) path
+ *
+ * When enabled, the box blur costs O(1) per pixel for any blur radius and every grid
+ * cell score is a constant-time lookup, so raising blur_radius or grid_size does not
+ * increase the per-frame cost. All pixels are scored instead of every other pixel.
+ *
+ * The path is scalar, so at the supported blur radii (0-5) it is slower than the
+ * default separable SIMD blur with sampled cell scoring (about 2x at 320x180 and
+ * 3-5x at 640x360 and above). Enable it only when full-pixel scoring is needed.
+ *
+ * @param stream_name The name of the stream
+ * @param enabled Whether to use integral images (disabled by default)
+ * @return 0 on success, non-zero on failure
+ */
+int configure_motion_detection_integral_image(const char *stream_name, bool enabled);
+
 /**
  * Enable or disable motion detection for a stream
  * 
@@ -88,4 +135,65 @@ int set_motion_detection_enabled(const char *stream_name, bool enabled);
  */
 bool is_motion_detection_enabled(const char *stream_name);
 
+/**
+ * Get memory usage statistics for motion detection
+ *
+ * @param stream_name The name of the stream
+ * @param allocated_memory Pointer to store the currently allocated memory in bytes
+ * @param peak_memory Pointer to store the peak memory usage in bytes
+ * @return 0 on success, non-zero on failure
+ */
+int get_motion_detection_memory_usage(const char *stream_name, size_t *allocated_memory, size_t *peak_memory);
+
+/**
+ * Get CPU usage statistics for motion detection
+ *
+ * Processing times include the vectorized kernels, see get_motion_detection_kernel_info()
+ * for the kernel set in use and its speedup over the scalar code.
+ *
+ * @param stream_name The name of the stream
+ * @param avg_processing_time Pointer to store the average processing time per frame in milliseconds
+ * @param peak_processing_time Pointer to store the peak processing time per frame in milliseconds
+ * @return 0 on success, non-zero on failure
+ */
+int get_motion_detection_cpu_usage(const char *stream_name, float *avg_processing_time, float *peak_processing_time);
+
+/**
+ * Get detection buffer allocation statistics for motion detection
+ *
+ * Counts the buffers detect_motion() allocates for a stream: the scratch arena, the
+ * previous frame, blur, background and grid buffers and the integral tables.
+ * Per-frame scratch buffers come from the arena, which is sized on the first frame
+ * and reused, so once a stream has warmed up last_frame_buffer_allocations stays 0
+ * and buffer_allocation_free_frames keeps growing. Both reset when the frame size
+ * changes. Allocations made outside these
+ * buffers, such as by the logger or by the caller decoding the frame, are not counted.
+ *
+ * @param stream_name The name of the stream
+ * @param total_buffer_allocations Pointer to store the number of buffers allocated for the stream
+ * @param last_frame_buffer_allocations Pointer to store the buffers allocated by the last frame
+ * @param buffer_allocation_free_frames Pointer to store the consecutive frames processed without allocating a buffer
+ * @return 0 on success, non-zero on failure
+ */
+int get_motion_detection_buffer_allocation_stats(const char *stream_name, uint64_t *total_buffer_allocations,
+                                                 uint32_t *last_frame_buffer_allocations,
+                                                 uint64_t *buffer_allocation_free_frames);
+
+/**
+ * Get the pixel kernel set used for motion detection
+ *
+ * @param kernel_name Pointer to store the kernel set name ("scalar", "sse2", "avx2" or "neon")
+ * @param speedup Pointer to store the speedup over the scalar kernels measured at startup
+ * @return 0 on success, non-zero on failure
+ */
+int get_motion_detection_kernel_info(const char **kernel_name, float *speedup);
+
+/**
+ * Reset performance statistics for motion detection
+ *
+ * @param stream_name The name of the stream
+ * @return 0 on success, non-zero on failure
+ */
+int reset_motion_detection_statistics(const char *stream_name);
+
 #endif /* MOTION_DETECTION_H */
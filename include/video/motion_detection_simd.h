@@ -0,0 +1,86 @@
+#ifndef MOTION_DETECTION_SIMD_H
+#define MOTION_DETECTION_SIMD_H
+
+#include <stddef.h>
+
+/**
+ * Pixel kernels used by the motion detector.
+ *
+ * Every implementation (scalar, SSE2, AVX2, NEON) produces bit-identical output
+ * to the scalar version, so switching kernel sets never changes detection results.
+ */
+typedef struct {
+    const char *name;
+
+    /**
+     * Convert packed RGB24 to 8-bit grayscale using the fixed-point
+     * coefficients (76, 150, 29) >> 8
+     */
+    void (*rgb_to_gray)(const unsigned char *rgb, unsigned char *gray, size_t pixels);
+
+    /**
+     * Downscale by exactly 2 in both directions, averaging each 2x2 block
+     * (truncating). dst_width/dst_height must not exceed src_width/2, src_height/2.
+     */
+    void (*downscale_2x)(const unsigned char *src, int src_width,
+                         unsigned char *dst, int dst_width, int dst_height);
+
+    /**
+     * Horizontal box blur of a single row. Pixels near the edges average only
+     * the in-bounds part of the window, matching the sliding-window scalar code.
+     */
+    void (*blur_row)(const unsigned char *src, unsigned char *dst, int width, int radius);
+
+    /**
+     * Average nrows consecutive rows (separated by stride bytes) into dst.
+     * Used for the vertical box blur pass. nrows must be in the range 1-11.
+     */
+    void (*average_rows)(const unsigned char *src, int stride, int nrows,
+                         unsigned char *dst, int width);
+
+    /**
+     * Running-average background update:
+     * bg = ((256 - alpha) * bg + alpha * cur) >> 8
+     */
+    void (*update_background)(unsigned char *background, const unsigned char *current,
+                              size_t pixels, int alpha);
+
+    /**
+     * Accumulate motion over every other pixel of a row segment.
+     * A sample counts as changed when max(|cur - prev|, |cur - bg|) > threshold.
+     *
+     * @param samples Number of samples (pixels at offsets 0, 2, 4, ...)
+     * @param changed Incremented by the number of changed samples
+     * @param total_diff Incremented by the sum of the differences of changed samples
+     */
+    void (*accumulate_motion)(const unsigned char *curr, const unsigned char *prev,
+                              const unsigned char *background, int samples, int threshold,
+                              int *changed, int *total_diff);
+} motion_kernels_t;
+
+/**
+ * Get the best kernel set supported by the running CPU.
+ * The selection is made once, on first use.
+ *
+ * @return Pointer to a static kernel table, never NULL
+ */
+const motion_kernels_t *motion_kernels_get(void);
+
+/**
+ * Get the portable scalar kernel set
+ *
+ * @return Pointer to the scalar kernel table
+ */
+const motion_kernels_t *motion_kernels_get_scalar(void);
+
+/**
+ * Measure how much faster the selected kernels are than the scalar ones
+ * on a synthetic frame of the given size. Intended to be run once at startup.
+ *
+ * @param width Frame width used for the benchmark
+ * @param height Frame height used for the benchmark
+ * @return Ratio scalar_time / selected_time (1.0 if the scalar kernels are selected)
+ */
+float motion_kernels_benchmark(int width, int height);
+
+#endif /* MOTION_DETECTION_SIMD_H */
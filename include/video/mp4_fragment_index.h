@@ -0,0 +1,53 @@
+/**
+ * MP4 Fragment Index
+ *
+ * Locates the fragments of a fragmented MP4 recording (the ftyp/moov
+ * initialization section followed by moof/mdat pairs) by walking its box
+ * headers, so the file can be addressed as HLS media segments with
+ * EXT-X-MAP and EXT-X-BYTERANGE instead of being fetched whole.
+ */
+
+#ifndef LIGHTNVR_MP4_FRAGMENT_INDEX_H
+#define LIGHTNVR_MP4_FRAGMENT_INDEX_H
+
+#include <stdint.h>
+
+/**
+ * Byte range and duration of one moof/mdat fragment
+ */
+typedef struct {
+    uint64_t offset;
+    uint64_t size;
+    double duration;    // Seconds, from the sample durations of the fragment
+} mp4_fragment_t;
+
+/**
+ * Fragments of a file, in file order
+ */
+typedef struct {
+    uint64_t init_size;         // Bytes of the initialization section, from offset 0
+    mp4_fragment_t *fragments;
+    int count;
+} mp4_fragment_index_t;
+
+/**
+ * Index the fragments of an MP4 file
+ *
+ * Only the fragments of the first video track (or the first track if there is
+ * no video) are timed; fragments of other tracks are merged into the
+ * surrounding byte ranges.
+ *
+ * @param path Path of the MP4 file
+ * @param index Index to fill, free with mp4_fragment_index_free()
+ * @return 0 on success, -1 if the file cannot be read or is not fragmented
+ */
+int mp4_fragment_index_load(const char *path, mp4_fragment_index_t *index);
+
+/**
+ * Free the fragments of an index
+ *
+ * @param index Index
+ */
+void mp4_fragment_index_free(mp4_fragment_index_t *index);
+
+#endif /* LIGHTNVR_MP4_FRAGMENT_INDEX_H */
@@ -53,6 +53,7 @@ typedef void (*record_segment_started_cb)(void *user_ctx);
  * @param output_file The path to the output MP4 file
  * @param duration The duration to record in seconds
  * @param has_audio Flag indicating whether to include audio in the recording
+ * @param fragmented Flag indicating whether to write fragmented MP4 instead of faststart MP4
  * @param input_ctx_ptr Pointer to the input context for this stream (reused between segments)
  * @param segment_info_ptr Pointer to the segment info for this stream
  * @param started_cb Optional callback invoked once when the first keyframe is detected
@@ -60,7 +61,7 @@ typedef void (*record_segment_started_cb)(void *user_ctx);
  * @return 0 on success, negative value on error
  */
 int record_segment(const char *rtsp_url, const char *output_file, int duration, int has_audio,
-                   AVFormatContext **input_ctx_ptr, segment_info_t *segment_info_ptr,
+                   int fragmented, AVFormatContext **input_ctx_ptr, segment_info_t *segment_info_ptr,
                    record_segment_started_cb started_cb, void *cb_ctx);
 
 /**
@@ -27,12 +27,17 @@ typedef struct {
     pthread_mutex_t mutex;    // Mutex to protect audio state
 } mp4_audio_state_t;
 
+// movflags for fragmented recordings: the moov is written up front and a fragment is
+// appended at every keyframe, so the file is written once and playable while recording
+#define MP4_FRAGMENTED_MOVFLAGS "+frag_keyframe+empty_moov+default_base_moof"
+
 struct mp4_writer {
     char output_path[MAX_PATH_LENGTH];
     char stream_name[MAX_STREAM_NAME];
     AVFormatContext *output_ctx;
     int video_stream_idx;
     int has_audio;            // Flag indicating if audio is enabled
+    int fragmented;           // Write fragmented MP4 instead of faststart MP4
     int64_t first_dts;        // First video DTS
     int64_t first_pts;        // First video PTS
     int64_t last_dts;         // Last video DTS
@@ -107,6 +112,16 @@ void mp4_writer_close(mp4_writer_t *writer);
  */
 void mp4_writer_set_segment_duration(mp4_writer_t *writer, int segment_duration);
 
+/**
+ * Select fragmented MP4 output for the writer's segments
+ *
+ * Takes effect with the next segment.
+ *
+ * @param writer The MP4 writer instance
+ * @param enable 1 for fragmented MP4, 0 for faststart MP4
+ */
+void mp4_writer_set_fragmented(mp4_writer_t *writer, int enable);
+
 // Rotation is now handled entirely by the writer thread in mp4_writer_rtsp.c
 
 /**
@@ -0,0 +1,33 @@
+#ifndef ONVIF_DISCOVERY_SCAN_H
+#define ONVIF_DISCOVERY_SCAN_H
+
+#include <stdint.h>
+
+// Maximum number of connection attempts in flight at once
+#define ONVIF_SCAN_MAX_CONCURRENT 256
+
+// Maximum number of connection attempts started per second
+#define ONVIF_SCAN_RATE_PER_SECOND 2000
+
+// Time allowed for each connection attempt
+#define ONVIF_SCAN_CONNECT_TIMEOUT_MS 200
+
+/**
+ * Scan a range of addresses for hosts with any of the given TCP ports open
+ *
+ * Connections are made without blocking and waited on together with epoll, so
+ * the scan takes about as long as the slowest batch of attempts rather than the
+ * sum of them. Hosts are returned in address order.
+ *
+ * @param first_ip First address to scan, in host byte order
+ * @param last_ip Last address to scan, in host byte order
+ * @param ports Ports to try on every host
+ * @param port_count Number of ports
+ * @param candidate_ips Array to fill with the addresses of hosts found
+ * @param max_candidates Maximum number of hosts to return
+ * @return Number of hosts found, or -1 on error
+ */
+int scan_open_ports(uint32_t first_ip, uint32_t last_ip, const int *ports, int port_count,
+                    char candidate_ips[][16], int max_candidates);
+
+#endif /* ONVIF_DISCOVERY_SCAN_H */
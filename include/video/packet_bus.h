@@ -0,0 +1,201 @@
+/**
+ * Per-stream packet bus
+ *
+ * One reader per camera publishes its demuxed packets on the stream's bus and
+ * every other consumer subscribes instead of opening its own connection. Each
+ * subscriber gets reference-counted copies of the packets (the payload is
+ * shared, not copied) in its own bounded queue, so a slow consumer only ever
+ * loses its own packets and never stalls the reader or the other subscribers.
+ *
+ * Consumers written against libavformat can use packet_bus_open_input(), which
+ * returns an input context with the source's streams that is read with
+ * packet_bus_read_frame() in place of av_read_frame().
+ */
+
+#ifndef PACKET_BUS_H
+#define PACKET_BUS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <libavformat/avformat.h>
+
+// Maximum number of subscribers per stream
+#define PACKET_BUS_MAX_SUBSCRIBERS 8
+
+// Maximum number of source streams (video, audio, data) carried by a bus
+#define PACKET_BUS_MAX_SOURCE_STREAMS 4
+
+// Queue length of inputs opened with packet_bus_open_input (several seconds of video)
+#define PACKET_BUS_INPUT_QUEUE_PACKETS 512
+
+// How long packet_bus_read_frame waits for a packet before failing (in milliseconds)
+#define PACKET_BUS_READ_TIMEOUT_MS 10000
+
+/**
+ * What a subscriber loses when its queue is full
+ */
+typedef enum {
+    PACKET_BUS_DROP_OLDEST,         // Drop the oldest queued packet
+    PACKET_BUS_DROP_TO_KEYFRAME     // Drop the whole queue and resume at the next video keyframe
+} packet_bus_drop_policy_t;
+
+typedef struct packet_bus packet_bus_t;
+typedef struct packet_bus_subscriber packet_bus_subscriber_t;
+
+/**
+ * Packet bus statistics for one stream
+ */
+typedef struct {
+    bool active;                // A source is attached
+    int subscribers;            // Current number of subscribers
+    uint64_t packets_published; // Packets published since the bus was created
+    uint64_t packets_dropped;   // Packets dropped by full subscriber queues
+} packet_bus_stats_t;
+
+/**
+ * Get the bus of a stream, creating it if needed
+ *
+ * Buses are never freed, the returned pointer stays valid for the lifetime of
+ * the process.
+ *
+ * @param stream_name Stream name
+ * @return Bus, or NULL if all bus slots are in use
+ */
+packet_bus_t *packet_bus_get(const char *stream_name);
+
+/**
+ * Attach a source to a bus
+ *
+ * Called by the stream's reader after it opened the camera. The stream layout
+ * of the input is recorded so subscribers can set up their outputs. Subscribers
+ * of an earlier source are ended.
+ *
+ * @param bus Bus
+ * @param input_ctx Opened input of the reader
+ * @return 0 on success, -1 on error
+ */
+int packet_bus_attach_source(packet_bus_t *bus, const AVFormatContext *input_ctx);
+
+/**
+ * Publish a packet read from the attached source to all subscribers
+ *
+ * Never blocks on subscribers. The packet is not consumed.
+ *
+ * @param bus Bus
+ * @param pkt Packet as returned by av_read_frame
+ */
+void packet_bus_publish(packet_bus_t *bus, const AVPacket *pkt);
+
+/**
+ * Detach the source of a bus
+ *
+ * Called by the reader when it loses the camera or stops. Subscribers receive
+ * what is already queued and then the end of the stream.
+ *
+ * @param bus Bus
+ */
+void packet_bus_detach_source(packet_bus_t *bus);
+
+/**
+ * Check whether a stream's bus has a source attached
+ *
+ * @param stream_name Stream name
+ * @return true if packets are being published for the stream
+ */
+bool packet_bus_has_source(const char *stream_name);
+
+/**
+ * Subscribe to a stream's bus
+ *
+ * The first packet delivered is a video keyframe.
+ *
+ * @param stream_name Stream name
+ * @param max_packets Queue length
+ * @param policy What to drop when the queue is full
+ * @return Subscriber, or NULL if the stream has no source or no free subscriber slot
+ */
+packet_bus_subscriber_t *packet_bus_subscribe(const char *stream_name, int max_packets,
+                                              packet_bus_drop_policy_t policy);
+
+/**
+ * Receive the next packet of a subscription
+ *
+ * @param sub Subscriber
+ * @param pkt Packet to fill, takes over the reference of the queued packet
+ * @param timeout_ms Maximum time to wait for a packet
+ * @return 0 on success, AVERROR(EAGAIN) on timeout, AVERROR_EOF once the
+ *         source was detached and the queue is empty
+ */
+int packet_bus_receive(packet_bus_subscriber_t *sub, AVPacket *pkt, int timeout_ms);
+
+/**
+ * End a subscription and free its queue
+ *
+ * @param sub Subscriber
+ */
+void packet_bus_unsubscribe(packet_bus_subscriber_t *sub);
+
+/**
+ * Open a stream's bus as a libavformat input
+ *
+ * The returned context has the source's streams but no demuxer; read it with
+ * packet_bus_read_frame() and close it with packet_bus_close_input().
+ *
+ * @param stream_name Stream name
+ * @param ctx Set to the new input context
+ * @return 0 on success, -1 if the stream has no source or on error
+ */
+int packet_bus_open_input(const char *stream_name, AVFormatContext **ctx);
+
+/**
+ * Read the next packet from an input
+ *
+ * Drop-in replacement for av_read_frame() that also accepts inputs opened with
+ * avformat_open_input().
+ *
+ * @param ctx Input context
+ * @param pkt Packet to fill
+ * @return 0 on success, AVERROR_EOF once the bus source is gone,
+ *         AVERROR(ETIMEDOUT) if no packet arrived within PACKET_BUS_READ_TIMEOUT_MS,
+ *         or the error of av_read_frame()
+ */
+int packet_bus_read_frame(AVFormatContext *ctx, AVPacket *pkt);
+
+/**
+ * Close an input opened with packet_bus_open_input() or avformat_open_input()
+ *
+ * @param ctx Input context, set to NULL
+ */
+void packet_bus_close_input(AVFormatContext **ctx);
+
+/**
+ * Check whether an input context was opened with packet_bus_open_input()
+ *
+ * @param ctx Input context
+ * @return true for bus inputs
+ */
+bool packet_bus_is_input(const AVFormatContext *ctx);
+
+/**
+ * Switch a consumer's input to the stream's bus when possible
+ *
+ * A bus input whose source went away is closed. If the stream has a source and
+ * the consumer has no input or its own connection, that input is closed and a
+ * bus input is opened in its place.
+ *
+ * @param stream_name Stream name
+ * @param ctx Consumer's input context, may point to NULL
+ * @return true if *ctx is now a bus input, false if the consumer has to open
+ *         (or keep) its own connection
+ */
+bool packet_bus_select_input(const char *stream_name, AVFormatContext **ctx);
+
+/**
+ * Get packet bus statistics for a stream
+ *
+ * @param stream_name Stream name
+ * @param stats Structure to fill (zeroed if the stream has no bus)
+ */
+void packet_bus_get_stats(const char *stream_name, packet_bus_stats_t *stats);
+
+#endif /* PACKET_BUS_H */
@@ -0,0 +1,70 @@
+/**
+ * Packet Pool
+ *
+ * Per-stream pool for packets that are held for a long time, such as the
+ * pre-detection buffers. Reference-counted packets are stored by taking a new
+ * reference on their payload. Payloads that cannot be shared (packets that are
+ * not reference-counted, or that would pin a much larger demuxer buffer) are
+ * copied into buffers from size-class AVBufferPools, so steady-state buffering
+ * reuses the same allocations instead of going through malloc for every frame.
+ */
+
+#ifndef LIGHTNVR_PACKET_POOL_H
+#define LIGHTNVR_PACKET_POOL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <libavcodec/avcodec.h>
+
+// Size classes are powers of two from 4 KB to 8 MB
+#define PACKET_POOL_MIN_CLASS_SHIFT 12
+#define PACKET_POOL_NUM_CLASSES 12
+
+typedef struct packet_pool packet_pool_t;
+
+/**
+ * Packet pool statistics
+ */
+typedef struct {
+    uint64_t packets_referenced;    // Packets stored by sharing their payload
+    uint64_t packets_copied;        // Packets copied into pooled buffers
+    uint64_t packets_unpooled;      // Packets larger than the biggest size class
+} packet_pool_stats_t;
+
+/**
+ * Create a packet pool
+ *
+ * @param name Name used in log messages (usually the stream name)
+ * @return New pool, or NULL on allocation failure
+ */
+packet_pool_t *packet_pool_create(const char *name);
+
+/**
+ * Destroy a packet pool
+ *
+ * Packets that still reference pooled buffers stay valid, the buffers are
+ * freed when their last reference is released.
+ *
+ * @param pool Pool to destroy
+ */
+void packet_pool_destroy(packet_pool_t *pool);
+
+/**
+ * Store a reference to a packet
+ *
+ * @param pool Pool to take payload buffers from
+ * @param dst Blank packet to fill (as after av_packet_alloc or av_packet_unref)
+ * @param src Packet to reference
+ * @return 0 on success, negative AVERROR on failure
+ */
+int packet_pool_ref(packet_pool_t *pool, AVPacket *dst, const AVPacket *src);
+
+/**
+ * Get packet pool statistics
+ *
+ * @param pool Pool to query
+ * @param stats Structure to fill
+ */
+void packet_pool_get_stats(packet_pool_t *pool, packet_pool_stats_t *stats);
+
+#endif /* LIGHTNVR_PACKET_POOL_H */
@@ -0,0 +1,202 @@
+/**
+ * Stream-copy remux engine
+ *
+ * Trims and concatenates recordings into a single MP4 without re-encoding and
+ * without running the ffmpeg binary. Jobs run on a small fixed pool of worker
+ * threads so several simultaneous exports cannot overload the device; their
+ * progress can be queried while they run.
+ */
+
+#ifndef REMUX_ENGINE_H
+#define REMUX_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <time.h>
+
+#include "core/config.h"
+
+// Default number of remux worker threads
+#define REMUX_DEFAULT_WORKERS 2
+
+// Maximum number of jobs waiting for a worker before submissions are refused
+#define REMUX_MAX_QUEUED_JOBS 16
+
+// Maximum number of jobs tracked at once (queued, running and recently finished)
+#define REMUX_MAX_JOBS 32
+
+// How long finished jobs stay queryable (in seconds)
+#define REMUX_JOB_RETENTION_TIME 300
+
+/**
+ * Output callback for streamed output
+ *
+ * @param opaque Caller data from the request
+ * @param buf Output bytes
+ * @param size Number of bytes
+ * @return 0 to continue, -1 to abort the job
+ */
+typedef int (*remux_write_cb_t)(void *opaque, const uint8_t *buf, size_t size);
+
+/**
+ * Completion callback, called on the worker thread once the job has finished
+ *
+ * @param opaque Caller data from the request
+ * @param success Whether the output was written completely
+ */
+typedef void (*remux_done_cb_t)(void *opaque, bool success);
+
+/**
+ * Cancellation callback, called when a running job is cancelled so a write_cb
+ * that is blocked waiting for its consumer can return
+ *
+ * Called with the engine lock held and before done_cb, so it must not call
+ * into the engine; it should only wake the writer.
+ *
+ * @param opaque Caller data from the request
+ */
+typedef void (*remux_cancel_cb_t)(void *opaque);
+
+/**
+ * Remux request
+ *
+ * Inputs are joined in order with their timestamps rebased so the output plays
+ * continuously. Cuts are made on keyframes: the output starts at the last
+ * keyframe at or before start_offset, so no frame that is needed for decoding
+ * is dropped. The duration is counted from start_offset, so the output runs
+ * until start_offset + duration and also holds the frames before the offset.
+ */
+typedef struct {
+    const char *const *inputs;   // Input files in playback order
+    int input_count;
+    double start_offset;         // Seconds to skip at the start of the first playable input
+    double duration;             // Seconds of output to write, <= 0 for everything
+    const char *output_path;     // Output file, or NULL to stream through write_cb
+    remux_write_cb_t write_cb;   // Receives the output when output_path is NULL
+    remux_done_cb_t done_cb;     // Optional, called when the job finishes
+    remux_cancel_cb_t cancel_cb; // Optional, called when the running job is cancelled
+    void *opaque;                // Passed to write_cb, done_cb and cancel_cb
+    bool fragmented;             // Write fragmented MP4 (forced for streamed output)
+} remux_request_t;
+
+/**
+ * Remux job state
+ */
+typedef enum {
+    REMUX_JOB_QUEUED,
+    REMUX_JOB_RUNNING,
+    REMUX_JOB_COMPLETE,
+    REMUX_JOB_FAILED,
+    REMUX_JOB_CANCELLED
+} remux_job_state_t;
+
+/**
+ * Remux job progress
+ */
+typedef struct {
+    char job_id[64];
+    remux_job_state_t state;
+    int input_count;                  // Number of input files
+    int inputs_done;                  // Input files fully processed
+    int inputs_skipped;               // Inputs that could not be opened or did not match
+    double progress;                  // Fraction done, 0.0 - 1.0
+    uint64_t bytes_written;           // Output bytes written so far
+    double output_seconds;            // Output duration written so far
+    char output_path[MAX_PATH_LENGTH]; // Output file (empty for streamed output)
+    char error_message[256];          // Reason for REMUX_JOB_FAILED
+    time_t created_at;
+    time_t updated_at;
+} remux_job_info_t;
+
+/**
+ * Remux engine statistics
+ */
+typedef struct {
+    int num_workers;        // Worker threads
+    int active_jobs;        // Jobs being remuxed
+    int queued_jobs;        // Jobs waiting for a worker
+    uint64_t completed;     // Jobs finished successfully since start
+    uint64_t failed;        // Jobs that failed or were cancelled
+    uint64_t rejected;      // Submissions refused because the queue was full
+} remux_stats_t;
+
+/**
+ * Start the remux worker pool
+ *
+ * @param num_workers Number of worker threads (<= 0 for the default)
+ * @return 0 on success, -1 on error
+ */
+int remux_engine_init(int num_workers);
+
+/**
+ * Stop the remux worker pool. Queued jobs are cancelled and running jobs are
+ * asked to stop before the workers are joined.
+ */
+void remux_engine_shutdown(void);
+
+/**
+ * Queue a remux job
+ *
+ * The input list and paths are copied, the request does not need to outlive the call.
+ *
+ * @param request Remux request
+ * @param job_id_out Buffer for the job ID (at least 64 bytes), may be NULL
+ * @return 0 on success, -1 if the request is invalid, the engine is not running
+ *         or the queue is full
+ */
+int remux_submit(const remux_request_t *request, char *job_id_out);
+
+/**
+ * Wait for a job to finish
+ *
+ * @param job_id Job ID
+ * @param info Filled with the final job state, may be NULL
+ * @return 0 if the job completed successfully, -1 otherwise
+ */
+int remux_wait(const char *job_id, remux_job_info_t *info);
+
+/**
+ * Get the progress of a job
+ *
+ * @param job_id Job ID
+ * @param info Structure to fill
+ * @return 0 on success, -1 if the job is unknown
+ */
+int remux_get_job(const char *job_id, remux_job_info_t *info);
+
+/**
+ * Ask a queued or running job to stop
+ *
+ * @param job_id Job ID
+ * @return 0 on success, -1 if the job is unknown or already finished
+ */
+int remux_cancel(const char *job_id);
+
+/**
+ * Get remux engine statistics
+ *
+ * @param stats Structure to fill
+ */
+void remux_get_stats(remux_stats_t *stats);
+
+/**
+ * Run a remux on the calling thread, bypassing the worker pool
+ *
+ * For callers that already run on their own thread (e.g. detection clips).
+ * done_cb is not called.
+ *
+ * @param request Remux request
+ * @return 0 on success, -1 on error
+ */
+int remux_run(const remux_request_t *request);
+
+/**
+ * Get the name of a job state
+ *
+ * @param state Job state
+ * @return State name ("queued", "running", ...)
+ */
+const char *remux_job_state_name(remux_job_state_t state);
+
+#endif /* REMUX_ENGINE_H */
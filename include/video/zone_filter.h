@@ -7,7 +7,8 @@
  * Filter detections based on configured zones for a stream
  * 
  * This function:
- * 1. Loads zones for the stream from the database
+ * 1. Loads zones for the stream from the zone cache (the database is only
+ *    queried the first time, or after invalidate_zone_cache())
  * 2. Filters detections to only include those within enabled zones
  * 3. Applies per-zone class filters and confidence thresholds
  * 4. Sets the zone_id field for each accepted detection
@@ -20,5 +21,13 @@
  */
 int filter_detections_by_zones(const char *stream_name, detection_result_t *result);
 
+/**
+ * Drop cached zones so they are reloaded from the database on next use.
+ * Must be called whenever zones are changed.
+ *
+ * @param stream_name The name of the stream, or NULL for all streams
+ */
+void invalidate_zone_cache(const char *stream_name);
+
 #endif /* LIGHTNVR_ZONE_FILTER_H */
 
@@ -12,7 +12,8 @@
  * @brief Handler for POST /api/webrtc
  *
  * This handler proxies WebRTC offer requests to the go2rtc API.
- * It uses the multithreading pattern to handle the request in a worker thread.
+ * The request runs on the event loop without blocking it; the response is
+ * streamed back from go2rtc as it arrives.
  *
  * @param c Mongoose connection
  * @param hm Mongoose HTTP message
@@ -22,7 +23,8 @@ void mg_handle_go2rtc_webrtc_offer(struct mg_connection *c, struct mg_http_messa
 /**
  * @brief Worker function for POST /api/webrtc
  *
- * This function is called by the multithreading system to handle WebRTC offer requests.
+ * Starts proxying WebRTC offer requests to go2rtc. Must be called on the
+ * event loop, which drives the proxied transfer.
  *
  * @param c Mongoose connection
  * @param hm Mongoose HTTP message
@@ -33,7 +35,8 @@ void mg_handle_go2rtc_webrtc_offer_worker(struct mg_connection *c, struct mg_htt
  * @brief Handler for POST /api/webrtc/ice
  *
  * This handler proxies WebRTC ICE candidate requests to the go2rtc API.
- * It uses the multithreading pattern to handle the request in a worker thread.
+ * The request runs on the event loop without blocking it; the response is
+ * streamed back from go2rtc as it arrives.
  *
  * @param c Mongoose connection
  * @param hm Mongoose HTTP message
@@ -43,7 +46,8 @@ void mg_handle_go2rtc_webrtc_ice(struct mg_connection *c, struct mg_http_message
 /**
  * @brief Worker function for POST /api/webrtc/ice
  *
- * This function is called by the multithreading system to handle WebRTC ICE candidate requests.
+ * Starts proxying WebRTC ICE candidate requests to go2rtc. Must be called on the
+ * event loop, which drives the proxied transfer.
  *
  * @param c Mongoose connection
  * @param hm Mongoose HTTP message
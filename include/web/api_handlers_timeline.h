@@ -40,15 +40,17 @@ void handle_get_timeline_segments(const http_request_t *request, http_response_t
 /**
  * Create a playback manifest for a sequence of recordings
  * 
+ * Fragmented MP4 recordings are addressed as byte ranges of the recording
+ * file (EXT-X-MAP and EXT-X-BYTERANGE), other recordings as whole files.
+ * 
  * @param segments      Array of segments to include in the manifest
  * @param segment_count Number of segments in the array
- * @param start_time    Requested playback start time
- * @param manifest_path Output path where the manifest will be written
+ * @param length        Set to the length of the manifest
  * 
- * @return 0 on success, non-zero on failure
+ * @return Manifest text (free with free()), or NULL on failure
  */
-int create_timeline_manifest(const timeline_segment_t *segments, int segment_count,
-                            time_t start_time, char *manifest_path);
+char *create_timeline_manifest(const timeline_segment_t *segments, int segment_count,
+                               size_t *length);
 
 /**
  * Handle GET request for timeline playback
@@ -0,0 +1,69 @@
+/**
+ * @file go2rtc_proxy_stream.h
+ * @brief Streaming reverse proxy to the go2rtc API
+ *
+ * Proxied requests run as transfers of one curl multi handle that the event
+ * loop drives without blocking, over the keep-alive connections of the shared
+ * go2rtc client. Upstream bodies are forwarded to the connection chunk by chunk
+ * as they arrive; a transfer is paused while its connection has
+ * GO2RTC_PROXY_SEND_LIMIT bytes unsent, so a slow client never makes the
+ * response pile up in memory.
+ *
+ * All functions must be called on the event loop.
+ */
+
+#ifndef GO2RTC_PROXY_STREAM_H
+#define GO2RTC_PROXY_STREAM_H
+
+#include <stddef.h>
+
+#include "mongoose.h"
+
+// Maximum number of concurrently proxied requests
+#define GO2RTC_PROXY_MAX_STREAMS 64
+
+// Pause the upstream transfer while the connection has this much unsent
+#define GO2RTC_PROXY_SEND_LIMIT (256 * 1024)
+
+// Marker in mg_connection::data[2] for connections with a proxied request
+#define GO2RTC_PROXY_CONN_MARK 'G'
+
+/**
+ * @brief Start proxying a request to go2rtc
+ *
+ * The response status and content type are taken from go2rtc. On success the
+ * response is sent later from go2rtc_proxy_stream_poll, including the 500 sent
+ * when go2rtc cannot be reached.
+ *
+ * @param c Mongoose connection
+ * @param url go2rtc URL
+ * @param content_type Content type of the request body, or NULL for a GET
+ * @param body Request body (copied), or NULL for a GET
+ * @param body_len Length of the request body
+ * @param timeout_seconds Time allowed for the whole upstream request
+ * @param response_headers Extra response headers, each ending in CRLF
+ * @return 0 on success, -1 if nothing was sent (no free stream slot or the
+ *         request could not be set up)
+ */
+int go2rtc_proxy_stream_start(struct mg_connection *c, const char *url,
+                              const char *content_type, const char *body, size_t body_len,
+                              long timeout_seconds, const char *response_headers);
+
+/**
+ * @brief Advance proxied transfers and resume the one of a drained connection
+ *
+ * Called from the event loop on MG_EV_POLL and MG_EV_WRITE for connections
+ * marked with GO2RTC_PROXY_CONN_MARK.
+ *
+ * @param c Mongoose connection
+ */
+void go2rtc_proxy_stream_poll(struct mg_connection *c);
+
+/**
+ * @brief Abort the proxied transfer of a closing connection
+ *
+ * @param c Mongoose connection
+ */
+void go2rtc_proxy_stream_close(struct mg_connection *c);
+
+#endif /* GO2RTC_PROXY_STREAM_H */
@@ -36,6 +36,8 @@ typedef struct {
     char key_path[256];             // SSL/TLS key path
     int max_connections;            // Maximum number of connections
     int connection_timeout;         // Connection timeout in seconds
+    int worker_threads;             // Worker pool size for threaded requests (0 for default)
+    int max_queued_requests;        // Requests queued for workers before 503 (0 for default)
     bool daemon_mode;               // Daemon mode
     char pid_file[256];             // PID file path
 } http_server_config_t;
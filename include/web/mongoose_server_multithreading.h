@@ -6,8 +6,29 @@
 #ifndef MONGOOSE_SERVER_MULTITHREADING_H
 #define MONGOOSE_SERVER_MULTITHREADING_H
 
+#include <stdint.h>
+#include <time.h>
+
 #include "mongoose.h"
 
+// Default number of worker threads when none is configured
+#define MG_WORKER_POOL_DEFAULT_THREADS 8
+
+// Default maximum number of requests waiting for a worker
+#define MG_WORKER_POOL_DEFAULT_QUEUE_DEPTH 64
+
+/**
+ * @brief Priority of a request queued for the worker pool
+ *
+ * Interactive API calls are always dequeued before bulk transfers
+ * (downloads, exports, file operations).
+ */
+typedef enum {
+  MG_TASK_PRIORITY_HIGH = 0,
+  MG_TASK_PRIORITY_BULK,
+  MG_TASK_PRIORITY_COUNT
+} mg_task_priority_t;
+
 /**
  * @brief Thread data structure for worker threads
  */
@@ -16,8 +37,84 @@ struct mg_thread_data {
   unsigned long conn_id;  // Parent connection ID
   struct mg_str message;  // Original HTTP request
   void (*handler_func)(struct mg_connection *c, struct mg_http_message *hm);  // Handler function
+  struct mg_http_message hm;  // Parsed request pointing into message, valid if has_parsed_message
+  bool has_parsed_message;
+  mg_task_priority_t priority;
+  struct timespec enqueue_time;  // When the request was queued
+  struct mg_thread_data *next;   // Next request in the same priority queue
+  unsigned int generation;       // Pool generation the response may be delivered to
 };
 
+/**
+ * @brief Worker pool statistics
+ */
+typedef struct {
+  int num_threads;          // Number of worker threads
+  int active_workers;       // Workers currently executing a request
+  int queue_depth;          // Requests waiting for a worker
+  int max_queue_depth;      // Queue depth limit before requests are rejected
+  uint64_t completed;       // Requests executed since start
+  uint64_t rejected;        // Requests rejected with 503 because the queue was full
+  double avg_queue_wait_ms; // Average time spent waiting for a worker
+  double max_queue_wait_ms; // Longest time spent waiting for a worker
+  double avg_exec_ms;       // Average handler execution time
+  double max_exec_ms;       // Longest handler execution time
+} mg_worker_pool_stats_t;
+
+/**
+ * @brief Start the worker pool used for offloaded requests
+ *
+ * @param num_threads Number of worker threads (<= 0 for the default)
+ * @param max_queue_depth Maximum number of queued requests (<= 0 for the default)
+ * @return 0 on success, -1 on failure
+ */
+int mg_worker_pool_init(int num_threads, int max_queue_depth);
+
+/**
+ * @brief Stop the worker pool
+ *
+ * Queued requests are dropped and workers are given a few seconds to finish
+ * the request they are executing. Must be called before the Mongoose manager
+ * the workers wake up is freed.
+ */
+void mg_worker_pool_shutdown(void);
+
+/**
+ * @brief Queue a request for execution on the worker pool
+ *
+ * Takes ownership of data on success. If the pool is not running the request
+ * is executed on a dedicated thread instead.
+ *
+ * @param data Thread data with message, connection ID, manager and handler set
+ * @param priority Queue priority
+ * @return true if the request was queued, false if the queue is full
+ */
+bool mg_worker_pool_submit(struct mg_thread_data *data, mg_task_priority_t priority);
+
+/**
+ * @brief Copy a request and hand it to a worker with the given handler
+ *
+ * The parsed message is rebased onto the copy so the worker does not have to
+ * parse the request again. On failure an error response (503 when the queue
+ * is full, 500 otherwise) has already been sent on c.
+ *
+ * @param c Mongoose connection
+ * @param hm HTTP message
+ * @param handler_func Handler to run on the worker
+ * @param priority Queue priority
+ * @return true if the request was queued, false otherwise
+ */
+bool mg_submit_request_to_worker(struct mg_connection *c, struct mg_http_message *hm,
+                                 void (*handler_func)(struct mg_connection *c, struct mg_http_message *hm),
+                                 mg_task_priority_t priority);
+
+/**
+ * @brief Get worker pool statistics
+ *
+ * @param stats Structure to fill
+ */
+void mg_worker_pool_get_stats(mg_worker_pool_stats_t *stats);
+
 /**
  * @brief Start a thread
  * 
@@ -40,11 +137,13 @@ void *mg_thread_function(void *param);
  * @param c Mongoose connection
  * @param hm HTTP message
  * @param fast_path If true, handle the request in the main thread
+ * @param priority Worker queue priority when the request is offloaded
  * @return true if the request was handled, false otherwise
  */
 bool mg_handle_request_with_threading(struct mg_connection *c, 
                                      struct mg_http_message *hm,
-                                     bool fast_path);
+                                     bool fast_path,
+                                     mg_task_priority_t priority);
 
 /**
  * @brief Wakeup event handler
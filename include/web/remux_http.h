@@ -0,0 +1,86 @@
+/**
+ * @file remux_http.h
+ * @brief HTTP delivery of remux engine output
+ *
+ * Remux jobs run on the remux worker pool, never on the event loop. Streamed
+ * output is passed to the connection through a bounded buffer that the event
+ * loop drains as chunked transfer encoding, so a slow client throttles its
+ * remux job instead of growing the send buffer.
+ */
+
+#ifndef REMUX_HTTP_H
+#define REMUX_HTTP_H
+
+#include <stdbool.h>
+#include <cjson/cJSON.h>
+
+#include "mongoose.h"
+#include "video/remux_engine.h"
+
+// Maximum number of concurrently streamed remux responses
+#define REMUX_HTTP_MAX_STREAMS 8
+
+// Bytes buffered between a remux job and its connection
+#define REMUX_HTTP_BUFFER_SIZE (1024 * 1024)
+
+// Stop moving data into the connection while it has this much unsent
+#define REMUX_HTTP_SEND_LIMIT (256 * 1024)
+
+// Marker in mg_connection::data[2] for connections with a remux stream
+#define REMUX_HTTP_CONN_MARK 'R'
+
+/**
+ * @brief Start streaming a remux job to a connection as fragmented MP4
+ *
+ * Must be called on the event loop. On success the response headers have been
+ * sent and the body follows as the job produces it. The output fields of the
+ * request (output_path, write_cb, done_cb, opaque) are ignored.
+ *
+ * @param c Mongoose connection
+ * @param request Remux request
+ * @return 0 on success, -1 if nothing was sent (no free stream slot or the
+ *         remux queue is full)
+ */
+int remux_http_stream_start(struct mg_connection *c, const remux_request_t *request);
+
+/**
+ * @brief Move buffered remux output into a connection
+ *
+ * Called from the event loop on MG_EV_POLL and MG_EV_WRITE for connections
+ * marked with REMUX_HTTP_CONN_MARK.
+ *
+ * @param c Mongoose connection
+ */
+void remux_http_stream_poll(struct mg_connection *c);
+
+/**
+ * @brief Release the remux stream of a closing connection, cancelling its job
+ *
+ * @param c Mongoose connection
+ */
+void remux_http_stream_close(struct mg_connection *c);
+
+/**
+ * @brief Send a JSON response to a connection from any thread
+ *
+ * Used by remux completion callbacks to answer a request whose handler returned
+ * without replying.
+ *
+ * @param mgr Mongoose manager of the connection
+ * @param conn_id Connection ID
+ * @param status_code HTTP status code
+ * @param json Response body
+ * @return true if the response was handed to the event loop
+ */
+bool remux_http_send_json(struct mg_mgr *mgr, unsigned long conn_id, int status_code,
+                          const char *json);
+
+/**
+ * @brief Convert a remux job's progress to JSON
+ *
+ * @param info Job progress
+ * @return New JSON object, or NULL on allocation failure
+ */
+cJSON *remux_http_job_to_json(const remux_job_info_t *info);
+
+#endif /* REMUX_HTTP_H */
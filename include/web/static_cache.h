@@ -0,0 +1,98 @@
+/**
+ * @file static_cache.h
+ * @brief In-memory cache of the web interface's static files
+ *
+ * Files are loaded into memory the first time they are requested together
+ * with their compressed variants and a strong ETag. A file is reloaded when
+ * its size or modification time on disk changes, so a rebuilt bundle is
+ * picked up without a restart.
+ *
+ * Compressed variants come from precompressed siblings on disk (file.br and
+ * file.gz, used only when at least as new as the file); when built with zlib,
+ * compressible files without a .gz sibling are gzipped at load time.
+ *
+ * Files whose name carries a bundler content hash (name-XXXXXXXX.ext) are
+ * served with an immutable Cache-Control; everything else must be revalidated,
+ * which If-None-Match turns into a 304.
+ */
+
+#ifndef STATIC_CACHE_H
+#define STATIC_CACHE_H
+
+#include "mongoose.h"
+
+// Files larger than this are not cached
+#define STATIC_CACHE_MAX_FILE_SIZE (4 * 1024 * 1024)
+
+// Bodies larger than this are streamed from memory as the connection drains
+// instead of being copied into its send buffer at once
+#define STATIC_CACHE_SEND_CHUNK (64 * 1024)
+
+// Top up a streamed body while the connection has less than this unsent
+#define STATIC_CACHE_SEND_LIMIT (256 * 1024)
+
+// Maximum number of bodies streamed at once, more are sent in one piece
+#define STATIC_CACHE_MAX_STREAMS 64
+
+// Marker in mg_connection::data[2] for connections streaming a cached body
+#define STATIC_CACHE_CONN_MARK 'S'
+
+// Total memory used by cached files and their variants
+#define STATIC_CACHE_MAX_TOTAL_SIZE (32 * 1024 * 1024)
+
+// Maximum number of cached files
+#define STATIC_CACHE_MAX_ENTRIES 512
+
+/**
+ * @brief Serve a static file from the cache, loading it if needed
+ *
+ * Sends a response: 304 if the request's If-None-Match matches, otherwise
+ * 200 with the best variant the client accepts (no body for HEAD). Bodies
+ * larger than STATIC_CACHE_SEND_CHUNK are finished by static_cache_stream_poll,
+ * so this must be called from the event loop with a real connection.
+ *
+ * @param c Mongoose connection
+ * @param hm HTTP request
+ * @param path Path of the file on disk
+ * @param extra_headers Extra response headers, each ending in CRLF, or NULL
+ * @return 0 if a response was sent, -1 if the file cannot be served from the
+ *         cache (missing, not a regular file, too large or unreadable)
+ */
+int static_cache_serve(struct mg_connection *c, struct mg_http_message *hm,
+                       const char *path, const char *extra_headers);
+
+/**
+ * @brief Get the Cache-Control value the cache uses for a file
+ *
+ * For files served without the cache, so hashed bundles stay immutable.
+ *
+ * @param path Path of the file
+ * @return Cache-Control header value
+ */
+const char *static_cache_control(const char *path);
+
+/**
+ * @brief Send more of a streamed body
+ *
+ * Called from the event loop on MG_EV_POLL and MG_EV_WRITE for connections
+ * marked with STATIC_CACHE_CONN_MARK.
+ *
+ * @param c Mongoose connection
+ */
+void static_cache_stream_poll(struct mg_connection *c);
+
+/**
+ * @brief Stop streaming to a closing connection
+ *
+ * @param c Mongoose connection
+ */
+void static_cache_stream_close(struct mg_connection *c);
+
+/**
+ * @brief Free all cached files
+ *
+ * Files still being streamed are freed when their stream ends.
+ */
+void static_cache_cleanup(void);
+
+#endif /* STATIC_CACHE_H */
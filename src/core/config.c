@@ -28,6 +28,7 @@ void load_default_config(config_t *config) {
     snprintf(config->pid_file, MAX_PATH_LENGTH, "/var/run/lightnvr.pid");
     snprintf(config->log_file, MAX_PATH_LENGTH, "/var/log/lightnvr.log");
     config->log_level = LOG_LEVEL_INFO;
+    config->log_async = false;
 
     // Syslog settings
     config->syslog_enabled = false;
@@ -70,6 +71,9 @@ void load_default_config(config_t *config) {
     snprintf(config->web_password, 32, "admin"); // Default password, should be changed
     config->webrtc_disabled = false; // WebRTC is enabled by default
     config->auth_timeout_hours = 24; // Default session timeout: 24 hours
+    config->web_thread_pool_size = 8;
+    config->web_max_queued_requests = 64;
+    config->remux_workers = 2;
     
     // Web optimization settings
     config->web_compression_enabled = true;
@@ -290,6 +294,8 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             strncpy(config->log_file, value, MAX_PATH_LENGTH - 1);
         } else if (strcmp(name, "log_level") == 0) {
             config->log_level = atoi(value);
+        } else if (strcmp(name, "log_async") == 0) {
+            config->log_async = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(name, "syslog_enabled") == 0) {
             config->syslog_enabled = (strcmp(value, "true") == 0 || strcmp(value, "1") == 0);
         } else if (strcmp(name, "syslog_ident") == 0) {
@@ -390,6 +396,25 @@ static int config_ini_handler(void* user, const char* section, const char* name,
             if (config->auth_timeout_hours < 1) {
                 config->auth_timeout_hours = 1; // Minimum 1 hour
             }
+        } else if (strcmp(name, "web_thread_pool_size") == 0) {
+            config->web_thread_pool_size = atoi(value);
+            if (config->web_thread_pool_size < 1) {
+                config->web_thread_pool_size = 1;
+            } else if (config->web_thread_pool_size > 64) {
+                config->web_thread_pool_size = 64;
+            }
+        } else if (strcmp(name, "web_max_queued_requests") == 0) {
+            config->web_max_queued_requests = atoi(value);
+            if (config->web_max_queued_requests < 1) {
+                config->web_max_queued_requests = 1;
+            }
+        } else if (strcmp(name, "remux_workers") == 0) {
+            config->remux_workers = atoi(value);
+            if (config->remux_workers < 1) {
+                config->remux_workers = 1;
+            } else if (config->remux_workers > 8) {
+                config->remux_workers = 8;
+            }
         }
     }
     // Stream settings
@@ -923,6 +948,7 @@ int save_config(const config_t *config, const char *path) {
     fprintf(file, "pid_file = %s\n", config->pid_file);
     fprintf(file, "log_file = %s\n", config->log_file);
     fprintf(file, "log_level = %d  ; 0=ERROR, 1=WARN, 2=INFO, 3=DEBUG\n", config->log_level);
+    fprintf(file, "log_async = %s\n", config->log_async ? "true" : "false");
     fprintf(file, "syslog_enabled = %s\n", config->syslog_enabled ? "true" : "false");
     fprintf(file, "syslog_ident = %s\n", config->syslog_ident);
 
@@ -989,6 +1015,9 @@ int save_config(const config_t *config, const char *path) {
     fprintf(file, "password = %s  ; IMPORTANT: Change this default password!\n", config->web_password);
     fprintf(file, "webrtc_disabled = %s\n", config->webrtc_disabled ? "true" : "false");
     fprintf(file, "auth_timeout_hours = %d  ; Session timeout in hours (default: 24)\n", config->auth_timeout_hours);
+    fprintf(file, "web_thread_pool_size = %d  ; Worker threads for API requests (default: 8)\n", config->web_thread_pool_size);
+    fprintf(file, "web_max_queued_requests = %d  ; Queued requests before returning 503 (default: 64)\n", config->web_max_queued_requests);
+    fprintf(file, "remux_workers = %d  ; Concurrent clip/export/playback remux jobs (default: 2)\n", config->remux_workers);
     fprintf(file, "\n");
     
     // Write stream settings
@@ -1074,6 +1103,7 @@ void print_config(const config_t *config) {
     printf("    PID File: %s\n", config->pid_file);
     printf("    Log File: %s\n", config->log_file);
     printf("    Log Level: %d\n", config->log_level);
+    printf("    Async Logging: %s\n", config->log_async ? "enabled" : "disabled");
     
     printf("  Storage Settings:\n");
     printf("    Storage Path: %s\n", config->storage_path);
@@ -1101,6 +1131,8 @@ void print_config(const config_t *config) {
     printf("    Web Password: %s\n", "********");
     printf("    WebRTC Disabled: %s\n", config->webrtc_disabled ? "true" : "false");
     printf("    Auth Timeout: %d hours\n", config->auth_timeout_hours);
+    printf("    Worker Threads: %d (queue limit: %d)\n", config->web_thread_pool_size, config->web_max_queued_requests);
+    printf("    Remux Workers: %d\n", config->remux_workers);
 
     printf("  Stream Settings:\n");
     printf("    Max Streams: %d\n", config->max_streams);
@@ -0,0 +1,227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "core/log_index.h"
+
+/**
+ * @brief Get the sidecar path of a log file
+ */
+void log_index_path(const char *log_path, char *path, size_t size) {
+    snprintf(path, size, "%s.idx", log_path);
+}
+
+/**
+ * @brief Extract the timestamp of a JSON log line
+ */
+int log_index_line_timestamp(const char *line, char *timestamp) {
+    static const char key[] = "\"timestamp\":\"";
+
+    const char *start = strstr(line, key);
+    if (!start) {
+        return -1;
+    }
+    start += sizeof(key) - 1;
+
+    const char *end = strchr(start, '"');
+    if (!end || end - start >= LOG_INDEX_TIMESTAMP_SIZE) {
+        return -1;
+    }
+
+    memset(timestamp, 0, LOG_INDEX_TIMESTAMP_SIZE);
+    memcpy(timestamp, start, end - start);
+    return 0;
+}
+
+/**
+ * @brief Append a record to an index
+ */
+int log_index_add(log_index_t *index, const char *timestamp, uint64_t offset) {
+    if (index->count == index->capacity) {
+        int capacity = index->capacity ? index->capacity * 2 : 64;
+        log_index_record_t *records = realloc(index->records, capacity * sizeof(log_index_record_t));
+        if (!records) {
+            return -1;
+        }
+        index->records = records;
+        index->capacity = capacity;
+    }
+
+    log_index_record_t *record = &index->records[index->count++];
+    memset(record->timestamp, 0, sizeof(record->timestamp));
+    strncpy(record->timestamp, timestamp, sizeof(record->timestamp) - 1);
+    record->offset = offset;
+    return 0;
+}
+
+/**
+ * @brief Build the index of a log file by scanning it
+ */
+static int build_index(const char *log_path, log_index_t *index) {
+    FILE *file = fopen(log_path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    char *line = NULL;
+    size_t line_size = 0;
+    ssize_t len;
+    uint64_t offset = 0;
+    char timestamp[LOG_INDEX_TIMESTAMP_SIZE];
+    int result = 0;
+
+    while ((len = getline(&line, &line_size, file)) > 0) {
+        bool due = index->count == 0 ||
+                   offset - index->records[index->count - 1].offset >= LOG_INDEX_INTERVAL_BYTES;
+        if (due && log_index_line_timestamp(line, timestamp) == 0) {
+            if (log_index_add(index, timestamp, offset) != 0) {
+                result = -1;
+                break;
+            }
+        }
+        offset += (uint64_t)len;
+    }
+
+    free(line);
+    fclose(file);
+    return result;
+}
+
+/**
+ * @brief Write an index to the sidecar, replacing it atomically
+ */
+static int write_index(const char *log_path, const log_index_t *index) {
+    char path[512];
+    char tmp_path[520];
+    log_index_path(log_path, path, sizeof(path));
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    FILE *file = fopen(tmp_path, "w");
+    if (!file) {
+        return -1;
+    }
+
+    size_t written = index->count > 0 ?
+        fwrite(index->records, sizeof(log_index_record_t), index->count, file) : 0;
+    if (fclose(file) != 0 || written != (size_t)index->count) {
+        unlink(tmp_path);
+        return -1;
+    }
+
+    if (rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read the sidecar of a log file and check it against the file
+ *
+ * @return int 0 if the sidecar is usable, -1 otherwise
+ */
+static int read_index(const char *log_path, uint64_t log_size, log_index_t *index) {
+    char path[512];
+    log_index_path(log_path, path, sizeof(path));
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fileno(file), &st) != 0) {
+        fclose(file);
+        return -1;
+    }
+
+    // A record being appended by the writer is ignored
+    int count = (int)(st.st_size / (off_t)sizeof(log_index_record_t));
+    if (count == 0) {
+        fclose(file);
+        return log_size == 0 ? 0 : -1;
+    }
+
+    index->records = malloc(count * sizeof(log_index_record_t));
+    if (!index->records) {
+        fclose(file);
+        return -1;
+    }
+    index->capacity = count;
+    index->count = (int)fread(index->records, sizeof(log_index_record_t), count, file);
+    fclose(file);
+
+    if (index->count != count || index->records[0].offset != 0) {
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        index->records[i].timestamp[LOG_INDEX_TIMESTAMP_SIZE - 1] = '\0';
+        if (index->records[i].offset >= log_size ||
+            (i > 0 && index->records[i].offset <= index->records[i - 1].offset)) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Load the index of a log file
+ */
+int log_index_load(const char *log_path, log_index_t *index, bool persist) {
+    memset(index, 0, sizeof(*index));
+
+    struct stat st;
+    if (stat(log_path, &st) != 0) {
+        return -1;
+    }
+
+    if (read_index(log_path, (uint64_t)st.st_size, index) == 0) {
+        return 0;
+    }
+
+    log_index_free(index);
+    if (build_index(log_path, index) != 0) {
+        log_index_free(index);
+        return -1;
+    }
+
+    // Not logged: the JSON logger calls this with its mutex held. A sidecar
+    // that cannot be written is simply rebuilt again on the next load.
+    if (persist) {
+        write_index(log_path, index);
+    }
+    return 0;
+}
+
+/**
+ * @brief Find the first record whose timestamp is not before a timestamp
+ */
+int log_index_find(const log_index_t *index, const char *timestamp) {
+    int low = 0;
+    int high = index->count;
+
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (strcmp(index->records[mid].timestamp, timestamp) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    return low;
+}
+
+/**
+ * @brief Free the records of an index
+ */
+void log_index_free(log_index_t *index) {
+    free(index->records);
+    index->records = NULL;
+    index->count = 0;
+    index->capacity = 0;
+}
@@ -10,6 +10,9 @@
 #include <errno.h>
 #include <libgen.h>
 #include <syslog.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdatomic.h>
 
 #include "core/logger.h"
 #include "core/logger_json.h"
@@ -40,6 +43,66 @@ static const char *log_level_strings[] = {
     "DEBUG"
 };
 
+// Messages the writer thread takes from the rings per batch
+#define LOG_ASYNC_BATCH_ENTRIES 256
+
+// Queued log message
+typedef struct {
+    uint64_t seq;                       // Global order of the message
+    time_t time;
+    log_level_t level;
+    char message[LOG_ASYNC_MESSAGE_SIZE];
+} log_entry_t;
+
+// Message ring of one thread. Only the owning thread writes entries and moves
+// head. Readers copy the entry at tail and then advance tail with a
+// compare-and-swap; a full ring drops its oldest entry by advancing tail the
+// same way, so a reader whose copy raced with the entry being overwritten sees
+// its compare-and-swap fail and discards the copy.
+typedef struct {
+    _Atomic uint64_t head;
+    _Atomic uint64_t tail;
+    atomic_int state;
+    log_entry_t entries[LOG_ASYNC_RING_ENTRIES];
+} log_ring_t;
+
+// Ring states
+enum {
+    LOG_RING_FREE = 0,                  // Can be claimed by a new thread
+    LOG_RING_IN_USE,                    // Owned by a running thread
+    LOG_RING_ORPHANED                   // Owner exited, free once drained
+};
+
+// Async logging state
+static struct {
+    atomic_bool running;
+    pthread_t thread;
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake_cond;
+    pthread_mutex_t drain_mutex;        // Serializes draining and protects batch
+    pthread_key_t ring_key;
+    _Atomic(log_ring_t *) rings[LOG_ASYNC_MAX_THREADS];
+    atomic_uint_fast64_t next_seq;
+    atomic_uint_fast64_t written;
+    atomic_uint_fast64_t dropped;
+    uint64_t dropped_reported;
+    log_entry_t batch[LOG_ASYNC_BATCH_ENTRIES];
+    struct sigaction old_actions[NSIG];
+} async_log = {
+    .running = false,
+    .wake_mutex = PTHREAD_MUTEX_INITIALIZER,
+    .wake_cond = PTHREAD_COND_INITIALIZER,
+    .drain_mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+static pthread_once_t ring_key_once = PTHREAD_ONCE_INIT;
+static __thread log_ring_t *thread_ring = NULL;
+static __thread bool thread_ring_unavailable = false;
+static __thread bool thread_in_push = false;
+
+// Signals that make the process exit without running the shutdown sequence
+static const int fatal_signals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
 // Initialize the logging system
 int init_logger(void) {
     // Initialize mutex
@@ -66,6 +129,9 @@ int init_logger(void) {
 
 // Shutdown the logging system
 void shutdown_logger(void) {
+    // Write out queued messages before the outputs are closed
+    disable_async_logging();
+
     pthread_mutex_lock(&logger.mutex);
 
     if (logger.log_file != NULL && logger.log_file != stdout && logger.log_file != stderr) {
@@ -279,46 +345,26 @@ const char *sanitize_for_logging(const char *str, size_t max_len) {
     return sanitized;
 }
 
-// Log a message at the specified level with va_list
-void log_message_v(log_level_t level, const char *format, va_list args) {
-    // Only log messages at or below the configured log level
-    // For example, if log_level is INFO (2), we log ERROR (0), WARN (1), and INFO (2), but not DEBUG (3)
-    if (level > logger.log_level) {
-        return;
-    }
-
-    time_t now;
-    struct tm *tm_info;
-    char timestamp[32];
-    char iso_timestamp[32];
-
-    // Get current time
-    time(&now);
-    tm_info = localtime(&now);
-
-    // Format timestamp for text log
-    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
-
-    // Format ISO timestamp for JSON log
-    strftime(iso_timestamp, sizeof(iso_timestamp), "%Y-%m-%dT%H:%M:%S", tm_info);
-
-    // Format the log message
-    char message[4096];
-    vsnprintf(message, sizeof(message), format, args);
-
-    pthread_mutex_lock(&logger.mutex);
-
+/**
+ * Write one message to the log file, console and syslog.
+ * Called with the logger mutex held.
+ */
+static void write_log_outputs(log_level_t level, const char *timestamp, const char *message, bool flush) {
     // Write to log file if available
     if (logger.log_file && logger.log_file != stdout && logger.log_file != stderr) {
         fprintf(logger.log_file, "[%s] [%s] %s\n", timestamp, log_level_strings[level], message);
-        fflush(logger.log_file);
+        if (flush) {
+            fflush(logger.log_file);
+        }
     }
 
     // Always write to console (tee behavior)
     // Use stderr for errors, stdout for other levels
     FILE *console = (level == LOG_LEVEL_ERROR) ? stderr : stdout;
     fprintf(console, "[%s] [%s] %s\n", timestamp, log_level_strings[level], message);
-    fflush(console);
+    if (flush) {
+        fflush(console);
+    }
 
     // Write to syslog if enabled
     if (logger.syslog_enabled) {
@@ -343,9 +389,12 @@ void log_message_v(log_level_t level, const char *format, va_list args) {
         }
         syslog(syslog_priority, "%s", message);
     }
+}
 
-    pthread_mutex_unlock(&logger.mutex);
-
+/**
+ * Write one message to the JSON log
+ */
+static void write_json_output(log_level_t level, const char *iso_timestamp, const char *message) {
     // Write to JSON log file if the function is available
     // This is a weak symbol that can be overridden by the actual implementation
     // If the JSON logger is not linked, this will be a no-op
@@ -355,6 +404,453 @@ void log_message_v(log_level_t level, const char *format, va_list args) {
     }
 }
 
+// Mark the ring of an exiting thread so the writer frees it once drained
+static void release_thread_ring(void *ptr) {
+    log_ring_t *ring = (log_ring_t *)ptr;
+    if (ring) {
+        atomic_store(&ring->state, LOG_RING_ORPHANED);
+    }
+}
+
+static void create_ring_key(void) {
+    pthread_key_create(&async_log.ring_key, release_thread_ring);
+}
+
+/**
+ * Get the calling thread's ring, claiming a free one on first use
+ */
+static log_ring_t *get_thread_ring(void) {
+    if (thread_ring || thread_ring_unavailable) {
+        return thread_ring;
+    }
+
+    pthread_once(&ring_key_once, create_ring_key);
+
+    for (int i = 0; i < LOG_ASYNC_MAX_THREADS && !thread_ring; i++) {
+        log_ring_t *ring = atomic_load(&async_log.rings[i]);
+
+        if (!ring) {
+            log_ring_t *new_ring = calloc(1, sizeof(log_ring_t));
+            if (!new_ring) {
+                break;
+            }
+            atomic_init(&new_ring->state, LOG_RING_IN_USE);
+
+            log_ring_t *expected = NULL;
+            if (atomic_compare_exchange_strong(&async_log.rings[i], &expected, new_ring)) {
+                thread_ring = new_ring;
+                break;
+            }
+
+            // Another thread filled this slot first
+            free(new_ring);
+            ring = expected;
+        }
+
+        int expected_state = LOG_RING_FREE;
+        if (atomic_compare_exchange_strong(&ring->state, &expected_state, LOG_RING_IN_USE)) {
+            thread_ring = ring;
+        }
+    }
+
+    if (!thread_ring) {
+        thread_ring_unavailable = true;
+        return NULL;
+    }
+
+    pthread_setspecific(async_log.ring_key, thread_ring);
+    return thread_ring;
+}
+
+/**
+ * Queue a message in the calling thread's ring
+ *
+ * @return true if the message was queued
+ */
+static bool async_log_push(log_level_t level, const char *format, va_list args) {
+    // A signal handler logging while this thread is queueing writes directly
+    if (thread_in_push) {
+        return false;
+    }
+
+    log_ring_t *ring = get_thread_ring();
+    if (!ring) {
+        return false;
+    }
+
+    thread_in_push = true;
+
+    uint64_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    // Drop the oldest message if the ring is full
+    while (head - tail >= LOG_ASYNC_RING_ENTRIES) {
+        if (atomic_compare_exchange_weak(&ring->tail, &tail, tail + 1)) {
+            atomic_fetch_add_explicit(&async_log.dropped, 1, memory_order_relaxed);
+            tail++;
+            break;
+        }
+    }
+
+    log_entry_t *entry = &ring->entries[head % LOG_ASYNC_RING_ENTRIES];
+    entry->seq = atomic_fetch_add_explicit(&async_log.next_seq, 1, memory_order_relaxed);
+    entry->time = time(NULL);
+    entry->level = level;
+    vsnprintf(entry->message, sizeof(entry->message), format, args);
+
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+
+    thread_in_push = false;
+
+    // Errors are written at once, and a filling ring should not wait for the timer
+    if (level == LOG_LEVEL_ERROR || head + 1 - tail >= LOG_ASYNC_RING_ENTRIES / 2) {
+        pthread_cond_signal(&async_log.wake_cond);
+    }
+
+    return true;
+}
+
+/**
+ * Move queued messages from the rings into an array
+ *
+ * Safe to run concurrently with other readers: every message is taken by
+ * exactly one of them.
+ *
+ * @return Number of messages copied
+ */
+static int collect_log_entries(log_entry_t *out, int max_entries) {
+    int count = 0;
+
+    for (int i = 0; i < LOG_ASYNC_MAX_THREADS && count < max_entries; i++) {
+        log_ring_t *ring = atomic_load(&async_log.rings[i]);
+        if (!ring) {
+            break;
+        }
+
+        int state = atomic_load(&ring->state);
+        if (state == LOG_RING_FREE) {
+            continue;
+        }
+
+        while (count < max_entries) {
+            uint64_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+            uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+            if (tail == head) {
+                if (state == LOG_RING_ORPHANED) {
+                    int expected = LOG_RING_ORPHANED;
+                    atomic_compare_exchange_strong(&ring->state, &expected, LOG_RING_FREE);
+                }
+                break;
+            }
+
+            memcpy(&out[count], &ring->entries[tail % LOG_ASYNC_RING_ENTRIES], sizeof(log_entry_t));
+            if (atomic_compare_exchange_strong(&ring->tail, &tail, tail + 1)) {
+                count++;
+            }
+        }
+    }
+
+    return count;
+}
+
+static int compare_log_entries(const void *a, const void *b) {
+    uint64_t seq_a = ((const log_entry_t *)a)->seq;
+    uint64_t seq_b = ((const log_entry_t *)b)->seq;
+    return (seq_a > seq_b) - (seq_a < seq_b);
+}
+
+/**
+ * Write a batch of messages with one flush per output.
+ * Called with the drain mutex held.
+ */
+static void write_log_batch(log_entry_t *entries, int count) {
+    char timestamp[32];
+    char iso_timestamp[32];
+    struct tm tm_info;
+
+    qsort(entries, count, sizeof(log_entry_t), compare_log_entries);
+
+    pthread_mutex_lock(&logger.mutex);
+
+    uint64_t dropped = atomic_load(&async_log.dropped);
+    if (dropped != async_log.dropped_reported) {
+        char message[128];
+        snprintf(message, sizeof(message), "Log queue full, dropped %llu messages",
+                 (unsigned long long)(dropped - async_log.dropped_reported));
+        time_t now = time(NULL);
+        localtime_r(&now, &tm_info);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+        write_log_outputs(LOG_LEVEL_WARN, timestamp, message, false);
+        async_log.dropped_reported = dropped;
+    }
+
+    for (int i = 0; i < count; i++) {
+        localtime_r(&entries[i].time, &tm_info);
+        strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", &tm_info);
+        write_log_outputs(entries[i].level, timestamp, entries[i].message, false);
+    }
+
+    if (logger.log_file && logger.log_file != stdout && logger.log_file != stderr) {
+        fflush(logger.log_file);
+    }
+    fflush(stdout);
+    fflush(stderr);
+
+    pthread_mutex_unlock(&logger.mutex);
+
+    for (int i = 0; i < count; i++) {
+        localtime_r(&entries[i].time, &tm_info);
+        strftime(iso_timestamp, sizeof(iso_timestamp), "%Y-%m-%dT%H:%M:%S", &tm_info);
+        write_json_output(entries[i].level, iso_timestamp, entries[i].message);
+    }
+
+    atomic_fetch_add(&async_log.written, (uint64_t)count);
+}
+
+/**
+ * Write everything queued. Called with the drain mutex held.
+ */
+static void drain_log_rings(void) {
+    int count;
+    while ((count = collect_log_entries(async_log.batch, LOG_ASYNC_BATCH_ENTRIES)) > 0) {
+        write_log_batch(async_log.batch, count);
+    }
+}
+
+/**
+ * Async log writer thread
+ */
+static void *async_log_thread_func(void *arg) {
+    (void)arg;
+
+    // Leave shutdown and timer signals to the other threads, their handlers log
+    sigset_t mask;
+    sigemptyset(&mask);
+    sigaddset(&mask, SIGINT);
+    sigaddset(&mask, SIGTERM);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGALRM);
+    sigaddset(&mask, SIGUSR1);
+    sigaddset(&mask, SIGUSR2);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+
+    while (atomic_load(&async_log.running)) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += LOG_ASYNC_FLUSH_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&async_log.wake_mutex);
+        pthread_cond_timedwait(&async_log.wake_cond, &async_log.wake_mutex, &deadline);
+        pthread_mutex_unlock(&async_log.wake_mutex);
+
+        pthread_mutex_lock(&async_log.drain_mutex);
+        drain_log_rings();
+        pthread_mutex_unlock(&async_log.drain_mutex);
+    }
+
+    pthread_mutex_lock(&async_log.drain_mutex);
+    drain_log_rings();
+    pthread_mutex_unlock(&async_log.drain_mutex);
+
+    return NULL;
+}
+
+/**
+ * Format a time as UTC without localtime_r or gmtime_r, which may take the
+ * time zone lock and are not async-signal-safe
+ */
+static void format_emergency_time(time_t t, char *buf, size_t size) {
+    int64_t days = (int64_t)t / 86400;
+    int64_t secs = (int64_t)t % 86400;
+    if (secs < 0) {
+        secs += 86400;
+        days--;
+    }
+
+    // Civil date from days since 1970-01-01 (proleptic Gregorian calendar)
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t doe = days - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    int day = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int month = (int)(mp < 10 ? mp + 3 : mp - 9);
+    int year = (int)(yoe + era * 400 + (month <= 2));
+
+    snprintf(buf, size, "%04d-%02d-%02d %02d:%02d:%02d UTC", year, month, day,
+             (int)(secs / 3600), (int)(secs / 60 % 60), (int)(secs % 60));
+}
+
+/**
+ * Write a message with write(2), for use when the process is dying
+ */
+static void write_emergency_line(int fd, const log_entry_t *entry) {
+    char line[LOG_ASYNC_MESSAGE_SIZE + 64];
+    char timestamp[32];
+
+    format_emergency_time(entry->time, timestamp, sizeof(timestamp));
+    int len = snprintf(line, sizeof(line), "[%s] [%s] %s\n", timestamp,
+                       log_level_strings[entry->level], entry->message);
+    if (len > (int)sizeof(line) - 1) {
+        len = (int)sizeof(line) - 1;
+    }
+    if (len > 0 && write(fd, line, (size_t)len) < 0) {
+        // Nothing left to report the failure to
+    }
+}
+
+// Write queued log messages with write(2) only, safe in a signal handler
+void log_emergency_flush(void) {
+    // The drain mutex may be held by the interrupted thread, readers do not need it
+    int fd = -1;
+    if (logger.log_file && logger.log_file != stdout && logger.log_file != stderr) {
+        fd = fileno(logger.log_file);
+    }
+
+    log_entry_t entry;
+    while (collect_log_entries(&entry, 1) > 0) {
+        if (fd >= 0) {
+            write_emergency_line(fd, &entry);
+        }
+        write_emergency_line(STDERR_FILENO, &entry);
+    }
+}
+
+/**
+ * Fatal signal handler: write out what is queued, then die with the signal
+ */
+static void async_log_fatal_signal_handler(int sig) {
+    log_emergency_flush();
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// Enable async logging
+int enable_async_logging(void) {
+    if (atomic_load(&async_log.running)) {
+        return 0;
+    }
+
+    atomic_store(&async_log.running, true);
+    if (pthread_create(&async_log.thread, NULL, async_log_thread_func, NULL) != 0) {
+        atomic_store(&async_log.running, false);
+        log_error("Failed to create async log writer thread");
+        return -1;
+    }
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = async_log_fatal_signal_handler;
+    sigemptyset(&sa.sa_mask);
+    for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]); i++) {
+        sigaction(fatal_signals[i], &sa, &async_log.old_actions[fatal_signals[i]]);
+    }
+
+    log_info("Async logging enabled (%d messages per thread, flush every %d ms)",
+             LOG_ASYNC_RING_ENTRIES, LOG_ASYNC_FLUSH_MS);
+    return 0;
+}
+
+// Disable async logging
+void disable_async_logging(void) {
+    if (!atomic_exchange(&async_log.running, false)) {
+        return;
+    }
+
+    pthread_cond_signal(&async_log.wake_cond);
+    pthread_join(async_log.thread, NULL);
+
+    for (size_t i = 0; i < sizeof(fatal_signals) / sizeof(fatal_signals[0]); i++) {
+        sigaction(fatal_signals[i], &async_log.old_actions[fatal_signals[i]], NULL);
+    }
+
+    // Messages queued while the writer was exiting
+    pthread_mutex_lock(&async_log.drain_mutex);
+    drain_log_rings();
+    pthread_mutex_unlock(&async_log.drain_mutex);
+}
+
+// Write all queued log messages now
+void log_flush(void) {
+    if (!atomic_load(&async_log.running)) {
+        return;
+    }
+
+    pthread_mutex_lock(&async_log.drain_mutex);
+    drain_log_rings();
+    pthread_mutex_unlock(&async_log.drain_mutex);
+}
+
+// Get async logging statistics
+void get_async_log_stats(log_async_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    stats->enabled = atomic_load(&async_log.running) ? 1 : 0;
+    stats->written = atomic_load(&async_log.written);
+    stats->dropped = atomic_load(&async_log.dropped);
+
+    for (int i = 0; i < LOG_ASYNC_MAX_THREADS; i++) {
+        log_ring_t *ring = atomic_load(&async_log.rings[i]);
+        if (!ring) {
+            break;
+        }
+        if (atomic_load(&ring->state) != LOG_RING_FREE) {
+            stats->threads++;
+        }
+    }
+}
+
+// Log a message at the specified level with va_list
+void log_message_v(log_level_t level, const char *format, va_list args) {
+    // Only log messages at or below the configured log level
+    // For example, if log_level is INFO (2), we log ERROR (0), WARN (1), and INFO (2), but not DEBUG (3)
+    if (level > logger.log_level) {
+        return;
+    }
+
+    // Queue the message for the writer thread; fall back to writing it here if
+    // async logging is off or this thread has no ring
+    if (atomic_load_explicit(&async_log.running, memory_order_acquire) &&
+        async_log_push(level, format, args)) {
+        return;
+    }
+
+    time_t now;
+    struct tm *tm_info;
+    char timestamp[32];
+    char iso_timestamp[32];
+
+    // Get current time
+    time(&now);
+    tm_info = localtime(&now);
+
+    // Format timestamp for text log
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%d %H:%M:%S", tm_info);
+
+    // Format ISO timestamp for JSON log
+    strftime(iso_timestamp, sizeof(iso_timestamp), "%Y-%m-%dT%H:%M:%S", tm_info);
+
+    // Format the log message
+    char message[4096];
+    vsnprintf(message, sizeof(message), format, args);
+
+    pthread_mutex_lock(&logger.mutex);
+    write_log_outputs(level, timestamp, message, true);
+    pthread_mutex_unlock(&logger.mutex);
+
+    write_json_output(level, iso_timestamp, message);
+}
+
 // Get the string representation of a log level
 const char *get_log_level_string(log_level_t level) {
     if (level >= LOG_LEVEL_ERROR && level <= LOG_LEVEL_DEBUG) {
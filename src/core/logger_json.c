@@ -11,20 +11,39 @@
 
 #include "core/logger.h"
 #include "core/logger_json.h"
+#include "core/log_index.h"
 #include <cjson/cJSON.h>
 
 // JSON logger state
 static struct {
     FILE *log_file;
+    FILE *index_file;                   // Sidecar of the current file, see log_index.h
     char log_filename[256];
     pthread_mutex_t mutex;
     int initialized;
+    uint64_t file_size;                 // Bytes in the current file
+    uint64_t last_indexed_offset;       // Offset of the last index record
+    int index_records;                  // Index records of the current file
+    json_log_entry_t ring[JSON_LOG_RING_ENTRIES];   // Recent entries, oldest at ring_start
+    int ring_start;
+    int ring_count;
 } json_logger = {
     .log_file = NULL,
+    .index_file = NULL,
     .log_filename = "",
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
     .initialized = 0
 };
 
+// Entries collected by a paged query
+typedef struct {
+    json_log_entry_t *entries;
+    int count;
+    int capacity;
+    int limit;
+    int done;
+} json_log_page_t;
+
 // Log level strings (lowercase for JSON)
 static const char *json_log_level_strings[] = {
     "error",
@@ -75,6 +94,321 @@ static int create_directory(const char *path) {
     return 0;
 }
 
+// Convert a JSON level string to a log level
+static log_level_t json_log_level_from_string(const char *level) {
+    if (strcmp(level, "error") == 0) {
+        return LOG_LEVEL_ERROR;
+    } else if (strcmp(level, "warning") == 0) {
+        return LOG_LEVEL_WARN;
+    } else if (strcmp(level, "debug") == 0) {
+        return LOG_LEVEL_DEBUG;
+    }
+    return LOG_LEVEL_INFO;
+}
+
+// Rename a log file together with its index
+static void rename_log_file(const char *old_path, const char *new_path) {
+    char old_index[512];
+    char new_index[512];
+
+    log_index_path(old_path, old_index, sizeof(old_index));
+    log_index_path(new_path, new_index, sizeof(new_index));
+
+    rename(old_path, new_path);
+    if (rename(old_index, new_index) != 0) {
+        // A missing index is rebuilt when the file is read
+        unlink(new_index);
+    }
+}
+
+// Open the current log file and its index. Called with the mutex held.
+static int open_log_files(void) {
+    char index_path[512];
+    log_index_path(json_logger.log_filename, index_path, sizeof(index_path));
+
+    log_index_t index;
+    json_logger.index_records = 0;
+    json_logger.last_indexed_offset = 0;
+    if (log_index_load(json_logger.log_filename, &index, true) == 0) {
+        json_logger.index_records = index.count;
+        if (index.count > 0) {
+            json_logger.last_indexed_offset = index.records[index.count - 1].offset;
+        }
+        log_index_free(&index);
+    } else {
+        // No log file yet, drop any stale index
+        unlink(index_path);
+    }
+
+    json_logger.log_file = fopen(json_logger.log_filename, "a");
+    if (!json_logger.log_file) {
+        return -1;
+    }
+
+    struct stat st;
+    json_logger.file_size = fstat(fileno(json_logger.log_file), &st) == 0 ? (uint64_t)st.st_size : 0;
+
+    // The index only speeds up queries, logging goes on without it
+    json_logger.index_file = fopen(index_path, "a");
+
+    return 0;
+}
+
+// Close the current log file and its index. Called with the mutex held.
+static void close_log_files(void) {
+    if (json_logger.log_file) {
+        fclose(json_logger.log_file);
+        json_logger.log_file = NULL;
+    }
+    if (json_logger.index_file) {
+        fclose(json_logger.index_file);
+        json_logger.index_file = NULL;
+    }
+}
+
+// Add an index record for a line if one is due. Called with the mutex held.
+static void index_line(uint64_t offset, const char *timestamp) {
+    if (!json_logger.index_file) {
+        return;
+    }
+    if (json_logger.index_records > 0 &&
+        offset - json_logger.last_indexed_offset < LOG_INDEX_INTERVAL_BYTES) {
+        return;
+    }
+
+    log_index_record_t record;
+    memset(&record, 0, sizeof(record));
+    strncpy(record.timestamp, timestamp, sizeof(record.timestamp) - 1);
+    record.offset = offset;
+
+    if (fwrite(&record, sizeof(record), 1, json_logger.index_file) == 1) {
+        fflush(json_logger.index_file);
+        json_logger.index_records++;
+        json_logger.last_indexed_offset = offset;
+    }
+}
+
+// Add an entry to the ring, replacing the oldest when full. Called with the mutex held.
+static void ring_push(log_level_t level, const char *timestamp, const char *message) {
+    char *copy = strdup(message);
+    if (!copy) {
+        return;
+    }
+
+    json_log_entry_t *entry;
+    if (json_logger.ring_count < JSON_LOG_RING_ENTRIES) {
+        entry = &json_logger.ring[(json_logger.ring_start + json_logger.ring_count) % JSON_LOG_RING_ENTRIES];
+        json_logger.ring_count++;
+    } else {
+        entry = &json_logger.ring[json_logger.ring_start];
+        free(entry->message);
+        json_logger.ring_start = (json_logger.ring_start + 1) % JSON_LOG_RING_ENTRIES;
+    }
+
+    strncpy(entry->timestamp, timestamp, sizeof(entry->timestamp) - 1);
+    entry->timestamp[sizeof(entry->timestamp) - 1] = '\0';
+    entry->level = level;
+    entry->message = copy;
+}
+
+// Free all ring entries. Called with the mutex held.
+static void ring_clear(void) {
+    for (int i = 0; i < json_logger.ring_count; i++) {
+        json_log_entry_t *entry = &json_logger.ring[(json_logger.ring_start + i) % JSON_LOG_RING_ENTRIES];
+        free(entry->message);
+        entry->message = NULL;
+    }
+    json_logger.ring_start = 0;
+    json_logger.ring_count = 0;
+}
+
+// Add an entry to a page, taking over its message
+static int page_add(json_log_page_t *page, json_log_entry_t *entry) {
+    if (page->count == page->capacity) {
+        int capacity = page->capacity ? page->capacity * 2 : 64;
+        json_log_entry_t *entries = realloc(page->entries, capacity * sizeof(json_log_entry_t));
+        if (!entries) {
+            return -1;
+        }
+        page->entries = entries;
+        page->capacity = capacity;
+    }
+
+    page->entries[page->count++] = *entry;
+    entry->message = NULL;
+    return 0;
+}
+
+/**
+ * @brief Add the matching entries of one stretch of a log file to a page
+ *
+ * Entries are added newest first. Once the page is full, only entries with the
+ * same timestamp as the oldest one on the page are still added.
+ */
+static int read_chunk(const char *path, uint64_t start, uint64_t end, const char *before,
+                      log_level_t max_level, json_log_page_t *page) {
+    if (end <= start) {
+        return 0;
+    }
+
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        return 0;
+    }
+
+    size_t len = (size_t)(end - start);
+    char *buffer = malloc(len + 1);
+    if (!buffer) {
+        fclose(file);
+        return -1;
+    }
+
+    size_t bytes_read = 0;
+    if (fseeko(file, (off_t)start, SEEK_SET) == 0) {
+        bytes_read = fread(buffer, 1, len, file);
+    }
+    buffer[bytes_read] = '\0';
+    fclose(file);
+
+    // Matching entries in file order
+    json_log_page_t chunk = {0};
+    int result = 0;
+
+    char *saveptr;
+    for (char *line = strtok_r(buffer, "\n", &saveptr); line; line = strtok_r(NULL, "\n", &saveptr)) {
+        char timestamp[LOG_INDEX_TIMESTAMP_SIZE];
+        if (log_index_line_timestamp(line, timestamp) != 0) {
+            continue;
+        }
+        if (before && strcmp(timestamp, before) >= 0) {
+            continue;
+        }
+
+        cJSON *log_entry = cJSON_Parse(line);
+        if (!log_entry) {
+            continue;
+        }
+
+        cJSON *level_json = cJSON_GetObjectItem(log_entry, "level");
+        cJSON *message_json = cJSON_GetObjectItem(log_entry, "message");
+        if (level_json && cJSON_IsString(level_json) &&
+            message_json && cJSON_IsString(message_json)) {
+            json_log_entry_t entry;
+            memset(&entry, 0, sizeof(entry));
+            strncpy(entry.timestamp, timestamp, sizeof(entry.timestamp) - 1);
+            entry.level = json_log_level_from_string(level_json->valuestring);
+
+            if (entry.level <= max_level) {
+                entry.message = strdup(message_json->valuestring);
+                if (!entry.message || page_add(&chunk, &entry) != 0) {
+                    free(entry.message);
+                    cJSON_Delete(log_entry);
+                    result = -1;
+                    break;
+                }
+            }
+        }
+
+        cJSON_Delete(log_entry);
+    }
+
+    for (int i = chunk.count - 1; i >= 0; i--) {
+        if (result == 0 && !page->done && page->count >= page->limit &&
+            strcmp(chunk.entries[i].timestamp, page->entries[page->count - 1].timestamp) != 0) {
+            page->done = 1;
+        }
+        if (result == 0 && !page->done && page_add(page, &chunk.entries[i]) != 0) {
+            result = -1;
+        }
+        // Still set unless page_add took the message over
+        free(chunk.entries[i].message);
+    }
+
+    free(chunk.entries);
+    free(buffer);
+    return result;
+}
+
+/**
+ * @brief Add the matching entries of one log file before a timestamp to a page
+ *
+ * @param size Bytes of the file to consider
+ * @param persist Whether the file's index may be rewritten
+ */
+static int read_file_before(const char *path, uint64_t size, const char *before,
+                            log_level_t max_level, json_log_page_t *page, bool persist) {
+    log_index_t index;
+    if (log_index_load(path, &index, persist) != 0) {
+        return 0;
+    }
+
+    // Index records from position first on are not before the timestamp, so
+    // their stretches of the file cannot hold matching entries
+    int first = before ? log_index_find(&index, before) : index.count;
+    uint64_t end = first < index.count ? index.records[first].offset : size;
+
+    int result = 0;
+    for (int i = first - 1; i >= 0 && !page->done && result == 0; i--) {
+        uint64_t start = index.records[i].offset;
+        result = read_chunk(path, start, end, before, max_level, page);
+        end = start;
+    }
+
+    log_index_free(&index);
+    return result;
+}
+
+/**
+ * @brief Page back through the current and rotated log files
+ *
+ * @param current_size Bytes of the current file to consider
+ */
+static int read_entries_before(const char *log_filename, uint64_t current_size, const char *before,
+                               log_level_t max_level, json_log_page_t *page) {
+    for (int i = 0; i <= JSON_LOG_MAX_ROTATED_FILES && !page->done; i++) {
+        char path[512];
+        uint64_t size = current_size;
+
+        if (i == 0) {
+            snprintf(path, sizeof(path), "%s", log_filename);
+        } else {
+            snprintf(path, sizeof(path), "%s.%d", log_filename, i);
+
+            struct stat st;
+            if (stat(path, &st) != 0) {
+                break;
+            }
+            size = (uint64_t)st.st_size;
+        }
+
+        if (read_file_before(path, size, before, max_level, page, i > 0) != 0) {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Fill the ring with the newest entries of the log files
+ *
+ * Called with the mutex held and the ring empty.
+ */
+static void seed_ring(void) {
+    json_log_page_t page = { .limit = JSON_LOG_RING_ENTRIES };
+
+    fflush(json_logger.log_file);
+    if (read_entries_before(json_logger.log_filename, json_logger.file_size, NULL,
+                            LOG_LEVEL_DEBUG, &page) == 0) {
+        int count = page.count < JSON_LOG_RING_ENTRIES ? page.count : JSON_LOG_RING_ENTRIES;
+        for (int i = count - 1; i >= 0; i--) {
+            ring_push(page.entries[i].level, page.entries[i].timestamp, page.entries[i].message);
+        }
+    }
+
+    json_log_free_entries(page.entries, page.count);
+}
+
 /**
  * @brief Initialize the JSON logger
  * 
@@ -84,13 +418,14 @@ static int create_directory(const char *path) {
 int init_json_logger(const char *filename) {
     if (!filename) return -1;
     
-    // Initialize mutex
-    if (pthread_mutex_init(&json_logger.mutex, NULL) != 0) {
-        fprintf(stderr, "Failed to initialize JSON logger mutex\n");
-        return -1;
-    }
-    
     pthread_mutex_lock(&json_logger.mutex);
+
+    // Switching to another file
+    if (json_logger.initialized) {
+        json_logger.initialized = 0;
+        close_log_files();
+        ring_clear();
+    }
     
     // Create directory for log file if needed
     char *dir_path = strdup(filename);
@@ -107,16 +442,18 @@ int init_json_logger(const char *filename) {
     }
     free(dir_path);
     
+    // Store filename for potential log rotation
+    strncpy(json_logger.log_filename, filename, sizeof(json_logger.log_filename) - 1);
+    json_logger.log_filename[sizeof(json_logger.log_filename) - 1] = '\0';
+    
     // Open log file
-    json_logger.log_file = fopen(filename, "a");
-    if (!json_logger.log_file) {
+    if (open_log_files() != 0) {
         pthread_mutex_unlock(&json_logger.mutex);
         return -1;
     }
-    
-    // Store filename for potential log rotation
-    strncpy(json_logger.log_filename, filename, sizeof(json_logger.log_filename) - 1);
-    json_logger.log_filename[sizeof(json_logger.log_filename) - 1] = '\0';
+
+    // Serve the entries from before the restart from memory as well
+    seed_ring();
     
     json_logger.initialized = 1;
     
@@ -142,15 +479,12 @@ int init_json_logger(const char *filename) {
 void shutdown_json_logger(void) {
     pthread_mutex_lock(&json_logger.mutex);
     
-    if (json_logger.log_file) {
-        fclose(json_logger.log_file);
-        json_logger.log_file = NULL;
-    }
+    close_log_files();
+    ring_clear();
     
     json_logger.initialized = 0;
     
     pthread_mutex_unlock(&json_logger.mutex);
-    pthread_mutex_destroy(&json_logger.mutex);
 }
 
 /**
@@ -193,12 +527,23 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
     pthread_mutex_lock(&json_logger.mutex);
     
     int result = 0;
-    if (fprintf(json_logger.log_file, "%s\n", json_str) < 0) {
+    if (!json_logger.log_file) {
         result = -1;
+    } else {
+        uint64_t offset = json_logger.file_size;
+        int written = fprintf(json_logger.log_file, "%s\n", json_str);
+        if (written < 0) {
+            result = -1;
+        } else {
+            json_logger.file_size += (uint64_t)written;
+            index_line(offset, timestamp);
+        }
+        
+        fflush(json_logger.log_file);
+        
+        ring_push(level, timestamp, message);
     }
     
-    fflush(json_logger.log_file);
-    
     pthread_mutex_unlock(&json_logger.mutex);
     
     free(json_str);
@@ -206,6 +551,132 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
     return result;
 }
 
+/**
+ * @brief Get the newest log entries after a timestamp
+ */
+int json_log_query_since(const char *since_timestamp, log_level_t max_level, int limit,
+                         json_log_entry_t **entries, int *count) {
+    *entries = NULL;
+    *count = 0;
+
+    if (!json_logger.initialized || limit <= 0) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&json_logger.mutex);
+
+    int max_entries = limit < json_logger.ring_count ? limit : json_logger.ring_count;
+    json_log_entry_t *result = calloc(max_entries > 0 ? max_entries : 1, sizeof(json_log_entry_t));
+    if (!result) {
+        pthread_mutex_unlock(&json_logger.mutex);
+        return -1;
+    }
+
+    // Walk back from the newest entry until the requested timestamp
+    int n = 0;
+    for (int i = json_logger.ring_count - 1; i >= 0 && n < max_entries; i--) {
+        const json_log_entry_t *entry = &json_logger.ring[(json_logger.ring_start + i) % JSON_LOG_RING_ENTRIES];
+        if (since_timestamp && strcmp(entry->timestamp, since_timestamp) <= 0) {
+            break;
+        }
+        if (entry->level > max_level) {
+            continue;
+        }
+
+        result[n] = *entry;
+        result[n].message = strdup(entry->message);
+        if (!result[n].message) {
+            pthread_mutex_unlock(&json_logger.mutex);
+            json_log_free_entries(result, n);
+            return -1;
+        }
+        n++;
+    }
+
+    pthread_mutex_unlock(&json_logger.mutex);
+
+    *entries = result;
+    *count = n;
+    return 0;
+}
+
+/**
+ * @brief Get the log entries before a timestamp
+ */
+int json_log_query_before(const char *before_timestamp, log_level_t max_level, int limit,
+                          json_log_entry_t **entries, int *count) {
+    *entries = NULL;
+    *count = 0;
+
+    if (!json_logger.initialized || limit <= 0) {
+        return -1;
+    }
+
+    // Only read what is completely written
+    char log_filename[256];
+    uint64_t current_size;
+
+    pthread_mutex_lock(&json_logger.mutex);
+    if (json_logger.log_file) {
+        fflush(json_logger.log_file);
+    }
+    strncpy(log_filename, json_logger.log_filename, sizeof(log_filename));
+    current_size = json_logger.file_size;
+    pthread_mutex_unlock(&json_logger.mutex);
+
+    json_log_page_t page = { .limit = limit };
+    if (read_entries_before(log_filename, current_size, before_timestamp, max_level, &page) != 0) {
+        json_log_free_entries(page.entries, page.count);
+        return -1;
+    }
+
+    *entries = page.entries;
+    *count = page.count;
+    return 0;
+}
+
+/**
+ * @brief Free entries returned by the JSON log queries
+ */
+void json_log_free_entries(json_log_entry_t *entries, int count) {
+    if (!entries) {
+        return;
+    }
+
+    for (int i = 0; i < count; i++) {
+        free(entries[i].message);
+    }
+    free(entries);
+}
+
+/**
+ * @brief Clear the current JSON log file and the in-memory entries
+ */
+int json_log_clear(void) {
+    if (!json_logger.initialized) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&json_logger.mutex);
+
+    close_log_files();
+    ring_clear();
+
+    char index_path[512];
+    log_index_path(json_logger.log_filename, index_path, sizeof(index_path));
+    unlink(index_path);
+
+    FILE *file = fopen(json_logger.log_filename, "w");
+    if (file) {
+        fclose(file);
+    }
+
+    int result = open_log_files();
+
+    pthread_mutex_unlock(&json_logger.mutex);
+    return result;
+}
+
 /**
  * @brief Get logs from the JSON log file with timestamp-based pagination
  * 
@@ -216,164 +687,51 @@ int write_json_log(log_level_t level, const char *timestamp, const char *message
  * @return int 0 on success, non-zero on error
  */
 int get_json_logs(const char *min_level, const char *last_timestamp, char ***logs, int *count) {
-    if (!json_logger.initialized || !json_logger.log_file) {
-        return -1;
-    }
-    
     // Initialize output parameters
     *logs = NULL;
     *count = 0;
-    
-    // Convert min_level to numeric value for comparison
-    int min_value = 2; // Default to INFO (2)
-    
-    if (strcmp(min_level, "error") == 0) {
-        min_value = 0;
-    } else if (strcmp(min_level, "warning") == 0) {
-        min_value = 1;
-    } else if (strcmp(min_level, "info") == 0) {
-        min_value = 2;
-    } else if (strcmp(min_level, "debug") == 0) {
-        min_value = 3;
-    }
-    
-    // Open log file for reading
-    FILE *file = fopen(json_logger.log_filename, "r");
-    if (!file) {
-        return -1;
-    }
-    
-    // Get file size
-    fseek(file, 0, SEEK_END);
-    long file_size = ftell(file);
-    
-    // Limit to last 100KB if file is larger
-    const long max_size = 100 * 1024;
-    long read_size = file_size;
-    long offset = 0;
-    
-    if (file_size > max_size) {
-        read_size = max_size;
-        offset = file_size - max_size;
-    }
-    
-    // Allocate buffer
-    char *buffer = malloc(read_size + 1);
-    if (!buffer) {
-        fclose(file);
+
+    json_log_entry_t *entries = NULL;
+    int entry_count = 0;
+    const char *since = (last_timestamp != NULL && last_timestamp[0] != '\0') ? last_timestamp : NULL;
+
+    if (json_log_query_since(since, json_log_level_from_string(min_level), JSON_LOG_RING_ENTRIES,
+                             &entries, &entry_count) != 0) {
         return -1;
     }
-    
-    // Read log file
-    fseek(file, offset, SEEK_SET);
-    size_t bytes_read = fread(buffer, 1, read_size, file);
-    buffer[bytes_read] = '\0';
-    
-    // Close file
-    fclose(file);
-    
-    // Count number of lines
-    int line_count = 0;
-    for (size_t i = 0; i < bytes_read; i++) {
-        if (buffer[i] == '\n') {
-            line_count++;
-        }
-    }
-    
-    // Add one more for the last line if it doesn't end with a newline
-    if (bytes_read > 0 && buffer[bytes_read - 1] != '\n') {
-        line_count++;
-    }
-    
+
     // Allocate array of log strings
-    char **log_lines = malloc(line_count * sizeof(char *));
+    char **log_lines = calloc(entry_count > 0 ? entry_count : 1, sizeof(char *));
     if (!log_lines) {
-        free(buffer);
+        json_log_free_entries(entries, entry_count);
         return -1;
     }
-    
-    // Split buffer into lines
-    char *saveptr;
-    char *line = strtok_r(buffer, "\n", &saveptr);
+
+    // Return the lines oldest first, as they appear in the file
     int log_index = 0;
-    
-    // For timestamp comparison
-    int compare_timestamp = (last_timestamp != NULL && last_timestamp[0] != '\0');
-    
-    while (line != NULL && log_index < line_count) {
-        // Parse JSON log entry
-        cJSON *log_entry = cJSON_Parse(line);
-        if (log_entry) {
-            // Extract timestamp, level, and message
-            cJSON *timestamp_json = cJSON_GetObjectItem(log_entry, "timestamp");
-            cJSON *level_json = cJSON_GetObjectItem(log_entry, "level");
-            cJSON *message_json = cJSON_GetObjectItem(log_entry, "message");
-            
-            if (timestamp_json && cJSON_IsString(timestamp_json) &&
-                level_json && cJSON_IsString(level_json) &&
-                message_json && cJSON_IsString(message_json)) {
-                
-                const char *timestamp = timestamp_json->valuestring;
-                const char *level = level_json->valuestring;
-                const char *message = message_json->valuestring;
-                
-                // Skip entries with timestamp <= last_timestamp
-                if (compare_timestamp && strcmp(timestamp, last_timestamp) <= 0) {
-                    cJSON_Delete(log_entry);
-                    line = strtok_r(NULL, "\n", &saveptr);
-                    continue;
-                }
-                
-                // Convert level to numeric value for comparison
-                int level_value = 2; // Default to INFO (2)
-                
-                if (strcmp(level, "error") == 0) {
-                    level_value = 0;
-                } else if (strcmp(level, "warning") == 0) {
-                    level_value = 1;
-                } else if (strcmp(level, "info") == 0) {
-                    level_value = 2;
-                } else if (strcmp(level, "debug") == 0) {
-                    level_value = 3;
-                }
-                
-                // Only include logs that meet the minimum level
-                // IMPORTANT: The logic here is inverted from what you might expect
-                // When min_level is "error" (0), we only want to include error logs (0)
-                // When min_level is "warning" (1), we want to include error (0) and warning (1)
-                // When min_level is "info" (2), we want to include error (0), warning (1), and info (2)
-                // When min_level is "debug" (3), we want to include all logs
-                if (level_value <= min_value) {
-                    // Include this log entry
-                    log_lines[log_index] = strdup(line);
-                    if (!log_lines[log_index]) {
-                        // Free previously allocated lines
-                        for (int i = 0; i < log_index; i++) {
-                            free(log_lines[i]);
-                        }
-                        free(log_lines);
-                        free(buffer);
-                        cJSON_Delete(log_entry);
-                        return -1;
-                    }
-                    
-                    log_index++;
-                }
-            }
-            
-            cJSON_Delete(log_entry);
+    for (int i = entry_count - 1; i >= 0; i--) {
+        cJSON *log_entry = cJSON_CreateObject();
+        if (!log_entry) {
+            continue;
+        }
+
+        cJSON_AddStringToObject(log_entry, "timestamp", entries[i].timestamp);
+        cJSON_AddStringToObject(log_entry, "level", json_log_level_strings[entries[i].level]);
+        cJSON_AddStringToObject(log_entry, "message", entries[i].message);
+
+        char *line = cJSON_PrintUnformatted(log_entry);
+        cJSON_Delete(log_entry);
+        if (line) {
+            log_lines[log_index++] = line;
         }
-        
-        line = strtok_r(NULL, "\n", &saveptr);
     }
-    
+
+    json_log_free_entries(entries, entry_count);
+
     // Set output parameters
     *logs = log_lines;
     *count = log_index;
-    
-    // Free buffer
-    free(buffer);
-    
+
     return 0;
 }
 
@@ -404,34 +762,32 @@ int json_log_rotate(size_t max_size, int max_files) {
         return 0;
     }
     
-    // Close current log file
-    if (json_logger.log_file) {
-        fclose(json_logger.log_file);
-        json_logger.log_file = NULL;
-    }
+    // Close current log file and its index
+    close_log_files();
     
-    // Rotate log files
+    // Rotate log files, each with its index
     char old_path[512];
     char new_path[512];
     
     // Remove oldest log file if it exists
     snprintf(old_path, sizeof(old_path), "%s.%d", json_logger.log_filename, max_files);
     unlink(old_path);
+    log_index_path(old_path, new_path, sizeof(new_path));
+    unlink(new_path);
     
     // Shift existing log files
     for (int i = max_files - 1; i > 0; i--) {
         snprintf(old_path, sizeof(old_path), "%s.%d", json_logger.log_filename, i);
         snprintf(new_path, sizeof(new_path), "%s.%d", json_logger.log_filename, i + 1);
-        rename(old_path, new_path);
+        rename_log_file(old_path, new_path);
     }
     
     // Rename current log file
     snprintf(new_path, sizeof(new_path), "%s.1", json_logger.log_filename);
-    rename(json_logger.log_filename, new_path);
+    rename_log_file(json_logger.log_filename, new_path);
     
     // Open new log file
-    json_logger.log_file = fopen(json_logger.log_filename, "a");
-    if (!json_logger.log_file) {
+    if (open_log_files() != 0) {
         pthread_mutex_unlock(&json_logger.mutex);
         return -1;
     }
@@ -41,6 +41,7 @@
 #include "video/onvif_discovery.h"
 #include "video/ffmpeg_leak_detector.h"
 #include "video/onvif_motion_recording.h"
+#include "video/remux_engine.h"
 
 // Include go2rtc headers if USE_GO2RTC is defined
 #ifdef USE_GO2RTC
@@ -54,6 +55,7 @@ void init_recordings_system(void);
 #include "database/db_schema_cache.h"
 #include "database/db_core.h"
 #include "database/db_recordings_sync.h"
+#include "database/db_detection_ingest.h"
 #include <sqlite3.h>
 #include "web/http_server.h"
 #include "web/mongoose_server.h"
@@ -194,6 +196,7 @@ static void alarm_handler(int sig) {
 
     // Phase 3: Final forced exit
     log_error("Emergency cleanup timed out after multiple phases, forcing immediate exit");
+    log_emergency_flush();  // log_flush takes locks the interrupted thread may hold
     _exit(EXIT_SUCCESS); // Use _exit instead of exit to avoid calling atexit handlers
 }
 
@@ -578,6 +581,13 @@ int main(int argc, char *argv[]) {
         }
     }
 
+    // Move log output to a background writer if configured
+    if (config.log_async) {
+        if (enable_async_logging() != 0) {
+            log_warn("Failed to enable async logging, writing log messages synchronously");
+        }
+    }
+
     // Copy configuration to global config
     memcpy(&g_config, &config, sizeof(config_t));
 
@@ -644,6 +654,11 @@ int main(int argc, char *argv[]) {
     }
     log_info("Shutdown coordinator initialized");
 
+    // Start the detection ingest thread (needs the database and the coordinator)
+    if (start_detection_ingest_thread() != 0) {
+        log_warn("Failed to start detection ingest thread, detections will be written synchronously");
+    }
+
     // Initialize signal handlers
     init_signals();
 
@@ -834,6 +849,11 @@ int main(int argc, char *argv[]) {
         log_info("Batch delete progress tracking initialized successfully");
     }
 
+    // Start the remux pool used by clip export and continuous playback
+    if (remux_engine_init(config.remux_workers) != 0) {
+        log_error("Failed to start remux engine, clip export will be unavailable");
+    }
+
     // Check if detection models exist and start detection-based recording - MOVED TO END OF SETUP
     for (int i = 0; i < config.max_streams; i++) {
         if (config.streams[i].name[0] != '\0' && config.streams[i].enabled &&
@@ -928,6 +948,8 @@ int main(int argc, char *argv[]) {
         .ssl_enabled = false,
         .max_connections = 100,
         .connection_timeout = 30,
+        .worker_threads = config.web_thread_pool_size,
+        .max_queued_requests = config.web_max_queued_requests,
         .daemon_mode = daemon_mode,
     };
 
@@ -1212,6 +1234,9 @@ cleanup:
         shutdown_onvif_discovery();
 
         // Now shut down components
+        // Stop remux jobs before the connections they answer go away
+        remux_engine_shutdown();
+
         log_info("Shutting down web server...");
         if (http_server) {
             http_server_stop(http_server);
@@ -1234,6 +1259,9 @@ cleanup:
         log_info("Shutting down recording sync thread...");
         stop_recording_sync_thread();
 
+        log_info("Flushing detection ingest queue...");
+        stop_detection_ingest_thread();
+
         // Add a memory barrier before database shutdown to ensure all previous operations are complete
         __sync_synchronize();
 
@@ -1313,6 +1341,7 @@ cleanup:
         cleanup_transcoding_backend();
 
         // Shut down remaining components
+        remux_engine_shutdown();
         if (http_server) {
             http_server_stop(http_server);
             http_server_destroy(http_server);
@@ -1326,6 +1355,7 @@ cleanup:
         shutdown_stream_state_adapter();
         shutdown_stream_state_manager();
         shutdown_storage_manager();
+        stop_detection_ingest_thread();
 
         // Ensure all database operations are complete before cleanup
         log_info("Ensuring all database operations are complete...");
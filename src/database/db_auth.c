@@ -14,6 +14,7 @@
 #include <sys/time.h>
 
 #include "database/db_auth.h"
+#include "database/db_auth_cache.h"
 #include "database/db_core.h"
 #include "core/logger.h"
 #include "core/config.h"
@@ -429,6 +430,8 @@ int db_auth_update_user(int64_t user_id, const char *email, int role, int is_act
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("User updated successfully: %lld", (long long)user_id);
     return 0;
 }
@@ -543,6 +546,8 @@ int db_auth_change_password(int64_t user_id, const char *new_password) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("Password changed successfully for user: %lld", (long long)user_id);
     return 0;
 }
@@ -593,6 +598,8 @@ int db_auth_delete_user(int64_t user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("User deleted successfully: %lld", (long long)user_id);
     return 0;
 }
@@ -606,6 +613,11 @@ int db_auth_get_user_by_id(int64_t user_id, user_t *user) {
         return -1;
     }
     
+    if (auth_cache_get_user(user_id, user)) {
+        return 0;
+    }
+    uint64_t cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -615,7 +627,7 @@ int db_auth_get_user_by_id(int64_t user_id, user_t *user) {
     // Query the user
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db,
-                               "SELECT id, username, email, role, api_key, created_at, "
+                               "SELECT id, username, email, role, created_at, "
                                "updated_at, last_login, is_active "
                                "FROM users WHERE id = ?;",
                                -1, &stmt, NULL);
@@ -647,21 +659,18 @@ int db_auth_get_user_by_id(int64_t user_id, user_t *user) {
     
     user->role = (user_role_t)sqlite3_column_int(stmt, 3);
     
-    const char *api_key = (const char *)sqlite3_column_text(stmt, 4);
-    if (api_key) {
-        strncpy(user->api_key, api_key, sizeof(user->api_key) - 1);
-        user->api_key[sizeof(user->api_key) - 1] = '\0';
-    } else {
-        user->api_key[0] = '\0';
-    }
+    // Not loaded, so the user can be cached without its API key
+    user->api_key[0] = '\0';
     
-    user->created_at = sqlite3_column_int64(stmt, 5);
-    user->updated_at = sqlite3_column_int64(stmt, 6);
-    user->last_login = sqlite3_column_int64(stmt, 7);
-    user->is_active = sqlite3_column_int(stmt, 8) != 0;
+    user->created_at = sqlite3_column_int64(stmt, 4);
+    user->updated_at = sqlite3_column_int64(stmt, 5);
+    user->last_login = sqlite3_column_int64(stmt, 6);
+    user->is_active = sqlite3_column_int(stmt, 7) != 0;
     
     sqlite3_finalize(stmt);
     
+    auth_cache_put_user(user, cache_generation);
+    
     return 0;
 }
 
@@ -742,6 +751,11 @@ int db_auth_get_user_by_api_key(const char *api_key, user_t *user) {
         return -1;
     }
     
+    if (auth_cache_get_api_key(api_key, user)) {
+        return 0;
+    }
+    uint64_t cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -798,6 +812,8 @@ int db_auth_get_user_by_api_key(const char *api_key, user_t *user) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_put_api_key(api_key, user, cache_generation);
+    
     return 0;
 }
 
@@ -863,6 +879,8 @@ int db_auth_generate_api_key(int64_t user_id, char *api_key, size_t api_key_size
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("API key generated successfully for user: %lld", (long long)user_id);
     return 0;
 }
@@ -876,6 +894,12 @@ int db_auth_authenticate(const char *username, const char *password, int64_t *us
         return -1;
     }
     
+    // Credentials verified recently skip the password hash and the last login update
+    if (auth_cache_get_credentials(username, password, user_id)) {
+        return 0;
+    }
+    uint64_t cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -955,6 +979,8 @@ int db_auth_authenticate(const char *username, const char *password, int64_t *us
         *user_id = id;
     }
     
+    auth_cache_put_credentials(username, password, id, cache_generation);
+    
     // Update last login time
     sqlite3_finalize(stmt);
     
@@ -1069,6 +1095,11 @@ int db_auth_validate_session(const char *token, int64_t *user_id) {
         return -1;
     }
     
+    if (auth_cache_get_session(token, user_id)) {
+        return 0;
+    }
+    uint64_t cache_generation = auth_cache_generation();
+    
     sqlite3 *db = get_db_handle();
     if (!db) {
         log_error("Database not initialized");
@@ -1122,6 +1153,8 @@ int db_auth_validate_session(const char *token, int64_t *user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_put_session(token, id, expires_at, cache_generation);
+    
     return 0;
 }
 
@@ -1159,6 +1192,8 @@ int db_auth_delete_session(const char *token) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_session(token);
+    
     log_info("Session deleted successfully");
     return 0;
 }
@@ -1192,6 +1227,8 @@ int db_auth_delete_user_sessions(int64_t user_id) {
     
     sqlite3_finalize(stmt);
     
+    auth_cache_invalidate_user(user_id);
+    
     log_info("Sessions deleted successfully for user: %lld", (long long)user_id);
     return 0;
 }
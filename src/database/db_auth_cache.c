@@ -0,0 +1,393 @@
+/**
+ * @file db_auth_cache.c
+ * @brief In-memory cache of verified credentials, sessions and users
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include <mbedtls/md.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+
+#include "database/db_auth_cache.h"
+#include "core/logger.h"
+
+#define DIGEST_LENGTH 32
+#define KEY_LENGTH 32
+
+// Slots searched for an entry, starting at the one its digest maps to
+#define PROBE_LENGTH 8
+
+typedef enum {
+    ENTRY_FREE = 0,
+    ENTRY_CREDENTIALS,
+    ENTRY_SESSION,
+    ENTRY_API_KEY,
+    ENTRY_USER
+} entry_kind_t;
+
+typedef struct {
+    entry_kind_t kind;
+    unsigned char digest[DIGEST_LENGTH];
+    int64_t user_id;
+    time_t expires_at;
+    user_t user;            // API key and user entries only, api_key is always blank
+} auth_cache_entry_t;
+
+static auth_cache_entry_t entries[AUTH_CACHE_SIZE];
+static unsigned char hmac_key[KEY_LENGTH];
+static bool key_ready = false;
+static uint64_t cache_generation = 0;
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Generate the HMAC key, called with the cache mutex held
+ */
+static int init_key(void) {
+    if (key_ready) {
+        return 0;
+    }
+
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+
+    int rc = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                   (const unsigned char *)"lightnvr-auth-cache", 19);
+    if (rc == 0) {
+        rc = mbedtls_ctr_drbg_random(&ctr_drbg, hmac_key, KEY_LENGTH);
+    }
+
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+
+    if (rc != 0) {
+        return -1;
+    }
+
+    key_ready = true;
+    return 0;
+}
+
+/**
+ * @brief Compute the digest of an entry from its kind and up to two values
+ *
+ * @return 0 on success, -1 if the cache cannot be used
+ */
+static int compute_digest(entry_kind_t kind, const void *first, size_t first_length,
+                          const void *second, size_t second_length,
+                          unsigned char *digest) {
+    const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if (!md_info) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&cache_mutex);
+    int rc = init_key();
+    pthread_mutex_unlock(&cache_mutex);
+    if (rc != 0) {
+        return -1;
+    }
+
+    mbedtls_md_context_t ctx;
+    mbedtls_md_init(&ctx);
+
+    unsigned char kind_byte = (unsigned char)kind;
+    unsigned char separator = 0;
+    rc = mbedtls_md_setup(&ctx, md_info, 1);
+    if (rc == 0) rc = mbedtls_md_hmac_starts(&ctx, hmac_key, KEY_LENGTH);
+    if (rc == 0) rc = mbedtls_md_hmac_update(&ctx, &kind_byte, 1);
+    if (rc == 0) rc = mbedtls_md_hmac_update(&ctx, first, first_length);
+    if (rc == 0 && second) {
+        // The separator keeps ("ab", "c") and ("a", "bc") apart
+        rc = mbedtls_md_hmac_update(&ctx, &separator, 1);
+        if (rc == 0) rc = mbedtls_md_hmac_update(&ctx, second, second_length);
+    }
+    if (rc == 0) rc = mbedtls_md_hmac_finish(&ctx, digest);
+
+    mbedtls_md_free(&ctx);
+    return rc == 0 ? 0 : -1;
+}
+
+static unsigned int home_slot(const unsigned char *digest) {
+    uint32_t value;
+    memcpy(&value, digest, sizeof(value));
+    return value % AUTH_CACHE_SIZE;
+}
+
+/**
+ * @brief Find a live entry, called with the cache mutex held
+ */
+static auth_cache_entry_t *find_entry(entry_kind_t kind, const unsigned char *digest, time_t now) {
+    unsigned int slot = home_slot(digest);
+
+    for (int i = 0; i < PROBE_LENGTH; i++) {
+        auth_cache_entry_t *entry = &entries[(slot + i) % AUTH_CACHE_SIZE];
+        if (entry->kind == kind && memcmp(entry->digest, digest, DIGEST_LENGTH) == 0) {
+            if (entry->expires_at <= now) {
+                entry->kind = ENTRY_FREE;
+                return NULL;
+            }
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+/**
+ * @brief Order slots for eviction: free and expired first, then by expiry
+ */
+static time_t eviction_rank(const auth_cache_entry_t *entry, time_t now) {
+    if (entry->kind == ENTRY_FREE || entry->expires_at <= now) {
+        return 0;
+    }
+    return entry->expires_at;
+}
+
+/**
+ * @brief Get the slot to store an entry in, called with the cache mutex held
+ *
+ * Prefers the existing entry, then a free or expired slot, then the slot that
+ * expires first.
+ */
+static auth_cache_entry_t *claim_entry(entry_kind_t kind, const unsigned char *digest, time_t now) {
+    unsigned int slot = home_slot(digest);
+    auth_cache_entry_t *victim = NULL;
+
+    for (int i = 0; i < PROBE_LENGTH; i++) {
+        auth_cache_entry_t *entry = &entries[(slot + i) % AUTH_CACHE_SIZE];
+        if (entry->kind == kind && memcmp(entry->digest, digest, DIGEST_LENGTH) == 0) {
+            return entry;
+        }
+
+        if (!victim || eviction_rank(entry, now) < eviction_rank(victim, now)) {
+            victim = entry;
+        }
+    }
+
+    return victim;
+}
+
+/**
+ * @brief Store an entry unless the cache was invalidated since generation
+ */
+static void put_entry(entry_kind_t kind, const unsigned char *digest, int64_t user_id,
+                      time_t expires_at, const user_t *user, uint64_t since) {
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&cache_mutex);
+
+    if (since == cache_generation && expires_at > now) {
+        auth_cache_entry_t *entry = claim_entry(kind, digest, now);
+        entry->kind = kind;
+        memcpy(entry->digest, digest, DIGEST_LENGTH);
+        entry->user_id = user_id;
+        entry->expires_at = expires_at;
+        if (user) {
+            entry->user = *user;
+            memset(entry->user.api_key, 0, sizeof(entry->user.api_key));
+        }
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/**
+ * @brief Look up an entry and copy out its user ID and user
+ */
+static bool get_entry(entry_kind_t kind, const unsigned char *digest, int64_t *user_id, user_t *user) {
+    bool found = false;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    auth_cache_entry_t *entry = find_entry(kind, digest, time(NULL));
+    if (entry) {
+        if (user_id) {
+            *user_id = entry->user_id;
+        }
+        if (user) {
+            *user = entry->user;
+        }
+        found = true;
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+    return found;
+}
+
+/**
+ * @brief Get the invalidation generation of the cache
+ */
+uint64_t auth_cache_generation(void) {
+    pthread_mutex_lock(&cache_mutex);
+    uint64_t current = cache_generation;
+    pthread_mutex_unlock(&cache_mutex);
+    return current;
+}
+
+/**
+ * @brief Look up verified username and password credentials
+ */
+bool auth_cache_get_credentials(const char *username, const char *password, int64_t *user_id) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!username || !password ||
+        compute_digest(ENTRY_CREDENTIALS, username, strlen(username), password, strlen(password), digest) != 0) {
+        return false;
+    }
+    return get_entry(ENTRY_CREDENTIALS, digest, user_id, NULL);
+}
+
+/**
+ * @brief Cache verified username and password credentials
+ */
+void auth_cache_put_credentials(const char *username, const char *password, int64_t user_id,
+                                uint64_t generation) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!username || !password ||
+        compute_digest(ENTRY_CREDENTIALS, username, strlen(username), password, strlen(password), digest) != 0) {
+        return;
+    }
+    put_entry(ENTRY_CREDENTIALS, digest, user_id, time(NULL) + AUTH_CACHE_TTL_SECONDS, NULL, generation);
+}
+
+/**
+ * @brief Look up a validated session token
+ */
+bool auth_cache_get_session(const char *token, int64_t *user_id) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!token || compute_digest(ENTRY_SESSION, token, strlen(token), NULL, 0, digest) != 0) {
+        return false;
+    }
+    return get_entry(ENTRY_SESSION, digest, user_id, NULL);
+}
+
+/**
+ * @brief Cache a validated session token
+ */
+void auth_cache_put_session(const char *token, int64_t user_id, time_t expires_at,
+                            uint64_t generation) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!token || compute_digest(ENTRY_SESSION, token, strlen(token), NULL, 0, digest) != 0) {
+        return;
+    }
+
+    time_t ttl_expiry = time(NULL) + AUTH_CACHE_TTL_SECONDS;
+    put_entry(ENTRY_SESSION, digest, user_id, expires_at < ttl_expiry ? expires_at : ttl_expiry,
+              NULL, generation);
+}
+
+/**
+ * @brief Look up a user by API key
+ */
+bool auth_cache_get_api_key(const char *api_key, user_t *user) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!api_key || compute_digest(ENTRY_API_KEY, api_key, strlen(api_key), NULL, 0, digest) != 0) {
+        return false;
+    }
+    if (!get_entry(ENTRY_API_KEY, digest, NULL, user)) {
+        return false;
+    }
+
+    // The key itself is not cached, it is the one that was looked up
+    strncpy(user->api_key, api_key, sizeof(user->api_key) - 1);
+    user->api_key[sizeof(user->api_key) - 1] = '\0';
+    return true;
+}
+
+/**
+ * @brief Cache the user of an API key
+ */
+void auth_cache_put_api_key(const char *api_key, const user_t *user, uint64_t generation) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!api_key || !user ||
+        compute_digest(ENTRY_API_KEY, api_key, strlen(api_key), NULL, 0, digest) != 0) {
+        return;
+    }
+    put_entry(ENTRY_API_KEY, digest, user->id, time(NULL) + AUTH_CACHE_TTL_SECONDS, user, generation);
+}
+
+/**
+ * @brief Look up a user by ID
+ */
+bool auth_cache_get_user(int64_t user_id, user_t *user) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (compute_digest(ENTRY_USER, &user_id, sizeof(user_id), NULL, 0, digest) != 0) {
+        return false;
+    }
+    return get_entry(ENTRY_USER, digest, NULL, user);
+}
+
+/**
+ * @brief Cache a user
+ */
+void auth_cache_put_user(const user_t *user, uint64_t generation) {
+    unsigned char digest[DIGEST_LENGTH];
+    if (!user || compute_digest(ENTRY_USER, &user->id, sizeof(user->id), NULL, 0, digest) != 0) {
+        return;
+    }
+    put_entry(ENTRY_USER, digest, user->id, time(NULL) + AUTH_CACHE_TTL_SECONDS, user, generation);
+}
+
+/**
+ * @brief Drop a session token from the cache
+ */
+void auth_cache_invalidate_session(const char *token) {
+    unsigned char digest[DIGEST_LENGTH];
+    bool have_digest = token &&
+        compute_digest(ENTRY_SESSION, token, strlen(token), NULL, 0, digest) == 0;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    cache_generation++;
+    if (have_digest) {
+        auth_cache_entry_t *entry = find_entry(ENTRY_SESSION, digest, time(NULL));
+        if (entry) {
+            entry->kind = ENTRY_FREE;
+        }
+    } else {
+        // Without the digest the entry cannot be found, so drop all sessions
+        for (int i = 0; i < AUTH_CACHE_SIZE; i++) {
+            if (entries[i].kind == ENTRY_SESSION) {
+                entries[i].kind = ENTRY_FREE;
+            }
+        }
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/**
+ * @brief Drop every entry of a user
+ */
+void auth_cache_invalidate_user(int64_t user_id) {
+    pthread_mutex_lock(&cache_mutex);
+
+    cache_generation++;
+    for (int i = 0; i < AUTH_CACHE_SIZE; i++) {
+        if (entries[i].kind != ENTRY_FREE && entries[i].user_id == user_id) {
+            entries[i].kind = ENTRY_FREE;
+        }
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/**
+ * @brief Drop all entries
+ */
+void auth_cache_clear(void) {
+    pthread_mutex_lock(&cache_mutex);
+
+    cache_generation++;
+    for (int i = 0; i < AUTH_CACHE_SIZE; i++) {
+        entries[i].kind = ENTRY_FREE;
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+}
@@ -15,6 +15,7 @@
 #include <errno.h>
 #include <libgen.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <fcntl.h>
 #include <limits.h>
 
@@ -48,7 +49,146 @@ static bool wal_mode_enabled = false;
 // Flag to indicate if a backup is in progress
 static bool backup_in_progress = false;
 
-// No longer tracking prepared statements - each function is responsible for finalizing its own statements
+// Prepared statement cache of one connection, keyed by SQL text
+typedef struct {
+    char *sql;
+    sqlite3_stmt *stmt;
+    uint64_t last_used;
+    bool in_use;                // Handed out and not yet released
+} cached_stmt_t;
+
+typedef struct {
+    sqlite3 *conn;
+    cached_stmt_t stmts[DB_STMT_CACHE_SIZE];
+    uint64_t use_counter;
+    bool in_use;                // Reader connections only: leased by a thread
+} db_connection_t;
+
+// Statement cache of the main (writer) connection, protected by db_mutex
+static db_connection_t writer_connection = {0};
+
+// Read-only connections, only available in WAL mode
+static db_connection_t reader_pool[DB_READER_POOL_SIZE];
+static int reader_pool_size = 0;
+static pthread_mutex_t reader_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t reader_pool_cond = PTHREAD_COND_INITIALIZER;
+
+// Set while the pool closes, no more readers are leased
+static bool reader_pool_closing = false;
+
+// Find the statement cache of a connection
+static db_connection_t *find_connection(sqlite3 *conn) {
+    if (!conn) {
+        return NULL;
+    }
+    if (writer_connection.conn == conn) {
+        return &writer_connection;
+    }
+
+    // The slot stays valid while the caller holds the lease
+    db_connection_t *dc = NULL;
+    pthread_mutex_lock(&reader_pool_mutex);
+    for (int i = 0; i < reader_pool_size; i++) {
+        if (reader_pool[i].conn == conn) {
+            dc = &reader_pool[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&reader_pool_mutex);
+    return dc;
+}
+
+// Finalize and forget all cached statements of a connection
+static void clear_statement_cache(db_connection_t *dc) {
+    int count = 0;
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        if (dc->stmts[i].stmt) {
+            sqlite3_finalize(dc->stmts[i].stmt);
+            count++;
+        }
+        free(dc->stmts[i].sql);
+        dc->stmts[i].stmt = NULL;
+        dc->stmts[i].sql = NULL;
+        dc->stmts[i].last_used = 0;
+        dc->stmts[i].in_use = false;
+    }
+    if (count > 0) {
+        log_info("Finalized %d cached prepared statements", count);
+    }
+}
+
+// Open the read-only connection pool used for queries that do not need the writer
+static void open_reader_pool(const char *db_path) {
+    pthread_mutex_lock(&reader_pool_mutex);
+    for (int i = 0; i < DB_READER_POOL_SIZE; i++) {
+        sqlite3 *conn = NULL;
+        // Private cache: shared-cache connections would block on the writer's table locks
+        int rc = sqlite3_open_v2(db_path, &conn,
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX |
+                                 SQLITE_OPEN_PRIVATECACHE,
+                                 NULL);
+        if (rc != SQLITE_OK) {
+            log_warn("Failed to open read-only database connection: %s",
+                     conn ? sqlite3_errmsg(conn) : "unknown error");
+            if (conn) {
+                sqlite3_close_v2(conn);
+            }
+            break;
+        }
+
+        sqlite3_busy_timeout(conn, 10000);
+        // Keep the per-reader page cache small (512 KB)
+        sqlite3_exec(conn, "PRAGMA cache_size=-512;", NULL, NULL, NULL);
+
+        memset(&reader_pool[i], 0, sizeof(reader_pool[i]));
+        reader_pool[i].conn = conn;
+        reader_pool_size++;
+    }
+    pthread_mutex_unlock(&reader_pool_mutex);
+
+    log_info("Opened %d read-only database connections", reader_pool_size);
+}
+
+// Close the read-only connection pool once every leased connection is returned
+static void close_reader_pool(void) {
+    pthread_mutex_lock(&reader_pool_mutex);
+
+    // New callers fall back to the writer while the leases drain
+    reader_pool_closing = true;
+    pthread_cond_broadcast(&reader_pool_cond);
+
+    struct timespec timeout;
+    clock_gettime(CLOCK_REALTIME, &timeout);
+    timeout.tv_sec += 5;
+
+    // A leased connection may be in the middle of a step, it cannot be closed under it
+    for (int i = 0; i < reader_pool_size; i++) {
+        bool warned = false;
+        while (reader_pool[i].in_use) {
+            if (warned) {
+                pthread_cond_wait(&reader_pool_cond, &reader_pool_mutex);
+            } else if (pthread_cond_timedwait(&reader_pool_cond, &reader_pool_mutex, &timeout) == ETIMEDOUT) {
+                log_warn("Read-only database connection %d still in use at shutdown, waiting for it", i);
+                warned = true;
+            }
+        }
+    }
+
+    int count = reader_pool_size;
+    reader_pool_size = 0;
+    for (int i = 0; i < count; i++) {
+        clear_statement_cache(&reader_pool[i]);
+        sqlite3_close_v2(reader_pool[i].conn);
+        memset(&reader_pool[i], 0, sizeof(reader_pool[i]));
+    }
+    reader_pool_closing = false;
+
+    pthread_mutex_unlock(&reader_pool_mutex);
+
+    if (count > 0) {
+        log_info("Closed %d read-only database connections", count);
+    }
+}
 
 // Create directory if it doesn't exist
 static int create_directory(const char *path) {
@@ -575,6 +715,14 @@ int init_database(const char *db_path) {
         return -1;
     }
 
+    // Cache prepared statements of the main connection
+    writer_connection.conn = db;
+
+    // Readers can only run alongside the writer in WAL mode
+    if (wal_mode_enabled) {
+        open_reader_pool(db_path);
+    }
+
     log_info("Database initialized successfully");
 
     // Create an initial backup if this is a new database
@@ -626,6 +774,9 @@ void shutdown_database(void) {
     // by waiting a bit longer before acquiring the mutex
     usleep(500000);  // 500ms to allow in-flight operations to complete
 
+    // Close the read-only connections before the main connection
+    close_reader_pool();
+
     // Use a try-lock first to avoid deadlocks if the mutex is already locked
     int lock_result = pthread_mutex_trylock(&db_mutex);
 
@@ -670,7 +821,9 @@ void shutdown_database(void) {
             }
         }
 
-        // No longer using tracked statements - we now rely on sqlite3_next_stmt to find all statements
+        // Cached statements are finalized through the cache so it holds no stale pointers
+        clear_statement_cache(&writer_connection);
+        writer_connection.conn = NULL;
 
         // Finalize all prepared statements before closing the database
         // This helps prevent "corrupted size vs. prev_size in fastbins" errors
@@ -777,4 +930,139 @@ pthread_mutex_t *get_db_mutex(void) {
     return &db_mutex;
 }
 
+// Get a prepared statement from the statement cache of a connection
+int db_prepare_cached(sqlite3 *conn, const char *sql, sqlite3_stmt **stmt) {
+    if (!conn || !sql || !stmt) {
+        return SQLITE_MISUSE;
+    }
+
+    *stmt = NULL;
+
+    db_connection_t *dc = find_connection(conn);
+    if (!dc) {
+        // Not a pooled connection, behave like sqlite3_prepare_v2
+        return sqlite3_prepare_v2(conn, sql, -1, stmt, NULL);
+    }
+
+    dc->use_counter++;
+
+    // Look for a cached statement and the slot to reuse if there is none
+    int victim = -1;
+    bool busy = false;
+    for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+        cached_stmt_t *entry = &dc->stmts[i];
+        if (entry->sql && strcmp(entry->sql, sql) == 0) {
+            if (entry->in_use) {
+                // Still held, e.g. by an outer query with the same SQL
+                busy = true;
+                break;
+            }
+            entry->in_use = true;
+            entry->last_used = dc->use_counter;
+            *stmt = entry->stmt;
+            return SQLITE_OK;
+        }
+        // Statements that are handed out are never evicted
+        if (!entry->in_use && (victim < 0 || entry->last_used < dc->stmts[victim].last_used)) {
+            victim = i;
+        }
+    }
+
+    int rc = sqlite3_prepare_v2(conn, sql, -1, stmt, NULL);
+    if (rc != SQLITE_OK || busy || victim < 0) {
+        // Uncached statements are finalized by db_release_statement()
+        return rc;
+    }
+
+    char *key = strdup(sql);
+    if (!key) {
+        return SQLITE_OK;
+    }
+
+    // Evict the least recently used statement (empty slots have last_used 0)
+    cached_stmt_t *entry = &dc->stmts[victim];
+    if (entry->stmt) {
+        sqlite3_finalize(entry->stmt);
+    }
+    free(entry->sql);
+
+    entry->sql = key;
+    entry->stmt = *stmt;
+    entry->last_used = dc->use_counter;
+    entry->in_use = true;
+
+    return SQLITE_OK;
+}
+
+// Return a statement obtained from db_prepare_cached()
+void db_release_statement(sqlite3_stmt *stmt) {
+    if (!stmt) {
+        return;
+    }
+
+    db_connection_t *dc = find_connection(sqlite3_db_handle(stmt));
+    if (dc) {
+        for (int i = 0; i < DB_STMT_CACHE_SIZE; i++) {
+            if (dc->stmts[i].stmt == stmt) {
+                sqlite3_reset(stmt);
+                sqlite3_clear_bindings(stmt);
+                dc->stmts[i].in_use = false;
+                return;
+            }
+        }
+    }
+
+    sqlite3_finalize(stmt);
+}
+
+// Lease a connection for read-only queries
+sqlite3 *db_acquire_reader(void) {
+    if (!db) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&reader_pool_mutex);
+    while (reader_pool_size > 0 && !reader_pool_closing) {
+        for (int i = 0; i < reader_pool_size; i++) {
+            if (!reader_pool[i].in_use) {
+                reader_pool[i].in_use = true;
+                pthread_mutex_unlock(&reader_pool_mutex);
+                return reader_pool[i].conn;
+            }
+        }
+        pthread_cond_wait(&reader_pool_cond, &reader_pool_mutex);
+    }
+    pthread_mutex_unlock(&reader_pool_mutex);
+
+    // No reader pool (not in WAL mode or closing), use the main connection
+    pthread_mutex_lock(&db_mutex);
+    if (!db) {
+        pthread_mutex_unlock(&db_mutex);
+        return NULL;
+    }
+    return db;
+}
+
+// Return a connection obtained from db_acquire_reader()
+void db_release_reader(sqlite3 *conn) {
+    if (!conn) {
+        return;
+    }
+
+    if (conn == writer_connection.conn || conn == db) {
+        pthread_mutex_unlock(&db_mutex);
+        return;
+    }
+
+    pthread_mutex_lock(&reader_pool_mutex);
+    for (int i = 0; i < reader_pool_size; i++) {
+        if (reader_pool[i].conn == conn) {
+            reader_pool[i].in_use = false;
+            break;
+        }
+    }
+    pthread_cond_broadcast(&reader_pool_cond);
+    pthread_mutex_unlock(&reader_pool_mutex);
+}
+
 // These functions have been moved to db_backup.c
@@ -0,0 +1,283 @@
+/**
+ * Detection Ingest Queue
+ *
+ * Detection threads append rows to a bounded in-memory ring and return at once.
+ * A single background thread drains the ring and writes up to
+ * DETECTION_INGEST_BATCH_ROWS rows per transaction, either when a full batch is
+ * queued or when the oldest row has waited DETECTION_INGEST_FLUSH_MS. On shutdown
+ * the thread writes everything still queued before exiting.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <time.h>
+#include <errno.h>
+
+#include "core/logger.h"
+#include "core/shutdown_coordinator.h"
+#include "database/db_detections.h"
+#include "database/db_detection_ingest.h"
+
+typedef struct {
+    detection_row_t row;
+    uint64_t enqueue_ms;
+} queued_row_t;
+
+// Ingest state, protected by mutex
+static struct {
+    pthread_t thread;
+    bool running;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int component_id;
+
+    queued_row_t rows[DETECTION_INGEST_MAX_ROWS];
+    int head;
+    int count;
+
+    detection_ingest_stats_t stats;
+} ingest = {
+    .running = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .cond = PTHREAD_COND_INITIALIZER,
+    .component_id = -1,
+};
+
+// Batch being written, only used by the ingest thread
+static detection_row_t batch[DETECTION_INGEST_BATCH_ROWS];
+
+static uint64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000 + (uint64_t)ts.tv_nsec / 1000000;
+}
+
+/**
+ * Wait until a batch is due: a full batch is queued, the oldest row is older than
+ * the flush interval, or the thread is stopping. Called with the mutex held.
+ */
+static void wait_for_batch(void) {
+    while (ingest.running && ingest.count == 0) {
+        pthread_cond_wait(&ingest.cond, &ingest.mutex);
+    }
+
+    while (ingest.running && ingest.count > 0 && ingest.count < DETECTION_INGEST_BATCH_ROWS &&
+           !is_shutdown_initiated()) {
+        uint64_t age = now_ms() - ingest.rows[ingest.head].enqueue_ms;
+        if (age >= DETECTION_INGEST_FLUSH_MS) {
+            break;
+        }
+
+        uint64_t wait_ms = DETECTION_INGEST_FLUSH_MS - age;
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += (time_t)(wait_ms / 1000);
+        deadline.tv_nsec += (long)(wait_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&ingest.cond, &ingest.mutex, &deadline);
+    }
+}
+
+/**
+ * Ingest thread function
+ */
+static void *ingest_thread_func(void *arg) {
+    (void)arg;
+
+    log_info("Detection ingest thread started");
+
+    pthread_mutex_lock(&ingest.mutex);
+    while (true) {
+        wait_for_batch();
+
+        if (ingest.count == 0) {
+            // Only reached when stopping with an empty queue
+            break;
+        }
+
+        // Move the oldest rows into the batch buffer
+        int n = ingest.count < DETECTION_INGEST_BATCH_ROWS ? ingest.count : DETECTION_INGEST_BATCH_ROWS;
+        uint64_t oldest_ms = ingest.rows[ingest.head].enqueue_ms;
+        for (int i = 0; i < n; i++) {
+            batch[i] = ingest.rows[ingest.head].row;
+            ingest.head = (ingest.head + 1) % DETECTION_INGEST_MAX_ROWS;
+        }
+        ingest.count -= n;
+        pthread_mutex_unlock(&ingest.mutex);
+
+        uint64_t start_ms = now_ms();
+        int rc = store_detection_rows_in_db(batch, n);
+        uint64_t end_ms = now_ms();
+
+        pthread_mutex_lock(&ingest.mutex);
+        detection_ingest_stats_t *stats = &ingest.stats;
+        stats->last_commit_ms = (double)(end_ms - start_ms);
+        if (rc == 0) {
+            stats->rows_written += (uint64_t)n;
+            stats->batches_written++;
+            stats->last_batch_rows = n;
+            if (n > stats->max_batch_rows) {
+                stats->max_batch_rows = n;
+            }
+            stats->avg_batch_rows = (double)stats->rows_written / (double)stats->batches_written;
+            stats->last_lag_ms = (double)(end_ms - oldest_ms);
+            if (stats->last_lag_ms > stats->max_lag_ms) {
+                stats->max_lag_ms = stats->last_lag_ms;
+            }
+        } else {
+            stats->failed_batches++;
+            log_error("Failed to write batch of %d detections, dropping it", n);
+        }
+    }
+    pthread_mutex_unlock(&ingest.mutex);
+
+    if (ingest.component_id >= 0) {
+        update_component_state(ingest.component_id, COMPONENT_STOPPED);
+    }
+
+    log_info("Detection ingest thread exiting");
+    return NULL;
+}
+
+/**
+ * Start the detection ingest thread
+ */
+int start_detection_ingest_thread(void) {
+    pthread_mutex_lock(&ingest.mutex);
+
+    // Check if thread is already running
+    if (ingest.running) {
+        log_warn("Detection ingest thread is already running");
+        pthread_mutex_unlock(&ingest.mutex);
+        return 0;
+    }
+
+    ingest.head = 0;
+    ingest.count = 0;
+    memset(&ingest.stats, 0, sizeof(ingest.stats));
+    ingest.running = true;
+
+    // Create thread
+    if (pthread_create(&ingest.thread, NULL, ingest_thread_func, NULL) != 0) {
+        log_error("Failed to create detection ingest thread");
+        ingest.running = false;
+        pthread_mutex_unlock(&ingest.mutex);
+        return -1;
+    }
+
+    pthread_mutex_unlock(&ingest.mutex);
+
+    // Stopped late so it can flush rows from the detection threads
+    ingest.component_id = register_component("detection_ingest", COMPONENT_OTHER, NULL, 20);
+
+    log_info("Detection ingest thread started (batch %d rows / %d ms, queue %d rows)",
+             DETECTION_INGEST_BATCH_ROWS, DETECTION_INGEST_FLUSH_MS, DETECTION_INGEST_MAX_ROWS);
+    return 0;
+}
+
+/**
+ * Stop the detection ingest thread
+ */
+int stop_detection_ingest_thread(void) {
+    pthread_mutex_lock(&ingest.mutex);
+
+    // Check if thread is running
+    if (!ingest.running) {
+        pthread_mutex_unlock(&ingest.mutex);
+        return 0;
+    }
+
+    // Signal thread to flush and stop
+    int pending = ingest.count;
+    ingest.running = false;
+    pthread_cond_broadcast(&ingest.cond);
+    pthread_mutex_unlock(&ingest.mutex);
+
+    if (pending > 0) {
+        log_info("Flushing %d queued detections", pending);
+    }
+
+    // Wait for thread to exit
+    if (pthread_join(ingest.thread, NULL) != 0) {
+        log_error("Failed to join detection ingest thread");
+        return -1;
+    }
+
+    log_info("Detection ingest thread stopped");
+    return 0;
+}
+
+/**
+ * Queue detection results for writing
+ */
+int detection_ingest_enqueue(const char *stream_name, const detection_result_t *result, time_t timestamp) {
+    if (!stream_name || !result || result->count <= 0) {
+        return -1;
+    }
+
+    if (strlen(stream_name) >= sizeof(((detection_row_t *)0)->stream_name)) {
+        return -1;
+    }
+
+    int count = result->count > MAX_DETECTIONS ? MAX_DETECTIONS : result->count;
+
+    pthread_mutex_lock(&ingest.mutex);
+
+    if (!ingest.running) {
+        pthread_mutex_unlock(&ingest.mutex);
+        return -1;
+    }
+
+    if (ingest.count + count > DETECTION_INGEST_MAX_ROWS) {
+        // Keep memory bounded, the caller writes these rows itself
+        ingest.stats.overflow_rows += (uint64_t)count;
+        pthread_mutex_unlock(&ingest.mutex);
+        log_warn("Detection ingest queue full, writing %d detections for %s directly",
+                 count, stream_name);
+        return -1;
+    }
+
+    uint64_t enqueue_ms = now_ms();
+    for (int i = 0; i < count; i++) {
+        queued_row_t *entry = &ingest.rows[(ingest.head + ingest.count) % DETECTION_INGEST_MAX_ROWS];
+        strcpy(entry->row.stream_name, stream_name);
+        entry->row.timestamp = timestamp;
+        entry->row.detection = result->detections[i];
+        entry->enqueue_ms = enqueue_ms;
+        ingest.count++;
+    }
+
+    // Wake the thread to start the flush timer or write a full batch
+    if (ingest.count == count || ingest.count >= DETECTION_INGEST_BATCH_ROWS) {
+        pthread_cond_signal(&ingest.cond);
+    }
+
+    pthread_mutex_unlock(&ingest.mutex);
+    return 0;
+}
+
+/**
+ * Get detection ingest metrics
+ */
+void get_detection_ingest_stats(detection_ingest_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&ingest.mutex);
+    *stats = ingest.stats;
+    stats->running = ingest.running ? 1 : 0;
+    stats->queued_rows = ingest.count;
+    stats->max_rows = DETECTION_INGEST_MAX_ROWS;
+    stats->lag_ms = ingest.count > 0 ?
+        (double)(now_ms() - ingest.rows[ingest.head].enqueue_ms) : 0.0;
+    pthread_mutex_unlock(&ingest.mutex);
+}
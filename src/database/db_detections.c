@@ -12,55 +12,25 @@
 
 #include "database/db_detections.h"
 #include "database/db_core.h"
+#include "database/db_detection_ingest.h"
+#include "database/db_timeline_index.h"
 #include "core/logger.h"
 #include "video/detection_result.h"
 
+// Set once the detections table is known to exist
+static bool detections_table_checked = false;
+
 /**
- * Store detection results in the database
- * 
- * @param stream_name Stream name
- * @param result Detection results
- * @param timestamp Timestamp of the detection (0 for current time)
- * @return 0 on success, non-zero on failure
+ * Make sure the detections table exists, recreating it if needed.
+ * Must be called with the database mutex held.
  */
-int store_detections_in_db(const char *stream_name, const detection_result_t *result, time_t timestamp) {
+static int ensure_detections_table(sqlite3 *db) {
     int rc;
-    sqlite3_stmt *stmt;
-    
-    sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
-    
-    if (!db) {
-        log_error("Database not initialized when trying to store detections");
-        return -1;
-    }
-    
-    if (!stream_name || !result) {
-        log_error("Invalid parameters for store_detections_in_db: stream_name=%p, result=%p", 
-                 stream_name, result);
-        return -1;
-    }
-    
-    // Use current time if timestamp is 0
-    if (timestamp == 0) {
-        timestamp = time(NULL);
-    }
-    
-    log_info("Storing %d detections in database for stream %s", result->count, stream_name);
-    
-    // Log the first detection for debugging
-    if (result->count > 0) {
-        log_info("First detection: %s (%.2f%%) at [%.2f, %.2f, %.2f, %.2f]",
-                result->detections[0].label,
-                result->detections[0].confidence * 100.0f,
-                result->detections[0].x,
-                result->detections[0].y,
-                result->detections[0].width,
-                result->detections[0].height);
+
+    if (detections_table_checked) {
+        return 0;
     }
-    
-    pthread_mutex_lock(db_mutex);
-    
+
     // Check if detections table exists
     char *err_msg = NULL;
     char **query_result;
@@ -72,7 +42,6 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
     if (rc != SQLITE_OK) {
         log_error("Failed to check if detections table exists: %s", err_msg);
         sqlite3_free(err_msg);
-        pthread_mutex_unlock(db_mutex);
         return -1;
     }
     
@@ -100,8 +69,7 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         if (rc != SQLITE_OK) {
             log_error("Failed to create detections table: %s", err_msg);
             sqlite3_free(err_msg);
-            pthread_mutex_unlock(db_mutex);
-            return -1;
+                return -1;
         }
         
         // Create indexes
@@ -113,13 +81,100 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         if (rc != SQLITE_OK) {
             log_error("Failed to create indexes: %s", err_msg);
             sqlite3_free(err_msg);
-            pthread_mutex_unlock(db_mutex);
-            return -1;
+                return -1;
         }
     } else {
         sqlite3_free_table(query_result);
     }
     
+    detections_table_checked = true;
+    return 0;
+}
+
+/**
+ * Store detection results in the database
+ * 
+ * @param stream_name Stream name
+ * @param result Detection results
+ * @param timestamp Timestamp of the detection (0 for current time)
+ * @return 0 on success, non-zero on failure
+ */
+int store_detections_in_db(const char *stream_name, const detection_result_t *result, time_t timestamp) {
+    if (!stream_name || !result) {
+        log_error("Invalid parameters for store_detections_in_db: stream_name=%p, result=%p", 
+                 stream_name, result);
+        return -1;
+    }
+    
+    // Use current time if timestamp is 0
+    if (timestamp == 0) {
+        timestamp = time(NULL);
+    }
+
+    if (result->count <= 0) {
+        return 0;
+    }
+    
+    // Log the first detection for debugging
+    log_debug("Storing %d detections for stream %s, first: %s (%.2f%%) at [%.2f, %.2f, %.2f, %.2f]",
+             result->count, stream_name,
+             result->detections[0].label,
+             result->detections[0].confidence * 100.0f,
+             result->detections[0].x,
+             result->detections[0].y,
+             result->detections[0].width,
+             result->detections[0].height);
+
+    // Normally the ingest thread writes the rows in its next batch
+    if (detection_ingest_enqueue(stream_name, result, timestamp) == 0) {
+        return 0;
+    }
+
+    // Ingest thread not running or its queue is full, write them now
+    detection_row_t rows[MAX_DETECTIONS];
+    int count = result->count > MAX_DETECTIONS ? MAX_DETECTIONS : result->count;
+    for (int i = 0; i < count; i++) {
+        strncpy(rows[i].stream_name, stream_name, sizeof(rows[i].stream_name) - 1);
+        rows[i].stream_name[sizeof(rows[i].stream_name) - 1] = '\0';
+        rows[i].timestamp = timestamp;
+        rows[i].detection = result->detections[i];
+    }
+
+    if (store_detection_rows_in_db(rows, count) != 0) {
+        return -1;
+    }
+
+    log_info("Successfully stored %d detections in database for stream %s", count, stream_name);
+    return 0;
+}
+
+/**
+ * Write detection rows to the database in a single transaction
+ */
+int store_detection_rows_in_db(const detection_row_t *rows, int count) {
+    int rc;
+    sqlite3_stmt *stmt;
+    char *err_msg = NULL;
+    
+    sqlite3 *db = get_db_handle();
+    pthread_mutex_t *db_mutex = get_db_mutex();
+    
+    if (!db) {
+        log_error("Database not initialized when trying to store detections");
+        return -1;
+    }
+
+    if (!rows || count <= 0) {
+        return 0;
+    }
+    
+    pthread_mutex_lock(db_mutex);
+
+    if (ensure_detections_table(db) != 0) {
+        pthread_mutex_unlock(db_mutex);
+        return -1;
+    }
+    
     // Begin transaction for better performance when inserting multiple detections
     rc = sqlite3_exec(db, "BEGIN TRANSACTION;", NULL, NULL, &err_msg);
     if (rc != SQLITE_OK) {
@@ -132,33 +187,37 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
     const char *sql = "INSERT INTO detections (stream_name, timestamp, label, confidence, x, y, width, height, track_id, zone_id) "
                       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
         sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+        // The table may have been dropped, check again next time
+        detections_table_checked = false;
         pthread_mutex_unlock(db_mutex);
         return -1;
     }
 
     // Insert each detection
-    for (int i = 0; i < result->count; i++) {
+    for (int i = 0; i < count; i++) {
+        const detection_t *det = &rows[i].detection;
+
         // Bind parameters
-        sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)timestamp);
-        sqlite3_bind_text(stmt, 3, result->detections[i].label, -1, SQLITE_STATIC);
-        sqlite3_bind_double(stmt, 4, result->detections[i].confidence);
-        sqlite3_bind_double(stmt, 5, result->detections[i].x);
-        sqlite3_bind_double(stmt, 6, result->detections[i].y);
-        sqlite3_bind_double(stmt, 7, result->detections[i].width);
-        sqlite3_bind_double(stmt, 8, result->detections[i].height);
-        sqlite3_bind_int(stmt, 9, result->detections[i].track_id);
-        sqlite3_bind_text(stmt, 10, result->detections[i].zone_id, -1, SQLITE_STATIC);
+        sqlite3_bind_text(stmt, 1, rows[i].stream_name, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)rows[i].timestamp);
+        sqlite3_bind_text(stmt, 3, det->label, -1, SQLITE_STATIC);
+        sqlite3_bind_double(stmt, 4, det->confidence);
+        sqlite3_bind_double(stmt, 5, det->x);
+        sqlite3_bind_double(stmt, 6, det->y);
+        sqlite3_bind_double(stmt, 7, det->width);
+        sqlite3_bind_double(stmt, 8, det->height);
+        sqlite3_bind_int(stmt, 9, det->track_id);
+        sqlite3_bind_text(stmt, 10, det->zone_id, -1, SQLITE_STATIC);
         
         // Execute statement
         rc = sqlite3_step(stmt);
         if (rc != SQLITE_DONE) {
             log_error("Failed to insert detection %d: %s", i, sqlite3_errmsg(db));
-            sqlite3_finalize(stmt);
+            db_release_statement(stmt);
             sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
             pthread_mutex_unlock(db_mutex);
             return -1;
@@ -169,8 +228,7 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         sqlite3_clear_bindings(stmt);
     }
     
-    // Untrack and finalize the prepared statement
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     
     // Commit transaction
     rc = sqlite3_exec(db, "COMMIT;", NULL, NULL, &err_msg);
@@ -182,25 +240,12 @@ int store_detections_in_db(const char *stream_name, const detection_result_t *re
         return -1;
     }
     
-    // Verify the detections were stored
-    char verify_sql[256];
-    snprintf(verify_sql, sizeof(verify_sql), 
-            "SELECT COUNT(*) FROM detections WHERE stream_name = '%s' AND timestamp = %lld;",
-            stream_name, (long long)timestamp);
-    
-    rc = sqlite3_get_table(db, verify_sql, &query_result, &rows, &cols, &err_msg);
-    if (rc != SQLITE_OK) {
-        log_error("Failed to verify detections were stored: %s", err_msg);
-        sqlite3_free(err_msg);
-    } else if (rows > 0 && cols > 0) {
-        int count = atoi(query_result[1]); // First row, first column
-        log_info("Verified %d detections were stored in database for stream %s", count, stream_name);
-        sqlite3_free_table(query_result);
-    }
-    
     pthread_mutex_unlock(db_mutex);
-    
-    log_info("Successfully stored %d detections in database for stream %s", result->count, stream_name);
+
+    for (int i = 0; i < count; i++) {
+        timeline_index_add_detection(rows[i].stream_name, rows[i].timestamp);
+    }
+
     return 0;
 }
 
@@ -220,7 +265,6 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
     sqlite3_stmt *stmt;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -235,7 +279,11 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
     // Initialize result
     memset(result, 0, sizeof(detection_result_t));
     
-    pthread_mutex_lock(db_mutex);
+    db = db_acquire_reader();
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
     
     // Build query based on filters
     char sql[512];
@@ -252,10 +300,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -276,10 +324,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -299,10 +347,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -326,10 +374,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
 
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
 
@@ -348,10 +396,10 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -390,8 +438,8 @@ int get_detections_from_db_time_range(const char *stream_name, detection_result_
     
     result->count = count;
 
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_release_statement(stmt);
+    db_release_reader(db);
     
     log_info("Found %d detections in database for stream %s", count, stream_name);
     return count;
@@ -414,7 +462,6 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
     sqlite3_stmt *stmt;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -426,7 +473,11 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
+    db = db_acquire_reader();
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
     
     // Build query based on filters
     char sql[512];
@@ -440,10 +491,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
 
@@ -461,10 +512,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -481,10 +532,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -505,10 +556,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -525,10 +576,10 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
                 "ORDER BY timestamp DESC "
                 "LIMIT ?;");
         
-        rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+        rc = db_prepare_cached(db, sql, &stmt);
         if (rc != SQLITE_OK) {
             log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-            pthread_mutex_unlock(db_mutex);
+            db_release_reader(db);
             return -1;
         }
         
@@ -568,8 +619,8 @@ int get_detection_timestamps(const char *stream_name, detection_result_t *result
         count++;
     }
     
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_release_statement(stmt);
+    db_release_reader(db);
     
     return 0;
 }
@@ -601,7 +652,6 @@ int has_detections_in_time_range(const char *stream_name, time_t start_time, tim
     int has_detections = 0;
 
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
 
     if (!db) {
         log_error("Database not initialized");
@@ -616,15 +666,19 @@ int has_detections_in_time_range(const char *stream_name, time_t start_time, tim
     log_info("Checking for detections: stream=%s, start=%lld, end=%lld",
              stream_name, (long long)start_time, (long long)end_time);
 
-    pthread_mutex_lock(db_mutex);
+    db = db_acquire_reader();
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
 
     // Use EXISTS for efficiency - stops at first match
     const char *sql = "SELECT EXISTS(SELECT 1 FROM detections WHERE stream_name = ? AND timestamp >= ? AND timestamp <= ? LIMIT 1);";
 
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+        db_release_reader(db);
         return -1;
     }
 
@@ -638,13 +692,13 @@ int has_detections_in_time_range(const char *stream_name, time_t start_time, tim
         log_info("Detection check result for stream %s: %d", stream_name, has_detections);
     } else {
         log_error("Failed to check for detections: %s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
-        pthread_mutex_unlock(db_mutex);
+        db_release_statement(stmt);
+        db_release_reader(db);
         return -1;
     }
 
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_release_statement(stmt);
+    db_release_reader(db);
 
     return has_detections;
 }
@@ -672,7 +726,7 @@ int delete_old_detections(uint64_t max_age) {
     
     const char *sql = "DELETE FROM detections WHERE timestamp < ?;";
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
         pthread_mutex_unlock(db_mutex);
@@ -689,7 +743,7 @@ int delete_old_detections(uint64_t max_age) {
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         log_error("Failed to delete old detections: %s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+        db_release_statement(stmt);
         pthread_mutex_unlock(db_mutex);
         return -1;
     }
@@ -697,8 +751,12 @@ int delete_old_detections(uint64_t max_age) {
     deleted_count = sqlite3_changes(db);
     
     // finalize the prepared statement
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
+
+    if (deleted_count > 0) {
+        timeline_index_invalidate_all();
+    }
     
     log_info("Deleted %d old detections from database", deleted_count);
     return deleted_count;
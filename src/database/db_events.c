@@ -38,7 +38,7 @@ uint64_t add_event(event_type_t type, const char *stream_name,
     const char *sql = "INSERT INTO events (type, timestamp, stream_name, description, details) "
                       "VALUES (?, ?, ?, ?, ?);";
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
         pthread_mutex_unlock(db_mutex);
@@ -73,7 +73,7 @@ uint64_t add_event(event_type_t type, const char *stream_name,
     }
     
     // finalize the prepared statement
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
     
     return event_id;
@@ -87,7 +87,6 @@ int get_events(time_t start_time, time_t end_time, int type,
     int count = 0;
     
     sqlite3 *db = get_db_handle();
-    pthread_mutex_t *db_mutex = get_db_mutex();
     
     if (!db) {
         log_error("Database not initialized");
@@ -99,7 +98,11 @@ int get_events(time_t start_time, time_t end_time, int type,
         return -1;
     }
     
-    pthread_mutex_lock(db_mutex);
+    db = db_acquire_reader();
+    if (!db) {
+        log_error("Database not initialized");
+        return -1;
+    }
     
     // Build query based on filters
     char sql[1024];
@@ -123,10 +126,10 @@ int get_events(time_t start_time, time_t end_time, int type,
     
     strcat(sql, " ORDER BY timestamp DESC LIMIT ?;");
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-        pthread_mutex_unlock(db_mutex);
+        db_release_reader(db);
         return -1;
     }
     
@@ -185,8 +188,8 @@ int get_events(time_t start_time, time_t end_time, int type,
     }
     
     // finalize the prepared statement
-    sqlite3_finalize(stmt);
-    pthread_mutex_unlock(db_mutex);
+    db_release_statement(stmt);
+    db_release_reader(db);
     
     log_info("Found %d events in database matching criteria", count);
     return count;
@@ -210,7 +213,7 @@ int delete_old_events(uint64_t max_age) {
     
     const char *sql = "DELETE FROM events WHERE timestamp < ?;";
     
-    rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    rc = db_prepare_cached(db, sql, &stmt);
     if (rc != SQLITE_OK) {
         log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
         pthread_mutex_unlock(db_mutex);
@@ -227,7 +230,7 @@ int delete_old_events(uint64_t max_age) {
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
         log_error("Failed to delete old events: %s", sqlite3_errmsg(db));
-        sqlite3_finalize(stmt);
+        db_release_statement(stmt);
         pthread_mutex_unlock(db_mutex);
         return -1;
     }
@@ -235,7 +238,7 @@ int delete_old_events(uint64_t max_age) {
     deleted_count = sqlite3_changes(db);
     
     // finalize the prepared statement
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
     
     return deleted_count;
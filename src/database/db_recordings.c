@@ -13,6 +13,8 @@
 #include "core/logger.h"
 #include "database/db_core.h"
 #include "database/db_recordings.h"
+#include "database/db_recordings_sync.h"
+#include "database/db_timeline_index.h"
 
 // Add recording metadata to the database
 uint64_t add_recording_metadata(const recording_metadata_t *metadata) {
@@ -40,7 +42,7 @@ uint64_t add_recording_metadata(const recording_metadata_t *metadata) {
       "size_bytes, width, height, fps, codec, is_complete, trigger_type) "
       "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -85,9 +87,19 @@ uint64_t add_recording_metadata(const recording_metadata_t *metadata) {
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
+  if (recording_id != 0 && metadata->is_complete && metadata->end_time > 0) {
+    timeline_index_add_recording(metadata->stream_name, metadata->start_time,
+                                 metadata->end_time);
+  }
+
+  // The file keeps growing until its writer reports the final size
+  if (recording_id != 0 && !metadata->is_complete) {
+    recording_sync_mark_dirty(recording_id);
+  }
+
   return recording_id;
 }
 
@@ -111,7 +123,7 @@ int update_recording_metadata(uint64_t id, time_t end_time, uint64_t size_bytes,
       "UPDATE recordings SET end_time = ?, size_bytes = ?, is_complete = ? "
       "WHERE id = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -131,15 +143,31 @@ int update_recording_metadata(uint64_t id, time_t end_time, uint64_t size_bytes,
   rc = sqlite3_step(stmt);
   if (rc != SQLITE_DONE) {
     log_error("Failed to update recording metadata: %s", sqlite3_errmsg(db));
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
     return -1;
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
+  // A completed recording with a size needs no further file size sync
+  if (is_complete && size_bytes > 0) {
+    recording_sync_mark_clean(id);
+  } else {
+    recording_sync_mark_dirty(id);
+  }
+
+  // Add the finished recording to the cached timeline
+  if (is_complete) {
+    recording_metadata_t metadata;
+    if (get_recording_metadata_by_id(id, &metadata) == 0) {
+      timeline_index_add_recording(metadata.stream_name, metadata.start_time,
+                                   end_time);
+    }
+  }
+
   return 0;
 }
 
@@ -169,7 +197,7 @@ int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
       "size_bytes, width, height, fps, codec, is_complete, trigger_type "
       "FROM recordings WHERE id = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -239,7 +267,7 @@ int get_recording_metadata_by_id(uint64_t id, recording_metadata_t *metadata) {
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
   return result;
@@ -273,7 +301,7 @@ int get_recording_metadata_by_path(const char *file_path,
       "protected, retention_override_days "
       "FROM recordings WHERE file_path = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -345,7 +373,7 @@ int get_recording_metadata_by_path(const char *file_path,
     result = 0; // Success
   }
 
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
   return result;
@@ -360,7 +388,6 @@ int get_recording_metadata(time_t start_time, time_t end_time,
   int count = 0;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
 
   if (!db) {
     log_error("Database not initialized");
@@ -372,7 +399,11 @@ int get_recording_metadata(time_t start_time, time_t end_time,
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   // Build query based on filters
   char sql[1024];
@@ -401,10 +432,10 @@ int get_recording_metadata(time_t start_time, time_t end_time,
 
   strcat(sql, " ORDER BY start_time DESC LIMIT ?;");
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -487,8 +518,8 @@ int get_recording_metadata(time_t start_time, time_t end_time,
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   log_info("Found %d recordings in database matching criteria", count);
   return count;
@@ -502,14 +533,17 @@ int get_recording_count(time_t start_time, time_t end_time,
   int count = 0;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
 
   if (!db) {
     log_error("Database not initialized");
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   // Build query based on filters
   char sql[1024];
@@ -544,10 +578,10 @@ int get_recording_count(time_t start_time, time_t end_time,
 
   log_info("SQL query for get_recording_count: %s", sql);
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -578,8 +612,8 @@ int get_recording_count(time_t start_time, time_t end_time,
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   log_info("Total count of recordings matching criteria: %d", count);
   return count;
@@ -597,7 +631,6 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
   int count = 0;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
 
   if (!db) {
     log_error("Database not initialized");
@@ -609,7 +642,11 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   // Validate and sanitize sort field to prevent SQL injection
   char safe_sort_field[32] = "start_time"; // Default sort field
@@ -687,10 +724,10 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
 
   log_info("SQL query for get_recording_metadata_paginated: %s", sql);
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -786,8 +823,8 @@ int get_recording_metadata_paginated(time_t start_time, time_t end_time,
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   log_info(
       "Found %d recordings in database matching criteria (page %d, limit %d)",
@@ -808,11 +845,15 @@ int delete_recording_metadata(uint64_t id) {
     return -1;
   }
 
+  // Needed to update the cached timeline once the row is gone
+  recording_metadata_t metadata;
+  bool have_metadata = get_recording_metadata_by_id(id, &metadata) == 0;
+
   pthread_mutex_lock(db_mutex);
 
   const char *sql = "DELETE FROM recordings WHERE id = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -829,15 +870,22 @@ int delete_recording_metadata(uint64_t id) {
   rc = sqlite3_step(stmt);
   if (rc != SQLITE_DONE) {
     log_error("Failed to delete recording metadata: %s", sqlite3_errmsg(db));
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
     return -1;
   }
 
   // Finalize the prepared statement
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
+  recording_sync_mark_clean(id);
+
+  if (have_metadata) {
+    timeline_index_invalidate(metadata.stream_name, metadata.start_time,
+                              metadata.end_time);
+  }
+
   return 0;
 }
 
@@ -859,7 +907,7 @@ int delete_old_recording_metadata(uint64_t max_age) {
 
   const char *sql = "DELETE FROM recordings WHERE end_time < ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -877,16 +925,20 @@ int delete_old_recording_metadata(uint64_t max_age) {
   if (rc != SQLITE_DONE) {
     log_error("Failed to delete old recording metadata: %s",
               sqlite3_errmsg(db));
-    sqlite3_finalize(stmt);
+    db_release_statement(stmt);
     pthread_mutex_unlock(db_mutex);
     return -1;
   }
 
   deleted_count = sqlite3_changes(db);
 
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
+  if (deleted_count > 0) {
+    timeline_index_invalidate_all();
+  }
+
   return deleted_count;
 }
 
@@ -913,7 +965,7 @@ int set_recording_protected(uint64_t id, bool protected) {
 
   const char *sql = "UPDATE recordings SET protected = ? WHERE id = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -924,7 +976,7 @@ int set_recording_protected(uint64_t id, bool protected) {
   sqlite3_bind_int64(stmt, 2, (sqlite3_int64)id);
 
   rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
   if (rc != SQLITE_DONE) {
@@ -961,7 +1013,7 @@ int set_recording_retention_override(uint64_t id, int days) {
   const char *sql =
       "UPDATE recordings SET retention_override_days = ? WHERE id = ?;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
     pthread_mutex_unlock(db_mutex);
@@ -976,7 +1028,7 @@ int set_recording_retention_override(uint64_t id, int days) {
   sqlite3_bind_int64(stmt, 2, (sqlite3_int64)id);
 
   rc = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  db_release_statement(stmt);
   pthread_mutex_unlock(db_mutex);
 
   if (rc != SQLITE_DONE) {
@@ -1002,14 +1054,17 @@ int get_protected_recordings_count(const char *stream_name) {
   int count = -1;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
 
   if (!db) {
     log_error("Database not initialized");
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   const char *sql;
   if (stream_name) {
@@ -1019,10 +1074,10 @@ int get_protected_recordings_count(const char *stream_name) {
     sql = "SELECT COUNT(*) FROM recordings WHERE protected = 1;";
   }
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -1034,298 +1089,238 @@ int get_protected_recordings_count(const char *stream_name) {
     count = sqlite3_column_int(stmt, 0);
   }
 
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   return count;
 }
 
+// Rows retention may delete; the batch DELETE repeats it so a recording
+// protected after it was selected is kept
+#define RETENTION_DELETABLE "AND protected = 0 AND is_complete = 1 "
+
 /**
- * Get recordings eligible for deletion based on retention policy
- * Priority 1: Regular recordings past retention period
- * Priority 2: Detection recordings past detection retention period
- * Protected recordings are never returned
+ * Get a batch of recordings eligible for retention, oldest first
  *
- * @param stream_name Stream name to filter
- * @param retention_days Regular recordings retention in days
- * @param detection_retention_days Detection recordings retention in days
- * @param recordings Array to fill with recording metadata
+ * Walks the recordings of a stream in (start_time, id) order from a cursor, so
+ * a whole archive is visited batch by batch with each query starting where the
+ * previous one stopped. Protected and incomplete recordings are never returned.
+ *
+ * @param stream_name Stream name
+ * @param scan Which recordings to return
+ * @param cutoff Only recordings that started before this time are returned
+ *               (ignored for RETENTION_SCAN_QUOTA)
+ * @param cursor Position to continue from, advanced past the returned rows
+ * @param candidates Array to fill
  * @param max_count Maximum number of recordings to return
  * @return Number of recordings found, or -1 on error
  */
-int get_recordings_for_retention(const char *stream_name, int retention_days,
-                                 int detection_retention_days,
-                                 recording_metadata_t *recordings,
-                                 int max_count) {
+int get_retention_batch(const char *stream_name, retention_scan_t scan,
+                        time_t cutoff, retention_cursor_t *cursor,
+                        retention_candidate_t *candidates, int max_count) {
   int rc;
   sqlite3_stmt *stmt;
   int count = 0;
 
-  sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
-
-  if (!db) {
-    log_error("Database not initialized");
+  // ?1 stream, ?2 cutoff, ?3 cursor start_time, ?4 cursor id, ?5 now, ?6 limit.
+  // The (stream_name, start_time) index serves both the range and the order;
+  // id is the rowid and comes with the index.
+  static const char *const sql_by_scan[] = {
+      [RETENTION_SCAN_REGULAR] =
+          "SELECT id, file_path, start_time, end_time, size_bytes "
+          "FROM recordings "
+          "WHERE stream_name = ?1 AND start_time < ?2 "
+          "AND (start_time > ?3 OR (start_time = ?3 AND id > ?4)) "
+          RETENTION_DELETABLE
+          "AND trigger_type != 'detection' "
+          "AND (retention_override_days IS NULL "
+          "     OR start_time < ?5 - retention_override_days * 86400) "
+          "ORDER BY start_time ASC, id ASC "
+          "LIMIT ?6;",
+      [RETENTION_SCAN_DETECTION] =
+          "SELECT id, file_path, start_time, end_time, size_bytes "
+          "FROM recordings "
+          "WHERE stream_name = ?1 AND start_time < ?2 "
+          "AND (start_time > ?3 OR (start_time = ?3 AND id > ?4)) "
+          RETENTION_DELETABLE
+          "AND trigger_type = 'detection' "
+          "AND (retention_override_days IS NULL "
+          "     OR start_time < ?5 - retention_override_days * 86400) "
+          "ORDER BY start_time ASC, id ASC "
+          "LIMIT ?6;",
+      [RETENTION_SCAN_QUOTA] =
+          "SELECT id, file_path, start_time, end_time, size_bytes "
+          "FROM recordings "
+          "WHERE stream_name = ?1 "
+          "AND (start_time > ?3 OR (start_time = ?3 AND id > ?4)) "
+          RETENTION_DELETABLE
+          "ORDER BY start_time ASC, id ASC "
+          "LIMIT ?6;",
+  };
+
+  if (!stream_name || !cursor || !candidates || max_count <= 0 ||
+      scan < RETENTION_SCAN_REGULAR || scan > RETENTION_SCAN_QUOTA) {
+    log_error("Invalid parameters for get_retention_batch");
     return -1;
   }
 
-  if (!stream_name || !recordings || max_count <= 0) {
-    log_error("Invalid parameters for get_recordings_for_retention");
+  sqlite3 *db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
     return -1;
   }
 
-  // Calculate cutoff times
-  time_t now = time(NULL);
-  time_t regular_cutoff =
-      (retention_days > 0) ? now - (retention_days * 86400) : 0;
-  time_t detection_cutoff = (detection_retention_days > 0)
-                                ? now - (detection_retention_days * 86400)
-                                : 0;
-
-  pthread_mutex_lock(db_mutex);
-
-  // Query for recordings past retention, ordered by priority (regular first,
-  // then detection) and by start_time (oldest first) Protected recordings are
-  // excluded Also exclude recordings with retention_override_days that haven't
-  // expired yet
-  const char *sql =
-      "SELECT id, stream_name, file_path, start_time, end_time, "
-      "size_bytes, width, height, fps, codec, is_complete, trigger_type, "
-      "protected, retention_override_days "
-      "FROM recordings "
-      "WHERE stream_name = ? "
-      "AND protected = 0 "
-      "AND is_complete = 1 "
-      "AND ("
-      "  (trigger_type != 'detection' AND ? > 0 AND start_time < ?) "
-      "  OR "
-      "  (trigger_type = 'detection' AND ? > 0 AND start_time < ?)"
-      ") "
-      "AND ("
-      "  retention_override_days IS NULL "
-      "  OR start_time < (strftime('%s', 'now') - retention_override_days * "
-      "86400)"
-      ") "
-      "ORDER BY "
-      "  CASE WHEN trigger_type = 'detection' THEN 1 ELSE 0 END ASC, "
-      "  start_time ASC "
-      "LIMIT ?;";
-
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql_by_scan[scan], &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
+  // Bound once instead of evaluating strftime('%s', 'now') for every row
+  time_t now = time(NULL);
+
   sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-  sqlite3_bind_int(stmt, 2, retention_days);
-  sqlite3_bind_int64(stmt, 3, (sqlite3_int64)regular_cutoff);
-  sqlite3_bind_int(stmt, 4, detection_retention_days);
-  sqlite3_bind_int64(stmt, 5, (sqlite3_int64)detection_cutoff);
+  sqlite3_bind_int64(stmt, 2, (sqlite3_int64)cutoff);
+  sqlite3_bind_int64(stmt, 3, (sqlite3_int64)cursor->start_time);
+  sqlite3_bind_int64(stmt, 4, (sqlite3_int64)cursor->id);
+  sqlite3_bind_int64(stmt, 5, (sqlite3_int64)now);
   sqlite3_bind_int(stmt, 6, max_count);
 
-  while (sqlite3_step(stmt) == SQLITE_ROW && count < max_count) {
-    recordings[count].id = (uint64_t)sqlite3_column_int64(stmt, 0);
-
-    const char *stream = (const char *)sqlite3_column_text(stmt, 1);
-    if (stream) {
-      strncpy(recordings[count].stream_name, stream,
-              sizeof(recordings[count].stream_name) - 1);
-      recordings[count].stream_name[sizeof(recordings[count].stream_name) - 1] =
-          '\0';
-    } else {
-      recordings[count].stream_name[0] = '\0';
-    }
+  while (count < max_count && (rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+    retention_candidate_t *candidate = &candidates[count];
+    candidate->id = (uint64_t)sqlite3_column_int64(stmt, 0);
 
-    const char *path = (const char *)sqlite3_column_text(stmt, 2);
+    const char *path = (const char *)sqlite3_column_text(stmt, 1);
     if (path) {
-      strncpy(recordings[count].file_path, path,
-              sizeof(recordings[count].file_path) - 1);
-      recordings[count].file_path[sizeof(recordings[count].file_path) - 1] =
-          '\0';
-    } else {
-      recordings[count].file_path[0] = '\0';
-    }
-
-    recordings[count].start_time = (time_t)sqlite3_column_int64(stmt, 3);
-
-    if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) {
-      recordings[count].end_time = (time_t)sqlite3_column_int64(stmt, 4);
-    } else {
-      recordings[count].end_time = 0;
-    }
-
-    recordings[count].size_bytes = (uint64_t)sqlite3_column_int64(stmt, 5);
-    recordings[count].width = sqlite3_column_int(stmt, 6);
-    recordings[count].height = sqlite3_column_int(stmt, 7);
-    recordings[count].fps = sqlite3_column_int(stmt, 8);
-
-    const char *codec = (const char *)sqlite3_column_text(stmt, 9);
-    if (codec) {
-      strncpy(recordings[count].codec, codec,
-              sizeof(recordings[count].codec) - 1);
-      recordings[count].codec[sizeof(recordings[count].codec) - 1] = '\0';
+      strncpy(candidate->file_path, path, sizeof(candidate->file_path) - 1);
+      candidate->file_path[sizeof(candidate->file_path) - 1] = '\0';
     } else {
-      recordings[count].codec[0] = '\0';
+      candidate->file_path[0] = '\0';
     }
 
-    recordings[count].is_complete = sqlite3_column_int(stmt, 10) != 0;
+    candidate->start_time = (time_t)sqlite3_column_int64(stmt, 2);
+    candidate->end_time = sqlite3_column_type(stmt, 3) != SQLITE_NULL
+                              ? (time_t)sqlite3_column_int64(stmt, 3)
+                              : 0;
+    candidate->size_bytes = (uint64_t)sqlite3_column_int64(stmt, 4);
+    count++;
+  }
 
-    const char *trigger_type = (const char *)sqlite3_column_text(stmt, 11);
-    if (trigger_type) {
-      strncpy(recordings[count].trigger_type, trigger_type,
-              sizeof(recordings[count].trigger_type) - 1);
-      recordings[count]
-          .trigger_type[sizeof(recordings[count].trigger_type) - 1] = '\0';
-    } else {
-      strncpy(recordings[count].trigger_type, "scheduled",
-              sizeof(recordings[count].trigger_type) - 1);
-    }
+  if (count < max_count && rc != SQLITE_DONE) {
+    log_error("Failed to read retention batch: %s", sqlite3_errmsg(db));
+    db_release_statement(stmt);
+    db_release_reader(db);
+    return -1;
+  }
 
-    recordings[count].protected = sqlite3_column_int(stmt, 12) != 0;
+  db_release_statement(stmt);
+  db_release_reader(db);
 
-    if (sqlite3_column_type(stmt, 13) != SQLITE_NULL) {
-      recordings[count].retention_override_days = sqlite3_column_int(stmt, 13);
-    } else {
-      recordings[count].retention_override_days = -1;
-    }
-
-    count++;
+  if (count > 0) {
+    cursor->start_time = candidates[count - 1].start_time;
+    cursor->id = candidates[count - 1].id;
   }
 
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
-
   return count;
 }
 
 /**
- * Get recordings for quota enforcement (oldest unprotected first)
+ * Delete the rows of a batch of recordings in one transaction
  *
- * @param stream_name Stream name
- * @param recordings Array to fill with recording metadata
- * @param max_count Maximum number of recordings to return
- * @return Number of recordings found, or -1 on error
+ * @param stream_name Stream the recordings belong to
+ * @param candidates Recordings to delete
+ * @param count Number of recordings
+ * @return Number of rows deleted, or -1 on error (nothing is deleted)
  */
-int get_recordings_for_quota_enforcement(const char *stream_name,
-                                         recording_metadata_t *recordings,
-                                         int max_count) {
+int delete_recordings_batch(const char *stream_name,
+                            retention_candidate_t *candidates,
+                            int count) {
   int rc;
   sqlite3_stmt *stmt;
-  int count = 0;
+  int deleted = 0;
 
-  sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
+  if (!stream_name || !candidates || count < 0) {
+    log_error("Invalid parameters for delete_recordings_batch");
+    return -1;
+  }
+
+  if (count == 0) {
+    return 0;
+  }
 
+  sqlite3 *db = get_db_handle();
   if (!db) {
     log_error("Database not initialized");
     return -1;
   }
 
-  if (!stream_name || !recordings || max_count <= 0) {
-    log_error("Invalid parameters for get_recordings_for_quota_enforcement");
+  // Holds the database mutex until commit or rollback
+  if (begin_transaction() != 0) {
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
-
-  // Get oldest unprotected recordings first
-  // Order by protection status (unprotected first), then by start_time (oldest
-  // first)
-  const char *sql = "SELECT id, stream_name, file_path, start_time, end_time, "
-                    "size_bytes, width, height, fps, codec, is_complete, "
-                    "trigger_type, protected, retention_override_days "
-                    "FROM recordings "
-                    "WHERE stream_name = ? "
-                    "AND protected = 0 "
-                    "AND is_complete = 1 "
-                    "ORDER BY start_time ASC "
-                    "LIMIT ?;";
-
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db,
+                         "DELETE FROM recordings "
+                         "WHERE id = ? AND stream_name = ? " RETENTION_DELETABLE ";",
+                         &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    rollback_transaction();
     return -1;
   }
 
-  sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
-  sqlite3_bind_int(stmt, 2, max_count);
-
-  while (sqlite3_step(stmt) == SQLITE_ROW && count < max_count) {
-    recordings[count].id = (uint64_t)sqlite3_column_int64(stmt, 0);
-
-    const char *stream = (const char *)sqlite3_column_text(stmt, 1);
-    if (stream) {
-      strncpy(recordings[count].stream_name, stream,
-              sizeof(recordings[count].stream_name) - 1);
-      recordings[count].stream_name[sizeof(recordings[count].stream_name) - 1] =
-          '\0';
-    } else {
-      recordings[count].stream_name[0] = '\0';
+  sqlite3_bind_text(stmt, 2, stream_name, -1, SQLITE_STATIC);
+  for (int i = 0; i < count; i++) {
+    candidates[i].deleted = false;
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)candidates[i].id);
+    rc = sqlite3_step(stmt);
+    if (rc != SQLITE_DONE) {
+      log_error("Failed to delete recording metadata: %s", sqlite3_errmsg(db));
+      db_release_statement(stmt);
+      rollback_transaction();
+      return -1;
     }
-
-    const char *path = (const char *)sqlite3_column_text(stmt, 2);
-    if (path) {
-      strncpy(recordings[count].file_path, path,
-              sizeof(recordings[count].file_path) - 1);
-      recordings[count].file_path[sizeof(recordings[count].file_path) - 1] =
-          '\0';
-    } else {
-      recordings[count].file_path[0] = '\0';
+    if (sqlite3_changes(db) > 0) {
+      candidates[i].deleted = true;
+      deleted++;
     }
+    sqlite3_reset(stmt);
+  }
 
-    recordings[count].start_time = (time_t)sqlite3_column_int64(stmt, 3);
+  db_release_statement(stmt);
 
-    if (sqlite3_column_type(stmt, 4) != SQLITE_NULL) {
-      recordings[count].end_time = (time_t)sqlite3_column_int64(stmt, 4);
-    } else {
-      recordings[count].end_time = 0;
-    }
+  if (commit_transaction() != 0) {
+    return -1;
+  }
 
-    recordings[count].size_bytes = (uint64_t)sqlite3_column_int64(stmt, 5);
-    recordings[count].width = sqlite3_column_int(stmt, 6);
-    recordings[count].height = sqlite3_column_int(stmt, 7);
-    recordings[count].fps = sqlite3_column_int(stmt, 8);
+  if (deleted == 0) {
+    return 0;
+  }
 
-    const char *codec = (const char *)sqlite3_column_text(stmt, 9);
-    if (codec) {
-      strncpy(recordings[count].codec, codec,
-              sizeof(recordings[count].codec) - 1);
-      recordings[count].codec[sizeof(recordings[count].codec) - 1] = '\0';
-    } else {
-      recordings[count].codec[0] = '\0';
+  time_t first_start = 0;
+  time_t last_end = 0;
+  bool have_range = false;
+  for (int i = 0; i < count; i++) {
+    if (!candidates[i].deleted) {
+      continue;
     }
-
-    recordings[count].is_complete = sqlite3_column_int(stmt, 10) != 0;
-
-    const char *trigger_type = (const char *)sqlite3_column_text(stmt, 11);
-    if (trigger_type) {
-      strncpy(recordings[count].trigger_type, trigger_type,
-              sizeof(recordings[count].trigger_type) - 1);
-      recordings[count]
-          .trigger_type[sizeof(recordings[count].trigger_type) - 1] = '\0';
-    } else {
-      strncpy(recordings[count].trigger_type, "scheduled",
-              sizeof(recordings[count].trigger_type) - 1);
+    recording_sync_mark_clean(candidates[i].id);
+    if (!have_range) {
+      first_start = candidates[i].start_time;
+      last_end = candidates[i].end_time;
+      have_range = true;
+    } else if (candidates[i].start_time < first_start) {
+      first_start = candidates[i].start_time;
     }
-
-    recordings[count].protected = sqlite3_column_int(stmt, 12) != 0;
-
-    if (sqlite3_column_type(stmt, 13) != SQLITE_NULL) {
-      recordings[count].retention_override_days = sqlite3_column_int(stmt, 13);
-    } else {
-      recordings[count].retention_override_days = -1;
+    if (candidates[i].end_time > last_end) {
+      last_end = candidates[i].end_time;
     }
-
-    count++;
   }
+  timeline_index_invalidate(stream_name, first_start,
+                            last_end > first_start ? last_end : first_start);
 
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
-
-  return count;
+  return deleted;
 }
 
 /**
@@ -1342,7 +1337,6 @@ int get_orphaned_db_entries(recording_metadata_t *recordings, int max_count) {
   int checked = 0;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
 
   if (!db) {
     log_error("Database not initialized");
@@ -1354,7 +1348,11 @@ int get_orphaned_db_entries(recording_metadata_t *recordings, int max_count) {
     return -1;
   }
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   // Get all recordings and check if files exist
   const char *sql =
@@ -1364,10 +1362,10 @@ int get_orphaned_db_entries(recording_metadata_t *recordings, int max_count) {
       "WHERE is_complete = 1 "
       "ORDER BY start_time ASC;";
 
-  rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -1434,8 +1432,8 @@ int get_orphaned_db_entries(recording_metadata_t *recordings, int max_count) {
     checked++;
   }
 
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   log_info("Checked %d recordings, found %d orphaned DB entries", checked,
            count);
@@ -1451,11 +1449,14 @@ int get_recording_days(char ***days_out, int *count_out) {
   *count_out = 0;
 
   sqlite3 *db = get_db_handle();
-  pthread_mutex_t *db_mutex = get_db_mutex();
   if (!db)
     return -1;
 
-  pthread_mutex_lock(db_mutex);
+  db = db_acquire_reader();
+  if (!db) {
+    log_error("Database not initialized");
+    return -1;
+  }
 
   // SQLite query for distinct days
   const char *sql = "SELECT DISTINCT strftime('%Y-%m-%d', datetime(start_time, "
@@ -1463,10 +1464,10 @@ int get_recording_days(char ***days_out, int *count_out) {
                     "FROM recordings WHERE is_complete = 1 ORDER BY day ASC;";
 
   sqlite3_stmt *stmt;
-  int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+  int rc = db_prepare_cached(db, sql, &stmt);
   if (rc != SQLITE_OK) {
     log_error("Failed to prepare statement: %s", sqlite3_errmsg(db));
-    pthread_mutex_unlock(db_mutex);
+    db_release_reader(db);
     return -1;
   }
 
@@ -1485,8 +1486,8 @@ int get_recording_days(char ***days_out, int *count_out) {
           for (int i = 0; i < count; i++)
             free(days[i]);
           free(days);
-          sqlite3_finalize(stmt);
-          pthread_mutex_unlock(db_mutex);
+          db_release_statement(stmt);
+          db_release_reader(db);
           return -1;
         }
         days = new_days;
@@ -1496,8 +1497,8 @@ int get_recording_days(char ***days_out, int *count_out) {
     }
   }
 
-  sqlite3_finalize(stmt);
-  pthread_mutex_unlock(db_mutex);
+  db_release_statement(stmt);
+  db_release_reader(db);
 
   *days_out = days;
   *count_out = count;
@@ -1,9 +1,14 @@
 /**
  * Database Recordings Synchronization
- * 
+ *
  * This module provides functionality to synchronize recording metadata in the database
  * with actual file sizes on disk. This ensures that the web interface displays accurate
  * file sizes even if the database wasn't updated during recording.
+ *
+ * Writers report the final size of a recording when they close it, so only the
+ * recordings in the dirty set (in progress, or closed without a size) are checked
+ * every interval. A reconciliation cursor additionally walks the whole table a
+ * small id-ordered chunk per interval to catch files changed behind our back.
  */
 
 #include <stdio.h>
@@ -13,10 +18,20 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <time.h>
+#include <sqlite3.h>
 
 #include "core/logger.h"
 #include "database/database_manager.h"
+#include "database/db_core.h"
 #include "database/db_recordings.h"
+#include "database/db_recordings_sync.h"
+
+// Rows checked per reconciliation chunk
+#define RECONCILE_CHUNK_SIZE 500
+
+// Incomplete recordings whose file has not changed for this long are left to
+// the reconciliation pass (their writer is gone)
+#define ACTIVE_RECORDING_SECONDS 3600
 
 // Thread state
 static struct {
@@ -29,100 +44,309 @@ static struct {
     .interval_seconds = 60, // Default to 1 minute
 };
 
+// Recordings whose size may be out of date
+static struct {
+    uint64_t ids[RECORDING_SYNC_MAX_DIRTY];
+    int count;
+    bool overflowed;
+    pthread_mutex_t mutex;
+} dirty_set = {
+    .count = 0,
+    .overflowed = false,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+};
+
+// Last id checked by the reconciliation pass
+static uint64_t reconcile_cursor = 0;
+
+// Serializes the sync thread and forced syncs
+static pthread_mutex_t run_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Mark a recording whose file size may differ from the database
+ */
+void recording_sync_mark_dirty(uint64_t recording_id) {
+    if (recording_id == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&dirty_set.mutex);
+
+    for (int i = 0; i < dirty_set.count; i++) {
+        if (dirty_set.ids[i] == recording_id) {
+            pthread_mutex_unlock(&dirty_set.mutex);
+            return;
+        }
+    }
+
+    if (dirty_set.count < RECORDING_SYNC_MAX_DIRTY) {
+        dirty_set.ids[dirty_set.count++] = recording_id;
+    } else {
+        // The reconciliation pass picks it up eventually
+        dirty_set.overflowed = true;
+    }
+
+    pthread_mutex_unlock(&dirty_set.mutex);
+}
+
+/**
+ * Mark a recording whose file size is known to be current
+ */
+void recording_sync_mark_clean(uint64_t recording_id) {
+    pthread_mutex_lock(&dirty_set.mutex);
+
+    for (int i = 0; i < dirty_set.count; i++) {
+        if (dirty_set.ids[i] == recording_id) {
+            dirty_set.ids[i] = dirty_set.ids[--dirty_set.count];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&dirty_set.mutex);
+}
+
 /**
  * Synchronize a single recording's file size with the database
+ *
+ * @param recording_id Recording ID
+ * @param file_path Path of the recording file
+ * @param size_bytes Size currently stored in the database
+ * @param st Set to the file status (may be NULL)
+ * @return 1 if updated, 0 if no update was needed, -1 on error
  */
-static int sync_recording_file_size(uint64_t recording_id, const char *file_path) {
-    struct stat st;
-    
+static int sync_recording_file_size(uint64_t recording_id, const char *file_path,
+                                    uint64_t size_bytes, struct stat *st) {
+    struct stat file_st;
+    if (!st) {
+        st = &file_st;
+    }
+
     // Check if file exists and get its size
-    if (stat(file_path, &st) != 0) {
-        log_debug("File not found for recording %llu: %s", 
+    if (stat(file_path, st) != 0) {
+        log_debug("File not found for recording %llu: %s",
                  (unsigned long long)recording_id, file_path);
         return -1;
     }
-    
-    // Only update if file has non-zero size
-    if (st.st_size > 0) {
-        // Get current metadata from database
+
+    // Only update if file has non-zero size and the size in database is different
+    if (st->st_size <= 0 || size_bytes == (uint64_t)st->st_size) {
+        return 0;
+    }
+
+    // Get current metadata from database, it may have changed since it was read
+    recording_metadata_t metadata;
+    if (get_recording_metadata_by_id(recording_id, &metadata) != 0) {
+        log_error("Failed to get metadata for recording %llu",
+                 (unsigned long long)recording_id);
+        return -1;
+    }
+
+    if (metadata.size_bytes == (uint64_t)st->st_size) {
+        return 0;
+    }
+
+    log_info("Syncing file size for recording %llu: %llu bytes (was %llu bytes)",
+            (unsigned long long)recording_id,
+            (unsigned long long)st->st_size,
+            (unsigned long long)metadata.size_bytes);
+
+    // Update the database with the actual file size
+    // Don't change end_time or is_complete status
+    if (update_recording_metadata(recording_id, metadata.end_time,
+                                (uint64_t)st->st_size, metadata.is_complete) != 0) {
+        log_error("Failed to update file size for recording %llu",
+                 (unsigned long long)recording_id);
+        return -1;
+    }
+
+    return 1; // Updated
+}
+
+/**
+ * Synchronize the recordings in the dirty set
+ */
+static int sync_dirty_recordings(int *error_count) {
+    uint64_t ids[RECORDING_SYNC_MAX_DIRTY];
+    int count;
+    int updated_count = 0;
+
+    // Take the whole set; recordings that stay active are put back
+    pthread_mutex_lock(&dirty_set.mutex);
+    count = dirty_set.count;
+    memcpy(ids, dirty_set.ids, count * sizeof(uint64_t));
+    dirty_set.count = 0;
+    pthread_mutex_unlock(&dirty_set.mutex);
+
+    time_t now = time(NULL);
+
+    for (int i = 0; i < count; i++) {
         recording_metadata_t metadata;
-        if (get_recording_metadata_by_id(recording_id, &metadata) != 0) {
-            log_error("Failed to get metadata for recording %llu", 
-                     (unsigned long long)recording_id);
-            return -1;
+        if (get_recording_metadata_by_id(ids[i], &metadata) != 0) {
+            // Deleted meanwhile
+            continue;
+        }
+
+        struct stat st;
+        int result = sync_recording_file_size(ids[i], metadata.file_path, metadata.size_bytes, &st);
+        if (result > 0) {
+            updated_count++;
+        } else if (result < 0) {
+            (*error_count)++;
+            continue;
         }
-        
-        // Only update if the size in database is different
-        if (metadata.size_bytes != (uint64_t)st.st_size) {
-            log_info("Syncing file size for recording %llu: %llu bytes (was %llu bytes)",
-                    (unsigned long long)recording_id, 
-                    (unsigned long long)st.st_size,
-                    (unsigned long long)metadata.size_bytes);
-            
-            // Update the database with the actual file size
-            // Don't change end_time or is_complete status
-            if (update_recording_metadata(recording_id, metadata.end_time, 
-                                        (uint64_t)st.st_size, metadata.is_complete) != 0) {
-                log_error("Failed to update file size for recording %llu", 
-                         (unsigned long long)recording_id);
-                return -1;
-            }
-            
-            return 1; // Updated
+
+        // Still being written, or completed without a size
+        if ((!metadata.is_complete && st.st_mtime > now - ACTIVE_RECORDING_SECONDS) ||
+            (metadata.is_complete && st.st_size == 0)) {
+            recording_sync_mark_dirty(ids[i]);
         }
     }
-    
-    return 0; // No update needed
+
+    return updated_count;
 }
 
 /**
- * Synchronize all recordings in the database with their file sizes
+ * Synchronize the next chunk of the recordings table after the cursor
+ *
+ * @param done Set to true when the end of the table was reached
+ * @return Number of recordings updated, or -1 on error
  */
-static int sync_all_recordings(void) {
-    int updated_count = 0;
-    int error_count = 0;
+static int sync_next_chunk(int *error_count, bool *done) {
+    typedef struct {
+        uint64_t id;
+        uint64_t size_bytes;
+        char file_path[MAX_PATH_LENGTH];
+    } chunk_row_t;
 
-    // First get the count of recordings
-    int total_count = get_recording_count(0, 0, NULL, 0);
+    *done = false;
 
-    if (total_count < 0) {
-        log_error("Failed to get recording count from database for sync");
+    chunk_row_t *rows = malloc(RECONCILE_CHUNK_SIZE * sizeof(chunk_row_t));
+    if (!rows) {
+        log_error("Failed to allocate memory for recordings sync");
         return -1;
     }
 
-    if (total_count == 0) {
-        log_debug("No recordings to sync");
-        return 0;
+    sqlite3 *db = db_acquire_reader();
+    if (!db) {
+        free(rows);
+        return -1;
     }
 
-    // Allocate memory for recordings
-    recording_metadata_t *recordings = (recording_metadata_t *)malloc(total_count * sizeof(recording_metadata_t));
-    if (!recordings) {
-        log_error("Failed to allocate memory for recordings sync");
+    const char *sql = "SELECT id, file_path, size_bytes FROM recordings "
+                      "WHERE id > ? ORDER BY id LIMIT ?;";
+    sqlite3_stmt *stmt;
+    if (db_prepare_cached(db, sql, &stmt) != SQLITE_OK) {
+        log_error("Failed to prepare recordings sync query: %s", sqlite3_errmsg(db));
+        db_release_reader(db);
+        free(rows);
         return -1;
     }
 
-    // Get recordings with allocated memory
-    int count = get_recording_metadata_paginated(0, 0, NULL, 0, "id", "asc",
-                                                recordings, total_count, 0);
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)reconcile_cursor);
+    sqlite3_bind_int(stmt, 2, RECONCILE_CHUNK_SIZE);
 
-    if (count < 0) {
-        log_error("Failed to get recordings from database for sync");
-        free(recordings);
-        return -1;
+    int count = 0;
+    while (count < RECONCILE_CHUNK_SIZE && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *path = (const char *)sqlite3_column_text(stmt, 1);
+        rows[count].id = (uint64_t)sqlite3_column_int64(stmt, 0);
+        rows[count].size_bytes = (uint64_t)sqlite3_column_int64(stmt, 2);
+        snprintf(rows[count].file_path, sizeof(rows[count].file_path), "%s", path ? path : "");
+        count++;
     }
 
-    // Sync each recording
+    db_release_statement(stmt);
+    db_release_reader(db);
+
+    // The files are checked without holding a connection
+    int updated_count = 0;
     for (int i = 0; i < count; i++) {
-        int result = sync_recording_file_size(recordings[i].id, recordings[i].file_path);
+        int result = sync_recording_file_size(rows[i].id, rows[i].file_path, rows[i].size_bytes, NULL);
         if (result > 0) {
             updated_count++;
         } else if (result < 0) {
-            error_count++;
+            (*error_count)++;
+        }
+    }
+
+    if (count < RECONCILE_CHUNK_SIZE) {
+        reconcile_cursor = 0;
+        *done = true;
+    } else {
+        reconcile_cursor = rows[count - 1].id;
+    }
+
+    free(rows);
+    return updated_count;
+}
+
+/**
+ * Add the incomplete recordings to the dirty set
+ */
+static void seed_dirty_recordings(void) {
+    sqlite3 *db = db_acquire_reader();
+    if (!db) {
+        return;
+    }
+
+    const char *sql = "SELECT id FROM recordings WHERE is_complete = 0 ORDER BY id DESC LIMIT ?;";
+    sqlite3_stmt *stmt;
+    if (db_prepare_cached(db, sql, &stmt) != SQLITE_OK) {
+        log_error("Failed to prepare incomplete recordings query: %s", sqlite3_errmsg(db));
+        db_release_reader(db);
+        return;
+    }
+
+    sqlite3_bind_int(stmt, 1, RECORDING_SYNC_MAX_DIRTY);
+
+    uint64_t ids[RECORDING_SYNC_MAX_DIRTY];
+    int count = 0;
+    while (count < RECORDING_SYNC_MAX_DIRTY && sqlite3_step(stmt) == SQLITE_ROW) {
+        ids[count++] = (uint64_t)sqlite3_column_int64(stmt, 0);
+    }
+
+    db_release_statement(stmt);
+    db_release_reader(db);
+
+    for (int i = 0; i < count; i++) {
+        recording_sync_mark_dirty(ids[i]);
+    }
+}
+
+/**
+ * Run one sync cycle: the dirty set plus chunks of the reconciliation pass
+ *
+ * @param max_chunks Reconciliation chunks to check, or 0 for a full pass
+ * @return Number of recordings updated, or -1 on error
+ */
+static int sync_recordings(int max_chunks) {
+    pthread_mutex_lock(&run_mutex);
+
+    int error_count = 0;
+    int updated_count = sync_dirty_recordings(&error_count);
+
+    // A full dirty set dropped recordings; walk the table faster until it drains
+    pthread_mutex_lock(&dirty_set.mutex);
+    if (dirty_set.overflowed && max_chunks > 0) {
+        max_chunks *= 4;
+    }
+    dirty_set.overflowed = false;
+    pthread_mutex_unlock(&dirty_set.mutex);
+
+    if (max_chunks == 0) {
+        reconcile_cursor = 0;
+    }
+
+    bool done = false;
+    for (int chunk = 0; (max_chunks == 0 || chunk < max_chunks) && !done; chunk++) {
+        int result = sync_next_chunk(&error_count, &done);
+        if (result < 0) {
+            pthread_mutex_unlock(&run_mutex);
+            return -1;
         }
+        updated_count += result;
     }
 
-    free(recordings);
+    pthread_mutex_unlock(&run_mutex);
 
     if (updated_count > 0 || error_count > 0) {
         log_info("Recording sync complete: %d updated, %d errors",
@@ -136,27 +360,27 @@ static int sync_all_recordings(void) {
  * Sync thread function
  */
 static void *sync_thread_func(void *arg) {
-    log_info("Recording sync thread started with interval: %d seconds", 
+    log_info("Recording sync thread started with interval: %d seconds",
             sync_thread.interval_seconds);
-    
-    // Initial sync
-    log_info("Performing initial recording sync");
-    sync_all_recordings();
-    
+
+    // Recordings left incomplete by a previous run
+    seed_dirty_recordings();
+    sync_recordings(1);
+
     while (sync_thread.running) {
         // Sleep for the interval
         for (int i = 0; i < sync_thread.interval_seconds && sync_thread.running; i++) {
             sleep(1);
         }
-        
+
         if (!sync_thread.running) {
             break;
         }
-        
+
         // Sync recordings
-        sync_all_recordings();
+        sync_recordings(1);
     }
-    
+
     log_info("Recording sync thread exiting");
     return NULL;
 }
@@ -234,6 +458,6 @@ int stop_recording_sync_thread(void) {
  */
 int force_recording_sync(void) {
     log_info("Forcing immediate recording sync");
-    return sync_all_recordings();
+    return sync_recordings(0);
 }
 
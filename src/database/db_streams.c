@@ -73,7 +73,7 @@ uint64_t add_stream_config(const stream_config_t *stream) {
                                 "detection_api_url = ?, protocol = ?, is_onvif = ?, record_audio = ?, "
                                 "backchannel_enabled = ?, retention_days = ?, detection_retention_days = ?, max_storage_mb = ?, "
                                 "ptz_enabled = ?, ptz_max_x = ?, ptz_max_y = ?, ptz_max_z = ?, ptz_has_home = ?, "
-                                "onvif_username = ?, onvif_password = ?, onvif_profile = ? "
+                                "onvif_username = ?, onvif_password = ?, onvif_profile = ?, fragmented_mp4 = ? "
                                 "WHERE id = ?;";
 
         rc = sqlite3_prepare_v2(db, update_sql, -1, &stmt, NULL);
@@ -133,8 +133,11 @@ uint64_t add_stream_config(const stream_config_t *stream) {
         sqlite3_bind_text(stmt, 31, stream->onvif_password, -1, SQLITE_STATIC);
         sqlite3_bind_text(stmt, 32, stream->onvif_profile, -1, SQLITE_STATIC);
 
+        // Bind recording container parameter
+        sqlite3_bind_int(stmt, 33, stream->fragmented_mp4 ? 1 : 0);
+
         // Bind ID parameter
-        sqlite3_bind_int64(stmt, 33, (sqlite3_int64)existing_id);
+        sqlite3_bind_int64(stmt, 34, (sqlite3_int64)existing_id);
 
         // Execute statement
         rc = sqlite3_step(stmt);
@@ -178,8 +181,8 @@ uint64_t add_stream_config(const stream_config_t *stream) {
           "pre_detection_buffer, post_detection_buffer, detection_api_url, protocol, is_onvif, record_audio, backchannel_enabled, "
           "retention_days, detection_retention_days, max_storage_mb, "
           "ptz_enabled, ptz_max_x, ptz_max_y, ptz_max_z, ptz_has_home, "
-          "onvif_username, onvif_password, onvif_profile) "
-          "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+          "onvif_username, onvif_password, onvif_profile, fragmented_mp4) "
+          "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
 
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
     if (rc != SQLITE_OK) {
@@ -239,6 +242,9 @@ uint64_t add_stream_config(const stream_config_t *stream) {
     sqlite3_bind_text(stmt, 32, stream->onvif_password, -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 33, stream->onvif_profile, -1, SQLITE_STATIC);
 
+    // Bind recording container parameter
+    sqlite3_bind_int(stmt, 34, stream->fragmented_mp4 ? 1 : 0);
+
     // Execute statement
     rc = sqlite3_step(stmt);
     if (rc != SQLITE_DONE) {
@@ -304,7 +310,7 @@ int update_stream_config(const char *name, const stream_config_t *stream) {
                       "detection_api_url = ?, protocol = ?, is_onvif = ?, record_audio = ?, "
                       "backchannel_enabled = ?, retention_days = ?, detection_retention_days = ?, max_storage_mb = ?, "
                       "ptz_enabled = ?, ptz_max_x = ?, ptz_max_y = ?, ptz_max_z = ?, ptz_has_home = ?, "
-                      "onvif_username = ?, onvif_password = ?, onvif_profile = ? "
+                      "onvif_username = ?, onvif_password = ?, onvif_profile = ?, fragmented_mp4 = ? "
                       "WHERE name = ?;";
 
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -365,8 +371,11 @@ int update_stream_config(const char *name, const stream_config_t *stream) {
     sqlite3_bind_text(stmt, 32, stream->onvif_password, -1, SQLITE_STATIC);
     sqlite3_bind_text(stmt, 33, stream->onvif_profile, -1, SQLITE_STATIC);
 
+    // Bind recording container parameter
+    sqlite3_bind_int(stmt, 34, stream->fragmented_mp4 ? 1 : 0);
+
     // Bind the WHERE clause parameter
-    sqlite3_bind_text(stmt, 34, name, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 35, name, -1, SQLITE_STATIC);
 
     // Execute statement
     rc = sqlite3_step(stmt);
@@ -525,7 +534,7 @@ int get_stream_config_by_name(const char *name, stream_config_t *stream) {
         "pre_detection_buffer, post_detection_buffer, detection_api_url, protocol, is_onvif, record_audio, backchannel_enabled, "
         "retention_days, detection_retention_days, max_storage_mb, "
         "ptz_enabled, ptz_max_x, ptz_max_y, ptz_max_z, ptz_has_home, "
-        "onvif_username, onvif_password, onvif_profile "
+        "onvif_username, onvif_password, onvif_profile, fragmented_mp4 "
         "FROM streams WHERE name = ?;";
 
     // Column index constants for readability
@@ -537,7 +546,7 @@ int get_stream_config_by_name(const char *name, stream_config_t *stream) {
         COL_PROTOCOL, COL_IS_ONVIF, COL_RECORD_AUDIO, COL_BACKCHANNEL_ENABLED,
         COL_RETENTION_DAYS, COL_DETECTION_RETENTION_DAYS, COL_MAX_STORAGE_MB,
         COL_PTZ_ENABLED, COL_PTZ_MAX_X, COL_PTZ_MAX_Y, COL_PTZ_MAX_Z, COL_PTZ_HAS_HOME,
-        COL_ONVIF_USERNAME, COL_ONVIF_PASSWORD, COL_ONVIF_PROFILE
+        COL_ONVIF_USERNAME, COL_ONVIF_PASSWORD, COL_ONVIF_PROFILE, COL_FRAGMENTED_MP4
     };
 
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -649,6 +658,8 @@ int get_stream_config_by_name(const char *name, stream_config_t *stream) {
             stream->onvif_profile[sizeof(stream->onvif_profile) - 1] = '\0';
         }
 
+        stream->fragmented_mp4 = sqlite3_column_int(stmt, COL_FRAGMENTED_MP4) != 0;
+
         result = 0;
     }
 
@@ -695,7 +706,7 @@ int get_all_stream_configs(stream_config_t *streams, int max_count) {
         "detection_based_recording, detection_model, detection_threshold, detection_interval, "
         "pre_detection_buffer, post_detection_buffer, detection_api_url, protocol, is_onvif, record_audio, backchannel_enabled, "
         "retention_days, detection_retention_days, max_storage_mb, "
-        "ptz_enabled, ptz_max_x, ptz_max_y, ptz_max_z, ptz_has_home "
+        "ptz_enabled, ptz_max_x, ptz_max_y, ptz_max_z, ptz_has_home, fragmented_mp4 "
         "FROM streams ORDER BY name;";
 
     // Column index constants (same as get_stream_config_by_name)
@@ -706,7 +717,8 @@ int get_all_stream_configs(stream_config_t *streams, int max_count) {
         COL_PRE_DETECTION_BUFFER, COL_POST_DETECTION_BUFFER, COL_DETECTION_API_URL,
         COL_PROTOCOL, COL_IS_ONVIF, COL_RECORD_AUDIO, COL_BACKCHANNEL_ENABLED,
         COL_RETENTION_DAYS, COL_DETECTION_RETENTION_DAYS, COL_MAX_STORAGE_MB,
-        COL_PTZ_ENABLED, COL_PTZ_MAX_X, COL_PTZ_MAX_Y, COL_PTZ_MAX_Z, COL_PTZ_HAS_HOME
+        COL_PTZ_ENABLED, COL_PTZ_MAX_X, COL_PTZ_MAX_Y, COL_PTZ_MAX_Z, COL_PTZ_HAS_HOME,
+        COL_FRAGMENTED_MP4
     };
 
     rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -798,6 +810,8 @@ int get_all_stream_configs(stream_config_t *streams, int max_count) {
             ? sqlite3_column_int(stmt, COL_PTZ_MAX_Z) : 0;
         s->ptz_has_home = sqlite3_column_int(stmt, COL_PTZ_HAS_HOME) != 0;
 
+        s->fragmented_mp4 = sqlite3_column_int(stmt, COL_FRAGMENTED_MP4) != 0;
+
         count++;
     }
 
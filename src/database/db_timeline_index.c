@@ -0,0 +1,566 @@
+/**
+ * Timeline Index
+ *
+ * Cached stream-days live in a fixed table evicted least recently used first.
+ * Days are loaded on a reader connection without holding the index mutex; a
+ * per-stream modification counter tells the loader whether a recording or
+ * detection arrived meanwhile, in which case it loads the day again. A day
+ * that keeps changing is used once without being cached.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <sqlite3.h>
+
+#include "database/db_timeline_index.h"
+#include "database/db_core.h"
+#include "core/logger.h"
+
+#define SECONDS_PER_DAY 86400
+#define COVERAGE_WORDS (SECONDS_PER_DAY / 64)
+#define DETECTION_BUCKETS (SECONDS_PER_DAY / TIMELINE_DETECTION_BUCKET_SECONDS)
+
+// Slots of the per-stream modification counters (streams are hashed into them)
+#define MODIFICATION_SLOTS 64
+
+// Longest range a query may span
+#define MAX_QUERY_DAYS 31
+
+// Attempts to load a day that keeps being modified while it is read
+#define MAX_LOAD_ATTEMPTS 3
+
+typedef struct {
+    char stream_name[64];
+    int64_t day;                                // Days since the epoch (UTC)
+    uint64_t last_used;
+    uint64_t coverage[COVERAGE_WORDS];          // Bit per second covered by a recording
+    uint16_t detections[DETECTION_BUCKETS];     // Detections per bucket (saturating)
+} timeline_day_t;
+
+static timeline_day_t *cached_days[TIMELINE_INDEX_MAX_DAYS];
+static uint64_t use_counter = 0;
+static uint64_t modifications[MODIFICATION_SLOTS];
+static uint64_t recording_generations[MODIFICATION_SLOTS];
+static pthread_mutex_t index_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int64_t day_of(time_t t) {
+    return t >= 0 ? (int64_t)t / SECONDS_PER_DAY : -(((int64_t)-t + SECONDS_PER_DAY - 1) / SECONDS_PER_DAY);
+}
+
+static unsigned int modification_slot(const char *stream_name) {
+    unsigned int hash = 5381;
+    for (const char *p = stream_name; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    return hash % MODIFICATION_SLOTS;
+}
+
+/**
+ * Set the bits of seconds [from, to) of a day
+ */
+static void set_seconds(uint64_t *bitmap, int from, int to) {
+    while (from < to) {
+        int word = from / 64;
+        int bit = from % 64;
+        int n = 64 - bit < to - from ? 64 - bit : to - from;
+        uint64_t mask = n == 64 ? ~0ULL : ((1ULL << n) - 1) << bit;
+        bitmap[word] |= mask;
+        from += n;
+    }
+}
+
+/**
+ * Find the first second in [from, to) whose bit has the given value
+ *
+ * @return The second, or to if there is none
+ */
+static int find_second(const uint64_t *bitmap, int from, int to, bool value) {
+    while (from < to) {
+        int word = from / 64;
+        int bit = from % 64;
+        uint64_t bits = (value ? bitmap[word] : ~bitmap[word]) >> bit;
+        if (bits) {
+            int found = from + __builtin_ctzll(bits);
+            return found < to ? found : to;
+        }
+        from += 64 - bit;
+    }
+    return to;
+}
+
+/**
+ * Mark a recording in a day, clipped to the day
+ */
+static void mark_recording(timeline_day_t *d, time_t start_time, time_t end_time) {
+    time_t day_start = (time_t)(d->day * SECONDS_PER_DAY);
+
+    // A recording covers at least the second it started in
+    if (end_time <= start_time) {
+        end_time = start_time + 1;
+    }
+
+    time_t from = start_time > day_start ? start_time : day_start;
+    time_t to = end_time < day_start + SECONDS_PER_DAY ? end_time : day_start + SECONDS_PER_DAY;
+    if (from < to) {
+        set_seconds(d->coverage, (int)(from - day_start), (int)(to - day_start));
+    }
+}
+
+/**
+ * Find a cached day. Called with the mutex held.
+ */
+static timeline_day_t *find_day(const char *stream_name, int64_t day) {
+    for (int i = 0; i < TIMELINE_INDEX_MAX_DAYS; i++) {
+        timeline_day_t *d = cached_days[i];
+        if (d && d->day == day && strcmp(d->stream_name, stream_name) == 0) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Add a day to the cache, evicting the least recently used one if it is full.
+ * Called with the mutex held.
+ */
+static timeline_day_t *insert_day(timeline_day_t *d) {
+    int slot = -1;
+    for (int i = 0; i < TIMELINE_INDEX_MAX_DAYS; i++) {
+        if (!cached_days[i]) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 || cached_days[i]->last_used < cached_days[slot]->last_used) {
+            slot = i;
+        }
+    }
+
+    free(cached_days[slot]);
+    cached_days[slot] = d;
+    return d;
+}
+
+/**
+ * Read a day from the database. Called without the mutex held.
+ */
+static timeline_day_t *load_day(const char *stream_name, int64_t day) {
+    timeline_day_t *d = calloc(1, sizeof(timeline_day_t));
+    if (!d) {
+        log_error("Failed to allocate timeline index day");
+        return NULL;
+    }
+
+    strncpy(d->stream_name, stream_name, sizeof(d->stream_name) - 1);
+    d->day = day;
+
+    time_t day_start = (time_t)(day * SECONDS_PER_DAY);
+    time_t day_end = day_start + SECONDS_PER_DAY;
+
+    sqlite3 *db = db_acquire_reader();
+    if (!db) {
+        log_error("Database not initialized");
+        free(d);
+        return NULL;
+    }
+
+    sqlite3_stmt *stmt;
+    const char *recordings_sql =
+        "SELECT start_time, end_time FROM recordings "
+        "WHERE stream_name = ? AND is_complete = 1 AND end_time > ? AND start_time < ?;";
+
+    if (db_prepare_cached(db, recordings_sql, &stmt) != SQLITE_OK) {
+        log_error("Failed to prepare timeline recordings query: %s", sqlite3_errmsg(db));
+        db_release_reader(db);
+        free(d);
+        return NULL;
+    }
+
+    sqlite3_bind_text(stmt, 1, stream_name, -1, SQLITE_STATIC);
+    sqlite3_bind_int64(stmt, 2, (sqlite3_int64)day_start);
+    sqlite3_bind_int64(stmt, 3, (sqlite3_int64)day_end);
+
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        mark_recording(d, (time_t)sqlite3_column_int64(stmt, 0), (time_t)sqlite3_column_int64(stmt, 1));
+    }
+    db_release_statement(stmt);
+
+    // The detections table is created on first use, it may not exist yet
+    const char *detections_sql =
+        "SELECT (timestamp - ?) / ?, COUNT(*) FROM detections "
+        "WHERE stream_name = ? AND timestamp >= ? AND timestamp < ? GROUP BY 1;";
+
+    if (db_prepare_cached(db, detections_sql, &stmt) == SQLITE_OK) {
+        sqlite3_bind_int64(stmt, 1, (sqlite3_int64)day_start);
+        sqlite3_bind_int(stmt, 2, TIMELINE_DETECTION_BUCKET_SECONDS);
+        sqlite3_bind_text(stmt, 3, stream_name, -1, SQLITE_STATIC);
+        sqlite3_bind_int64(stmt, 4, (sqlite3_int64)day_start);
+        sqlite3_bind_int64(stmt, 5, (sqlite3_int64)day_end);
+
+        while (sqlite3_step(stmt) == SQLITE_ROW) {
+            int bucket = sqlite3_column_int(stmt, 0);
+            sqlite3_int64 count = sqlite3_column_int64(stmt, 1);
+            if (bucket >= 0 && bucket < DETECTION_BUCKETS) {
+                d->detections[bucket] = count > UINT16_MAX ? UINT16_MAX : (uint16_t)count;
+            }
+        }
+        db_release_statement(stmt);
+    }
+
+    db_release_reader(db);
+
+    log_debug("Loaded timeline index for stream %s, day %lld", stream_name, (long long)day);
+    return d;
+}
+
+/**
+ * Get a day, loading it if it is not cached
+ *
+ * Called with the mutex held, which is released while the day is read from
+ * the database; pointers to other days are not valid after this returns.
+ * A day still being modified on the last attempt is returned without caching
+ * it and *uncached set; the caller frees it after use.
+ */
+static timeline_day_t *get_day(const char *stream_name, int64_t day, bool *uncached) {
+    unsigned int slot = modification_slot(stream_name);
+    timeline_day_t *d = find_day(stream_name, day);
+
+    *uncached = false;
+
+    for (int attempt = 1; !d && attempt <= MAX_LOAD_ATTEMPTS; attempt++) {
+        uint64_t mods = modifications[slot];
+
+        pthread_mutex_unlock(&index_mutex);
+        timeline_day_t *loaded = load_day(stream_name, day);
+        pthread_mutex_lock(&index_mutex);
+
+        if (!loaded) {
+            return NULL;
+        }
+
+        // Loaded by another query meanwhile
+        d = find_day(stream_name, day);
+        if (d) {
+            free(loaded);
+            break;
+        }
+
+        // Changes made while the day was read may be missing from it
+        if (modifications[slot] != mods) {
+            if (attempt < MAX_LOAD_ATTEMPTS) {
+                free(loaded);
+                continue;
+            }
+            *uncached = true;
+            return loaded;
+        }
+
+        d = insert_day(loaded);
+    }
+
+    if (d) {
+        d->last_used = ++use_counter;
+    }
+    return d;
+}
+
+static bool valid_range(time_t start_time, time_t end_time) {
+    if (end_time <= start_time) {
+        return false;
+    }
+    if (day_of(end_time - 1) - day_of(start_time) >= MAX_QUERY_DAYS) {
+        log_warn("Timeline query spans more than %d days", MAX_QUERY_DAYS);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Get the time ranges of a stream covered by complete recordings
+ */
+int timeline_index_get_coverage(const char *stream_name, time_t start_time, time_t end_time,
+                                int max_gap, timeline_interval_t **intervals, int *count) {
+    if (!stream_name || !intervals || !count) {
+        return -1;
+    }
+
+    *intervals = NULL;
+    *count = 0;
+
+    if (!valid_range(start_time, end_time)) {
+        return end_time <= start_time ? 0 : -1;
+    }
+
+    timeline_interval_t *result = NULL;
+    int n = 0;
+    int capacity = 0;
+
+    pthread_mutex_lock(&index_mutex);
+
+    for (int64_t day = day_of(start_time); day <= day_of(end_time - 1); day++) {
+        bool uncached;
+        timeline_day_t *d = get_day(stream_name, day, &uncached);
+        if (!d) {
+            pthread_mutex_unlock(&index_mutex);
+            free(result);
+            return -1;
+        }
+
+        time_t day_start = (time_t)(day * SECONDS_PER_DAY);
+        int from = start_time > day_start ? (int)(start_time - day_start) : 0;
+        int to = end_time < day_start + SECONDS_PER_DAY ? (int)(end_time - day_start) : SECONDS_PER_DAY;
+
+        while (from < to) {
+            int run_start = find_second(d->coverage, from, to, true);
+            if (run_start >= to) {
+                break;
+            }
+            int run_end = find_second(d->coverage, run_start, to, false);
+
+            time_t s = day_start + run_start;
+            time_t e = day_start + run_end;
+
+            if (n > 0 && s - result[n - 1].end <= max_gap) {
+                result[n - 1].end = e;
+            } else {
+                if (n == capacity) {
+                    capacity = capacity ? capacity * 2 : 64;
+                    timeline_interval_t *grown = realloc(result, capacity * sizeof(timeline_interval_t));
+                    if (!grown) {
+                        pthread_mutex_unlock(&index_mutex);
+                        if (uncached) {
+                            free(d);
+                        }
+                        free(result);
+                        return -1;
+                    }
+                    result = grown;
+                }
+                result[n].start = s;
+                result[n].end = e;
+                n++;
+            }
+
+            from = run_end;
+        }
+
+        if (uncached) {
+            free(d);
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+
+    *intervals = result;
+    *count = n;
+    return 0;
+}
+
+/**
+ * Get detection counts of a stream in equal buckets
+ */
+int timeline_index_get_detection_counts(const char *stream_name, time_t start_time, time_t end_time,
+                                        int bucket_seconds, uint32_t *counts, int max_buckets) {
+    if (!stream_name || !counts || max_buckets <= 0) {
+        return -1;
+    }
+    if (!valid_range(start_time, end_time)) {
+        return end_time <= start_time ? 0 : -1;
+    }
+
+    if (bucket_seconds < TIMELINE_DETECTION_BUCKET_SECONDS) {
+        bucket_seconds = TIMELINE_DETECTION_BUCKET_SECONDS;
+    }
+    bucket_seconds = (bucket_seconds + TIMELINE_DETECTION_BUCKET_SECONDS - 1) /
+                     TIMELINE_DETECTION_BUCKET_SECONDS * TIMELINE_DETECTION_BUCKET_SECONDS;
+
+    int64_t buckets = ((int64_t)(end_time - start_time) + bucket_seconds - 1) / bucket_seconds;
+    int num_buckets = buckets < max_buckets ? (int)buckets : max_buckets;
+    memset(counts, 0, num_buckets * sizeof(uint32_t));
+
+    pthread_mutex_lock(&index_mutex);
+
+    for (int64_t day = day_of(start_time); day <= day_of(end_time - 1); day++) {
+        bool uncached;
+        timeline_day_t *d = get_day(stream_name, day, &uncached);
+        if (!d) {
+            pthread_mutex_unlock(&index_mutex);
+            return -1;
+        }
+
+        time_t day_start = (time_t)(day * SECONDS_PER_DAY);
+        for (int i = 0; i < DETECTION_BUCKETS; i++) {
+            if (d->detections[i] == 0) {
+                continue;
+            }
+
+            time_t t = day_start + (time_t)i * TIMELINE_DETECTION_BUCKET_SECONDS;
+            if (t + TIMELINE_DETECTION_BUCKET_SECONDS <= start_time || t >= end_time) {
+                continue;
+            }
+
+            int64_t bucket = t > start_time ? (int64_t)(t - start_time) / bucket_seconds : 0;
+            if (bucket < num_buckets) {
+                counts[bucket] += d->detections[i];
+            }
+        }
+
+        if (uncached) {
+            free(d);
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+    return num_buckets;
+}
+
+/**
+ * Check whether a stream has detections in a time range
+ */
+bool timeline_index_has_detection(const char *stream_name, time_t start_time, time_t end_time) {
+    if (!stream_name || !valid_range(start_time, end_time + 1)) {
+        return false;
+    }
+
+    bool found = false;
+
+    pthread_mutex_lock(&index_mutex);
+
+    for (int64_t day = day_of(start_time); day <= day_of(end_time) && !found; day++) {
+        bool uncached;
+        timeline_day_t *d = get_day(stream_name, day, &uncached);
+        if (!d) {
+            break;
+        }
+
+        time_t day_start = (time_t)(day * SECONDS_PER_DAY);
+        int first = start_time > day_start ? (int)(start_time - day_start) / TIMELINE_DETECTION_BUCKET_SECONDS : 0;
+        int last = end_time < day_start + SECONDS_PER_DAY ?
+                   (int)(end_time - day_start) / TIMELINE_DETECTION_BUCKET_SECONDS : DETECTION_BUCKETS - 1;
+
+        for (int i = first; i <= last; i++) {
+            if (d->detections[i] > 0) {
+                found = true;
+                break;
+            }
+        }
+
+        if (uncached) {
+            free(d);
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+    return found;
+}
+
+/**
+ * Record a completed recording
+ */
+void timeline_index_add_recording(const char *stream_name, time_t start_time, time_t end_time) {
+    if (!stream_name) {
+        return;
+    }
+
+    time_t last = end_time > start_time ? end_time - 1 : start_time;
+
+    pthread_mutex_lock(&index_mutex);
+
+    modifications[modification_slot(stream_name)]++;
+    recording_generations[modification_slot(stream_name)]++;
+
+    // Days that are not cached pick the recording up when they are loaded
+    for (int64_t day = day_of(start_time); day <= day_of(last); day++) {
+        timeline_day_t *d = find_day(stream_name, day);
+        if (d) {
+            mark_recording(d, start_time, end_time);
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/**
+ * Record a detection
+ */
+void timeline_index_add_detection(const char *stream_name, time_t timestamp) {
+    if (!stream_name) {
+        return;
+    }
+
+    pthread_mutex_lock(&index_mutex);
+
+    modifications[modification_slot(stream_name)]++;
+
+    timeline_day_t *d = find_day(stream_name, day_of(timestamp));
+    if (d) {
+        int bucket = (int)(timestamp - (time_t)(d->day * SECONDS_PER_DAY)) / TIMELINE_DETECTION_BUCKET_SECONDS;
+        if (d->detections[bucket] < UINT16_MAX) {
+            d->detections[bucket]++;
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/**
+ * Drop the cached days of a stream overlapping a time range
+ */
+void timeline_index_invalidate(const char *stream_name, time_t start_time, time_t end_time) {
+    if (!stream_name) {
+        return;
+    }
+
+    int64_t first = day_of(start_time);
+    int64_t last = day_of(end_time > start_time ? end_time : start_time);
+
+    pthread_mutex_lock(&index_mutex);
+
+    modifications[modification_slot(stream_name)]++;
+    recording_generations[modification_slot(stream_name)]++;
+
+    for (int i = 0; i < TIMELINE_INDEX_MAX_DAYS; i++) {
+        timeline_day_t *d = cached_days[i];
+        if (d && d->day >= first && d->day <= last && strcmp(d->stream_name, stream_name) == 0) {
+            free(d);
+            cached_days[i] = NULL;
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/**
+ * Drop all cached days
+ */
+void timeline_index_invalidate_all(void) {
+    pthread_mutex_lock(&index_mutex);
+
+    for (int i = 0; i < MODIFICATION_SLOTS; i++) {
+        modifications[i]++;
+        recording_generations[i]++;
+    }
+
+    for (int i = 0; i < TIMELINE_INDEX_MAX_DAYS; i++) {
+        free(cached_days[i]);
+        cached_days[i] = NULL;
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/**
+ * Get the recording generation of a stream
+ */
+uint64_t timeline_index_get_recording_generation(const char *stream_name) {
+    if (!stream_name) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&index_mutex);
+    uint64_t generation = recording_generations[modification_slot(stream_name)];
+    pthread_mutex_unlock(&index_mutex);
+
+    return generation;
+}
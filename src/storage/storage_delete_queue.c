@@ -0,0 +1,202 @@
+/**
+ * @file storage_delete_queue.c
+ * @brief Background deletion of recording files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <errno.h>
+#include <pthread.h>
+
+#include "storage/storage_delete_queue.h"
+#include "storage/storage_manager_streams_cache.h"
+#include "core/logger.h"
+
+typedef struct {
+    char file_path[256];
+    uint64_t size_bytes;
+} delete_job_t;
+
+// Ring buffer of files waiting to be deleted
+static struct {
+    delete_job_t jobs[STORAGE_DELETE_QUEUE_SIZE];
+    int head;
+    int count;
+    int in_progress;            // Jobs taken by a thread and not finished yet
+    bool running;
+    pthread_t threads[STORAGE_DELETE_THREADS];
+    int thread_count;
+    pthread_mutex_t mutex;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_cond_t idle;
+} delete_queue = {
+    .head = 0,
+    .count = 0,
+    .in_progress = 0,
+    .running = false,
+    .thread_count = 0,
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .not_empty = PTHREAD_COND_INITIALIZER,
+    .not_full = PTHREAD_COND_INITIALIZER,
+    .idle = PTHREAD_COND_INITIALIZER,
+};
+
+/**
+ * Delete one file and update the storage cache
+ */
+static int delete_file(const char *file_path, uint64_t size_bytes) {
+    if (unlink(file_path) == 0) {
+        log_debug("Deleted recording file: %s", file_path);
+        stream_storage_cache_remove_file(file_path, size_bytes);
+        return 0;
+    }
+
+    // Already gone, nothing left to free
+    if (errno == ENOENT) {
+        return 0;
+    }
+
+    log_error("Failed to delete recording file: %s (error: %s)", file_path, strerror(errno));
+    return -1;
+}
+
+static void *delete_thread_func(void *arg) {
+    (void)arg;
+    delete_job_t job;
+
+    pthread_mutex_lock(&delete_queue.mutex);
+    for (;;) {
+        while (delete_queue.count == 0 && delete_queue.running) {
+            pthread_cond_wait(&delete_queue.not_empty, &delete_queue.mutex);
+        }
+
+        // Shutdown still finishes the queued files
+        if (delete_queue.count == 0) {
+            break;
+        }
+
+        job = delete_queue.jobs[delete_queue.head];
+        delete_queue.head = (delete_queue.head + 1) % STORAGE_DELETE_QUEUE_SIZE;
+        delete_queue.count--;
+        delete_queue.in_progress++;
+        pthread_cond_signal(&delete_queue.not_full);
+        pthread_mutex_unlock(&delete_queue.mutex);
+
+        delete_file(job.file_path, job.size_bytes);
+
+        pthread_mutex_lock(&delete_queue.mutex);
+        delete_queue.in_progress--;
+        if (delete_queue.count == 0 && delete_queue.in_progress == 0) {
+            pthread_cond_broadcast(&delete_queue.idle);
+        }
+    }
+    pthread_mutex_unlock(&delete_queue.mutex);
+
+    return NULL;
+}
+
+/**
+ * Start the deletion threads
+ */
+int init_storage_delete_queue(void) {
+    pthread_mutex_lock(&delete_queue.mutex);
+
+    if (delete_queue.running) {
+        pthread_mutex_unlock(&delete_queue.mutex);
+        return 0;
+    }
+
+    delete_queue.running = true;
+    delete_queue.thread_count = 0;
+    for (int i = 0; i < STORAGE_DELETE_THREADS; i++) {
+        if (pthread_create(&delete_queue.threads[i], NULL, delete_thread_func, NULL) != 0) {
+            log_error("Failed to create recording deletion thread: %s", strerror(errno));
+            break;
+        }
+        delete_queue.thread_count++;
+    }
+
+    if (delete_queue.thread_count == 0) {
+        delete_queue.running = false;
+        pthread_mutex_unlock(&delete_queue.mutex);
+        return -1;
+    }
+
+    pthread_mutex_unlock(&delete_queue.mutex);
+
+    log_info("Recording deletion queue started with %d threads", delete_queue.thread_count);
+    return 0;
+}
+
+/**
+ * Delete the queued files and stop the deletion threads
+ */
+void shutdown_storage_delete_queue(void) {
+    pthread_mutex_lock(&delete_queue.mutex);
+    if (!delete_queue.running) {
+        pthread_mutex_unlock(&delete_queue.mutex);
+        return;
+    }
+    delete_queue.running = false;
+    pthread_cond_broadcast(&delete_queue.not_empty);
+    int thread_count = delete_queue.thread_count;
+    pthread_mutex_unlock(&delete_queue.mutex);
+
+    for (int i = 0; i < thread_count; i++) {
+        pthread_join(delete_queue.threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&delete_queue.mutex);
+    delete_queue.thread_count = 0;
+    pthread_cond_broadcast(&delete_queue.not_full);
+    pthread_cond_broadcast(&delete_queue.idle);
+    pthread_mutex_unlock(&delete_queue.mutex);
+
+    log_info("Recording deletion queue stopped");
+}
+
+/**
+ * Queue a recording file for deletion
+ */
+int storage_delete_queue_push(const char *file_path, uint64_t size_bytes) {
+    if (!file_path || file_path[0] == '\0') {
+        return -1;
+    }
+
+    pthread_mutex_lock(&delete_queue.mutex);
+
+    while (delete_queue.running && delete_queue.count == STORAGE_DELETE_QUEUE_SIZE) {
+        pthread_cond_wait(&delete_queue.not_full, &delete_queue.mutex);
+    }
+
+    if (!delete_queue.running) {
+        pthread_mutex_unlock(&delete_queue.mutex);
+        return delete_file(file_path, size_bytes);
+    }
+
+    int tail = (delete_queue.head + delete_queue.count) % STORAGE_DELETE_QUEUE_SIZE;
+    delete_job_t *job = &delete_queue.jobs[tail];
+    strncpy(job->file_path, file_path, sizeof(job->file_path) - 1);
+    job->file_path[sizeof(job->file_path) - 1] = '\0';
+    job->size_bytes = size_bytes;
+    delete_queue.count++;
+
+    pthread_cond_signal(&delete_queue.not_empty);
+    pthread_mutex_unlock(&delete_queue.mutex);
+    return 0;
+}
+
+/**
+ * Wait until every queued file has been deleted
+ */
+void storage_delete_queue_wait_idle(void) {
+    pthread_mutex_lock(&delete_queue.mutex);
+    while (delete_queue.running && (delete_queue.count > 0 || delete_queue.in_progress > 0)) {
+        pthread_cond_wait(&delete_queue.idle, &delete_queue.mutex);
+    }
+    pthread_mutex_unlock(&delete_queue.mutex);
+}
@@ -12,6 +12,7 @@
 
 #include "storage/storage_manager.h"
 #include "storage/storage_manager_streams_cache.h"
+#include "storage/storage_delete_queue.h"
 #include "database/db_auth.h"
 #include "database/db_streams.h"
 #include "database/db_recordings.h"
@@ -19,12 +20,15 @@
 
 // Maximum number of streams to process at once
 #define MAX_STREAMS_BATCH 64
-// Maximum recordings to delete per stream per run
-#define MAX_RECORDINGS_PER_STREAM 100
+// Recordings deleted per database transaction
+#define RETENTION_BATCH_SIZE 256
 
 // Forward declarations
 static int apply_legacy_retention_policy(void);
 
+// Set while the storage manager thread stops, ends a retention pass early
+static volatile bool retention_stop_requested = false;
+
 // Storage manager state
 static struct {
     char storage_path[256];
@@ -229,11 +233,83 @@ int delete_recording(const char *path) {
         log_error("Failed to delete file: %s (error: %s)", path, strerror(errno));
         return -1;
     }
+    stream_storage_cache_remove_file(path, (uint64_t)st.st_size);
 
     log_info("Successfully deleted recording file: %s", path);
     return 0;
 }
 
+/**
+ * Delete a batch of recordings: the rows in one transaction, then the files
+ * through the deletion queue
+ *
+ * @param stream_name Stream the recordings belong to
+ * @param batch Recordings to delete
+ * @param count Number of recordings
+ * @param freed Incremented by the size of the deleted recordings
+ * @return Number of recordings deleted, or -1 on error
+ */
+static int delete_batch(const char *stream_name, retention_candidate_t *batch, int count,
+                        uint64_t *freed) {
+    int deleted = delete_recordings_batch(stream_name, batch, count);
+    if (deleted < 0) {
+        log_error("Failed to delete a batch of %d recordings for stream %s", count, stream_name);
+        return -1;
+    }
+
+    // Rows protected since the batch was selected were kept, and so are their files
+    for (int i = 0; i < count; i++) {
+        if (!batch[i].deleted) {
+            continue;
+        }
+        if (batch[i].file_path[0] != '\0') {
+            storage_delete_queue_push(batch[i].file_path, batch[i].size_bytes);
+        }
+        *freed += batch[i].size_bytes;
+    }
+    return deleted;
+}
+
+/**
+ * Delete all recordings of one kind that are past their retention
+ *
+ * @param stream_name Stream name
+ * @param scan RETENTION_SCAN_REGULAR or RETENTION_SCAN_DETECTION
+ * @param retention_days Retention of these recordings in days
+ * @param batch Buffer of RETENTION_BATCH_SIZE recordings
+ * @param freed Incremented by the size of the deleted recordings
+ * @return Number of recordings deleted
+ */
+static int apply_time_retention(const char *stream_name, retention_scan_t scan, int retention_days,
+                                retention_candidate_t *batch, uint64_t *freed) {
+    time_t cutoff = time(NULL) - (time_t)retention_days * 86400;
+    retention_cursor_t cursor = {0};
+    int total = 0;
+
+    while (!retention_stop_requested) {
+        int count = get_retention_batch(stream_name, scan, cutoff, &cursor, batch, RETENTION_BATCH_SIZE);
+        if (count <= 0) {
+            break;
+        }
+
+        int deleted = delete_batch(stream_name, batch, count, freed);
+        if (deleted < 0) {
+            break;
+        }
+        total += deleted;
+
+        if (count < RETENTION_BATCH_SIZE) {
+            break;
+        }
+    }
+
+    if (total > 0) {
+        log_info("Stream %s: deleted %d %s recordings past retention", stream_name, total,
+                 scan == RETENTION_SCAN_DETECTION ? "detection" : "regular");
+    }
+    return total;
+}
+
 /**
  * Apply per-stream retention policy
  *
@@ -268,8 +344,14 @@ int apply_retention_policy(void) {
 
     log_info("Processing retention policy for %d streams", stream_count);
 
+    retention_candidate_t *batch = malloc(RETENTION_BATCH_SIZE * sizeof(retention_candidate_t));
+    if (!batch) {
+        log_error("Failed to allocate memory for retention batch");
+        return -1;
+    }
+
     // Process each stream
-    for (int s = 0; s < stream_count; s++) {
+    for (int s = 0; s < stream_count && !retention_stop_requested; s++) {
         const char *stream_name = stream_names[s];
         stream_retention_config_t config;
 
@@ -291,43 +373,18 @@ int apply_retention_policy(void) {
             continue;
         }
 
-        // Phase 1: Time-based retention cleanup
-        if (config.retention_days > 0 || config.detection_retention_days > 0) {
-            recording_metadata_t recordings[MAX_RECORDINGS_PER_STREAM];
-            int count = get_recordings_for_retention(stream_name,
-                                                     config.retention_days,
-                                                     config.detection_retention_days,
-                                                     recordings,
-                                                     MAX_RECORDINGS_PER_STREAM);
-
-            if (count > 0) {
-                log_info("Stream %s: found %d recordings past retention", stream_name, count);
-
-                for (int i = 0; i < count; i++) {
-                    // Delete the file
-                    if (recordings[i].file_path[0] != '\0') {
-                        if (unlink(recordings[i].file_path) == 0) {
-                            log_debug("Deleted recording: %s (trigger: %s)",
-                                     recordings[i].file_path, recordings[i].trigger_type);
-                            total_freed += recordings[i].size_bytes;
-                            total_deleted++;
-                        } else if (errno != ENOENT) {
-                            log_error("Failed to delete recording file: %s (error: %s)",
-                                     recordings[i].file_path, strerror(errno));
-                        }
-                    }
-
-                    // Delete the database entry
-                    if (delete_recording_metadata(recordings[i].id) != 0) {
-                        log_warn("Failed to delete recording metadata for ID %llu",
-                                (unsigned long long)recordings[i].id);
-                    }
-                }
-            }
+        // Phase 1: Time-based retention cleanup, regular recordings first
+        if (config.retention_days > 0) {
+            total_deleted += apply_time_retention(stream_name, RETENTION_SCAN_REGULAR,
+                                                  config.retention_days, batch, &total_freed);
+        }
+        if (config.detection_retention_days > 0) {
+            total_deleted += apply_time_retention(stream_name, RETENTION_SCAN_DETECTION,
+                                                  config.detection_retention_days, batch, &total_freed);
         }
 
         // Phase 2: Storage quota enforcement
-        if (config.max_storage_mb > 0) {
+        if (config.max_storage_mb > 0 && !retention_stop_requested) {
             uint64_t current_usage = get_stream_storage_usage_db(stream_name);
             uint64_t max_bytes = config.max_storage_mb * 1024 * 1024;
 
@@ -336,32 +393,33 @@ int apply_retention_policy(void) {
                 log_info("Stream %s: over quota by %lu bytes, need to free space",
                         stream_name, (unsigned long)to_free);
 
-                recording_metadata_t recordings[MAX_RECORDINGS_PER_STREAM];
-                int count = get_recordings_for_quota_enforcement(stream_name,
-                                                                  recordings,
-                                                                  MAX_RECORDINGS_PER_STREAM);
-
+                retention_cursor_t cursor = {0};
                 uint64_t freed = 0;
-                for (int i = 0; i < count && freed < to_free; i++) {
-                    // Delete the file
-                    if (recordings[i].file_path[0] != '\0') {
-                        if (unlink(recordings[i].file_path) == 0) {
-                            log_debug("Deleted recording for quota: %s", recordings[i].file_path);
-                            freed += recordings[i].size_bytes;
-                            total_freed += recordings[i].size_bytes;
-                            total_deleted++;
-                        } else if (errno != ENOENT) {
-                            log_error("Failed to delete recording file: %s (error: %s)",
-                                     recordings[i].file_path, strerror(errno));
-                        }
+                while (freed < to_free && !retention_stop_requested) {
+                    int count = get_retention_batch(stream_name, RETENTION_SCAN_QUOTA, 0, &cursor,
+                                                    batch, RETENTION_BATCH_SIZE);
+                    if (count <= 0) {
+                        break;
+                    }
+
+                    // Only as many of the oldest as the quota needs
+                    int needed = 0;
+                    uint64_t needed_bytes = 0;
+                    while (needed < count && freed + needed_bytes < to_free) {
+                        needed_bytes += batch[needed++].size_bytes;
+                    }
+
+                    int deleted = delete_batch(stream_name, batch, needed, &freed);
+                    if (deleted < 0) {
+                        break;
                     }
+                    total_deleted += deleted;
 
-                    // Delete the database entry
-                    if (delete_recording_metadata(recordings[i].id) != 0) {
-                        log_warn("Failed to delete recording metadata for ID %llu",
-                                (unsigned long long)recordings[i].id);
+                    if (count < RETENTION_BATCH_SIZE) {
+                        break;
                     }
                 }
+                total_freed += freed;
 
                 log_info("Stream %s: freed %lu bytes for quota enforcement",
                         stream_name, (unsigned long)freed);
@@ -369,6 +427,11 @@ int apply_retention_policy(void) {
         }
     }
 
+    free(batch);
+
+    // Let the queued files go before looking for orphans on either side
+    storage_delete_queue_wait_idle();
+
     // Phase 3: Clean up orphaned database entries (files that no longer exist)
     recording_metadata_t orphaned[100];
     int orphan_count = get_orphaned_db_entries(orphaned, 100);
@@ -544,7 +607,7 @@ static struct {
     .running = false,
     .interval_seconds = 3600, // Default to 1 hour
     .last_cache_refresh = 0,
-    .cache_refresh_interval = 900 // Default to 15 minutes
+    .cache_refresh_interval = 3600 // Counters are kept up to date, rescan hourly to correct drift
 };
 
 // Forward declaration for the cache refresh function
@@ -629,11 +692,18 @@ int start_storage_manager_thread(int interval_seconds) {
     // Set interval (minimum 60 seconds)
     storage_manager_thread.interval_seconds = (interval_seconds < 60) ? 60 : interval_seconds;
     storage_manager_thread.running = true;
+    retention_stop_requested = false;
+
+    // Retention hands recording files to the deletion threads
+    if (init_storage_delete_queue() != 0) {
+        log_warn("Recording deletion queue unavailable, retention will delete files inline");
+    }
 
     // Create thread
     if (pthread_create(&storage_manager_thread.thread, NULL, storage_manager_thread_func, NULL) != 0) {
         log_error("Failed to create storage manager thread: %s", strerror(errno));
         storage_manager_thread.running = false;
+        shutdown_storage_delete_queue();
         pthread_mutex_unlock(&storage_manager_thread.mutex);
         return -1;
     }
@@ -656,6 +726,7 @@ int stop_storage_manager_thread(void) {
 
     // Signal thread to stop
     storage_manager_thread.running = false;
+    retention_stop_requested = true;
     pthread_mutex_unlock(&storage_manager_thread.mutex);
 
     // Wait for thread to exit
@@ -664,6 +735,9 @@ int stop_storage_manager_thread(void) {
         return -1;
     }
 
+    // Finish deleting the files of recordings already removed from the database
+    shutdown_storage_delete_queue();
+
     log_info("Storage manager thread stopped");
     return 0;
 }
@@ -11,6 +11,9 @@
 #include <sys/types.h>
 #include <unistd.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 #include "storage/storage_manager.h"
 #include "storage/storage_manager_streams.h"
@@ -18,6 +21,59 @@
 #include "core/config.h"
 #include <cjson/cJSON.h>
 
+// Maximum directory depth below a stream directory (mp4/<stream>/YYYY/MM/DD)
+#define MAX_SCAN_DEPTH 8
+
+/**
+ * Check whether a file name has an .mp4 extension
+ */
+static bool is_mp4_file(const char *name) {
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".mp4") == 0;
+}
+
+/**
+ * Sum the sizes of all regular files below a directory and count the MP4 files.
+ * Takes ownership of dir_fd.
+ */
+static void scan_directory(int dir_fd, int depth, uint64_t *size_bytes, int *file_count) {
+    DIR *dir = fdopendir(dir_fd);
+    if (!dir) {
+        close(dir_fd);
+        return;
+    }
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        // Skip . and ..
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+            continue;
+        }
+
+        struct stat st;
+        if (fstatat(dirfd(dir), entry->d_name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            continue;
+        }
+
+        if (S_ISDIR(st.st_mode)) {
+            if (depth < MAX_SCAN_DEPTH) {
+                int sub_fd = openat(dirfd(dir), entry->d_name,
+                                    O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+                if (sub_fd >= 0) {
+                    scan_directory(sub_fd, depth + 1, size_bytes, file_count);
+                }
+            }
+        } else if (S_ISREG(st.st_mode)) {
+            *size_bytes += (uint64_t)st.st_size;
+            if (is_mp4_file(entry->d_name)) {
+                (*file_count)++;
+            }
+        }
+    }
+
+    closedir(dir);
+}
+
 /**
  * Get storage usage per stream
  * 
@@ -55,39 +111,23 @@ int get_stream_storage_usage(const char *storage_path, stream_storage_info_t *st
             continue;
         }
         
-        // Check if it's a directory (stream directory)
-        char stream_path[512];
-        snprintf(stream_path, sizeof(stream_path), "%s/%s", mp4_path, entry->d_name);
-        
-        struct stat st;
-        if (stat(stream_path, &st) == 0 && S_ISDIR(st.st_mode)) {
-            // Initialize stream info
+        // Only stream directories are scanned
+        int stream_fd = openat(dirfd(dir), entry->d_name,
+                               O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (stream_fd < 0) {
+            continue;
+        }
+
+        uint64_t size_bytes = 0;
+        int file_count = 0;
+        scan_directory(stream_fd, 0, &size_bytes, &file_count);
+
+        if (file_count > 0) {
             strncpy(stream_info[stream_count].name, entry->d_name, sizeof(stream_info[stream_count].name) - 1);
             stream_info[stream_count].name[sizeof(stream_info[stream_count].name) - 1] = '\0';
-            stream_info[stream_count].size_bytes = 0;
-            stream_info[stream_count].recording_count = 0;
-            
-            // Use du command to get directory size
-            char du_cmd[768];
-            snprintf(du_cmd, sizeof(du_cmd), "du -sb %s 2>/dev/null | cut -f1", stream_path);
-            FILE *fp = popen(du_cmd, "r");
-            if (fp) {
-                if (fscanf(fp, "%lu", &stream_info[stream_count].size_bytes) == 1) {
-                    // Use find to count MP4 files
-                    char find_cmd[768];
-                    snprintf(find_cmd, sizeof(find_cmd), "find %s -type f -name \"*.mp4\" | wc -l", stream_path);
-                    FILE *fp_count = popen(find_cmd, "r");
-                    if (fp_count) {
-                        if (fscanf(fp_count, "%d", &stream_info[stream_count].recording_count) == 1) {
-                            if (stream_info[stream_count].recording_count > 0) {
-                                stream_count++;
-                            }
-                        }
-                        pclose(fp_count);
-                    }
-                }
-                pclose(fp);
-            }
+            stream_info[stream_count].size_bytes = size_bytes;
+            stream_info[stream_count].recording_count = file_count;
+            stream_count++;
         }
     }
     
@@ -199,7 +239,7 @@ int add_stream_storage_usage_to_json(cJSON *json_obj) {
         cJSON *stream_obj = cJSON_CreateObject();
         if (stream_obj) {
             cJSON_AddStringToObject(stream_obj, "name", stream_info[i].name);
-            cJSON_AddNumberToObject(stream_obj, "size", stream_info[i].size_bytes);
+            cJSON_AddNumberToObject(stream_obj, "size", (double)stream_info[i].size_bytes);
             cJSON_AddNumberToObject(stream_obj, "count", stream_info[i].recording_count);
             
             cJSON_AddItemToArray(stream_storage_array, stream_obj);
@@ -11,6 +11,7 @@
 #include <errno.h>
 #include <stdbool.h>
 #include <unistd.h>
+#include <sys/syscall.h>
 
 #include "storage/storage_manager_streams_cache.h"
 #include "storage/storage_manager.h"
@@ -22,11 +23,23 @@
 extern int get_stream_storage_usage(const char *storage_path, stream_storage_info_t *stream_info, int max_streams);
 extern int get_all_stream_storage_usage(stream_storage_info_t **stream_info);
 
+// Linux I/O priority values (see ioprio_set(2))
+#define IOPRIO_CLASS_SHIFT 13
+#define IOPRIO_CLASS_IDLE 3
+#define IOPRIO_WHO_PROCESS 1
+
 // Cache structure
+//
+// Per-stream byte and file counters. They are seeded by a full directory scan and
+// then kept up to date by stream_storage_cache_add_file() and
+// stream_storage_cache_remove_file(), so reads never touch the disk. The storage
+// manager thread periodically rescans to correct any drift.
 typedef struct {
     stream_storage_info_t *stream_info;
     int stream_count;
-    time_t last_update;
+    int capacity;
+    int seeded;                 // Counters hold the result of a scan
+    time_t last_update;         // Time of the last scan
     int ttl_seconds;
     pthread_mutex_t mutex;
     int initialized;
@@ -36,8 +49,11 @@ typedef struct {
 static stream_storage_cache_t cache = {
     .stream_info = NULL,
     .stream_count = 0,
+    .capacity = 0,
+    .seeded = 0,
     .last_update = 0,
     .ttl_seconds = 1800, // Default TTL: 30 minutes
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
     .initialized = 0
 };
 
@@ -48,12 +64,6 @@ static stream_storage_cache_t cache = {
  * @return 0 on success, -1 on error
  */
 int init_storage_manager_streams_cache(int cache_ttl_seconds) {
-    // Initialize mutex
-    if (pthread_mutex_init(&cache.mutex, NULL) != 0) {
-        log_error("Failed to initialize storage manager streams cache mutex");
-        return -1;
-    }
-
     pthread_mutex_lock(&cache.mutex);
 
     // Set TTL (minimum 10 seconds)
@@ -67,29 +77,116 @@ int init_storage_manager_streams_cache(int cache_ttl_seconds) {
 }
 
 /**
- * Check if cache is stale and needs refreshing
+ * Lower the I/O priority of the calling thread to the idle class
  *
- * @return 1 if cache is stale, 0 if cache is valid
+ * @return Previous I/O priority, or -1 if it could not be changed
  */
-static int is_cache_stale(void) {
-    if (!cache.initialized) {
-        return 1;
+static int set_idle_io_priority(void) {
+#ifdef SYS_ioprio_set
+    int previous = (int)syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    if (previous < 0) {
+        return -1;
+    }
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_CLASS_IDLE << IOPRIO_CLASS_SHIFT) != 0) {
+        return -1;
     }
+    return previous;
+#else
+    return -1;
+#endif
+}
 
-    if (!cache.stream_info || cache.stream_count <= 0) {
-        return 1;
+/**
+ * Restore an I/O priority returned by set_idle_io_priority()
+ */
+static void restore_io_priority(int previous) {
+#ifdef SYS_ioprio_set
+    if (previous >= 0) {
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, previous);
+    }
+#else
+    (void)previous;
+#endif
+}
+
+/**
+ * Find the counters of a stream, adding them if needed.
+ * Must be called with the cache mutex held.
+ */
+static stream_storage_info_t *find_stream_entry(const char *name, size_t name_len, bool create) {
+    if (name_len == 0 || name_len >= sizeof(cache.stream_info[0].name)) {
+        return NULL;
     }
 
-    time_t now = time(NULL);
-    if (now - cache.last_update > cache.ttl_seconds) {
-        return 1;
+    for (int i = 0; i < cache.stream_count; i++) {
+        if (strncmp(cache.stream_info[i].name, name, name_len) == 0 &&
+            cache.stream_info[i].name[name_len] == '\0') {
+            return &cache.stream_info[i];
+        }
     }
 
-    return 0;
+    if (!create) {
+        return NULL;
+    }
+
+    if (cache.stream_count == cache.capacity) {
+        int new_capacity = cache.capacity > 0 ? cache.capacity * 2 : 16;
+        stream_storage_info_t *grown = realloc(cache.stream_info, new_capacity * sizeof(stream_storage_info_t));
+        if (!grown) {
+            log_error("Failed to grow stream storage counters");
+            return NULL;
+        }
+        cache.stream_info = grown;
+        cache.capacity = new_capacity;
+    }
+
+    stream_storage_info_t *entry = &cache.stream_info[cache.stream_count++];
+    memset(entry, 0, sizeof(*entry));
+    memcpy(entry->name, name, name_len);
+    return entry;
+}
+
+/**
+ * Get the stream directory name of a file under <storage_path>/mp4/
+ *
+ * @return Pointer to the name inside file_path, or NULL if the file is not a stream recording
+ */
+static const char *stream_name_from_path(const char *file_path, size_t *name_len) {
+    const char *storage_path = g_config.storage_path;
+    size_t root_len = strlen(storage_path);
+
+    if (root_len == 0 || strncmp(file_path, storage_path, root_len) != 0) {
+        return NULL;
+    }
+
+    // Tolerate a trailing slash in the configured storage path
+    const char *rest = file_path + root_len;
+    if (rest[-1] != '/') {
+        if (*rest != '/') {
+            return NULL;
+        }
+        rest++;
+    }
+    while (*rest == '/') {
+        rest++;
+    }
+
+    if (strncmp(rest, "mp4/", 4) != 0) {
+        return NULL;
+    }
+    rest += 4;
+
+    const char *slash = strchr(rest, '/');
+    if (!slash) {
+        return NULL;
+    }
+
+    *name_len = (size_t)(slash - rest);
+    return rest;
 }
 
 /**
- * Refresh the cache with current storage usage data
+ * Refresh the cache by scanning the recording directories
  *
  * @return 0 on success, -1 on error
  */
@@ -98,11 +195,16 @@ static int refresh_cache(void) {
         init_storage_manager_streams_cache(900);
     }
 
+    // The scan is background work, keep it from competing with recording writes
+    int previous_ioprio = set_idle_io_priority();
+
     // Get current stream storage usage
     stream_storage_info_t *stream_info = NULL;
     int stream_count = get_all_stream_storage_usage(&stream_info);
 
-    if (stream_count <= 0 || !stream_info) {
+    restore_io_priority(previous_ioprio);
+
+    if (stream_count < 0) {
         log_warn("No stream storage usage information available for cache refresh");
         return -1;
     }
@@ -114,9 +216,11 @@ static int refresh_cache(void) {
         free(cache.stream_info);
     }
 
-    // Update cache with new data
+    // Replace the counters with the scanned values
     cache.stream_info = stream_info;
     cache.stream_count = stream_count;
+    cache.capacity = stream_count;
+    cache.seeded = 1;
     cache.last_update = time(NULL);
 
     pthread_mutex_unlock(&cache.mutex);
@@ -141,8 +245,13 @@ int get_cached_stream_storage_usage(stream_storage_info_t **stream_info, int for
     // Initialize output parameter
     *stream_info = NULL;
 
-    // Check if cache needs refreshing
-    if (force_refresh || is_cache_stale()) {
+    // Only scan when forced or before the counters have been seeded; afterwards
+    // they are maintained incrementally and rescanned by the storage manager thread
+    pthread_mutex_lock(&cache.mutex);
+    int seeded = cache.seeded;
+    pthread_mutex_unlock(&cache.mutex);
+
+    if (force_refresh || !seeded) {
         if (refresh_cache() != 0) {
             log_error("Failed to refresh storage manager streams cache");
             return -1;
@@ -154,7 +263,7 @@ int get_cached_stream_storage_usage(stream_storage_info_t **stream_info, int for
     // Check if cache is valid
     if (!cache.stream_info || cache.stream_count <= 0) {
         pthread_mutex_unlock(&cache.mutex);
-        log_warn("No cached stream storage usage information available");
+        log_debug("No cached stream storage usage information available");
         return 0;
     }
 
@@ -166,12 +275,21 @@ int get_cached_stream_storage_usage(stream_storage_info_t **stream_info, int for
         return -1;
     }
 
-    // Copy cached data to output array
-    memcpy(*stream_info, cache.stream_info, cache.stream_count * sizeof(stream_storage_info_t));
-    int stream_count = cache.stream_count;
+    // Copy streams that still hold recordings
+    int stream_count = 0;
+    for (int i = 0; i < cache.stream_count; i++) {
+        if (cache.stream_info[i].recording_count > 0) {
+            (*stream_info)[stream_count++] = cache.stream_info[i];
+        }
+    }
 
     pthread_mutex_unlock(&cache.mutex);
 
+    if (stream_count == 0) {
+        free(*stream_info);
+        *stream_info = NULL;
+    }
+
     return stream_count;
 }
 
@@ -212,7 +330,13 @@ int add_cached_stream_storage_usage_to_json(cJSON *json_obj, int force_refresh)
     stream_storage_info_t *stream_info = NULL;
     int stream_count = get_cached_stream_storage_usage(&stream_info, force_refresh);
 
-    if (stream_count <= 0 || !stream_info) {
+    if (stream_count == 0) {
+        // No stream holds recordings
+        cJSON_AddItemToObject(json_obj, "streamStorage", stream_storage_array);
+        return 0;
+    }
+
+    if (stream_count < 0 || !stream_info) {
         log_warn("No cached stream storage usage information available");
 
         // Try to get the information directly without caching
@@ -235,7 +359,7 @@ int add_cached_stream_storage_usage_to_json(cJSON *json_obj, int force_refresh)
         cJSON *stream_obj = cJSON_CreateObject();
         if (stream_obj) {
             cJSON_AddStringToObject(stream_obj, "name", stream_info[i].name);
-            cJSON_AddNumberToObject(stream_obj, "size", stream_info[i].size_bytes);
+            cJSON_AddNumberToObject(stream_obj, "size", (double)stream_info[i].size_bytes);
             cJSON_AddNumberToObject(stream_obj, "count", stream_info[i].recording_count);
 
             cJSON_AddItemToArray(stream_storage_array, stream_obj);
@@ -281,6 +405,8 @@ int invalidate_stream_storage_cache(void) {
     }
 
     cache.stream_count = 0;
+    cache.capacity = 0;
+    cache.seeded = 0;
     cache.last_update = 0;
 
     pthread_mutex_unlock(&cache.mutex);
@@ -298,3 +424,63 @@ int force_refresh_cache(void) {
     return refresh_cache();
 }
 
+/**
+ * Account for a recording file that was completed
+ *
+ * @param file_path Path of the file
+ * @param size_bytes Size of the file in bytes
+ */
+void stream_storage_cache_add_file(const char *file_path, uint64_t size_bytes) {
+    if (!file_path) {
+        return;
+    }
+
+    size_t name_len = 0;
+    const char *name = stream_name_from_path(file_path, &name_len);
+    if (!name) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache.mutex);
+    // Before the first scan there is nothing to update, the scan will count the file
+    if (cache.seeded) {
+        stream_storage_info_t *entry = find_stream_entry(name, name_len, true);
+        if (entry) {
+            entry->size_bytes += size_bytes;
+            const char *ext = strrchr(file_path, '.');
+            if (ext && strcmp(ext, ".mp4") == 0) {
+                entry->recording_count++;
+            }
+        }
+    }
+    pthread_mutex_unlock(&cache.mutex);
+}
+
+/**
+ * Account for a recording file that was deleted
+ *
+ * @param file_path Path of the file
+ * @param size_bytes Size of the file in bytes
+ */
+void stream_storage_cache_remove_file(const char *file_path, uint64_t size_bytes) {
+    if (!file_path) {
+        return;
+    }
+
+    size_t name_len = 0;
+    const char *name = stream_name_from_path(file_path, &name_len);
+    if (!name) {
+        return;
+    }
+
+    pthread_mutex_lock(&cache.mutex);
+    stream_storage_info_t *entry = cache.seeded ? find_stream_entry(name, name_len, false) : NULL;
+    if (entry) {
+        entry->size_bytes = entry->size_bytes > size_bytes ? entry->size_bytes - size_bytes : 0;
+        const char *ext = strrchr(file_path, '.');
+        if (ext && strcmp(ext, ".mp4") == 0 && entry->recording_count > 0) {
+            entry->recording_count--;
+        }
+    }
+    pthread_mutex_unlock(&cache.mutex);
+}
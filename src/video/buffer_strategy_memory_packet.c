@@ -152,6 +152,7 @@ typedef struct {
     int64_t first_pts;
     int64_t pts_offset;
     bool first_packet;
+    AVPacket *pkt;              // Reused for every packet, only holds a reference
 } flush_context_t;
 
 static int flush_packet_to_file(const AVPacket *packet, void *user_data) {
@@ -161,8 +162,9 @@ static int flush_packet_to_file(const AVPacket *packet, void *user_data) {
         return -1;
     }
 
-    AVPacket *pkt = av_packet_clone(packet);
-    if (!pkt) {
+    // Hand the muxer a new reference to the buffered payload instead of a copy
+    AVPacket *pkt = ctx->pkt;
+    if (av_packet_ref(pkt, packet) < 0) {
         return -1;
     }
 
@@ -187,10 +189,8 @@ static int flush_packet_to_file(const AVPacket *packet, void *user_data) {
         pkt->stream_index = ctx->audio_stream_idx >= 0 ? ctx->audio_stream_idx : 0;
     }
 
-    int ret = av_interleaved_write_frame(ctx->output_ctx, pkt);
-    av_packet_free(&pkt);
-
-    return ret;
+    // Takes over the reference and leaves pkt blank for the next packet
+    return av_interleaved_write_frame(ctx->output_ctx, pkt);
 }
 
 static int memory_packet_strategy_flush_to_file(pre_buffer_strategy_t *self,
@@ -257,10 +257,12 @@ static int memory_packet_strategy_flush_to_file(pre_buffer_strategy_t *self,
         .audio_stream_idx = -1,
         .first_pts = 0,
         .pts_offset = 0,
-        .first_packet = true
+        .first_packet = true,
+        .pkt = av_packet_alloc()
     };
 
-    int flushed = motion_buffer_flush(data->motion_buffer, flush_packet_to_file, &ctx);
+    int flushed = ctx.pkt ? motion_buffer_flush(data->motion_buffer, flush_packet_to_file, &ctx) : -1;
+    av_packet_free(&ctx.pkt);
 
     // Write trailer and cleanup
     av_write_trailer(output_ctx);
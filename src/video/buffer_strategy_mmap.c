@@ -9,6 +9,13 @@
  * - Gets benefits of both memory speed and disk capacity
  * - Survives process crashes (data is on disk)
  * 
+ * Packets are stored back to back as variable-length records in a byte ring,
+ * so the file only needs to hold buffer_seconds of the stream's actual bitrate.
+ * A separate in-memory index of keyframe positions lets a flush start at the
+ * right keyframe with a binary search instead of a scan. The ring starts from
+ * an estimated bitrate and grows (up to the disk limit) when it cannot hold
+ * buffer_seconds of content.
+ * 
  * Advantages:
  * - Memory-like access speed for hot data
  * - Automatic disk paging for cold data
@@ -18,9 +25,10 @@
  * Disadvantages:
  * - More complex implementation
  * - Disk I/O for cold pages
- * - Fixed file size allocation
  */
 
+#define _GNU_SOURCE
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,7 +43,7 @@
 #include "core/logger.h"
 #include "core/config.h"
 
-// Packet entry in mmap buffer (fixed size for simplicity)
+// Packet record in the ring, followed by data_size bytes of packet data
 typedef struct {
     uint32_t magic;                     // Magic value for validation
     uint32_t data_size;                 // Actual packet data size
@@ -48,23 +56,37 @@ typedef struct {
 } __attribute__((packed)) mmap_packet_entry_t;
 
 #define MMAP_MAGIC 0x4D4D5056            // "MMPV" - mmap packet video
-#define MAX_PACKET_SIZE (256 * 1024)     // 256KB max per packet
-#define ENTRY_SIZE(data_sz) (sizeof(mmap_packet_entry_t) + (data_sz))
-#define ENTRY_ALIGNED_SIZE(data_sz) (((ENTRY_SIZE(data_sz) + 4095) / 4096) * 4096)
+#define MMAP_WRAP_MAGIC 0x4D4D5057       // "MMPW" - rest of the ring is unused, continue at offset 0
+#define RECORD_ALIGN 8
+#define RECORD_SIZE(data_sz) \
+    (((sizeof(mmap_packet_entry_t) + (data_sz)) + RECORD_ALIGN - 1) & ~((size_t)RECORD_ALIGN - 1))
+
+// Ring sizing: buffer_seconds at this rate plus headroom, grown on demand
+#define MMAP_ESTIMATED_BYTES_PER_SEC (512 * 1024)   // 4 Mbit/s
+#define MMAP_MIN_RING_SIZE (1024 * 1024)
+#define MMAP_MAX_RING_SIZE (256 * 1024 * 1024)      // Used when no disk limit is configured
 
 // Mmap buffer header
 typedef struct {
     uint32_t magic;                     // File magic
     uint32_t version;                   // Format version
-    uint32_t entry_count;               // Number of entries
-    uint32_t head;                      // Write position
-    uint32_t tail;                      // Read position
-    uint64_t total_size;                // Total mapped size
+    uint32_t entry_count;               // Number of records
+    uint32_t reserved;
+    uint64_t head;                      // Logical write position
+    uint64_t tail;                      // Logical position of the oldest record
+    uint64_t ring_size;                 // Size of the data area
     uint64_t data_offset;               // Offset to data area
     char stream_name[256];              // Stream name
 } __attribute__((packed)) mmap_buffer_header_t;
 
 #define MMAP_FILE_MAGIC 0x4E564D4D       // "NVMM" - NVR mmap
+#define MMAP_FILE_VERSION 2
+
+// Keyframe index entry
+typedef struct {
+    uint64_t pos;                       // Logical position of the keyframe record
+    time_t timestamp;                   // Wall clock timestamp
+} keyframe_index_entry_t;
 
 // Strategy private data
 typedef struct {
@@ -75,24 +97,35 @@ typedef struct {
     size_t mapped_size;                 // Total mapped size
     mmap_buffer_header_t *header;       // Pointer to header
     uint8_t *data_area;                 // Pointer to data area
-    
+
     int buffer_seconds;
-    int max_entries;                    // Maximum packet entries
-    size_t entry_size;                  // Size per entry slot
-    
+    size_t ring_size;                   // Size of the data area
+    size_t max_ring_size;               // Limit for growing the ring
+
+    // Logical positions grow monotonically, the physical offset is pos % ring_size
+    uint64_t head;
+    uint64_t tail;
+
+    // Keyframe positions in ring order, oldest at kf_first
+    keyframe_index_entry_t *kf_index;
+    int kf_capacity;
+    int kf_first;
+    int kf_count;
+
     pthread_mutex_t lock;
-    
+
     // Statistics
     int current_count;
     size_t current_bytes;
     time_t oldest_timestamp;
     time_t newest_timestamp;
-    int keyframe_count;
 } mmap_strategy_data_t;
 
 // --- Private helper functions ---
 
-static int create_mmap_file(mmap_strategy_data_t *data, size_t size) {
+static int create_mmap_file(mmap_strategy_data_t *data, size_t ring_size) {
+    size_t size = sizeof(mmap_buffer_header_t) + ring_size;
+
     // Open/create file
     data->fd = open(data->file_path, O_RDWR | O_CREAT, 0644);
     if (data->fd < 0) {
@@ -112,22 +145,22 @@ static int create_mmap_file(mmap_strategy_data_t *data, size_t size) {
     data->mapped_data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, data->fd, 0);
     if (data->mapped_data == MAP_FAILED) {
         log_error("Failed to mmap file: %s", strerror(errno));
+        data->mapped_data = NULL;
         close(data->fd);
         data->fd = -1;
         return -1;
     }
     
     data->mapped_size = size;
+    data->ring_size = ring_size;
     data->header = (mmap_buffer_header_t *)data->mapped_data;
     data->data_area = data->mapped_data + sizeof(mmap_buffer_header_t);
     
     // Initialize header
+    memset(data->header, 0, sizeof(*data->header));
     data->header->magic = MMAP_FILE_MAGIC;
-    data->header->version = 1;
-    data->header->entry_count = 0;
-    data->header->head = 0;
-    data->header->tail = 0;
-    data->header->total_size = size;
+    data->header->version = MMAP_FILE_VERSION;
+    data->header->ring_size = ring_size;
     data->header->data_offset = sizeof(mmap_buffer_header_t);
     strncpy(data->header->stream_name, data->stream_name, sizeof(data->header->stream_name) - 1);
     
@@ -139,26 +172,229 @@ static int create_mmap_file(mmap_strategy_data_t *data, size_t size) {
     return 0;
 }
 
+static void sync_header(mmap_strategy_data_t *data) {
+    data->header->head = data->head;
+    data->header->tail = data->tail;
+    data->header->entry_count = (uint32_t)data->current_count;
+}
+
+/**
+ * Get the record at a logical position, following a wrap marker.
+ * Advances *pos to the position of the returned record.
+ */
+static mmap_packet_entry_t *record_at(mmap_strategy_data_t *data, uint64_t *pos) {
+    size_t offset = *pos % data->ring_size;
+    mmap_packet_entry_t *entry = (mmap_packet_entry_t *)(data->data_area + offset);
+
+    if (offset != 0 && entry->magic == MMAP_WRAP_MAGIC) {
+        *pos += data->ring_size - offset;
+        entry = (mmap_packet_entry_t *)data->data_area;
+    }
+    return entry;
+}
+
+static keyframe_index_entry_t *keyframe_at(mmap_strategy_data_t *data, int i) {
+    return &data->kf_index[(data->kf_first + i) % data->kf_capacity];
+}
+
+static int push_keyframe(mmap_strategy_data_t *data, uint64_t pos, time_t timestamp) {
+    if (data->kf_count == data->kf_capacity) {
+        int new_capacity = data->kf_capacity > 0 ? data->kf_capacity * 2 : 64;
+        keyframe_index_entry_t *index = malloc(new_capacity * sizeof(*index));
+        if (!index) {
+            return -1;
+        }
+        for (int i = 0; i < data->kf_count; i++) {
+            index[i] = *keyframe_at(data, i);
+        }
+        free(data->kf_index);
+        data->kf_index = index;
+        data->kf_capacity = new_capacity;
+        data->kf_first = 0;
+    }
+
+    keyframe_index_entry_t *entry = &data->kf_index[(data->kf_first + data->kf_count) % data->kf_capacity];
+    entry->pos = pos;
+    entry->timestamp = timestamp;
+    data->kf_count++;
+    return 0;
+}
+
+/**
+ * Find the newest keyframe at or before a wall clock time
+ *
+ * @return Index into the keyframe index, or -1 if every keyframe is newer
+ */
+static int find_keyframe_before(mmap_strategy_data_t *data, time_t cutoff) {
+    int lo = 0;
+    int hi = data->kf_count - 1;
+    int found = -1;
+
+    while (lo <= hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (keyframe_at(data, mid)->timestamp <= cutoff) {
+            found = mid;
+            lo = mid + 1;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return found;
+}
+
+/**
+ * Drop the oldest record
+ */
+static void evict_oldest(mmap_strategy_data_t *data) {
+    mmap_packet_entry_t *entry = record_at(data, &data->tail);
+
+    if (entry->magic == MMAP_MAGIC) {
+        data->current_bytes -= entry->data_size;
+        data->tail += RECORD_SIZE(entry->data_size);
+    } else {
+        // Corrupt record, nothing after it can be trusted
+        log_warn("Invalid mmap record at offset %zu for %s, dropping buffer",
+                 (size_t)(data->tail % data->ring_size), data->stream_name);
+        data->tail = data->head;
+    }
+    data->current_count--;
+
+    while (data->kf_count > 0 && keyframe_at(data, 0)->pos < data->tail) {
+        data->kf_first = (data->kf_first + 1) % data->kf_capacity;
+        data->kf_count--;
+    }
+
+    if (data->tail >= data->head) {
+        data->tail = data->head;
+        data->current_count = 0;
+        data->current_bytes = 0;
+        data->oldest_timestamp = 0;
+    } else {
+        data->oldest_timestamp = record_at(data, &data->tail)->timestamp;
+    }
+}
+
+/**
+ * Drop records that are no longer needed: everything before the newest
+ * keyframe that is already older than buffer_seconds
+ */
+static void evict_expired(mmap_strategy_data_t *data) {
+    int kf = find_keyframe_before(data, data->newest_timestamp - data->buffer_seconds);
+    if (kf < 0) {
+        return;
+    }
+
+    uint64_t keep_from = keyframe_at(data, kf)->pos;
+    while (data->current_count > 0 && data->tail < keep_from) {
+        evict_oldest(data);
+    }
+}
+
+/**
+ * Grow the ring so it holds at least min_ring_size bytes
+ *
+ * The live records are copied out, the file is extended and remapped, and the
+ * records are written back from offset 0.
+ */
+static int grow_ring(mmap_strategy_data_t *data, size_t min_ring_size) {
+    size_t new_ring_size = data->ring_size;
+    while (new_ring_size < min_ring_size) {
+        new_ring_size *= 2;
+    }
+    if (new_ring_size > data->max_ring_size) {
+        new_ring_size = data->max_ring_size;
+    }
+    if (new_ring_size <= data->ring_size) {
+        return -1;
+    }
+
+    uint8_t *records = malloc(data->ring_size);
+    if (!records) {
+        return -1;
+    }
+
+    // Linearize the live records
+    size_t len = 0;
+    uint64_t pos = data->tail;
+    for (int i = 0; i < data->current_count; i++) {
+        mmap_packet_entry_t *entry = record_at(data, &pos);
+        size_t record_size = RECORD_SIZE(entry->data_size);
+        memcpy(records + len, entry, record_size);
+        len += record_size;
+        pos += record_size;
+    }
+
+    size_t new_size = sizeof(mmap_buffer_header_t) + new_ring_size;
+    if (ftruncate(data->fd, new_size) < 0) {
+        log_warn("Failed to grow mmap file %s: %s", data->file_path, strerror(errno));
+        free(records);
+        return -1;
+    }
+
+    uint8_t *mapped = mremap(data->mapped_data, data->mapped_size, new_size, MREMAP_MAYMOVE);
+    if (mapped == MAP_FAILED) {
+        log_warn("Failed to remap mmap file %s: %s", data->file_path, strerror(errno));
+        if (ftruncate(data->fd, data->mapped_size) < 0) {
+            log_warn("Failed to shrink mmap file %s back: %s", data->file_path, strerror(errno));
+        }
+        free(records);
+        return -1;
+    }
+
+    data->mapped_data = mapped;
+    data->mapped_size = new_size;
+    data->ring_size = new_ring_size;
+    data->header = (mmap_buffer_header_t *)mapped;
+    data->data_area = mapped + sizeof(mmap_buffer_header_t);
+    data->header->ring_size = new_ring_size;
+    madvise(data->mapped_data, new_size, MADV_SEQUENTIAL);
+
+    memcpy(data->data_area, records, len);
+    free(records);
+
+    // Rebuild the keyframe index for the new positions
+    data->kf_first = 0;
+    data->kf_count = 0;
+    data->tail = 0;
+    data->head = len;
+    for (pos = 0; pos < len; ) {
+        mmap_packet_entry_t *entry = (mmap_packet_entry_t *)(data->data_area + pos);
+        if ((entry->flags & AV_PKT_FLAG_KEY) && push_keyframe(data, pos, entry->timestamp) != 0) {
+            log_warn("Failed to index keyframe for %s", data->stream_name);
+        }
+        pos += RECORD_SIZE(entry->data_size);
+    }
+    sync_header(data);
+
+    log_info("Grew mmap buffer for %s to %zu bytes", data->stream_name, new_size);
+    return 0;
+}
+
 // --- Strategy interface methods ---
 
 static int mmap_strategy_init(pre_buffer_strategy_t *self, const buffer_config_t *config) {
     mmap_strategy_data_t *data = (mmap_strategy_data_t *)self->private_data;
 
-    data->buffer_seconds = config->buffer_seconds;
+    data->buffer_seconds = config->buffer_seconds > 0 ? config->buffer_seconds : 1;
 
-    // Calculate buffer size
-    // Assume ~30 fps, ~50KB per frame average, 1.5x overhead
-    int estimated_frames = config->estimated_fps > 0 ? config->estimated_fps : 30;
-    data->max_entries = estimated_frames * config->buffer_seconds * 2;  // 2x for audio+video
-    data->entry_size = ENTRY_ALIGNED_SIZE(MAX_PACKET_SIZE);
-
-    size_t total_size = sizeof(mmap_buffer_header_t) +
-                        (data->max_entries * data->entry_size);
+    // Size the ring for the buffered duration at an estimated bitrate, with 50% headroom
+    size_t ring_size = (size_t)data->buffer_seconds * MMAP_ESTIMATED_BYTES_PER_SEC * 3 / 2;
+    if (ring_size < MMAP_MIN_RING_SIZE) {
+        ring_size = MMAP_MIN_RING_SIZE;
+    }
 
     // Cap at configured limit if specified
-    if (config->disk_limit_bytes > 0 && total_size > config->disk_limit_bytes) {
-        total_size = config->disk_limit_bytes;
-        data->max_entries = (total_size - sizeof(mmap_buffer_header_t)) / data->entry_size;
+    data->max_ring_size = MMAP_MAX_RING_SIZE;
+    if (config->disk_limit_bytes > 0) {
+        if (config->disk_limit_bytes <= sizeof(mmap_buffer_header_t) + RECORD_ALIGN) {
+            log_error("Disk limit of %zu bytes is too small for mmap buffer", config->disk_limit_bytes);
+            return -1;
+        }
+        data->max_ring_size = (config->disk_limit_bytes - sizeof(mmap_buffer_header_t)) &
+                              ~((size_t)RECORD_ALIGN - 1);
+    }
+    if (ring_size > data->max_ring_size) {
+        ring_size = data->max_ring_size;
     }
 
     // Set up file path
@@ -177,14 +413,14 @@ static int mmap_strategy_init(pre_buffer_strategy_t *self, const buffer_config_t
     pthread_mutex_init(&data->lock, NULL);
 
     // Create mmap file
-    if (create_mmap_file(data, total_size) != 0) {
+    if (create_mmap_file(data, ring_size) != 0) {
         pthread_mutex_destroy(&data->lock);
         return -1;
     }
 
     self->initialized = true;
-    log_info("Mmap strategy initialized for %s (%d entries, %zu bytes)",
-             data->stream_name, data->max_entries, total_size);
+    log_info("Mmap strategy initialized for %s (%ds, %zu byte ring, up to %zu bytes)",
+             data->stream_name, data->buffer_seconds, ring_size, data->max_ring_size);
 
     return 0;
 }
@@ -206,6 +442,8 @@ static void mmap_strategy_destroy(pre_buffer_strategy_t *self) {
     // Optionally remove the buffer file
     // unlink(data->file_path);
 
+    free(data->kf_index);
+
     pthread_mutex_unlock(&data->lock);
     pthread_mutex_destroy(&data->lock);
 
@@ -219,33 +457,58 @@ static int mmap_strategy_add_packet(pre_buffer_strategy_t *self,
                                      time_t timestamp) {
     mmap_strategy_data_t *data = (mmap_strategy_data_t *)self->private_data;
 
-    if (!packet || packet->size > MAX_PACKET_SIZE) {
+    if (!packet || packet->size <= 0) {
         return -1;
     }
 
+    size_t record_size = RECORD_SIZE(packet->size);
+
     pthread_mutex_lock(&data->lock);
 
-    // Calculate entry position
-    size_t offset = data->header->head * data->entry_size;
-    mmap_packet_entry_t *entry = (mmap_packet_entry_t *)(data->data_area + offset);
+    // A single packet may use at most half the ring
+    if (record_size > data->ring_size / 2) {
+        grow_ring(data, record_size * 2);
+    }
+    if (record_size > data->ring_size / 2) {
+        pthread_mutex_unlock(&data->lock);
+        log_warn("Packet of %d bytes does not fit mmap buffer for %s", packet->size, data->stream_name);
+        return -1;
+    }
 
-    // If buffer is full, advance tail
-    if (data->header->entry_count >= data->max_entries) {
-        // Remove oldest entry from stats
-        size_t tail_offset = data->header->tail * data->entry_size;
-        mmap_packet_entry_t *tail_entry = (mmap_packet_entry_t *)(data->data_area + tail_offset);
-        if (tail_entry->magic == MMAP_MAGIC) {
-            data->current_bytes -= tail_entry->data_size;
-            if (tail_entry->flags & AV_PKT_FLAG_KEY) {
-                data->keyframe_count--;
-            }
+    if (timestamp > data->newest_timestamp) {
+        data->newest_timestamp = timestamp;
+    }
+    evict_expired(data);
+
+    // Records never straddle the end of the ring
+    size_t offset = data->head % data->ring_size;
+    size_t skip = data->ring_size - offset < record_size ? data->ring_size - offset : 0;
+
+    // Make room, growing the ring first if content younger than buffer_seconds would be lost
+    while (data->current_count > 0 && data->head + skip + record_size - data->tail > data->ring_size) {
+        if (data->oldest_timestamp > data->newest_timestamp - data->buffer_seconds &&
+            data->ring_size < data->max_ring_size && grow_ring(data, data->ring_size * 2) == 0) {
+            offset = data->head % data->ring_size;
+            skip = data->ring_size - offset < record_size ? data->ring_size - offset : 0;
+            continue;
         }
+        evict_oldest(data);
+    }
+    if (data->current_count == 0) {
+        // Restart at the beginning of the ring
+        data->head = data->tail = 0;
+        offset = 0;
+        skip = 0;
+    }
 
-        data->header->tail = (data->header->tail + 1) % data->max_entries;
-        data->header->entry_count--;
+    if (skip > 0) {
+        ((mmap_packet_entry_t *)(data->data_area + offset))->magic = MMAP_WRAP_MAGIC;
+        data->head += skip;
+        offset = 0;
     }
 
-    // Write entry
+    // Write record
+    mmap_packet_entry_t *entry = (mmap_packet_entry_t *)(data->data_area + offset);
     entry->magic = MMAP_MAGIC;
     entry->data_size = packet->size;
     entry->pts = packet->pts;
@@ -255,20 +518,19 @@ static int mmap_strategy_add_packet(pre_buffer_strategy_t *self,
     entry->timestamp = timestamp;
     memcpy(entry->data, packet->data, packet->size);
 
+    if ((packet->flags & AV_PKT_FLAG_KEY) && push_keyframe(data, data->head, timestamp) != 0) {
+        log_warn("Failed to index keyframe for %s", data->stream_name);
+    }
+
     // Update head
-    data->header->head = (data->header->head + 1) % data->max_entries;
-    data->header->entry_count++;
-    data->current_count = data->header->entry_count;
+    data->head += record_size;
+    data->current_count++;
     data->current_bytes += packet->size;
-    data->newest_timestamp = timestamp;
 
-    if (data->header->entry_count == 1) {
+    if (data->current_count == 1) {
         data->oldest_timestamp = timestamp;
     }
-
-    if (packet->flags & AV_PKT_FLAG_KEY) {
-        data->keyframe_count++;
-    }
+    sync_header(data);
 
     pthread_mutex_unlock(&data->lock);
 
@@ -285,8 +547,8 @@ static int mmap_strategy_get_stats(pre_buffer_strategy_t *self, buffer_stats_t *
     stats->packet_count = data->current_count;
     stats->memory_usage_bytes = 0;  // Memory managed by OS
     stats->disk_usage_bytes = data->mapped_size;
-    stats->keyframe_count = data->keyframe_count;
-    stats->has_complete_gop = (data->keyframe_count > 0);
+    stats->keyframe_count = data->kf_count;
+    stats->has_complete_gop = (data->kf_count > 0);
     stats->oldest_timestamp = data->oldest_timestamp;
     stats->newest_timestamp = data->newest_timestamp;
 
@@ -311,14 +573,15 @@ static void mmap_strategy_clear(pre_buffer_strategy_t *self) {
 
     pthread_mutex_lock(&data->lock);
 
-    data->header->head = 0;
-    data->header->tail = 0;
-    data->header->entry_count = 0;
+    data->head = 0;
+    data->tail = 0;
+    data->kf_first = 0;
+    data->kf_count = 0;
     data->current_count = 0;
     data->current_bytes = 0;
-    data->keyframe_count = 0;
     data->oldest_timestamp = 0;
     data->newest_timestamp = 0;
+    sync_header(data);
 
     pthread_mutex_unlock(&data->lock);
 }
@@ -330,17 +593,24 @@ static int mmap_strategy_flush_to_callback(pre_buffer_strategy_t *self,
 
     pthread_mutex_lock(&data->lock);
 
-    int flushed = 0;
-    uint32_t pos = data->header->tail;
+    // Start at the newest keyframe that still gives buffer_seconds of pre-roll,
+    // or the oldest keyframe if the buffer holds less than that
+    uint64_t pos = data->tail;
+    if (data->kf_count > 0) {
+        int kf = find_keyframe_before(data, data->newest_timestamp - data->buffer_seconds);
+        pos = keyframe_at(data, kf >= 0 ? kf : 0)->pos;
+    } else if (data->current_count > 0) {
+        log_warn("No keyframe in mmap buffer for %s, flush will not start on a keyframe",
+                 data->stream_name);
+    }
 
-    for (uint32_t i = 0; i < data->header->entry_count; i++) {
-        size_t offset = pos * data->entry_size;
-        mmap_packet_entry_t *entry = (mmap_packet_entry_t *)(data->data_area + offset);
+    int flushed = 0;
+    while (pos < data->head) {
+        mmap_packet_entry_t *entry = record_at(data, &pos);
 
         if (entry->magic != MMAP_MAGIC) {
-            log_warn("Invalid mmap entry at position %u", pos);
-            pos = (pos + 1) % data->max_entries;
-            continue;
+            log_warn("Invalid mmap record at offset %zu", (size_t)(pos % data->ring_size));
+            break;
         }
 
         // Reconstruct AVPacket
@@ -368,7 +638,7 @@ static int mmap_strategy_flush_to_callback(pre_buffer_strategy_t *self,
         }
 
         flushed++;
-        pos = (pos + 1) % data->max_entries;
+        pos += RECORD_SIZE(entry->data_size);
     }
 
     pthread_mutex_unlock(&data->lock);
@@ -29,6 +29,7 @@
 #include "video/detection_result.h"
 #include "video/detection_recording.h"
 #include "video/detection_embedded.h"
+#include "video/motion_detection.h"
 #include "video/streams.h"
 #include "video/hls_writer.h"
 #include "video/hls/hls_unified_thread.h"
@@ -53,6 +54,258 @@ time_t global_startup_delay_end = 0;
 int detect_objects(detection_model_t model, const uint8_t *frame_data, int width, int height, int channels, detection_result_t *result);
 int process_frame_for_recording(const char *stream_name, const uint8_t *frame_data, int width, int height, int channels, time_t timestamp, detection_result_t *result);
 
+/**
+ * Check if a model path selects built-in motion detection rather than a model file
+ */
+static bool is_motion_only_model(const char *model_path) {
+    return model_path && (strcmp(model_path, "motion") == 0 || ends_with(model_path, "/motion"));
+}
+
+/**
+ * Check if the first plane of a decoded frame is a full-resolution 8-bit luma plane
+ */
+static bool has_luma_plane(int format) {
+    switch (format) {
+        case AV_PIX_FMT_YUV420P:
+        case AV_PIX_FMT_YUVJ420P:
+        case AV_PIX_FMT_YUV422P:
+        case AV_PIX_FMT_YUVJ422P:
+        case AV_PIX_FMT_YUV444P:
+        case AV_PIX_FMT_YUVJ444P:
+        case AV_PIX_FMT_NV12:
+        case AV_PIX_FMT_NV21:
+        case AV_PIX_FMT_GRAY8:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/**
+ * Decode pipeline kept across the segments of a stream
+ *
+ * Every HLS segment of a stream carries the same codec, so the decoder, frame,
+ * packet and scaler are built once and only rebuilt when the codec parameters
+ * change. Only used by the stream's own detection thread.
+ */
+struct segment_decoder {
+    AVCodecContext *codec_ctx;
+    enum AVCodecID codec_id;        // Parameters the decoder was opened with
+    int width;
+    int height;
+    int lowres;
+    uint8_t *extradata;
+    int extradata_size;
+
+    AVFrame *frame;
+    AVPacket *pkt;
+
+    struct SwsContext *sws_ctx;     // Reused through sws_getCachedContext
+    uint8_t *scaled_buffer;
+    size_t scaled_size;
+
+    float segment_duration;         // From the last segment that was fully probed
+    double frames_per_second;
+};
+
+/**
+ * Find the first video stream of an opened input
+ */
+static int find_video_stream(const AVFormatContext *format_ctx) {
+    for (unsigned int i = 0; i < format_ctx->nb_streams; i++) {
+        if (format_ctx->streams[i] && format_ctx->streams[i]->codecpar &&
+            format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO &&
+            format_ctx->streams[i]->codecpar->codec_id != AV_CODEC_ID_NONE) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Check if a decoder can keep decoding a stream with the given parameters.
+ * Dimensions and extradata are only compared when the demuxer reported them,
+ * which it does not without a stream info probe.
+ */
+static bool segment_decoder_matches(const segment_decoder_t *decoder, const AVCodecParameters *par,
+                                    int lowres) {
+    if (decoder->codec_id != par->codec_id || decoder->lowres != lowres) {
+        return false;
+    }
+
+    if (par->width > 0 && par->height > 0 &&
+        (decoder->width != par->width || decoder->height != par->height)) {
+        return false;
+    }
+
+    if (par->extradata_size > 0 &&
+        (decoder->extradata_size != par->extradata_size ||
+         memcmp(decoder->extradata, par->extradata, (size_t)par->extradata_size) != 0)) {
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * Free a thread's segment decoder
+ */
+static void free_segment_decoder(stream_detection_thread_t *thread) {
+    segment_decoder_t *decoder = thread->decoder;
+    if (!decoder) {
+        return;
+    }
+
+    avcodec_free_context(&decoder->codec_ctx);
+    av_frame_free(&decoder->frame);
+    av_packet_free(&decoder->pkt);
+    sws_freeContext(decoder->sws_ctx);
+    free(decoder->scaled_buffer);
+    free(decoder->extradata);
+    free(decoder);
+    thread->decoder = NULL;
+}
+
+/**
+ * Open the thread's segment decoder for the given codec parameters, replacing
+ * any existing decoder
+ *
+ * @return 0 on success, -1 on error
+ */
+static int open_segment_decoder(stream_detection_thread_t *thread, const AVCodec *codec,
+                                const AVCodecParameters *par, int lowres) {
+    // Keep the timing learned from earlier segments across the rebuild
+    float segment_duration = thread->decoder ? thread->decoder->segment_duration : 0.0f;
+    double frames_per_second = thread->decoder ? thread->decoder->frames_per_second : 0.0;
+    bool rebuild = thread->decoder != NULL;
+
+    free_segment_decoder(thread);
+
+    segment_decoder_t *decoder = calloc(1, sizeof(segment_decoder_t));
+    if (!decoder) {
+        log_error("[Stream %s] Could not allocate segment decoder", thread->stream_name);
+        return -1;
+    }
+
+    decoder->codec_ctx = avcodec_alloc_context3(codec);
+    decoder->frame = av_frame_alloc();
+    decoder->pkt = av_packet_alloc();
+    if (!decoder->codec_ctx || !decoder->frame || !decoder->pkt) {
+        log_error("[Stream %s] Could not allocate decoder resources", thread->stream_name);
+        goto fail;
+    }
+
+    int ret = avcodec_parameters_to_context(decoder->codec_ctx, par);
+    if (ret < 0) {
+        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        log_error("[Stream %s] Could not copy codec parameters (error: %s)",
+                 thread->stream_name, err_buf);
+        goto fail;
+    }
+    decoder->codec_ctx->lowres = lowres;
+
+    ret = avcodec_open2(decoder->codec_ctx, codec, NULL);
+    if (ret < 0) {
+        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+        av_strerror(ret, err_buf, sizeof(err_buf));
+        log_error("[Stream %s] Could not open codec %s (error: %s)",
+                 thread->stream_name, codec->name, err_buf);
+        goto fail;
+    }
+
+    if (par->extradata_size > 0) {
+        decoder->extradata = malloc((size_t)par->extradata_size);
+        if (!decoder->extradata) {
+            log_error("[Stream %s] Could not allocate decoder extradata", thread->stream_name);
+            goto fail;
+        }
+        memcpy(decoder->extradata, par->extradata, (size_t)par->extradata_size);
+        decoder->extradata_size = par->extradata_size;
+    }
+
+    decoder->codec_id = par->codec_id;
+    decoder->width = par->width;
+    decoder->height = par->height;
+    decoder->lowres = lowres;
+    decoder->segment_duration = segment_duration;
+    decoder->frames_per_second = frames_per_second;
+    thread->decoder = decoder;
+
+    log_info("[Stream %s] %s segment decoder: %s %dx%d (lowres %d)",
+             thread->stream_name, rebuild ? "Rebuilt" : "Opened", codec->name,
+             par->width, par->height, lowres);
+    return 0;
+
+fail:
+    thread->decoder = decoder;
+    free_segment_decoder(thread);
+    return -1;
+}
+
+/**
+ * Convert a decoded frame into a packed buffer owned by the segment decoder
+ *
+ * @return Pointer to the converted pixels (valid until the next call), or NULL on error
+ */
+static uint8_t *segment_decoder_scale(stream_detection_thread_t *thread, const AVFrame *frame,
+                                      int dst_width, int dst_height, enum AVPixelFormat dst_format,
+                                      int channels, int flags) {
+    segment_decoder_t *decoder = thread->decoder;
+
+    decoder->sws_ctx = sws_getCachedContext(decoder->sws_ctx,
+        frame->width, frame->height, frame->format,
+        dst_width, dst_height, dst_format,
+        flags, NULL, NULL, NULL);
+    if (!decoder->sws_ctx) {
+        log_error("[Stream %s] Failed to create SwsContext for pixel format %d",
+                 thread->stream_name, frame->format);
+        return NULL;
+    }
+
+    size_t size = (size_t)dst_width * dst_height * channels;
+    if (size > decoder->scaled_size) {
+        uint8_t *buffer = realloc(decoder->scaled_buffer, size);
+        if (!buffer) {
+            log_error("[Stream %s] Failed to allocate %zu byte conversion buffer",
+                     thread->stream_name, size);
+            return NULL;
+        }
+        decoder->scaled_buffer = buffer;
+        decoder->scaled_size = size;
+    }
+
+    uint8_t *dst_data[4] = {decoder->scaled_buffer, NULL, NULL, NULL};
+    int dst_linesize[4] = {dst_width * channels, 0, 0, 0};
+    sws_scale(decoder->sws_ctx, (const uint8_t * const *)frame->data, frame->linesize, 0,
+             frame->height, dst_data, dst_linesize);
+
+    return decoder->scaled_buffer;
+}
+
+/**
+ * Run motion detection on a decoded frame
+ *
+ * The Y plane of YUV frames is passed straight to the motion detector. Other pixel
+ * formats are converted to grayscale first, which is still a single pass.
+ */
+static int detect_motion_on_frame(stream_detection_thread_t *thread, const AVFrame *frame,
+                                  int prescale_factor, time_t frame_time, detection_result_t *result) {
+    if (has_luma_plane(frame->format)) {
+        return detect_motion_luma(thread->stream_name, frame->data[0], frame->linesize[0],
+                                  frame->width, frame->height, prescale_factor, frame_time, result);
+    }
+
+    uint8_t *gray_buffer = segment_decoder_scale(thread, frame, frame->width, frame->height,
+                                                 AV_PIX_FMT_GRAY8, 1, SWS_POINT);
+    if (!gray_buffer) {
+        return -1;
+    }
+
+    return detect_motion_luma(thread->stream_name, gray_buffer, frame->width,
+                              frame->width, frame->height, prescale_factor, frame_time, result);
+}
+
 /**
  * Process a frame directly for detection
  * This function is called from process_decoded_frame_for_detection
@@ -209,7 +462,6 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     AVCodecContext *codec_ctx = NULL;
     AVFrame *frame = NULL;
     AVPacket *pkt = NULL;
-    struct SwsContext *sws_ctx = NULL;
     int video_stream_idx = -1;
     int ret = -1;
 
@@ -242,8 +494,11 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     // This prevents potential double-free issues if avformat_open_input fails
     format_ctx = NULL;
 
+    // HLS segments are written as MPEG-TS, naming the demuxer skips content probing
+    const AVInputFormat *input_format = ends_with(segment_path, ".ts") ? av_find_input_format("mpegts") : NULL;
+
     // Open input file with safety checks
-    int open_result = avformat_open_input(&format_ctx, segment_path, NULL, NULL);
+    int open_result = avformat_open_input(&format_ctx, segment_path, input_format, NULL);
     if (open_result != 0) {
         char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
         av_strerror(open_result, err_buf, sizeof(err_buf));
@@ -272,35 +527,38 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
         return 0;
     }
 
-    // Find stream info with safety checks
-    int find_stream_result = avformat_find_stream_info(format_ctx, NULL);
-    if (find_stream_result < 0) {
-        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
-        av_strerror(find_stream_result, err_buf, sizeof(err_buf));
-        log_error("[Stream %s] Could not find stream info in segment file: %s (error: %s)",
-                 thread->stream_name, segment_path, err_buf);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to find stream info", thread->stream_name);
-        return 0;
-    }
-
-    // CRITICAL FIX: Verify that format_ctx and streams are valid
-    if (!format_ctx || !format_ctx->nb_streams) {
-        log_error("[Stream %s] Invalid format context or no streams after finding stream info: %s",
-                thread->stream_name, segment_path);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite invalid streams", thread->stream_name);
-        return 0;
-    }
-
-    // Find video stream with safety checks
-    video_stream_idx = -1;
-    for (int i = 0; i < format_ctx->nb_streams; i++) {
-        if (format_ctx->streams[i] && format_ctx->streams[i]->codecpar &&
-            format_ctx->streams[i]->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
-            video_stream_idx = i;
-            break;
+    // The MPEG-TS demuxer creates its streams from the PMT while opening. Once a
+    // decoder is running for the same codec, the in-band parameter sets are all it
+    // needs, so the slow stream info probe only runs for the first segment or when
+    // the stream changes.
+    bool probed = false;
+    video_stream_idx = find_video_stream(format_ctx);
+    if (!input_format || !thread->decoder || video_stream_idx < 0 ||
+        !segment_decoder_matches(thread->decoder, format_ctx->streams[video_stream_idx]->codecpar,
+                                 thread->decoder->lowres)) {
+        // Find stream info with safety checks
+        int find_stream_result = avformat_find_stream_info(format_ctx, NULL);
+        if (find_stream_result < 0) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+            av_strerror(find_stream_result, err_buf, sizeof(err_buf));
+            log_error("[Stream %s] Could not find stream info in segment file: %s (error: %s)",
+                     thread->stream_name, segment_path, err_buf);
+            safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
+            log_info("[Stream %s] Continuing detection thread despite failure to find stream info", thread->stream_name);
+            return 0;
         }
+        probed = true;
+
+        // CRITICAL FIX: Verify that format_ctx and streams are valid
+        if (!format_ctx || !format_ctx->nb_streams) {
+            log_error("[Stream %s] Invalid format context or no streams after finding stream info: %s",
+                    thread->stream_name, segment_path);
+            safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
+            log_info("[Stream %s] Continuing detection thread despite invalid streams", thread->stream_name);
+            return 0;
+        }
+
+        video_stream_idx = find_video_stream(format_ctx);
     }
 
     if (video_stream_idx == -1) {
@@ -311,90 +569,37 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
         return 0;
     }
 
-    // Get codec with safety checks
-    if (!format_ctx->streams[video_stream_idx] || !format_ctx->streams[video_stream_idx]->codecpar) {
-        log_error("[Stream %s] Invalid codec parameters in segment file: %s",
-                thread->stream_name, segment_path);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite invalid codec parameters", thread->stream_name);
-        return 0;
-    }
-
-    const AVCodec *codec = avcodec_find_decoder(format_ctx->streams[video_stream_idx]->codecpar->codec_id);
+    AVCodecParameters *codecpar = format_ctx->streams[video_stream_idx]->codecpar;
+    const AVCodec *codec = avcodec_find_decoder(codecpar->codec_id);
     if (!codec) {
         log_error("[Stream %s] Unsupported codec in segment file: %s (codec_id: %d)",
-                 thread->stream_name, segment_path, format_ctx->streams[video_stream_idx]->codecpar->codec_id);
+                 thread->stream_name, segment_path, codecpar->codec_id);
         safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
         log_info("[Stream %s] Continuing detection thread despite unsupported codec", thread->stream_name);
         return 0;
     }
 
-    // Allocate codec context with safety checks
-    codec_ctx = avcodec_alloc_context3(codec);
-    if (!codec_ctx) {
-        log_error("[Stream %s] Could not allocate codec context for segment file: %s",
-                 thread->stream_name, segment_path);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to allocate codec context", thread->stream_name);
-        // No cleanup handler to pop
-        return 0;
-    }
-
-    // Codec context is now allocated
-
-    // Copy codec parameters with safety checks
-    int copy_params_result = avcodec_parameters_to_context(codec_ctx, format_ctx->streams[video_stream_idx]->codecpar);
-    if (copy_params_result < 0) {
-        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
-        av_strerror(copy_params_result, err_buf, sizeof(err_buf));
-        log_error("[Stream %s] Could not copy codec parameters for segment file: %s (error: %s)",
-                 thread->stream_name, segment_path, err_buf);
-        avcodec_free_context(&codec_ctx);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to copy codec parameters", thread->stream_name);
-        return 0;
-    }
-
-    // Open codec with safety checks
-    int open_codec_result = avcodec_open2(codec_ctx, codec, NULL);
-    if (open_codec_result < 0) {
-        char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
-        av_strerror(open_codec_result, err_buf, sizeof(err_buf));
-        log_error("[Stream %s] Could not open codec for segment file: %s (error: %s)",
-                 thread->stream_name, segment_path, err_buf);
-        avcodec_free_context(&codec_ctx);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to open codec", thread->stream_name);
-        return 0;
-    }
-
-    // Allocate frame and packet with safety checks
-    frame = av_frame_alloc();
-    if (!frame) {
-        log_error("[Stream %s] Could not allocate frame for segment file: %s",
-                 thread->stream_name, segment_path);
-        avcodec_free_context(&codec_ctx);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to allocate frame", thread->stream_name);
-        // No cleanup handler to pop
-        return 0;
+    // Motion-only streams never need RGB frames, let the decoder downscale when it can
+    bool motion_only = is_motion_only_model(thread->model_path);
+    int lowres = 0;
+    if (motion_only && codec->max_lowres > 0) {
+        lowres = get_motion_detection_decoder_lowres(thread->stream_name, codec->max_lowres);
     }
+    int prescale_factor = 1 << lowres;
 
-    // Frame is now allocated
-
-    pkt = av_packet_alloc();
-    if (!pkt) {
-        log_error("[Stream %s] Could not allocate packet for segment file: %s",
-                 thread->stream_name, segment_path);
-        av_frame_free(&frame);
-        avcodec_free_context(&codec_ctx);
-        safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
-        log_info("[Stream %s] Continuing detection thread despite failure to allocate packet", thread->stream_name);
-        // No cleanup handler to pop
-        return 0;
+    // Reuse the stream's decoder, rebuilding it only when the codec parameters changed
+    if (!thread->decoder || !segment_decoder_matches(thread->decoder, codecpar, lowres)) {
+        if (open_segment_decoder(thread, codec, codecpar, lowres) != 0) {
+            safe_avformat_cleanup(&format_ctx); // Use our safe cleanup function
+            log_info("[Stream %s] Continuing detection thread despite failure to open codec", thread->stream_name);
+            return 0;
+        }
     }
 
-    // Packet is now allocated
+    segment_decoder_t *decoder = thread->decoder;
+    codec_ctx = decoder->codec_ctx;
+    frame = decoder->frame;
+    pkt = decoder->pkt;
 
     // Initialize frame_count at the beginning of the function
     int frame_count = 0;
@@ -403,6 +608,9 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     float segment_duration = 0;
     if (format_ctx->duration != AV_NOPTS_VALUE) {
         segment_duration = format_ctx->duration / (float)AV_TIME_BASE;
+    } else if (decoder->segment_duration > 0) {
+        // Not known without the stream info probe, segments keep the same length
+        segment_duration = decoder->segment_duration;
     } else {
         // Default to 2 seconds if duration is not available
         segment_duration = 2.0f;
@@ -421,7 +629,14 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     double frames_per_second = 0.0;
     // Get the frame rate from the stream if available
     AVRational frame_rate = av_guess_frame_rate(format_ctx, format_ctx->streams[video_stream_idx], NULL);
-    if (frame_rate.num > 0 && frame_rate.den > 0) {
+    if (probed && frame_rate.num > 0 && frame_rate.den > 0) {
+        frames_per_second = (double)frame_rate.num / frame_rate.den;
+        log_info("[Stream %s] Using stream frame rate: %.2f fps",
+                 thread->stream_name, frames_per_second);
+    } else if (decoder->frames_per_second > 0) {
+        // Frame rate found by the last stream info probe
+        frames_per_second = decoder->frames_per_second;
+    } else if (frame_rate.num > 0 && frame_rate.den > 0) {
         frames_per_second = (double)frame_rate.num / frame_rate.den;
         log_info("[Stream %s] Using stream frame rate: %.2f fps",
                  thread->stream_name, frames_per_second);
@@ -439,6 +654,11 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
         frames_per_second = 25.0f; // Use a reasonable default
     }
 
+    if (probed) {
+        decoder->segment_duration = segment_duration;
+        decoder->frames_per_second = frames_per_second;
+    }
+
     // Calculate total frames with safety checks
     int total_frames = (int)(segment_duration * frames_per_second);
 
@@ -554,8 +774,32 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
                 // Lock the thread mutex to ensure exclusive access to the model
                 pthread_mutex_lock(&thread->mutex);
 
-                // Process the frame for detection using our dedicated model
-                if (thread->model) {
+                if (motion_only) {
+                    detection_result_t result;
+                    memset(&result, 0, sizeof(detection_result_t));
+
+                    int detect_ret = detect_motion_on_frame(thread, frame, prescale_factor,
+                                                            frame_timestamp, &result);
+                    if (detect_ret == 0 && result.count > 0) {
+                        log_info("[Stream %s] Motion detected in frame %d (confidence: %.2f)",
+                                thread->stream_name, frame_count, result.detections[0].confidence);
+
+                        int record_ret = process_frame_for_recording(thread->stream_name, frame->data[0],
+                                                                   frame->width, frame->height, 1,
+                                                                   frame_timestamp, &result);
+                        if (record_ret != 0) {
+                            log_error("[Stream %s] Failed to process frame for recording (error code: %d)",
+                                     thread->stream_name, record_ret);
+                        }
+                    } else if (detect_ret != 0) {
+                        log_error("[Stream %s] Motion detection failed for frame %d (error code: %d)",
+                                 thread->stream_name, frame_count, detect_ret);
+                    }
+
+                    // Update last detection time
+                    thread->last_detection_time = time(NULL);
+                } else if (thread->model) {
+                    // Process the frame for detection using our dedicated model
                     // Convert frame to RGB format
                     int width = frame->width;
                     int height = frame->height;
@@ -574,36 +818,14 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
                     target_height = (target_height / 2) * 2;
 
                     // Convert frame to RGB format with downscaling
-                    sws_ctx = sws_getContext(
-                        width, height, frame->format,
-                        target_width, target_height, AV_PIX_FMT_RGB24,
-                        SWS_BILINEAR, NULL, NULL, NULL);
-
-                    if (!sws_ctx) {
-                        log_error("[Stream %s] Failed to create SwsContext", thread->stream_name);
-                        av_packet_unref(pkt);
-                        continue;
-                    }
-
-                    // SwsContext is now allocated
-
-                    // Allocate buffer for RGB frame
-                    uint8_t *rgb_buffer = (uint8_t *)malloc(target_width * target_height * channels);
+                    uint8_t *rgb_buffer = segment_decoder_scale(thread, frame, target_width, target_height,
+                                                                AV_PIX_FMT_RGB24, channels, SWS_BILINEAR);
                     if (!rgb_buffer) {
-                        log_error("[Stream %s] Failed to allocate RGB buffer", thread->stream_name);
-                        sws_freeContext(sws_ctx);
+                        pthread_mutex_unlock(&thread->mutex);
                         av_packet_unref(pkt);
                         continue;
                     }
 
-                    // Setup RGB frame
-                    uint8_t *rgb_data[4] = {rgb_buffer, NULL, NULL, NULL};
-                    int rgb_linesize[4] = {target_width * channels, 0, 0, 0};
-
-                    // Convert frame to RGB
-                    sws_scale(sws_ctx, (const uint8_t * const *)frame->data, frame->linesize, 0,
-                             height, rgb_data, rgb_linesize);
-
                     // Create detection result structure
                     detection_result_t result;
                     memset(&result, 0, sizeof(detection_result_t));
@@ -706,10 +928,6 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
                         result.count = 0;
                     }
 
-                    // Free resources
-                    free(rgb_buffer);
-                    sws_freeContext(sws_ctx);
-
                     // Update last detection time
                     thread->last_detection_time = time(NULL);
                 }
@@ -727,32 +945,15 @@ int process_segment_for_detection(stream_detection_thread_t *thread, const char
     log_info("[Stream %s] Processed %d frames out of %d total frames from segment file: %s (errors: %d)",
              thread->stream_name, processed_frames, frame_count, segment_path, error_frames);
 
-    // CRITICAL FIX: Use comprehensive cleanup to prevent memory leaks and segmentation faults
-    log_debug("[Stream %s] Starting comprehensive cleanup of FFmpeg resources", thread->stream_name);
-
-    // Cleanup with safety checks
-    if (frame) {
-        log_debug("[Stream %s] Freeing frame during cleanup", thread->stream_name);
-        av_frame_free(&frame);
-    }
-
-    if (pkt) {
-        log_debug("[Stream %s] Freeing packet during cleanup", thread->stream_name);
-        av_packet_free(&pkt);
-    }
-
-    if (codec_ctx) {
-        log_debug("[Stream %s] Freeing codec context during cleanup", thread->stream_name);
-        avcodec_free_context(&codec_ctx);
-    }
+    // Drop reference frames and any buffered output so the next segment starts clean
+    avcodec_flush_buffers(codec_ctx);
+    av_packet_unref(pkt);
 
     if (format_ctx) {
-        log_debug("[Stream %s] Closing input format context during cleanup", thread->stream_name);
+        log_debug("[Stream %s] Closing input format context", thread->stream_name);
         avformat_close_input(&format_ctx);
     }
 
-    log_debug("[Stream %s] Completed comprehensive cleanup of FFmpeg resources", thread->stream_name);
-
     // No cleanup handler to pop
 
     return 0;
@@ -863,7 +1064,11 @@ static void *stream_detection_thread_func(void *arg) {
 
     // CRITICAL FIX: Ensure model is loaded with proper error handling
     pthread_mutex_lock(&thread->mutex);
-    if (!thread->model && thread->model_path[0] != '\0') {
+    if (is_motion_only_model(thread->model_path)) {
+        // Built-in motion detection works on decoded luma, there is no model to load
+        log_info("[Stream %s] Using built-in motion detection", thread->stream_name);
+        set_motion_detection_enabled(thread->stream_name, true);
+    } else if (!thread->model && thread->model_path[0] != '\0') {
         log_info("[Stream %s] Loading detection model: %s", thread->stream_name, thread->model_path);
 
         // Check if this is an API URL or the special "api-detection" string
@@ -1094,6 +1299,12 @@ static void *stream_detection_thread_func(void *arg) {
     }
     pthread_mutex_unlock(&thread->mutex);
 
+    free_segment_decoder(thread);
+
+    if (is_motion_only_model(thread->model_path)) {
+        set_motion_detection_enabled(thread->stream_name, false);
+    }
+
     log_info("[Stream %s] Detection thread exiting", thread->stream_name);
     return NULL;
 }
@@ -4,17 +4,13 @@
  */
 
 #include "video/go2rtc/go2rtc_api.h"
+#include "video/go2rtc/go2rtc_client.h"
 #include "core/logger.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
-#include <netdb.h>
-#include <errno.h>
 #include <curl/curl.h>
 #include <ctype.h>
 #include <cjson/cJSON.h>
@@ -28,121 +24,83 @@ static bool g_initialized = false;
 #define HTTP_BUFFER_SIZE 4096
 #define URL_BUFFER_SIZE 1024
 
+// Response body of a request made with send_http_request
+typedef struct {
+    char *data;
+    size_t size;
+    size_t capacity;
+} response_buffer_t;
+
+static size_t response_buffer_write(void *contents, size_t size, size_t nmemb, void *userp) {
+    size_t realsize = size * nmemb;
+    response_buffer_t *buffer = (response_buffer_t *)userp;
+
+    size_t n = realsize;
+    if (buffer->size + n + 1 > buffer->capacity) {
+        n = buffer->capacity - buffer->size - 1;
+        if (n < realsize) {
+            log_warn("HTTP response truncated (buffer too small)");
+        }
+    }
+
+    memcpy(buffer->data + buffer->size, contents, n);
+    buffer->size += n;
+    buffer->data[buffer->size] = '\0';
+
+    // Accept the whole chunk so a truncated response still completes
+    return realsize;
+}
+
 /**
  * @brief Send an HTTP request to the go2rtc API
  * 
  * @param method HTTP method (GET, POST, DELETE)
  * @param path API endpoint path
  * @param data Request body data (can be NULL)
- * @param response Buffer to store the response
+ * @param response Buffer to store the response body
  * @param response_size Size of the response buffer
  * @return int HTTP status code, or -1 on error
  */
 static int send_http_request(const char *method, const char *path, const char *data, 
                              char *response, size_t response_size) {
-    struct hostent *server;
-    struct sockaddr_in server_addr;
-    int sockfd, bytes, status_code = -1;
-    char request[HTTP_BUFFER_SIZE];
-    char buffer[HTTP_BUFFER_SIZE];
-    
-    // Create socket
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        log_error("Failed to create socket: %s", strerror(errno));
-        return -1;
-    }
-    
-    // Resolve hostname
-    server = gethostbyname(g_api_host);
-    if (server == NULL) {
-        log_error("Failed to resolve hostname: %s", g_api_host);
-        close(sockfd);
-        return -1;
-    }
-    
-    // Set up server address
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    memcpy(&server_addr.sin_addr.s_addr, server->h_addr_list[0], server->h_length);
-    server_addr.sin_port = htons(g_api_port);
-    
-    // Connect to server
-    if (connect(sockfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
-        log_error("Failed to connect to %s:%d: %s", g_api_host, g_api_port, strerror(errno));
-        close(sockfd);
+    char url[URL_BUFFER_SIZE];
+    struct curl_slist *headers = NULL;
+    response_buffer_t buffer = {response, 0, response_size};
+    int status_code = -1;
+
+    memset(response, 0, response_size);
+
+    CURL *curl = go2rtc_client_acquire();
+    if (!curl) {
         return -1;
     }
-    
-    // Prepare HTTP request
+
+    snprintf(url, sizeof(url), "http://%s:%d%s", g_api_host, g_api_port, path);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, response_buffer_write);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &buffer);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+
     if (data) {
-        snprintf(request, sizeof(request),
-                 "%s %s HTTP/1.1\r\n"
-                 "Host: %s:%d\r\n"
-                 "Content-Type: application/json\r\n"
-                 "Content-Length: %zu\r\n"
-                 "Connection: close\r\n"
-                 "\r\n"
-                 "%s",
-                 method, path, g_api_host, g_api_port, strlen(data), data);
-    } else {
-        snprintf(request, sizeof(request),
-                 "%s %s HTTP/1.1\r\n"
-                 "Host: %s:%d\r\n"
-                 "Connection: close\r\n"
-                 "\r\n",
-                 method, path, g_api_host, g_api_port);
+        headers = curl_slist_append(headers, "Content-Type: application/json");
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data);
     }
-    
-    // Send request
-    if (send(sockfd, request, strlen(request), 0) < 0) {
-        log_error("Failed to send HTTP request: %s", strerror(errno));
-        close(sockfd);
-        return -1;
-    }
-    
-    // Receive response
-    memset(response, 0, response_size);
-    size_t total_bytes = 0;
-    
-    while ((bytes = recv(sockfd, buffer, sizeof(buffer) - 1, 0)) > 0) {
-        buffer[bytes] = '\0';
-        
-        // Extract status code from first line of response
-        if (status_code == -1) {
-            if (sscanf(buffer, "HTTP/1.1 %d", &status_code) != 1) {
-                log_error("Failed to parse HTTP status code");
-                close(sockfd);
-                return -1;
-            }
-        }
-        
-        // Append to response buffer if there's space
-        if (total_bytes + bytes < response_size) {
-            memcpy(response + total_bytes, buffer, bytes);
-            total_bytes += bytes;
-        } else {
-            log_warn("HTTP response truncated (buffer too small)");
-            break;
-        }
-    }
-    
-    close(sockfd);
-    return status_code;
-}
 
-/**
- * @brief Extract response body from HTTP response
- * 
- * @param response Full HTTP response
- * @return char* Pointer to the start of the response body, or NULL if not found
- */
-static char *extract_response_body(char *response) {
-    char *body = strstr(response, "\r\n\r\n");
-    if (body) {
-        return body + 4; // Skip the \r\n\r\n separator
+    CURLcode res = curl_easy_perform(curl);
+    if (res != CURLE_OK) {
+        log_error("Failed to send HTTP request to %s: %s", url, curl_easy_strerror(res));
+    } else {
+        long http_code = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+        status_code = (int)http_code;
     }
-    return NULL;
+
+    go2rtc_client_release(curl);
+    curl_slist_free_all(headers);
+    return status_code;
 }
 
 bool go2rtc_api_init(const char *api_host, int api_port) {
@@ -229,10 +187,9 @@ bool go2rtc_api_add_stream(const char *stream_id, const char *stream_url) {
     char url[URL_BUFFER_SIZE];
     bool success = false;
     
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL");
         return false;
     }
     
@@ -290,8 +247,8 @@ bool go2rtc_api_add_stream(const char *stream_id, const char *stream_url) {
         }
     }
     
-    // Clean up
-    curl_easy_cleanup(curl);
+    // Return the handle to the pool
+    go2rtc_client_release(curl);
     
     return success;
 }
@@ -312,10 +269,9 @@ bool go2rtc_api_remove_stream(const char *stream_id) {
     char url[URL_BUFFER_SIZE];
     bool success = false;
     
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL");
         return false;
     }
     
@@ -387,8 +343,8 @@ bool go2rtc_api_remove_stream(const char *stream_id) {
         }
     }
     
-    // Clean up
-    curl_easy_cleanup(curl);
+    // Return the handle to the pool
+    go2rtc_client_release(curl);
     
     return success;
 }
@@ -413,11 +369,8 @@ bool go2rtc_api_stream_exists(const char *stream_id) {
     // Send GET request
     int status = send_http_request("GET", path, NULL, response, sizeof(response));
     
-    if (status == 200) {
-        char *body = extract_response_body(response);
-        if (body && strstr(body, stream_id)) {
-            return true;
-        }
+    if (status == 200 && strstr(response, stream_id)) {
+        return true;
     }
     
     return false;
@@ -458,8 +411,8 @@ bool go2rtc_api_update_config(void) {
         log_info("Successfully updated go2rtc configuration");
         return true;
     } else {
-        char *body = extract_response_body(response);
-        log_error("Failed to update go2rtc configuration (status %d): %s", status, body ? body : "unknown error");
+        log_error("Failed to update go2rtc configuration (status %d): %s", status,
+                  response[0] ? response : "unknown error");
         return false;
     }
 }
@@ -492,12 +445,9 @@ bool go2rtc_api_get_streams(char *buffer, size_t buffer_size) {
     int status = send_http_request("GET", path, NULL, response, sizeof(response));
     
     if (status == 200) {
-        char *body = extract_response_body(response);
-        if (body) {
-            strncpy(buffer, body, buffer_size - 1);
-            buffer[buffer_size - 1] = '\0';
-            return true;
-        }
+        strncpy(buffer, response, buffer_size - 1);
+        buffer[buffer_size - 1] = '\0';
+        return true;
     }
     
     return false;
@@ -514,10 +464,9 @@ bool go2rtc_api_get_server_info(int *rtsp_port) {
     char url[URL_BUFFER_SIZE];
     bool success = false;
 
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL");
         return false;
     }
 
@@ -583,8 +532,8 @@ bool go2rtc_api_get_server_info(int *rtsp_port) {
         }
     }
 
-    // Clean up
-    curl_easy_cleanup(curl);
+    // Return the handle to the pool
+    go2rtc_client_release(curl);
 
     return success;
 }
@@ -594,6 +543,8 @@ void go2rtc_api_cleanup(void) {
         return;
     }
 
+    go2rtc_client_cleanup();
+
     free(g_api_host);
     g_api_host = NULL;
     g_api_port = 0;
@@ -0,0 +1,154 @@
+/**
+ * @file go2rtc_client.c
+ * @brief Shared HTTP client for the go2rtc API
+ */
+
+#include "video/go2rtc/go2rtc_client.h"
+#include "core/logger.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+
+// Idle handles, reused in LIFO order so the most recently used connection is taken first
+static CURL *g_idle[GO2RTC_CLIENT_POOL_SIZE];
+static int g_idle_count = 0;
+
+// Handles currently taken by callers
+static int g_in_use = 0;
+
+static CURLSH *g_share = NULL;
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// One lock per kind of data in the share object
+static pthread_mutex_t g_share_locks[CURL_LOCK_DATA_LAST];
+
+static void share_lock(CURL *handle, curl_lock_data data, curl_lock_access access, void *userptr) {
+    (void)handle;
+    (void)access;
+    (void)userptr;
+    pthread_mutex_lock(&g_share_locks[data]);
+}
+
+static void share_unlock(CURL *handle, curl_lock_data data, void *userptr) {
+    (void)handle;
+    (void)userptr;
+    pthread_mutex_unlock(&g_share_locks[data]);
+}
+
+/**
+ * @brief Create the share object. Called with the pool mutex held.
+ */
+static int init_share_locked(void) {
+    static bool locks_initialized = false;
+
+    if (g_share) {
+        return 0;
+    }
+
+    if (!locks_initialized) {
+        for (int i = 0; i < CURL_LOCK_DATA_LAST; i++) {
+            pthread_mutex_init(&g_share_locks[i], NULL);
+        }
+        locks_initialized = true;
+    }
+
+    g_share = curl_share_init();
+    if (!g_share) {
+        log_error("Failed to create shared go2rtc connection cache");
+        return -1;
+    }
+
+    curl_share_setopt(g_share, CURLSHOPT_LOCKFUNC, share_lock);
+    curl_share_setopt(g_share, CURLSHOPT_UNLOCKFUNC, share_unlock);
+    curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+    if (curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_CONNECT) != CURLSHE_OK) {
+        // Older libcurl: each pooled handle still keeps its own connections alive
+        log_warn("libcurl cannot share connections, go2rtc connections are cached per handle");
+    }
+    return 0;
+}
+
+/**
+ * @brief Take a handle for a request to go2rtc
+ */
+CURL *go2rtc_client_acquire(void) {
+    CURL *curl = NULL;
+
+    pthread_mutex_lock(&g_pool_mutex);
+    if (init_share_locked() != 0) {
+        pthread_mutex_unlock(&g_pool_mutex);
+        return NULL;
+    }
+    if (g_idle_count > 0) {
+        curl = g_idle[--g_idle_count];
+    }
+    g_in_use++;
+    CURLSH *share = g_share;
+    pthread_mutex_unlock(&g_pool_mutex);
+
+    if (!curl) {
+        curl = curl_easy_init();
+        if (!curl) {
+            log_error("Failed to initialize CURL handle for go2rtc");
+            pthread_mutex_lock(&g_pool_mutex);
+            g_in_use--;
+            pthread_mutex_unlock(&g_pool_mutex);
+            return NULL;
+        }
+    }
+
+    curl_easy_setopt(curl, CURLOPT_SHARE, share);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    return curl;
+}
+
+/**
+ * @brief Return a handle taken with go2rtc_client_acquire
+ */
+void go2rtc_client_release(CURL *curl) {
+    if (!curl) {
+        return;
+    }
+
+    // Resetting keeps the handle's live connections
+    curl_easy_reset(curl);
+
+    pthread_mutex_lock(&g_pool_mutex);
+    g_in_use--;
+    if (g_idle_count < GO2RTC_CLIENT_POOL_SIZE) {
+        g_idle[g_idle_count++] = curl;
+        curl = NULL;
+    }
+    pthread_mutex_unlock(&g_pool_mutex);
+
+    if (curl) {
+        curl_easy_cleanup(curl);
+    }
+}
+
+/**
+ * @brief Free the idle handles and the shared connection cache
+ */
+void go2rtc_client_cleanup(void) {
+    pthread_mutex_lock(&g_pool_mutex);
+
+    for (int i = 0; i < g_idle_count; i++) {
+        curl_easy_cleanup(g_idle[i]);
+        g_idle[i] = NULL;
+    }
+    g_idle_count = 0;
+
+    if (g_share) {
+        if (g_in_use == 0) {
+            curl_share_cleanup(g_share);
+            g_share = NULL;
+        } else {
+            log_warn("%d go2rtc requests still running, keeping their connection cache", g_in_use);
+        }
+    }
+
+    pthread_mutex_unlock(&g_pool_mutex);
+
+    log_info("go2rtc client cleaned up");
+}
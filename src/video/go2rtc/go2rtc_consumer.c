@@ -5,6 +5,7 @@
 
 #include "video/go2rtc/go2rtc_consumer.h"
 #include "video/go2rtc/go2rtc_api.h"
+#include "video/go2rtc/go2rtc_client.h"
 #include "video/go2rtc/go2rtc_stream.h"
 #include "core/logger.h"
 #include "core/config.h"
@@ -127,10 +128,9 @@ static bool add_go2rtc_recording_consumer(const char *stream_id, const char *out
     char url[URL_BUFFER_SIZE];
     bool success = false;
     
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL");
         return false;
     }
     
@@ -189,7 +189,7 @@ static bool add_go2rtc_recording_consumer(const char *stream_id, const char *out
     if (headers) {
         curl_slist_free_all(headers);
     }
-    curl_easy_cleanup(curl);
+    go2rtc_client_release(curl);
     
     return success;
 }
@@ -212,10 +212,9 @@ static bool remove_go2rtc_consumer(const char *stream_id, const char *consumer_t
     char url[URL_BUFFER_SIZE];
     bool success = false;
     
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL");
         return false;
     }
     
@@ -227,7 +226,7 @@ static bool remove_go2rtc_consumer(const char *stream_id, const char *consumer_t
     } else {
         // For HLS, we don't need to remove anything as we're using direct access
         log_info("No need to remove HLS consumer for stream %s", stream_id);
-        curl_easy_cleanup(curl);
+        go2rtc_client_release(curl);
         return true;
     }
     
@@ -259,7 +258,7 @@ static bool remove_go2rtc_consumer(const char *stream_id, const char *consumer_t
     }
     
     // Clean up
-    curl_easy_cleanup(curl);
+    go2rtc_client_release(curl);
     
     return success;
 }
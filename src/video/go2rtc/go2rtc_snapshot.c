@@ -4,6 +4,7 @@
  */
 
 #include "video/go2rtc/go2rtc_snapshot.h"
+#include "video/go2rtc/go2rtc_client.h"
 #include "core/logger.h"
 #include <curl/curl.h>
 #include <stdlib.h>
@@ -75,10 +76,9 @@ bool go2rtc_get_snapshot(const char *stream_name, unsigned char **jpeg_data, siz
         return false;
     }
     
-    // Initialize CURL
-    curl = curl_easy_init();
+    // Take a pooled handle
+    curl = go2rtc_client_acquire();
     if (!curl) {
-        log_error("Failed to initialize CURL for snapshot");
         free(buffer.data);
         return false;
     }
@@ -118,8 +118,8 @@ bool go2rtc_get_snapshot(const char *stream_name, unsigned char **jpeg_data, siz
         }
     }
     
-    // Clean up CURL
-    curl_easy_cleanup(curl);
+    // Return the handle to the pool
+    go2rtc_client_release(curl);
     
     return success;
 }
@@ -116,6 +116,7 @@ static void global_ffmpeg_cleanup(void) {
 #include "video/hls/hls_directory.h"
 #include "video/hls/hls_unified_thread.h"
 #include "video/hls_writer.h"
+#include "video/packet_bus.h"
 #include "video/stream_manager.h"
 #include "video/stream_protocol.h"
 #include "video/stream_state.h"
@@ -961,6 +962,10 @@ void *hls_unified_thread_func(void *arg) {
 
   log_info("Starting unified HLS thread for stream %s", stream_name);
 
+  // This thread is the camera reader of the stream, other consumers subscribe
+  // to the packets it publishes instead of opening their own connection
+  packet_bus_t *bus = packet_bus_get(stream_name);
+
   // Check if we're still running before proceeding
   if (!atomic_load(&ctx->running)) {
     log_warn(
@@ -1425,6 +1430,7 @@ void *hls_unified_thread_func(void *arg) {
       log_info("Successfully connected to stream %s", stream_name);
       thread_state = HLS_THREAD_RUNNING;
       reconnect_attempt = 0;
+      packet_bus_attach_source(bus, input_ctx);
 
       // CRITICAL FIX: Check if context is still valid before accessing
       if (is_context_already_freed(ctx) || is_context_pending_deletion(ctx)) {
@@ -1498,6 +1504,9 @@ void *hls_unified_thread_func(void *arg) {
         continue;
       }
 
+      // Hand the packet to the other consumers of the stream
+      packet_bus_publish(bus, pkt);
+
       // Process packets based on stream type
       if (pkt->stream_index == video_stream_idx) {
         // This is a video packet - process it
@@ -1628,6 +1637,7 @@ void *hls_unified_thread_func(void *arg) {
                reconnect_attempt);
 
       // Close existing connection
+      packet_bus_detach_source(bus);
       safe_cleanup_resources(&input_ctx, NULL, NULL);
 
       // Calculate reconnection delay with exponential backoff
@@ -1841,6 +1851,7 @@ void *hls_unified_thread_func(void *arg) {
                stream_name, reconnect_attempt);
       thread_state = HLS_THREAD_RUNNING;
       reconnect_attempt = 0;
+      packet_bus_attach_source(bus, input_ctx);
       atomic_store(&ctx->connection_valid, 1);
       atomic_store(&ctx->consecutive_failures, 0);
       last_packet_time = time(NULL);
@@ -1857,6 +1868,7 @@ void *hls_unified_thread_func(void *arg) {
                stream_name);
 
       // Clean up input context and packet
+      packet_bus_detach_source(bus);
       safe_cleanup_resources(&input_ctx, &pkt, NULL);
 
       // Clean up HLS writer if it exists
@@ -1922,6 +1934,9 @@ void *hls_unified_thread_func(void *arg) {
     strcpy(stream_name_buf, "unknown");
   }
 
+  // Subscribers must not wait for packets from a thread that has exited
+  packet_bus_detach_source(bus);
+
   // CRITICAL FIX: Ensure all resources are cleaned up before exiting
   // This is a safety measure in case we exited the loop without proper cleanup
   if (input_ctx != NULL || pkt != NULL) {
@@ -140,6 +140,29 @@ motion_buffer_t* create_motion_buffer(const char *stream_name, int buffer_second
         return NULL;
     }
     
+    // Packets are allocated once per slot and reused for every packet stored in it
+    for (int i = 0; i < buffer->max_packets; i++) {
+        buffer->packets[i].packet = av_packet_alloc();
+        if (!buffer->packets[i].packet) {
+            break;
+        }
+    }
+
+    buffer->pool = packet_pool_create(stream_name);
+    if (!buffer->pool || !buffer->packets[buffer->max_packets - 1].packet) {
+        log_error("Failed to allocate packets for buffer");
+        for (int i = 0; i < buffer->max_packets; i++) {
+            av_packet_free(&buffer->packets[i].packet);
+        }
+        free(buffer->packets);
+        buffer->packets = NULL;
+        packet_pool_destroy(buffer->pool);
+        buffer->pool = NULL;
+        pthread_mutex_unlock(&buffer->mutex);
+        pthread_mutex_unlock(&buffer_pool.pool_mutex);
+        return NULL;
+    }
+
     buffer->head = 0;
     buffer->tail = 0;
     buffer->count = 0;
@@ -187,6 +210,9 @@ void destroy_motion_buffer(motion_buffer_t *buffer) {
         free(buffer->packets);
         buffer->packets = NULL;
     }
+
+    packet_pool_destroy(buffer->pool);
+    buffer->pool = NULL;
     
     // Close disk buffer if open
     if (buffer->disk_buffer_file) {
@@ -222,24 +248,25 @@ int motion_buffer_add_packet(motion_buffer_t *buffer, const AVPacket *packet, ti
         // Remove oldest packet to make room
         if (buffer->packets[buffer->tail].packet) {
             buffer->current_memory_usage -= buffer->packets[buffer->tail].data_size;
-            av_packet_free(&buffer->packets[buffer->tail].packet);
+            av_packet_unref(buffer->packets[buffer->tail].packet);
         }
         buffer->tail = (buffer->tail + 1) % buffer->max_packets;
         buffer->count--;
         buffer->total_packets_dropped++;
     }
     
-    // Clone the packet
-    AVPacket *cloned_packet = av_packet_clone(packet);
-    if (!cloned_packet) {
-        log_error("Failed to clone packet for buffer");
+    // Reference the packet, reusing the slot's packet (gone only after motion_buffer_pop_oldest)
+    buffered_packet_t *slot = &buffer->packets[buffer->head];
+    if (!slot->packet) {
+        slot->packet = av_packet_alloc();
+    }
+    if (!slot->packet || packet_pool_ref(buffer->pool, slot->packet, packet) < 0) {
+        log_error("Failed to reference packet for buffer");
         pthread_mutex_unlock(&buffer->mutex);
         return -1;
     }
     
     // Store packet in buffer
-    buffered_packet_t *slot = &buffer->packets[buffer->head];
-    slot->packet = cloned_packet;
     slot->timestamp = timestamp;
     slot->pts = packet->pts;
     slot->dts = packet->dts;
@@ -285,7 +312,7 @@ int motion_buffer_peek_oldest(motion_buffer_t *buffer, AVPacket **packet) {
         return -1;
     }
 
-    // Clone the oldest packet
+    // New reference to the oldest packet, the payload is shared
     *packet = av_packet_clone(buffer->packets[buffer->tail].packet);
 
     pthread_mutex_unlock(&buffer->mutex);
@@ -355,10 +382,9 @@ int motion_buffer_flush(motion_buffer_t *buffer,
                 flushed_count++;
             }
 
-            // Free the packet
+            // Release the reference, the slot keeps its packet
             buffer->current_memory_usage -= buffer->packets[index].data_size;
-            av_packet_free(&buffer->packets[index].packet);
-            buffer->packets[index].packet = NULL;
+            av_packet_unref(buffer->packets[index].packet);
         }
     }
 
@@ -384,12 +410,12 @@ void motion_buffer_clear(motion_buffer_t *buffer) {
 
     pthread_mutex_lock(&buffer->mutex);
 
-    // Free all packets
-    for (int i = 0; i < buffer->max_packets; i++) {
-        if (buffer->packets[i].packet) {
-            buffer->current_memory_usage -= buffer->packets[i].data_size;
-            av_packet_free(&buffer->packets[i].packet);
-            buffer->packets[i].packet = NULL;
+    // Release all buffered packets
+    for (int i = 0; i < buffer->count; i++) {
+        int index = (buffer->tail + i) % buffer->max_packets;
+        if (buffer->packets[index].packet) {
+            buffer->current_memory_usage -= buffer->packets[index].data_size;
+            av_packet_unref(buffer->packets[index].packet);
         }
     }
 
@@ -16,6 +16,7 @@
 
 #include "core/logger.h"
 #include "video/motion_detection.h"
+#include "video/motion_detection_simd.h"
 #include "video/streams.h"
 #include "video/detection_result.h"
 #include "utils/memory.h"
@@ -31,14 +32,19 @@
 #define DEFAULT_GRID_SIZE 6              // Reduced from 8 to 6 for performance
 #define DEFAULT_DOWNSCALE_ENABLED true   // Enable downscaling for embedded devices
 #define DEFAULT_DOWNSCALE_FACTOR 2       // Downscale factor (2 = half size)
+#define DEFAULT_USE_INTEGRAL_IMAGE false // Summed-area tables lose to the SIMD kernels at blur_radius <= 5
+#define MAX_INTEGRAL_PIXELS (1 << 24)    // 255 * pixels must fit in a 32-bit table entry
 #define MOTION_LABEL "motion"
 #define EMBEDDED_DEVICE_OPTIMIZATION 1   // Enable embedded device optimizations
 
-// Structure to store frame data for temporal filtering
+// Per-stream scratch arena for per-frame buffers, sized once and reused across frames
 typedef struct {
-    unsigned char *frame;
-    time_t timestamp;
-} frame_history_t;
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+} motion_arena_t;
+
+#define ARENA_ALIGN(size) (((size) + 63) & ~(size_t)63)  // Keep slices cache-line aligned
 
 // Structure to store previous frame data for a stream
 typedef struct {
@@ -46,10 +52,10 @@ typedef struct {
     unsigned char *prev_frame;           // Previous grayscale frame
     unsigned char *blur_buffer;          // Buffer for blur operations
     unsigned char *background;           // Background model
-    frame_history_t *frame_history;      // Circular buffer for frame history
-    int history_size;                    // Size of frame history buffer
-    int history_index;                   // Current index in history buffer
+    int history_size;                    // Configured history length, no frames are kept
     float *grid_scores;                  // Array to store grid cell motion scores
+    uint32_t *integral;                  // Two (width+1)*(height+1) summed-area tables
+    motion_arena_t arena;                // Scratch buffers for grayscale, downscale and blur
     int width;
     int height;
     int channels;
@@ -66,6 +72,7 @@ typedef struct {
     int downscale_factor;                // Factor by which to downscale (2 = half size)
     int downscaled_width;                // Width after downscaling
     int downscaled_height;               // Height after downscaling
+    bool use_integral_image;             // Whether to use summed-area tables for blur and scoring
     
     // Performance monitoring
     size_t allocated_memory;             // Total allocated memory in bytes
@@ -75,6 +82,9 @@ typedef struct {
     float avg_processing_time;           // Average processing time in milliseconds
     float peak_processing_time;          // Peak processing time in milliseconds
     int frames_processed;                // Number of frames processed
+    uint64_t buffer_allocations;             // Detection buffers allocated for the stream
+    uint32_t last_frame_buffer_allocations;  // Detection buffers allocated while processing the last frame
+    uint64_t buffer_allocation_free_frames;  // Consecutive frames processed without allocating a buffer
     
     pthread_mutex_t mutex;
 } motion_stream_t;
@@ -88,6 +98,10 @@ static motion_stream_t* motion_streams[MAX_MOTION_STREAMS];
 static pthread_mutex_t motion_streams_mutex = PTHREAD_MUTEX_INITIALIZER;
 static bool initialized = false;
 
+// Pixel kernels selected for this CPU and their measured speedup over scalar code
+static const motion_kernels_t *kernels = NULL;
+static float kernel_speedup = 1.0f;
+
 /**
  * Allocate a motion stream structure on the heap
  * This avoids large stack allocations that can cause crashes on embedded devices
@@ -128,15 +142,15 @@ void free_motion_stream(motion_stream_t* stream) {
         stream->grid_scores = NULL;
     }
 
-    if (stream->frame_history) {
-        for (int j = 0; j < stream->history_size; j++) {
-            if (stream->frame_history[j].frame) {
-                free(stream->frame_history[j].frame);
-                stream->frame_history[j].frame = NULL;  // Set to NULL after freeing to prevent double-free
-            }
-        }
-        free(stream->frame_history);
-        stream->frame_history = NULL;
+    if (stream->integral) {
+        free(stream->integral);
+        stream->integral = NULL;
+    }
+
+    if (stream->arena.base) {
+        free(stream->arena.base);
+        stream->arena.base = NULL;
+        stream->arena.capacity = 0;
     }
     
     pthread_mutex_unlock(&stream->mutex);
@@ -146,16 +160,18 @@ void free_motion_stream(motion_stream_t* stream) {
 }
 
 // Forward declarations for helper functions
-static void apply_box_blur(unsigned char *src, unsigned char *dst, int width, int height, int radius);
+static void apply_box_blur(const unsigned char *src, unsigned char *dst, unsigned char *temp,
+                           int width, int height, int radius);
 static void update_background_model(unsigned char *background, const unsigned char *current,
                                     int width, int height, float learning_rate);
 static float calculate_grid_motion(const unsigned char *curr_frame, const unsigned char *prev_frame,
                                   const unsigned char *background, int width, int height,
                                   float sensitivity, int noise_threshold, int grid_size,
                                   float *grid_scores, float *motion_area);
-static unsigned char *rgb_to_grayscale(const unsigned char *rgb_data, int width, int height);
-static unsigned char *downscale_grayscale(const unsigned char *src, int width, int height, int factor, 
-                                         int *out_width, int *out_height);
+static void rgb_to_grayscale(const unsigned char *rgb_data, unsigned char *gray_data, int width, int height);
+static void get_downscaled_size(int width, int height, int factor, int *out_width, int *out_height);
+static void downscale_grayscale(const unsigned char *src, int width, int height, int src_stride,
+                                int factor, unsigned char *dst, int out_width, int out_height);
 
 /**
  * Initialize the motion detection system - optimized for embedded devices
@@ -171,10 +187,14 @@ int init_motion_detection_system(void) {
         motion_streams[i] = NULL;
     }
 
+    kernels = motion_kernels_get();
     initialized = true;
     pthread_mutex_unlock(&motion_streams_mutex);
 
-    log_info("Motion detection system initialized with embedded device optimizations");
+    kernel_speedup = motion_kernels_benchmark(320, 240);
+
+    log_info("Motion detection system initialized with embedded device optimizations "
+             "(%s kernels, %.1fx faster than scalar)", kernels->name, kernel_speedup);
     return 0;
 }
 
@@ -253,6 +273,7 @@ static motion_stream_t *get_motion_stream(const char *stream_name) {
             motion_streams[i]->enabled = false;
             motion_streams[i]->downscale_enabled = DEFAULT_DOWNSCALE_ENABLED;
             motion_streams[i]->downscale_factor = DEFAULT_DOWNSCALE_FACTOR;
+            motion_streams[i]->use_integral_image = DEFAULT_USE_INTEGRAL_IMAGE;
             
             log_info("Created new motion stream entry for %s", stream_name);
             pthread_mutex_unlock(&motion_streams_mutex);
@@ -321,7 +342,6 @@ int configure_advanced_motion_detection(const char *stream_name, int blur_radius
 
     // Store old values to check if reallocation is needed
     int old_grid_size = stream->grid_size;
-    int old_history_size = stream->history_size;
 
     // Validate and set parameters
     stream->blur_radius = (blur_radius >= 0 && blur_radius <= 5) ?
@@ -336,7 +356,7 @@ int configure_advanced_motion_detection(const char *stream_name, int blur_radius
                          grid_size : DEFAULT_GRID_SIZE;
 
     // Validate history size
-    int new_history_size = (history_size > 0 && history_size <= 10) ?
+    stream->history_size = (history_size > 0 && history_size <= 10) ?
                            history_size : DEFAULT_MOTION_HISTORY;
 
     // Reallocate grid_scores if grid size changed
@@ -345,20 +365,6 @@ int configure_advanced_motion_detection(const char *stream_name, int blur_radius
         stream->grid_scores = NULL;
     }
 
-    // Reset frame history if size changed
-    if (new_history_size != old_history_size && stream->frame_history) {
-        for (int i = 0; i < old_history_size; i++) {
-            if (stream->frame_history[i].frame) {
-                free(stream->frame_history[i].frame);
-                stream->frame_history[i].frame = NULL;  // Set to NULL after freeing to prevent double-free
-            }
-        }
-        free(stream->frame_history);
-        stream->frame_history = NULL;
-    }
-
-    stream->history_size = new_history_size;
-
     pthread_mutex_unlock(&stream->mutex);
 
     log_info("Configured advanced motion detection for stream %s: blur=%d, noise=%d, grid=%s, grid_size=%d, history=%d",
@@ -408,6 +414,39 @@ int configure_motion_detection_optimizations(const char *stream_name, bool downs
     return 0;
 }
 
+/**
+ * Enable or disable the summed-area table path for blur and grid scoring
+ */
+int configure_motion_detection_integral_image(const char *stream_name, bool enabled) {
+    if (!stream_name) {
+        log_error("Invalid stream name for configure_motion_detection_integral_image");
+        return -1;
+    }
+
+    motion_stream_t *stream = get_motion_stream(stream_name);
+    if (!stream) {
+        log_error("Failed to get motion stream for %s", stream_name);
+        return -1;
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+
+    stream->use_integral_image = enabled;
+
+    // The tables are allocated lazily on the next frame
+    if (!enabled && stream->integral) {
+        free(stream->integral);
+        stream->integral = NULL;
+    }
+
+    pthread_mutex_unlock(&stream->mutex);
+
+    log_info("Integral image motion detection %s for stream %s",
+             enabled ? "enabled" : "disabled", stream_name);
+
+    return 0;
+}
+
 /**
  * Enable or disable motion detection for a stream
  */
@@ -447,21 +486,20 @@ int set_motion_detection_enabled(const char *stream_name, bool enabled) {
             stream->grid_scores = NULL;
         }
 
-        if (stream->frame_history) {
-            for (int i = 0; i < stream->history_size; i++) {
-                if (stream->frame_history[i].frame) {
-                    free(stream->frame_history[i].frame);
-                    stream->frame_history[i].frame = NULL;  // Set to NULL after freeing to prevent double-free
-                }
-            }
-            free(stream->frame_history);
-            stream->frame_history = NULL;
+        if (stream->integral) {
+            free(stream->integral);
+            stream->integral = NULL;
+        }
+
+        if (stream->arena.base) {
+            free(stream->arena.base);
+            stream->arena.base = NULL;
+            stream->arena.capacity = 0;
         }
 
         stream->width = 0;
         stream->height = 0;
         stream->channels = 0;
-        stream->history_index = 0;
         stream->downscaled_width = 0;
         stream->downscaled_height = 0;
     }
@@ -498,36 +536,10 @@ bool is_motion_detection_enabled(const char *stream_name) {
 /**
  * Convert RGB frame to grayscale - optimized for embedded devices
  */
-static unsigned char *rgb_to_grayscale(const unsigned char *rgb_data, int width, int height) {
-    unsigned char *gray_data = (unsigned char *)malloc(width * height);
-    if (!gray_data) {
-        log_error("Failed to allocate memory for grayscale conversion");
-        return NULL;
-    }
-
+static void rgb_to_grayscale(const unsigned char *rgb_data, unsigned char *gray_data, int width, int height) {
     #if EMBEDDED_DEVICE_OPTIMIZATION
-    // Use integer arithmetic for faster conversion
-    // Pre-compute fixed-point coefficients (8-bit fraction)
-    const int r_coeff = (int)(0.299f * 256);
-    const int g_coeff = (int)(0.587f * 256);
-    const int b_coeff = (int)(0.114f * 256);
-    
-    for (int y = 0; y < height; y++) {
-        for (int x = 0; x < width; x++) {
-            int rgb_idx = (y * width + x) * 3;
-            int gray_idx = y * width + x;
-
-            // Convert RGB to grayscale using integer arithmetic
-            int gray_value = (r_coeff * rgb_data[rgb_idx] + 
-                             g_coeff * rgb_data[rgb_idx + 1] + 
-                             b_coeff * rgb_data[rgb_idx + 2]) >> 8;
-                             
-            // Clamp to 0-255 range
-            if (gray_value > 255) gray_value = 255;
-            
-            gray_data[gray_idx] = (unsigned char)gray_value;
-        }
-    }
+    // Fixed-point conversion (8-bit fraction), vectorized where the CPU allows
+    kernels->rgb_to_gray(rgb_data, gray_data, (size_t)width * height);
     #else
     // Original implementation for non-embedded devices
     for (int y = 0; y < height; y++) {
@@ -545,42 +557,39 @@ static unsigned char *rgb_to_grayscale(const unsigned char *rgb_data, int width,
     }
     #endif
 
-    return gray_data;
 }
 
 /**
- * Downscale a grayscale image for faster processing
+ * Calculate the dimensions of a downscaled frame
  */
-static unsigned char *downscale_grayscale(const unsigned char *src, int width, int height, int factor, 
-                                         int *out_width, int *out_height) {
+static void get_downscaled_size(int width, int height, int factor, int *out_width, int *out_height) {
     if (factor <= 1) {
-        // No downscaling needed
-        unsigned char *copy = (unsigned char *)malloc(width * height);
-        if (!copy) {
-            log_error("Failed to allocate memory for image copy");
-            return NULL;
-        }
-        memcpy(copy, src, width * height);
         *out_width = width;
         *out_height = height;
-        return copy;
+        return;
     }
-    
-    // Calculate new dimensions
-    int new_width = width / factor;
-    int new_height = height / factor;
-    
+
+    *out_width = width / factor;
+    *out_height = height / factor;
+
     // Ensure minimum size
-    if (new_width < 32) new_width = 32;
-    if (new_height < 32) new_height = 32;
-    
-    // Allocate memory for downscaled image
-    unsigned char *dst = (unsigned char *)malloc(new_width * new_height);
-    if (!dst) {
-        log_error("Failed to allocate memory for downscaled image");
-        return NULL;
+    if (*out_width < 32) *out_width = 32;
+    if (*out_height < 32) *out_height = 32;
+}
+
+/**
+ * Downscale a grayscale image for faster processing into a caller-provided buffer
+ * of out_width x out_height (as returned by get_downscaled_size).
+ * Source rows are src_stride bytes apart so decoder planes can be read in place.
+ */
+static void downscale_grayscale(const unsigned char *src, int width, int height, int src_stride,
+                                int factor, unsigned char *dst, int new_width, int new_height) {
+    // Exact 2x downscaling has a vectorized kernel
+    if (factor == 2 && new_width == width / 2 && new_height == height / 2) {
+        kernels->downscale_2x(src, src_stride, dst, new_width, new_height);
+        return;
     }
-    
+
     // Perform downscaling by averaging blocks of pixels
     for (int y = 0; y < new_height; y++) {
         for (int x = 0; x < new_width; x++) {
@@ -590,25 +599,22 @@ static unsigned char *downscale_grayscale(const unsigned char *src, int width, i
             // Average the pixels in the block
             for (int dy = 0; dy < factor && (y * factor + dy) < height; dy++) {
                 for (int dx = 0; dx < factor && (x * factor + dx) < width; dx++) {
-                    sum += src[(y * factor + dy) * width + (x * factor + dx)];
+                    sum += src[(size_t)(y * factor + dy) * src_stride + (x * factor + dx)];
                     count++;
                 }
             }
             
-            // Store the average
-            dst[y * new_width + x] = (unsigned char)(sum / count);
+            // Store the average (blocks past the edge of tiny frames are black)
+            dst[y * new_width + x] = count > 0 ? (unsigned char)(sum / count) : 0;
         }
     }
-    
-    *out_width = new_width;
-    *out_height = new_height;
-    return dst;
 }
 
 /**
  * Apply a fast box blur to reduce noise - optimized for embedded devices
  */
-static void apply_box_blur(unsigned char *src, unsigned char *dst, int width, int height, int radius) {
+static void apply_box_blur(const unsigned char *src, unsigned char *dst, unsigned char *temp,
+                           int width, int height, int radius) {
     // Skip if radius is 0
     if (radius <= 0) {
         memcpy(dst, src, width * height);
@@ -618,85 +624,20 @@ static void apply_box_blur(unsigned char *src, unsigned char *dst, int width, in
     // For embedded devices, use a faster approximation with reduced radius
     #if EMBEDDED_DEVICE_OPTIMIZATION
     // Use a simplified blur for embedded devices - horizontal and vertical passes
-    // Horizontal pass
+    // Horizontal pass (sliding window per row)
     for (int y = 0; y < height; y++) {
-        int row_offset = y * width;
-        
-        // Initialize sliding window sum for the row
-        int sum = 0;
-        int count = 0;
-        
-        // Initialize the sum with the first radius+1 pixels
-        for (int i = 0; i <= radius && i < width; i++) {
-            sum += src[row_offset + i];
-            count++;
-        }
-        
-        // Process first pixel
-        dst[row_offset] = (unsigned char)(sum / count);
-        
-        // Slide the window for the rest of the row
-        for (int x = 1; x < width; x++) {
-            // Add new pixel to the right
-            if (x + radius < width) {
-                sum += src[row_offset + x + radius];
-                count++;
-            }
-            
-            // Remove pixel from the left
-            if (x - radius - 1 >= 0) {
-                sum -= src[row_offset + x - radius - 1];
-                count--;
-            }
-            
-            dst[row_offset + x] = (unsigned char)(sum / count);
-        }
-    }
-    
-    // Vertical pass (using dst as source and writing back to dst)
-    unsigned char *temp = (unsigned char *)malloc(width * height);
-    if (!temp) {
-        // If memory allocation fails, just return the horizontal blur
-        return;
+        kernels->blur_row(src + y * width, temp + y * width, width, radius);
     }
     
-    memcpy(temp, dst, width * height);
-    
-    for (int x = 0; x < width; x++) {
-        // Initialize sliding window sum for the column
-        int sum = 0;
-        int count = 0;
-        
-        // Initialize the sum with the first radius+1 pixels
-        for (int i = 0; i <= radius && i < height; i++) {
-            sum += temp[i * width + x];
-            count++;
-        }
-        
-        // Process first pixel
-        dst[x] = (unsigned char)(sum / count);
-        
-        // Slide the window for the rest of the column
-        for (int y = 1; y < height; y++) {
-            // Add new pixel below
-            if (y + radius < height) {
-                sum += temp[(y + radius) * width + x];
-                count++;
-            }
-            
-            // Remove pixel from above
-            if (y - radius - 1 >= 0) {
-                sum -= temp[(y - radius - 1) * width + x];
-                count--;
-            }
-            
-            dst[y * width + x] = (unsigned char)(sum / count);
-        }
+    // Vertical pass (from the horizontal result in temp back into dst)
+    // Each output row is the average of the in-bounds rows of its window
+    for (int y = 0; y < height; y++) {
+        int first = (y - radius < 0) ? 0 : y - radius;
+        int last = (y + radius >= height) ? height - 1 : y + radius;
+        kernels->average_rows(temp + first * width, width, last - first + 1, dst + y * width, width);
     }
-    
-    free(temp);
-    temp = NULL;  // Set to NULL after freeing to prevent use-after-free
     #else
+    (void)temp;
     // Original implementation for non-embedded devices
     for (int y = 0; y < height; y++) {
         for (int x = 0; x < width; x++) {
@@ -739,13 +680,9 @@ static void update_background_model(unsigned char *background, const unsigned ch
     // For embedded devices, use integer arithmetic for speed
     // Convert learning_rate to fixed-point (8-bit fraction)
     int alpha = (int)(learning_rate * 256);
-    int inv_alpha = 256 - alpha;
-    
-    for (int i = 0; i < width * height; i++) {
-        // background = (1-alpha) * background + alpha * current
-        // Using fixed-point arithmetic (8-bit fraction)
-        background[i] = (unsigned char)((inv_alpha * background[i] + alpha * current[i]) >> 8);
-    }
+
+    // background = (1-alpha) * background + alpha * current
+    kernels->update_background(background, current, (size_t)width * height, alpha);
     #else
     // Original implementation for non-embedded devices
     for (int i = 0; i < width * height; i++) {
@@ -774,8 +711,10 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
     float max_cell_score = 0.0f;
 
     #if EMBEDDED_DEVICE_OPTIMIZATION
-    // Convert sensitivity to fixed-point for faster comparison
+    // Convert sensitivity to fixed-point for faster comparison. A pixel counts as changed
+    // only when it clears both the noise and the sensitivity threshold.
     int sensitivity_threshold = (int)(sensitivity * 255.0f);
+    int threshold = (noise_threshold > sensitivity_threshold) ? noise_threshold : sensitivity_threshold;
     
     // Calculate motion for each grid cell
     for (int gy = 0; gy < grid_size; gy++) {
@@ -795,28 +734,12 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
 
             // Process each pixel in the cell - use sampling for better performance
             // Sample every other pixel in both dimensions
+            int samples_per_row = (cell_end_x - cell_start_x + 1) / 2;
             for (int y = cell_start_y; y < cell_end_y; y += 2) {
-                for (int x = cell_start_x; x < cell_end_x; x += 2) {
-                    int idx = y * width + x;
-
-                    // Calculate differences from previous frame and background
-                    int frame_diff = abs((int)curr_frame[idx] - (int)prev_frame[idx]);
-                    int bg_diff = abs((int)curr_frame[idx] - (int)background[idx]);
-
-                    // Use the larger of the two differences
-                    int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-                    // Apply noise threshold
-                    if (diff > noise_threshold) {
-                        // Pixel difference exceeds sensitivity threshold
-                        if (diff > sensitivity_threshold) {
-                            changed_pixels++;
-                            total_diff += diff;
-                        }
-                    }
-
-                    cell_pixels++;
-                }
+                int idx = y * width + cell_start_x;
+                kernels->accumulate_motion(curr_frame + idx, prev_frame + idx, background + idx,
+                                           samples_per_row, threshold, &changed_pixels, &total_diff);
+                cell_pixels += samples_per_row;
             }
 
             // Calculate cell motion score
@@ -906,30 +829,236 @@ static float calculate_grid_motion(const unsigned char *curr_frame, const unsign
 }
 
 /**
- * Add frame to history buffer
+ * Build a summed-area table: entry (x, y) holds the sum of all pixels above and left of it.
+ * The table is (width+1) x (height+1) with a zero first row and column.
+ */
+static void build_integral_image(const unsigned char *src, int width, int height, uint32_t *integral) {
+    int stride = width + 1;
+
+    memset(integral, 0, stride * sizeof(uint32_t));
+
+    for (int y = 0; y < height; y++) {
+        const unsigned char *row = src + y * width;
+        const uint32_t *above = integral + y * stride;
+        uint32_t *out = integral + (y + 1) * stride;
+        uint32_t row_sum = 0;
+
+        out[0] = 0;
+        for (int x = 0; x < width; x++) {
+            row_sum += row[x];
+            out[x + 1] = above[x + 1] + row_sum;
+        }
+    }
+}
+
+/**
+ * Sum of the rectangle [x0, x1) x [y0, y1) from a summed-area table
  */
-static void add_frame_to_history(motion_stream_t *stream, const unsigned char *frame, time_t timestamp) {
-    if (!stream || !frame || !stream->frame_history) {
+static inline uint32_t integral_rect_sum(const uint32_t *integral, int stride, int x0, int y0, int x1, int y1) {
+    return integral[y1 * stride + x1] - integral[y0 * stride + x1] -
+           integral[y1 * stride + x0] + integral[y0 * stride + x0];
+}
+
+/**
+ * Apply a box blur using a summed-area table - O(1) per pixel for any radius.
+ * Edge pixels average only the in-bounds part of the window.
+ */
+static void apply_box_blur_integral(const unsigned char *src, unsigned char *dst, int width, int height,
+                                    int radius, uint32_t *integral) {
+    if (radius <= 0) {
+        memcpy(dst, src, width * height);
         return;
     }
 
-    // Free the old frame if it exists
-    if (stream->frame_history[stream->history_index].frame) {
-        free(stream->frame_history[stream->history_index].frame);
+    build_integral_image(src, width, height, integral);
+
+    int stride = width + 1;
+    int window = 2 * radius + 1;
+    // floor(sum * magic / 2^32) == sum / (window * window) for every possible window sum
+    uint64_t magic = ((1ULL << 32) + window * window - 1) / (window * window);
+
+    for (int y = 0; y < height; y++) {
+        int y0 = (y - radius < 0) ? 0 : y - radius;
+        int y1 = (y + radius + 1 > height) ? height : y + radius + 1;
+        bool full_rows = (y1 - y0) == window;
+        unsigned char *out = dst + y * width;
+
+        for (int x = 0; x < width; x++) {
+            int x0 = (x - radius < 0) ? 0 : x - radius;
+            int x1 = (x + radius + 1 > width) ? width : x + radius + 1;
+            uint32_t sum = integral_rect_sum(integral, stride, x0, y0, x1, y1);
+
+            if (full_rows && (x1 - x0) == window) {
+                out[x] = (unsigned char)(((uint64_t)sum * magic) >> 32);
+            } else {
+                out[x] = (unsigned char)(sum / (uint32_t)((x1 - x0) * (y1 - y0)));
+            }
+        }
     }
+}
 
-    // Allocate and copy new frame
-    stream->frame_history[stream->history_index].frame = (unsigned char *)malloc(stream->width * stream->height);
-    if (!stream->frame_history[stream->history_index].frame) {
-        log_error("Failed to allocate memory for frame history");
-        return;
+/**
+ * Build summed-area tables of changed pixels and their differences in a single pass.
+ * A pixel is changed when max(|curr - prev|, |curr - background|) > threshold.
+ */
+static void build_motion_integrals(const unsigned char *curr_frame, const unsigned char *prev_frame,
+                                   const unsigned char *background, int width, int height, int threshold,
+                                   uint32_t *count_integral, uint32_t *diff_integral) {
+    int stride = width + 1;
+
+    memset(count_integral, 0, stride * sizeof(uint32_t));
+    memset(diff_integral, 0, stride * sizeof(uint32_t));
+
+    for (int y = 0; y < height; y++) {
+        int row_offset = y * width;
+        const uint32_t *count_above = count_integral + y * stride;
+        const uint32_t *diff_above = diff_integral + y * stride;
+        uint32_t *count_out = count_integral + (y + 1) * stride;
+        uint32_t *diff_out = diff_integral + (y + 1) * stride;
+        uint32_t row_count = 0;
+        uint32_t row_diff = 0;
+
+        count_out[0] = 0;
+        diff_out[0] = 0;
+        for (int x = 0; x < width; x++) {
+            int idx = row_offset + x;
+            int frame_diff = abs((int)curr_frame[idx] - (int)prev_frame[idx]);
+            int bg_diff = abs((int)curr_frame[idx] - (int)background[idx]);
+            int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
+
+            if (diff > threshold) {
+                row_count++;
+                row_diff += diff;
+            }
+
+            count_out[x + 1] = count_above[x + 1] + row_count;
+            diff_out[x + 1] = diff_above[x + 1] + row_diff;
+        }
+    }
+}
+
+/**
+ * Calculate grid motion from the difference summed-area table - O(1) per grid cell
+ */
+static float calculate_grid_motion_integral(const uint32_t *diff_integral, int width, int height, int grid_size,
+                                            float *grid_scores, float *motion_area) {
+    int stride = width + 1;
+    int cell_width = width / grid_size;
+    int cell_height = height / grid_size;
+    int total_cells = grid_size * grid_size;
+    int cells_with_motion = 0;
+    float max_cell_score = 0.0f;
+
+    for (int gy = 0; gy < grid_size; gy++) {
+        for (int gx = 0; gx < grid_size; gx++) {
+            int x0 = gx * cell_width;
+            int y0 = gy * cell_height;
+            int x1 = (gx + 1) * cell_width;
+            int y1 = (gy + 1) * cell_height;
+
+            if (x1 > width) x1 = width;
+            if (y1 > height) y1 = height;
+
+            int cell_pixels = (x1 - x0) * (y1 - y0);
+            if (cell_pixels <= 0) {
+                grid_scores[gy * grid_size + gx] = 0.0f;
+                continue;
+            }
+
+            uint32_t total_diff = integral_rect_sum(diff_integral, stride, x0, y0, x1, y1);
+            float cell_score = (float)total_diff / (float)(cell_pixels * 255.0f);
+
+            grid_scores[gy * grid_size + gx] = cell_score;
+
+            // Track overall motion
+            if (cell_score > 0.01f) {  // Cell has meaningful motion
+                cells_with_motion++;
+                if (cell_score > max_cell_score) {
+                    max_cell_score = cell_score;
+                }
+            }
+        }
     }
 
-    memcpy(stream->frame_history[stream->history_index].frame, frame, stream->width * stream->height);
-    stream->frame_history[stream->history_index].timestamp = timestamp;
+    *motion_area = (float)cells_with_motion / (float)total_cells;
+    return max_cell_score;
+}
+
+/**
+ * Allocate a buffer on behalf of a stream, counting the allocation in its statistics.
+ * Every buffer detect_motion() allocates goes through here.
+ */
+static void *motion_stream_alloc(motion_stream_t *stream, size_t size) {
+    stream->buffer_allocations++;
+    return malloc(size);
+}
+
+/**
+ * Reset the stream's scratch arena, growing it first if it cannot hold size bytes.
+ * Once the arena has grown to fit the stream's frame size this never allocates.
+ *
+ * @return true on success, false if the arena could not be grown
+ */
+static bool arena_reset(motion_stream_t *stream, size_t size) {
+    motion_arena_t *arena = &stream->arena;
+
+    arena->used = 0;
+    if (arena->capacity >= size) {
+        return true;
+    }
+
+    free(arena->base);
+    arena->base = (unsigned char *)motion_stream_alloc(stream, size);
+    if (!arena->base) {
+        arena->capacity = 0;
+        log_error("Failed to allocate %zu byte motion arena for stream %s", size, stream->stream_name);
+        return false;
+    }
+    arena->capacity = size;
+
+    log_debug("Motion arena for stream %s sized to %zu bytes", stream->stream_name, size);
+    return true;
+}
+
+/**
+ * Take a buffer from the stream's scratch arena; valid until the next arena_reset()
+ */
+static unsigned char *arena_alloc(motion_arena_t *arena, size_t size) {
+    size = ARENA_ALIGN(size);
+    if (arena->used + size > arena->capacity) {
+        return NULL;
+    }
 
-    // Update index
-    stream->history_index = (stream->history_index + 1) % stream->history_size;
+    unsigned char *ptr = arena->base + arena->used;
+    arena->used += size;
+    return ptr;
+}
+
+/**
+ * Make sure the summed-area tables exist for the current frame size
+ *
+ * @return true if the integral image path can be used for this frame
+ */
+static bool ensure_integral_buffers(motion_stream_t *stream) {
+    if (!stream->use_integral_image) {
+        return false;
+    }
+
+    if ((size_t)stream->width * stream->height >= MAX_INTEGRAL_PIXELS) {
+        return false;
+    }
+
+    if (!stream->integral) {
+        size_t entries = (size_t)(stream->width + 1) * (stream->height + 1);
+        stream->integral = (uint32_t *)motion_stream_alloc(stream, entries * 2 * sizeof(uint32_t));
+        if (!stream->integral) {
+            log_warn("Failed to allocate integral image for stream %s, using separable blur",
+                     stream->stream_name);
+            return false;
+        }
+    }
+
+    return true;
 }
 
 /**
@@ -941,6 +1070,22 @@ static float get_time_ms() {
     return (float)(ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0);
 }
 
+/**
+ * Calculate the memory held by a stream's detection buffers
+ */
+static size_t get_stream_memory(const motion_stream_t *stream) {
+    size_t frame_size = (size_t)stream->width * stream->height;
+    size_t total = stream->arena.capacity + frame_size * 3;  // arena, prev_frame, blur_buffer, background
+    if (stream->grid_scores) {
+        total += stream->grid_size * stream->grid_size * sizeof(float);
+    }
+    if (stream->integral) {
+        total += (size_t)(stream->width + 1) * (stream->height + 1) * 2 * sizeof(uint32_t);
+    }
+
+    return total;
+}
+
 /**
  * Update memory usage statistics
  */
@@ -954,15 +1099,16 @@ static void update_memory_usage(motion_stream_t *stream, size_t allocated) {
 }
 
 /**
- * Process a frame for motion detection - optimized for embedded devices
+ * Shared motion detection pipeline behind detect_motion() and detect_motion_luma().
+ *
+ * line_size is the distance in bytes between rows of single-channel input (RGB input
+ * must be packed). prescale_factor is the downscaling already applied by the decoder,
+ * which is subtracted from the stream's configured downscale factor.
  */
-int detect_motion(const char *stream_name, const unsigned char *frame_data,
-                 int width, int height, int channels, time_t frame_time,
-                 detection_result_t *result) {
-    if (!stream_name || !frame_data || !result || width <= 0 || height <= 0 || channels <= 0) {
-        log_error("Invalid parameters for detect_motion");
-        return -1;
-    }
+static int process_motion_frame(const char *stream_name, const unsigned char *frame_data,
+                                int width, int height, int channels, int line_size,
+                                int prescale_factor, time_t frame_time,
+                                detection_result_t *result) {
 
     // Initialize result
     memset(result, 0, sizeof(detection_result_t));
@@ -981,8 +1127,8 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
     clock_gettime(CLOCK_MONOTONIC, &start_time);
     stream->last_frame_start = start_time;
     
-    // Track memory usage
-    size_t current_memory = 0;
+    // Buffers are only allocated while the stream warms up or changes resolution
+    uint64_t buffer_allocations_at_start = stream->buffer_allocations;
 
     // Check if motion detection is enabled
     if (!stream->enabled) {
@@ -997,56 +1143,68 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         return 0;
     }
 
-    // Convert to grayscale if needed
-    unsigned char *gray_frame = NULL;
-    if (channels == 3) {
-        gray_frame = rgb_to_grayscale(frame_data, width, height);
-        if (!gray_frame) {
-            pthread_mutex_unlock(&stream->mutex);
-            return -1;
-        }
-        current_memory += width * height;
-    } else if (channels == 1) {
-        // If input is already grayscale, just make a copy
-        gray_frame = (unsigned char *)malloc(width * height);
-        if (!gray_frame) {
-            log_error("Failed to allocate memory for gray frame");
-            pthread_mutex_unlock(&stream->mutex);
-            return -1;
-        }
-        memcpy(gray_frame, frame_data, width * height);
-        current_memory += width * height;
-    } else {
+    if (channels != 3 && channels != 1) {
         log_error("Unsupported number of channels: %d", channels);
         pthread_mutex_unlock(&stream->mutex);
         return -1;
     }
 
-    // Downscale the frame if enabled
-    unsigned char *processing_frame = gray_frame;
+    // Work out the processing size up front so all scratch buffers come from the arena
     int processing_width = width;
     int processing_height = height;
-    
-    if (stream->downscale_enabled && stream->downscale_factor > 1) {
-        unsigned char *downscaled = downscale_grayscale(gray_frame, width, height, 
-                                                      stream->downscale_factor,
-                                                      &processing_width, &processing_height);
-        if (downscaled) {
-            // Use the downscaled frame for processing
-            free(gray_frame);
-            gray_frame = NULL;
-            processing_frame = downscaled;
-            
-            // Update memory tracking
-            current_memory = current_memory - (width * height) + (processing_width * processing_height);
-            
-            log_debug("Downscaled frame from %dx%d to %dx%d for motion detection",
-                     width, height, processing_width, processing_height);
-        } else {
-            log_warn("Failed to downscale frame, using original resolution");
+    int downscale_factor = stream->downscale_factor;
+    if (prescale_factor > 1) {
+        downscale_factor /= prescale_factor;
+    }
+    bool downscale = stream->downscale_enabled && downscale_factor > 1;
+    if (downscale) {
+        get_downscaled_size(width, height, downscale_factor, &processing_width, &processing_height);
+    }
+
+    // Strided grayscale input only needs packing when it is not downscaled
+    bool pack_rows = channels == 1 && line_size != width && !downscale;
+
+    size_t input_size = (size_t)width * height;
+    size_t processing_size = (size_t)processing_width * processing_height;
+    size_t arena_size = ARENA_ALIGN(processing_size);                 // Blur temp buffer
+    if (channels == 3 || pack_rows) arena_size += ARENA_ALIGN(input_size);  // Grayscale frame
+    if (downscale) arena_size += ARENA_ALIGN(processing_size);       // Downscaled frame
+
+    if (!arena_reset(stream, arena_size)) {
+        pthread_mutex_unlock(&stream->mutex);
+        return -1;
+    }
+
+    // Convert to grayscale if needed, packed grayscale input is used in place
+    const unsigned char *gray_frame = frame_data;
+    int gray_stride = channels == 1 ? line_size : width;
+    if (channels == 3) {
+        unsigned char *gray = arena_alloc(&stream->arena, input_size);
+        rgb_to_grayscale(frame_data, gray, width, height);
+        gray_frame = gray;
+    } else if (pack_rows) {
+        unsigned char *gray = arena_alloc(&stream->arena, input_size);
+        for (int y = 0; y < height; y++) {
+            memcpy(gray + (size_t)y * width, frame_data + (size_t)y * line_size, width);
         }
+        gray_frame = gray;
+        gray_stride = width;
     }
 
+    // Downscale the frame if enabled
+    const unsigned char *processing_frame = gray_frame;
+    if (downscale) {
+        unsigned char *downscaled = arena_alloc(&stream->arena, processing_size);
+        downscale_grayscale(gray_frame, width, height, gray_stride, downscale_factor,
+                            downscaled, processing_width, processing_height);
+        processing_frame = downscaled;
+
+        log_debug("Downscaled frame from %dx%d to %dx%d for motion detection",
+                 width, height, processing_width, processing_height);
+    }
+
+    unsigned char *blur_temp = arena_alloc(&stream->arena, processing_size);
+
     // Check if we need to allocate or reallocate resources
     if (!stream->prev_frame || stream->width != processing_width || stream->height != processing_height) {
         // Free old resources if they exist
@@ -1070,20 +1228,15 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
             stream->grid_scores = NULL;
         }
 
-        if (stream->frame_history) {
-            for (int i = 0; i < stream->history_size; i++) {
-                if (stream->frame_history[i].frame) {
-                    free(stream->frame_history[i].frame);
-                }
-            }
-            free(stream->frame_history);
-            stream->frame_history = NULL;
+        if (stream->integral) {
+            free(stream->integral);
+            stream->integral = NULL;
         }
 
         // Allocate new resources
-        stream->prev_frame = (unsigned char *)malloc(processing_width * processing_height);
-        stream->blur_buffer = (unsigned char *)malloc(processing_width * processing_height);
-        stream->background = (unsigned char *)malloc(processing_width * processing_height);
+        stream->prev_frame = (unsigned char *)motion_stream_alloc(stream, processing_size);
+        stream->blur_buffer = (unsigned char *)motion_stream_alloc(stream, processing_size);
+        stream->background = (unsigned char *)motion_stream_alloc(stream, processing_size);
 
         if (!stream->prev_frame || !stream->blur_buffer || !stream->background) {
             log_error("Failed to allocate memory for motion detection buffers");
@@ -1103,41 +1256,13 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
                 stream->background = NULL;
             }
 
-            free(processing_frame);
             pthread_mutex_unlock(&stream->mutex);
             return -1;
         }
 
         // Initialize the background with the current frame
-        memcpy(stream->background, processing_frame, processing_width * processing_height);
-        memcpy(stream->prev_frame, processing_frame, processing_width * processing_height);
-
-        // Allocate grid scores array
-        if (stream->use_grid_detection) {
-            stream->grid_scores = (float *)malloc(stream->grid_size * stream->grid_size * sizeof(float));
-            if (!stream->grid_scores) {
-                log_error("Failed to allocate memory for grid scores");
-                free(processing_frame);
-                pthread_mutex_unlock(&stream->mutex);
-                return -1;
-            }
-            memset(stream->grid_scores, 0, stream->grid_size * stream->grid_size * sizeof(float));
-        }
-
-        // Allocate frame history buffer
-        stream->frame_history = (frame_history_t *)malloc(stream->history_size * sizeof(frame_history_t));
-        if (!stream->frame_history) {
-            log_error("Failed to allocate memory for frame history");
-            if (stream->grid_scores) {
-                free(stream->grid_scores);
-                stream->grid_scores = NULL;
-            }
-            free(processing_frame);
-            pthread_mutex_unlock(&stream->mutex);
-            return -1;
-        }
-        memset(stream->frame_history, 0, stream->history_size * sizeof(frame_history_t));
-        stream->history_index = 0;
+        memcpy(stream->background, processing_frame, processing_size);
+        memcpy(stream->prev_frame, processing_frame, processing_size);
 
         // Update dimensions
         stream->width = processing_width;
@@ -1145,21 +1270,82 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         stream->channels = 1;  // We always store grayscale
         stream->downscaled_width = processing_width;
         stream->downscaled_height = processing_height;
+        stream->last_frame_buffer_allocations = (uint32_t)(stream->buffer_allocations - buffer_allocations_at_start);
+        stream->buffer_allocation_free_frames = 0;
 
-        free(processing_frame);
         pthread_mutex_unlock(&stream->mutex);
         return 0;  // Skip motion detection on first frame
     }
 
+    // Grid buffers are (re)allocated lazily, e.g. after configuration changes
+    if (stream->use_grid_detection && !stream->grid_scores) {
+        size_t grid_bytes = stream->grid_size * stream->grid_size * sizeof(float);
+        stream->grid_scores = (float *)motion_stream_alloc(stream, grid_bytes);
+        if (!stream->grid_scores) {
+            log_error("Failed to allocate memory for grid scores");
+            pthread_mutex_unlock(&stream->mutex);
+            return -1;
+        }
+        memset(stream->grid_scores, 0, grid_bytes);
+    }
+
+    // Opt-in: the summed-area tables make blur and scoring cost independent of blur_radius and grid_size
+    bool use_integral = ensure_integral_buffers(stream);
+    uint32_t *count_integral = NULL;
+    uint32_t *diff_integral = NULL;
+    if (use_integral) {
+        count_integral = stream->integral;
+        diff_integral = stream->integral + (size_t)(processing_width + 1) * (processing_height + 1);
+    }
+
     // Apply blur to reduce noise
-    apply_box_blur(processing_frame, stream->blur_buffer, processing_width, processing_height, stream->blur_radius);
+    if (use_integral) {
+        apply_box_blur_integral(processing_frame, stream->blur_buffer, processing_width, processing_height,
+                                stream->blur_radius, count_integral);
+    } else {
+        apply_box_blur(processing_frame, stream->blur_buffer, blur_temp,
+                       processing_width, processing_height, stream->blur_radius);
+    }
+
+    // A pixel counts as changed when it clears both the noise and the sensitivity threshold
+    // (diff > sensitivity * 255.0f is the same as diff > (int)(sensitivity * 255.0f) for integer diffs)
+    int sensitivity_threshold = (int)(stream->sensitivity * 255.0f);
+    int threshold = (stream->noise_threshold > sensitivity_threshold) ?
+                    stream->noise_threshold : sensitivity_threshold;
+
+    // The blur table is no longer needed, so its memory is reused for the motion tables
+    if (use_integral) {
+        build_motion_integrals(stream->blur_buffer, stream->prev_frame, stream->background,
+                               processing_width, processing_height, threshold,
+                               count_integral, diff_integral);
+    }
 
     bool motion_detected = false;
     float motion_score = 0.0f;
     float motion_area = 0.0f;
 
     // Detect motion between frames
-    if (stream->use_grid_detection) {
+    if (stream->use_grid_detection && use_integral) {
+        // Grid-based motion detection, each cell is a constant-time table lookup
+        motion_score = calculate_grid_motion_integral(
+            diff_integral, processing_width, processing_height,
+            stream->grid_size, stream->grid_scores, &motion_area
+        );
+
+        // Determine if motion is detected based on area threshold
+        motion_detected = (motion_area >= stream->min_motion_area) && (motion_score > 0.01f);
+    } else if (use_integral) {
+        // Whole-frame differencing is a single rectangle of the motion tables
+        int stride = processing_width + 1;
+        int pixel_count = processing_width * processing_height;
+        uint32_t changed_pixels = integral_rect_sum(count_integral, stride, 0, 0, processing_width, processing_height);
+        uint32_t total_diff = integral_rect_sum(diff_integral, stride, 0, 0, processing_width, processing_height);
+
+        motion_area = (float)changed_pixels / (float)pixel_count;
+        motion_score = (float)total_diff / ((float)pixel_count * 255.0f);
+
+        motion_detected = (motion_area >= stream->min_motion_area);
+    } else if (stream->use_grid_detection) {
         // Grid-based motion detection
         motion_score = calculate_grid_motion(
             stream->blur_buffer, stream->prev_frame, stream->background,
@@ -1178,26 +1364,12 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         #if EMBEDDED_DEVICE_OPTIMIZATION
         // For embedded devices, use sampling to reduce computation
         // Process every other pixel in both dimensions
+        int samples_per_row = (processing_width + 1) / 2;
         for (int y = 0; y < processing_height; y += 2) {
-            for (int x = 0; x < processing_width; x += 2) {
-                int idx = y * processing_width + x;
-                
-                // Calculate differences from previous frame and background
-                int frame_diff = abs((int)stream->blur_buffer[idx] - (int)stream->prev_frame[idx]);
-                int bg_diff = abs((int)stream->blur_buffer[idx] - (int)stream->background[idx]);
-
-                // Use the larger of the two differences
-                int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
-
-                // Apply noise threshold
-                if (diff > stream->noise_threshold) {
-                    // Count pixels that changed more than the sensitivity threshold
-                    if (diff > (stream->sensitivity * 255.0f)) {
-                        changed_pixels++;
-                        total_diff += diff;
-                    }
-                }
-            }
+            int idx = y * processing_width;
+            kernels->accumulate_motion(stream->blur_buffer + idx, stream->prev_frame + idx,
+                                       stream->background + idx, samples_per_row, threshold,
+                                       &changed_pixels, &total_diff);
         }
         
         // Adjust for sampling (we only processed 1/4 of the pixels)
@@ -1231,9 +1403,6 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
         motion_detected = (motion_area >= stream->min_motion_area);
     }
 
-    // Add current frame to history
-    add_frame_to_history(stream, stream->blur_buffer, frame_time);
-
     // Update background model with a slow learning rate
     // Use a faster learning rate (0.05) when no motion is detected, slower (0.01) when motion is detected
     float learning_rate = motion_detected ? 0.01f : 0.05f;
@@ -1266,9 +1435,6 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
                  stream_name, motion_score, motion_area * 100.0f, stream->min_motion_area);
     }
 
-    // Clean up
-    free(processing_frame);
-    
     // End performance monitoring
     struct timespec end_time;
     clock_gettime(CLOCK_MONOTONIC, &end_time);
@@ -1293,13 +1459,77 @@ int detect_motion(const char *stream_name, const unsigned char *frame_data,
     }
     
     // Update memory usage statistics
-    update_memory_usage(stream, current_memory);
+    update_memory_usage(stream, get_stream_memory(stream));
+
+    // Update buffer allocation statistics
+    stream->last_frame_buffer_allocations = (uint32_t)(stream->buffer_allocations - buffer_allocations_at_start);
+    if (stream->last_frame_buffer_allocations == 0) {
+        stream->buffer_allocation_free_frames++;
+    } else {
+        stream->buffer_allocation_free_frames = 0;
+    }
     
     pthread_mutex_unlock(&stream->mutex);
 
     return 0;
 }
 
+/**
+ * Process a frame for motion detection - optimized for embedded devices
+ */
+int detect_motion(const char *stream_name, const unsigned char *frame_data,
+                 int width, int height, int channels, time_t frame_time,
+                 detection_result_t *result) {
+    if (!stream_name || !frame_data || !result || width <= 0 || height <= 0 || channels <= 0) {
+        log_error("Invalid parameters for detect_motion");
+        return -1;
+    }
+
+    return process_motion_frame(stream_name, frame_data, width, height, channels,
+                                width * channels, 1, frame_time, result);
+}
+
+/**
+ * Process the luma plane of a decoded YUV frame for motion detection
+ */
+int detect_motion_luma(const char *stream_name, const unsigned char *y_plane, int line_size,
+                       int width, int height, int prescale_factor, time_t frame_time,
+                       detection_result_t *result) {
+    if (!stream_name || !y_plane || !result || width <= 0 || height <= 0 || line_size < width) {
+        log_error("Invalid parameters for detect_motion_luma");
+        return -1;
+    }
+
+    return process_motion_frame(stream_name, y_plane, width, height, 1, line_size,
+                                prescale_factor, frame_time, result);
+}
+
+/**
+ * Get the decoder lowres level to request for a motion-only stream
+ */
+int get_motion_detection_decoder_lowres(const char *stream_name, int max_lowres) {
+    if (!stream_name || max_lowres <= 0) {
+        return 0;
+    }
+
+    motion_stream_t *stream = get_motion_stream(stream_name);
+    if (!stream) {
+        return 0;
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+    int factor = stream->downscale_enabled ? stream->downscale_factor : 1;
+    pthread_mutex_unlock(&stream->mutex);
+
+    // Largest power of two not exceeding the configured downscale factor
+    int lowres = 0;
+    while (lowres < max_lowres && (2 << lowres) <= factor) {
+        lowres++;
+    }
+
+    return lowres;
+}
+
 /**
  * Get memory usage statistics for motion detection
  */
@@ -1342,6 +1572,45 @@ int get_motion_detection_cpu_usage(const char *stream_name, float *avg_processin
     return 0;
 }
 
+/**
+ * Get buffer allocation statistics for motion detection
+ */
+int get_motion_detection_buffer_allocation_stats(const char *stream_name, uint64_t *total_buffer_allocations,
+                                                 uint32_t *last_frame_buffer_allocations,
+                                                 uint64_t *buffer_allocation_free_frames) {
+    if (!stream_name || !total_buffer_allocations || !last_frame_buffer_allocations || !buffer_allocation_free_frames) {
+        return -1;
+    }
+
+    motion_stream_t *stream = get_motion_stream(stream_name);
+    if (!stream) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&stream->mutex);
+    *total_buffer_allocations = stream->buffer_allocations;
+    *last_frame_buffer_allocations = stream->last_frame_buffer_allocations;
+    *buffer_allocation_free_frames = stream->buffer_allocation_free_frames;
+    pthread_mutex_unlock(&stream->mutex);
+
+    return 0;
+}
+
+/**
+ * Get the pixel kernel set used for motion detection and its speedup over scalar code
+ */
+int get_motion_detection_kernel_info(const char **kernel_name, float *speedup) {
+    if (!kernel_name || !speedup) {
+        return -1;
+    }
+
+    const motion_kernels_t *active = kernels ? kernels : motion_kernels_get();
+    *kernel_name = active->name;
+    *speedup = kernel_speedup;
+
+    return 0;
+}
+
 /**
  * Reset performance statistics for motion detection
  */
@@ -0,0 +1,817 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <time.h>
+
+#include "core/logger.h"
+#include "video/motion_detection_simd.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MOTION_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MOTION_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+// Fixed-point grayscale coefficients, (int)(0.299 * 256) etc.
+#define GRAY_R_COEFF 76
+#define GRAY_G_COEFF 150
+#define GRAY_B_COEFF 29
+
+/**
+ * Magic multiplier for dividing a 16-bit sum by d with a multiply-high.
+ * floor(n * m / 65536) == floor(n / d) for every n <= 11 * 255 and 2 <= d <= 11,
+ * which covers all box blur windows (radius <= 5).
+ */
+static inline uint16_t div_magic(int d) {
+    return (uint16_t)((65536 + d - 1) / d);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Scalar kernels                                                            */
+/* ------------------------------------------------------------------------- */
+
+static void scalar_rgb_to_gray(const unsigned char *rgb, unsigned char *gray, size_t pixels) {
+    for (size_t i = 0; i < pixels; i++) {
+        gray[i] = (unsigned char)((GRAY_R_COEFF * rgb[i * 3] +
+                                   GRAY_G_COEFF * rgb[i * 3 + 1] +
+                                   GRAY_B_COEFF * rgb[i * 3 + 2]) >> 8);
+    }
+}
+
+static void scalar_downscale_2x(const unsigned char *src, int src_width,
+                                unsigned char *dst, int dst_width, int dst_height) {
+    for (int y = 0; y < dst_height; y++) {
+        const unsigned char *row0 = src + (size_t)(y * 2) * src_width;
+        const unsigned char *row1 = row0 + src_width;
+        unsigned char *out = dst + (size_t)y * dst_width;
+        for (int x = 0; x < dst_width; x++) {
+            out[x] = (unsigned char)((row0[x * 2] + row0[x * 2 + 1] +
+                                      row1[x * 2] + row1[x * 2 + 1]) >> 2);
+        }
+    }
+}
+
+static void scalar_blur_row(const unsigned char *src, unsigned char *dst, int width, int radius) {
+    int sum = 0;
+    int count = 0;
+
+    // Initialize the sum with the first radius+1 pixels
+    for (int i = 0; i <= radius && i < width; i++) {
+        sum += src[i];
+        count++;
+    }
+    dst[0] = (unsigned char)(sum / count);
+
+    // Slide the window for the rest of the row
+    for (int x = 1; x < width; x++) {
+        if (x + radius < width) {
+            sum += src[x + radius];
+            count++;
+        }
+        if (x - radius - 1 >= 0) {
+            sum -= src[x - radius - 1];
+            count--;
+        }
+        dst[x] = (unsigned char)(sum / count);
+    }
+}
+
+/**
+ * Blur a single pixel of a row - used by the vector kernels for the row edges
+ */
+static inline unsigned char blur_pixel(const unsigned char *src, int width, int radius, int x) {
+    int start = x - radius < 0 ? 0 : x - radius;
+    int end = x + radius >= width ? width - 1 : x + radius;
+    int sum = 0;
+    for (int i = start; i <= end; i++) {
+        sum += src[i];
+    }
+    return (unsigned char)(sum / (end - start + 1));
+}
+
+static void scalar_average_rows(const unsigned char *src, int stride, int nrows,
+                                unsigned char *dst, int width) {
+    for (int x = 0; x < width; x++) {
+        int sum = 0;
+        for (int r = 0; r < nrows; r++) {
+            sum += src[(size_t)r * stride + x];
+        }
+        dst[x] = (unsigned char)(sum / nrows);
+    }
+}
+
+static void scalar_update_background(unsigned char *background, const unsigned char *current,
+                                     size_t pixels, int alpha) {
+    int inv_alpha = 256 - alpha;
+    for (size_t i = 0; i < pixels; i++) {
+        background[i] = (unsigned char)((inv_alpha * background[i] + alpha * current[i]) >> 8);
+    }
+}
+
+static void scalar_accumulate_motion(const unsigned char *curr, const unsigned char *prev,
+                                     const unsigned char *background, int samples, int threshold,
+                                     int *changed, int *total_diff) {
+    int local_changed = 0;
+    int local_total = 0;
+
+    for (int i = 0; i < samples; i++) {
+        int idx = i * 2;
+        int frame_diff = abs((int)curr[idx] - (int)prev[idx]);
+        int bg_diff = abs((int)curr[idx] - (int)background[idx]);
+        int diff = (frame_diff > bg_diff) ? frame_diff : bg_diff;
+
+        if (diff > threshold) {
+            local_changed++;
+            local_total += diff;
+        }
+    }
+
+    *changed += local_changed;
+    *total_diff += local_total;
+}
+
+static const motion_kernels_t scalar_kernels = {
+    .name = "scalar",
+    .rgb_to_gray = scalar_rgb_to_gray,
+    .downscale_2x = scalar_downscale_2x,
+    .blur_row = scalar_blur_row,
+    .average_rows = scalar_average_rows,
+    .update_background = scalar_update_background,
+    .accumulate_motion = scalar_accumulate_motion,
+};
+
+#ifdef MOTION_SIMD_X86
+/* ------------------------------------------------------------------------- */
+/* SSE2 kernels                                                              */
+/* ------------------------------------------------------------------------- */
+
+__attribute__((target("sse2")))
+static void sse2_downscale_2x(const unsigned char *src, int src_width,
+                              unsigned char *dst, int dst_width, int dst_height) {
+    const __m128i low_bytes = _mm_set1_epi16(0x00FF);
+
+    for (int y = 0; y < dst_height; y++) {
+        const unsigned char *row0 = src + (size_t)(y * 2) * src_width;
+        const unsigned char *row1 = row0 + src_width;
+        unsigned char *out = dst + (size_t)y * dst_width;
+        int x = 0;
+
+        for (; x + 16 <= dst_width; x += 16) {
+            __m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + x * 2));
+            __m128i a1 = _mm_loadu_si128((const __m128i *)(row0 + x * 2 + 16));
+            __m128i b0 = _mm_loadu_si128((const __m128i *)(row1 + x * 2));
+            __m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + x * 2 + 16));
+
+            // Pairwise horizontal sums in 16-bit lanes (even byte + odd byte)
+            __m128i s0 = _mm_add_epi16(_mm_and_si128(a0, low_bytes), _mm_srli_epi16(a0, 8));
+            __m128i s1 = _mm_add_epi16(_mm_and_si128(a1, low_bytes), _mm_srli_epi16(a1, 8));
+            s0 = _mm_add_epi16(s0, _mm_add_epi16(_mm_and_si128(b0, low_bytes), _mm_srli_epi16(b0, 8)));
+            s1 = _mm_add_epi16(s1, _mm_add_epi16(_mm_and_si128(b1, low_bytes), _mm_srli_epi16(b1, 8)));
+
+            s0 = _mm_srli_epi16(s0, 2);
+            s1 = _mm_srli_epi16(s1, 2);
+            _mm_storeu_si128((__m128i *)(out + x), _mm_packus_epi16(s0, s1));
+        }
+
+        for (; x < dst_width; x++) {
+            out[x] = (unsigned char)((row0[x * 2] + row0[x * 2 + 1] +
+                                      row1[x * 2] + row1[x * 2 + 1]) >> 2);
+        }
+    }
+}
+
+__attribute__((target("sse2")))
+static void sse2_blur_row(const unsigned char *src, unsigned char *dst, int width, int radius) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i magic = _mm_set1_epi16((short)div_magic(2 * radius + 1));
+    int x = 0;
+
+    for (; x < radius && x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+
+    // Interior pixels always average the full 2*radius+1 window
+    for (; x + 16 + radius <= width; x += 16) {
+        __m128i lo = zero;
+        __m128i hi = zero;
+        for (int k = -radius; k <= radius; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + x + k));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        lo = _mm_mulhi_epu16(lo, magic);
+        hi = _mm_mulhi_epu16(hi, magic);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+
+    for (; x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+}
+
+__attribute__((target("sse2")))
+static void sse2_average_rows(const unsigned char *src, int stride, int nrows,
+                              unsigned char *dst, int width) {
+    if (nrows == 1) {
+        memcpy(dst, src, width);
+        return;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i magic = _mm_set1_epi16((short)div_magic(nrows));
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        __m128i lo = zero;
+        __m128i hi = zero;
+        for (int r = 0; r < nrows; r++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(src + (size_t)r * stride + x));
+            lo = _mm_add_epi16(lo, _mm_unpacklo_epi8(v, zero));
+            hi = _mm_add_epi16(hi, _mm_unpackhi_epi8(v, zero));
+        }
+        lo = _mm_mulhi_epu16(lo, magic);
+        hi = _mm_mulhi_epu16(hi, magic);
+        _mm_storeu_si128((__m128i *)(dst + x), _mm_packus_epi16(lo, hi));
+    }
+
+    if (x < width) {
+        scalar_average_rows(src + x, stride, nrows, dst + x, width - x);
+    }
+}
+
+__attribute__((target("sse2")))
+static void sse2_update_background(unsigned char *background, const unsigned char *current,
+                                   size_t pixels, int alpha) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i va = _mm_set1_epi16((short)alpha);
+    const __m128i vinv = _mm_set1_epi16((short)(256 - alpha));
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        __m128i bg = _mm_loadu_si128((const __m128i *)(background + i));
+        __m128i cur = _mm_loadu_si128((const __m128i *)(current + i));
+
+        __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(bg, zero), vinv),
+                                   _mm_mullo_epi16(_mm_unpacklo_epi8(cur, zero), va));
+        __m128i hi = _mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(bg, zero), vinv),
+                                   _mm_mullo_epi16(_mm_unpackhi_epi8(cur, zero), va));
+
+        lo = _mm_srli_epi16(lo, 8);
+        hi = _mm_srli_epi16(hi, 8);
+        _mm_storeu_si128((__m128i *)(background + i), _mm_packus_epi16(lo, hi));
+    }
+
+    if (i < pixels) {
+        scalar_update_background(background + i, current + i, pixels - i, alpha);
+    }
+}
+
+__attribute__((target("sse2")))
+static void sse2_accumulate_motion(const unsigned char *curr, const unsigned char *prev,
+                                   const unsigned char *background, int samples, int threshold,
+                                   int *changed, int *total_diff) {
+    // No 8-bit difference can exceed 255
+    if (threshold >= 255) {
+        return;
+    }
+    if (threshold < -1) {
+        threshold = -1;
+    }
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i even = _mm_set1_epi16(0x00FF);
+    const __m128i ones = _mm_set1_epi8(1);
+    const __m128i min_diff = _mm_set1_epi8((char)(threshold + 1));
+    __m128i count_acc = zero;
+    __m128i diff_acc = zero;
+    int i = 0;
+
+    // Each iteration consumes 8 samples (16 bytes) and never reads past the last sample
+    for (; i + 9 <= samples; i += 8) {
+        __m128i c = _mm_loadu_si128((const __m128i *)(curr + i * 2));
+        __m128i p = _mm_loadu_si128((const __m128i *)(prev + i * 2));
+        __m128i b = _mm_loadu_si128((const __m128i *)(background + i * 2));
+
+        __m128i frame_diff = _mm_or_si128(_mm_subs_epu8(c, p), _mm_subs_epu8(p, c));
+        __m128i bg_diff = _mm_or_si128(_mm_subs_epu8(c, b), _mm_subs_epu8(b, c));
+        __m128i diff = _mm_max_epu8(frame_diff, bg_diff);
+
+        // diff >= threshold + 1, restricted to the sampled (even) bytes
+        __m128i mask = _mm_cmpeq_epi8(_mm_max_epu8(diff, min_diff), diff);
+        mask = _mm_and_si128(mask, even);
+
+        diff_acc = _mm_add_epi64(diff_acc, _mm_sad_epu8(_mm_and_si128(diff, mask), zero));
+        count_acc = _mm_add_epi64(count_acc, _mm_sad_epu8(_mm_and_si128(mask, ones), zero));
+    }
+
+    *changed += _mm_cvtsi128_si32(count_acc) + _mm_cvtsi128_si32(_mm_srli_si128(count_acc, 8));
+    *total_diff += _mm_cvtsi128_si32(diff_acc) + _mm_cvtsi128_si32(_mm_srli_si128(diff_acc, 8));
+
+    if (i < samples) {
+        scalar_accumulate_motion(curr + i * 2, prev + i * 2, background + i * 2,
+                                 samples - i, threshold, changed, total_diff);
+    }
+}
+
+static const motion_kernels_t sse2_kernels = {
+    .name = "sse2",
+    .rgb_to_gray = scalar_rgb_to_gray,  // Deinterleaving RGB needs pshufb (SSSE3+)
+    .downscale_2x = sse2_downscale_2x,
+    .blur_row = sse2_blur_row,
+    .average_rows = sse2_average_rows,
+    .update_background = sse2_update_background,
+    .accumulate_motion = sse2_accumulate_motion,
+};
+
+/* ------------------------------------------------------------------------- */
+/* AVX2 kernels                                                              */
+/* ------------------------------------------------------------------------- */
+
+__attribute__((target("avx2")))
+static void avx2_rgb_to_gray(const unsigned char *rgb, unsigned char *gray, size_t pixels) {
+    // Shuffle masks gathering R, G and B of 16 pixels out of three 16-byte loads
+    const __m128i r0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i r1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+    const __m128i r2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+    const __m128i g0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i g1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+    const __m128i g2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+    const __m128i b0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+    const __m128i b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+    const __m128i b2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+    const __m256i cr = _mm256_set1_epi16(GRAY_R_COEFF);
+    const __m256i cg = _mm256_set1_epi16(GRAY_G_COEFF);
+    const __m256i cb = _mm256_set1_epi16(GRAY_B_COEFF);
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        const unsigned char *p = rgb + i * 3;
+        __m128i v0 = _mm_loadu_si128((const __m128i *)p);
+        __m128i v1 = _mm_loadu_si128((const __m128i *)(p + 16));
+        __m128i v2 = _mm_loadu_si128((const __m128i *)(p + 32));
+
+        __m128i r = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, r0), _mm_shuffle_epi8(v1, r1)),
+                                 _mm_shuffle_epi8(v2, r2));
+        __m128i g = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, g0), _mm_shuffle_epi8(v1, g1)),
+                                 _mm_shuffle_epi8(v2, g2));
+        __m128i b = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(v0, b0), _mm_shuffle_epi8(v1, b1)),
+                                 _mm_shuffle_epi8(v2, b2));
+
+        // 76*255 + 150*255 + 29*255 = 65025 fits in an unsigned 16-bit lane
+        __m256i sum = _mm256_mullo_epi16(_mm256_cvtepu8_epi16(r), cr);
+        sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(g), cg));
+        sum = _mm256_add_epi16(sum, _mm256_mullo_epi16(_mm256_cvtepu8_epi16(b), cb));
+        sum = _mm256_srli_epi16(sum, 8);
+
+        __m128i out = _mm_packus_epi16(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        _mm_storeu_si128((__m128i *)(gray + i), out);
+    }
+
+    if (i < pixels) {
+        scalar_rgb_to_gray(rgb + i * 3, gray + i, pixels - i);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_blur_row(const unsigned char *src, unsigned char *dst, int width, int radius) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i magic = _mm256_set1_epi16((short)div_magic(2 * radius + 1));
+    int x = 0;
+
+    for (; x < radius && x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+
+    for (; x + 32 + radius <= width; x += 32) {
+        __m256i lo = zero;
+        __m256i hi = zero;
+        for (int k = -radius; k <= radius; k++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(src + x + k));
+            lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(v, zero));
+            hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(v, zero));
+        }
+        // unpack and pack both operate per 128-bit lane, so byte order is preserved
+        lo = _mm256_mulhi_epu16(lo, magic);
+        hi = _mm256_mulhi_epu16(hi, magic);
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+
+    for (; x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_average_rows(const unsigned char *src, int stride, int nrows,
+                              unsigned char *dst, int width) {
+    if (nrows == 1) {
+        memcpy(dst, src, width);
+        return;
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i magic = _mm256_set1_epi16((short)div_magic(nrows));
+    int x = 0;
+
+    for (; x + 32 <= width; x += 32) {
+        __m256i lo = zero;
+        __m256i hi = zero;
+        for (int r = 0; r < nrows; r++) {
+            __m256i v = _mm256_loadu_si256((const __m256i *)(src + (size_t)r * stride + x));
+            lo = _mm256_add_epi16(lo, _mm256_unpacklo_epi8(v, zero));
+            hi = _mm256_add_epi16(hi, _mm256_unpackhi_epi8(v, zero));
+        }
+        lo = _mm256_mulhi_epu16(lo, magic);
+        hi = _mm256_mulhi_epu16(hi, magic);
+        _mm256_storeu_si256((__m256i *)(dst + x), _mm256_packus_epi16(lo, hi));
+    }
+
+    if (x < width) {
+        sse2_average_rows(src + x, stride, nrows, dst + x, width - x);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_update_background(unsigned char *background, const unsigned char *current,
+                                   size_t pixels, int alpha) {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i va = _mm256_set1_epi16((short)alpha);
+    const __m256i vinv = _mm256_set1_epi16((short)(256 - alpha));
+    size_t i = 0;
+
+    for (; i + 32 <= pixels; i += 32) {
+        __m256i bg = _mm256_loadu_si256((const __m256i *)(background + i));
+        __m256i cur = _mm256_loadu_si256((const __m256i *)(current + i));
+
+        __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpacklo_epi8(bg, zero), vinv),
+                                      _mm256_mullo_epi16(_mm256_unpacklo_epi8(cur, zero), va));
+        __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_unpackhi_epi8(bg, zero), vinv),
+                                      _mm256_mullo_epi16(_mm256_unpackhi_epi8(cur, zero), va));
+
+        lo = _mm256_srli_epi16(lo, 8);
+        hi = _mm256_srli_epi16(hi, 8);
+        _mm256_storeu_si256((__m256i *)(background + i), _mm256_packus_epi16(lo, hi));
+    }
+
+    if (i < pixels) {
+        sse2_update_background(background + i, current + i, pixels - i, alpha);
+    }
+}
+
+__attribute__((target("avx2")))
+static void avx2_accumulate_motion(const unsigned char *curr, const unsigned char *prev,
+                                   const unsigned char *background, int samples, int threshold,
+                                   int *changed, int *total_diff) {
+    if (threshold >= 255) {
+        return;
+    }
+    if (threshold < -1) {
+        threshold = -1;
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i even = _mm256_set1_epi16(0x00FF);
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i min_diff = _mm256_set1_epi8((char)(threshold + 1));
+    __m256i count_acc = zero;
+    __m256i diff_acc = zero;
+    int i = 0;
+
+    // Each iteration consumes 16 samples (32 bytes) and never reads past the last sample
+    for (; i + 17 <= samples; i += 16) {
+        __m256i c = _mm256_loadu_si256((const __m256i *)(curr + i * 2));
+        __m256i p = _mm256_loadu_si256((const __m256i *)(prev + i * 2));
+        __m256i b = _mm256_loadu_si256((const __m256i *)(background + i * 2));
+
+        __m256i frame_diff = _mm256_or_si256(_mm256_subs_epu8(c, p), _mm256_subs_epu8(p, c));
+        __m256i bg_diff = _mm256_or_si256(_mm256_subs_epu8(c, b), _mm256_subs_epu8(b, c));
+        __m256i diff = _mm256_max_epu8(frame_diff, bg_diff);
+
+        __m256i mask = _mm256_cmpeq_epi8(_mm256_max_epu8(diff, min_diff), diff);
+        mask = _mm256_and_si256(mask, even);
+
+        diff_acc = _mm256_add_epi64(diff_acc, _mm256_sad_epu8(_mm256_and_si256(diff, mask), zero));
+        count_acc = _mm256_add_epi64(count_acc, _mm256_sad_epu8(_mm256_and_si256(mask, ones), zero));
+    }
+
+    __m128i count128 = _mm_add_epi64(_mm256_castsi256_si128(count_acc), _mm256_extracti128_si256(count_acc, 1));
+    __m128i diff128 = _mm_add_epi64(_mm256_castsi256_si128(diff_acc), _mm256_extracti128_si256(diff_acc, 1));
+    *changed += _mm_cvtsi128_si32(count128) + _mm_cvtsi128_si32(_mm_srli_si128(count128, 8));
+    *total_diff += _mm_cvtsi128_si32(diff128) + _mm_cvtsi128_si32(_mm_srli_si128(diff128, 8));
+
+    if (i < samples) {
+        sse2_accumulate_motion(curr + i * 2, prev + i * 2, background + i * 2,
+                               samples - i, threshold, changed, total_diff);
+    }
+}
+
+static const motion_kernels_t avx2_kernels = {
+    .name = "avx2",
+    .rgb_to_gray = avx2_rgb_to_gray,
+    .downscale_2x = sse2_downscale_2x,  // Bound by loads, AVX2 gives no measurable gain
+    .blur_row = avx2_blur_row,
+    .average_rows = avx2_average_rows,
+    .update_background = avx2_update_background,
+    .accumulate_motion = avx2_accumulate_motion,
+};
+#endif /* MOTION_SIMD_X86 */
+
+#ifdef MOTION_SIMD_NEON
+/* ------------------------------------------------------------------------- */
+/* NEON kernels                                                              */
+/* ------------------------------------------------------------------------- */
+
+static inline uint8x8_t neon_div_u16(uint16x8_t sum, uint16_t magic) {
+    uint32x4_t lo = vmull_n_u16(vget_low_u16(sum), magic);
+    uint32x4_t hi = vmull_n_u16(vget_high_u16(sum), magic);
+    uint16x8_t q = vcombine_u16(vshrn_n_u32(lo, 16), vshrn_n_u32(hi, 16));
+    return vmovn_u16(q);
+}
+
+static void neon_rgb_to_gray(const unsigned char *rgb, unsigned char *gray, size_t pixels) {
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16x3_t px = vld3q_u8(rgb + i * 3);
+
+        uint16x8_t lo = vmull_u8(vget_low_u8(px.val[0]), vdup_n_u8(GRAY_R_COEFF));
+        lo = vmlal_u8(lo, vget_low_u8(px.val[1]), vdup_n_u8(GRAY_G_COEFF));
+        lo = vmlal_u8(lo, vget_low_u8(px.val[2]), vdup_n_u8(GRAY_B_COEFF));
+
+        uint16x8_t hi = vmull_u8(vget_high_u8(px.val[0]), vdup_n_u8(GRAY_R_COEFF));
+        hi = vmlal_u8(hi, vget_high_u8(px.val[1]), vdup_n_u8(GRAY_G_COEFF));
+        hi = vmlal_u8(hi, vget_high_u8(px.val[2]), vdup_n_u8(GRAY_B_COEFF));
+
+        vst1q_u8(gray + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+
+    if (i < pixels) {
+        scalar_rgb_to_gray(rgb + i * 3, gray + i, pixels - i);
+    }
+}
+
+static void neon_downscale_2x(const unsigned char *src, int src_width,
+                              unsigned char *dst, int dst_width, int dst_height) {
+    for (int y = 0; y < dst_height; y++) {
+        const unsigned char *row0 = src + (size_t)(y * 2) * src_width;
+        const unsigned char *row1 = row0 + src_width;
+        unsigned char *out = dst + (size_t)y * dst_width;
+        int x = 0;
+
+        for (; x + 8 <= dst_width; x += 8) {
+            uint16x8_t sum = vpaddlq_u8(vld1q_u8(row0 + x * 2));
+            sum = vpadalq_u8(sum, vld1q_u8(row1 + x * 2));
+            vst1_u8(out + x, vshrn_n_u16(sum, 2));
+        }
+
+        for (; x < dst_width; x++) {
+            out[x] = (unsigned char)((row0[x * 2] + row0[x * 2 + 1] +
+                                      row1[x * 2] + row1[x * 2 + 1]) >> 2);
+        }
+    }
+}
+
+static void neon_blur_row(const unsigned char *src, unsigned char *dst, int width, int radius) {
+    const uint16_t magic = div_magic(2 * radius + 1);
+    int x = 0;
+
+    for (; x < radius && x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+
+    for (; x + 16 + radius <= width; x += 16) {
+        uint16x8_t lo = vdupq_n_u16(0);
+        uint16x8_t hi = vdupq_n_u16(0);
+        for (int k = -radius; k <= radius; k++) {
+            uint8x16_t v = vld1q_u8(src + x + k);
+            lo = vaddw_u8(lo, vget_low_u8(v));
+            hi = vaddw_u8(hi, vget_high_u8(v));
+        }
+        vst1q_u8(dst + x, vcombine_u8(neon_div_u16(lo, magic), neon_div_u16(hi, magic)));
+    }
+
+    for (; x < width; x++) {
+        dst[x] = blur_pixel(src, width, radius, x);
+    }
+}
+
+static void neon_average_rows(const unsigned char *src, int stride, int nrows,
+                              unsigned char *dst, int width) {
+    if (nrows == 1) {
+        memcpy(dst, src, width);
+        return;
+    }
+
+    const uint16_t magic = div_magic(nrows);
+    int x = 0;
+
+    for (; x + 16 <= width; x += 16) {
+        uint16x8_t lo = vdupq_n_u16(0);
+        uint16x8_t hi = vdupq_n_u16(0);
+        for (int r = 0; r < nrows; r++) {
+            uint8x16_t v = vld1q_u8(src + (size_t)r * stride + x);
+            lo = vaddw_u8(lo, vget_low_u8(v));
+            hi = vaddw_u8(hi, vget_high_u8(v));
+        }
+        vst1q_u8(dst + x, vcombine_u8(neon_div_u16(lo, magic), neon_div_u16(hi, magic)));
+    }
+
+    if (x < width) {
+        scalar_average_rows(src + x, stride, nrows, dst + x, width - x);
+    }
+}
+
+static void neon_update_background(unsigned char *background, const unsigned char *current,
+                                   size_t pixels, int alpha) {
+    const uint16_t a = (uint16_t)alpha;
+    const uint16_t inv = (uint16_t)(256 - alpha);
+    size_t i = 0;
+
+    for (; i + 16 <= pixels; i += 16) {
+        uint8x16_t bg = vld1q_u8(background + i);
+        uint8x16_t cur = vld1q_u8(current + i);
+
+        uint16x8_t lo = vmulq_n_u16(vmovl_u8(vget_low_u8(bg)), inv);
+        lo = vmlaq_n_u16(lo, vmovl_u8(vget_low_u8(cur)), a);
+        uint16x8_t hi = vmulq_n_u16(vmovl_u8(vget_high_u8(bg)), inv);
+        hi = vmlaq_n_u16(hi, vmovl_u8(vget_high_u8(cur)), a);
+
+        vst1q_u8(background + i, vcombine_u8(vshrn_n_u16(lo, 8), vshrn_n_u16(hi, 8)));
+    }
+
+    if (i < pixels) {
+        scalar_update_background(background + i, current + i, pixels - i, alpha);
+    }
+}
+
+static void neon_accumulate_motion(const unsigned char *curr, const unsigned char *prev,
+                                   const unsigned char *background, int samples, int threshold,
+                                   int *changed, int *total_diff) {
+    if (threshold >= 255) {
+        return;
+    }
+
+    // Even-byte deinterleave gives 16 samples per 32 bytes read
+    const uint8x16_t thr = vdupq_n_u8((uint8_t)(threshold < 0 ? 0 : threshold));
+    const bool all_pass = threshold < 0;
+    uint32x4_t count_acc = vdupq_n_u32(0);
+    uint32x4_t diff_acc = vdupq_n_u32(0);
+    int i = 0;
+
+    for (; i + 17 <= samples; i += 16) {
+        uint8x16_t c = vld2q_u8(curr + i * 2).val[0];
+        uint8x16_t p = vld2q_u8(prev + i * 2).val[0];
+        uint8x16_t b = vld2q_u8(background + i * 2).val[0];
+
+        uint8x16_t diff = vmaxq_u8(vabdq_u8(c, p), vabdq_u8(c, b));
+        uint8x16_t mask = all_pass ? vdupq_n_u8(0xFF) : vcgtq_u8(diff, thr);
+
+        diff_acc = vpadalq_u16(diff_acc, vpaddlq_u8(vandq_u8(diff, mask)));
+        count_acc = vpadalq_u16(count_acc, vpaddlq_u8(vshrq_n_u8(mask, 7)));
+    }
+
+    *changed += (int)(vgetq_lane_u32(count_acc, 0) + vgetq_lane_u32(count_acc, 1) +
+                      vgetq_lane_u32(count_acc, 2) + vgetq_lane_u32(count_acc, 3));
+    *total_diff += (int)(vgetq_lane_u32(diff_acc, 0) + vgetq_lane_u32(diff_acc, 1) +
+                         vgetq_lane_u32(diff_acc, 2) + vgetq_lane_u32(diff_acc, 3));
+
+    if (i < samples) {
+        scalar_accumulate_motion(curr + i * 2, prev + i * 2, background + i * 2,
+                                 samples - i, threshold, changed, total_diff);
+    }
+}
+
+static const motion_kernels_t neon_kernels = {
+    .name = "neon",
+    .rgb_to_gray = neon_rgb_to_gray,
+    .downscale_2x = neon_downscale_2x,
+    .blur_row = neon_blur_row,
+    .average_rows = neon_average_rows,
+    .update_background = neon_update_background,
+    .accumulate_motion = neon_accumulate_motion,
+};
+#endif /* MOTION_SIMD_NEON */
+
+/* ------------------------------------------------------------------------- */
+/* Runtime dispatch                                                          */
+/* ------------------------------------------------------------------------- */
+
+static const motion_kernels_t *selected_kernels = &scalar_kernels;
+static pthread_once_t kernels_once = PTHREAD_ONCE_INIT;
+
+static void select_motion_kernels(void) {
+#ifdef MOTION_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        selected_kernels = &avx2_kernels;
+    } else if (__builtin_cpu_supports("sse2")) {
+        selected_kernels = &sse2_kernels;
+    }
+#elif defined(MOTION_SIMD_NEON)
+    selected_kernels = &neon_kernels;
+#endif
+
+    log_info("Motion detection using %s pixel kernels", selected_kernels->name);
+}
+
+const motion_kernels_t *motion_kernels_get(void) {
+    pthread_once(&kernels_once, select_motion_kernels);
+    return selected_kernels;
+}
+
+const motion_kernels_t *motion_kernels_get_scalar(void) {
+    return &scalar_kernels;
+}
+
+/**
+ * Run the per-frame kernel sequence once on synthetic data
+ */
+static double run_kernel_pass(const motion_kernels_t *k, const unsigned char *rgb,
+                              unsigned char *gray, unsigned char *small, unsigned char *blur,
+                              unsigned char *temp, unsigned char *prev, unsigned char *background,
+                              int width, int height) {
+    struct timespec start, end;
+    int sw = width / 2;
+    int sh = height / 2;
+    int radius = 1;
+    int changed = 0;
+    int total = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    k->rgb_to_gray(rgb, gray, (size_t)width * height);
+    k->downscale_2x(gray, width, small, sw, sh);
+    for (int y = 0; y < sh; y++) {
+        k->blur_row(small + (size_t)y * sw, temp + (size_t)y * sw, sw, radius);
+    }
+    for (int y = 0; y < sh; y++) {
+        int y0 = y - radius < 0 ? 0 : y - radius;
+        int y1 = y + radius >= sh ? sh - 1 : y + radius;
+        k->average_rows(temp + (size_t)y0 * sw, sw, y1 - y0 + 1, blur + (size_t)y * sw, sw);
+    }
+    for (int y = 0; y < sh; y += 2) {
+        k->accumulate_motion(blur + (size_t)y * sw, prev + (size_t)y * sw, background + (size_t)y * sw,
+                             (sw + 1) / 2, 38, &changed, &total);
+    }
+    k->update_background(background, blur, (size_t)sw * sh, 12);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+}
+
+float motion_kernels_benchmark(int width, int height) {
+    const motion_kernels_t *best = motion_kernels_get();
+    if (best == &scalar_kernels || width < 64 || height < 64) {
+        return 1.0f;
+    }
+
+    size_t pixels = (size_t)width * height;
+    size_t small_pixels = (size_t)(width / 2) * (height / 2);
+    unsigned char *rgb = malloc(pixels * 3);
+    unsigned char *gray = malloc(pixels);
+    unsigned char *work = malloc(small_pixels * 5);
+    if (!rgb || !gray || !work) {
+        free(rgb);
+        free(gray);
+        free(work);
+        return 1.0f;
+    }
+
+    unsigned int seed = 12345;
+    for (size_t i = 0; i < pixels * 3; i++) {
+        seed = seed * 1103515245u + 12345u;
+        rgb[i] = (unsigned char)(seed >> 16);
+    }
+    memset(work, 128, small_pixels * 5);
+
+    unsigned char *small = work;
+    unsigned char *blur = work + small_pixels;
+    unsigned char *temp = work + small_pixels * 2;
+    unsigned char *prev = work + small_pixels * 3;
+    unsigned char *background = work + small_pixels * 4;
+
+    // Take the best of a few runs for each kernel set to filter out scheduling noise
+    double scalar_ms = 0.0;
+    double best_ms = 0.0;
+    for (int run = 0; run < 5; run++) {
+        double s = run_kernel_pass(&scalar_kernels, rgb, gray, small, blur, temp, prev, background, width, height);
+        double b = run_kernel_pass(best, rgb, gray, small, blur, temp, prev, background, width, height);
+        if (run == 0 || s < scalar_ms) scalar_ms = s;
+        if (run == 0 || b < best_ms) best_ms = b;
+    }
+
+    free(rgb);
+    free(gray);
+    free(work);
+
+    if (best_ms <= 0.0) {
+        return 1.0f;
+    }
+    return (float)(scalar_ms / best_ms);
+}
@@ -0,0 +1,402 @@
+/**
+ * MP4 Fragment Index Implementation
+ *
+ * Only the top-level box headers are read while walking the file; the moov box
+ * and each moof box are read whole to find the track timescale and the sample
+ * durations of every fragment.
+ */
+
+#define _FILE_OFFSET_BITS 64
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <sys/types.h>
+
+#include "video/mp4_fragment_index.h"
+#include "core/logger.h"
+
+// Largest moov or moof box that is read into memory
+#define MAX_HEADER_BOX_SIZE (4 * 1024 * 1024)
+
+typedef struct {
+    uint32_t track_id;
+    uint32_t timescale;
+    uint32_t default_duration;      // From the trex box of the track
+} track_info_t;
+
+static uint32_t read_u32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t read_u64(const uint8_t *p) {
+    return ((uint64_t)read_u32(p) << 32) | read_u32(p + 4);
+}
+
+/**
+ * Get the next box of a buffer and advance past it
+ *
+ * @return 0 on success, -1 at the end of the buffer or on a malformed box
+ */
+static int next_box(const uint8_t **p, const uint8_t *end, char type[4],
+                    const uint8_t **payload, size_t *payload_size) {
+    size_t left = (size_t)(end - *p);
+    if (left < 8) {
+        return -1;
+    }
+
+    uint64_t size = read_u32(*p);
+    size_t header = 8;
+    if (size == 1) {
+        if (left < 16) {
+            return -1;
+        }
+        size = read_u64(*p + 8);
+        header = 16;
+    } else if (size == 0) {
+        size = left;
+    }
+
+    if (size < header || size > left) {
+        return -1;
+    }
+
+    memcpy(type, *p + 4, 4);
+    *payload = *p + header;
+    *payload_size = (size_t)size - header;
+    *p += size;
+    return 0;
+}
+
+/**
+ * Find the first child box of a type
+ */
+static const uint8_t *find_box(const uint8_t *data, size_t size, const char *wanted, size_t *payload_size) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    const uint8_t *payload;
+    char type[4];
+
+    while (next_box(&p, end, type, &payload, payload_size) == 0) {
+        if (memcmp(type, wanted, 4) == 0) {
+            return payload;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Read the ID, timescale and handler of a trak box
+ */
+static int parse_trak(const uint8_t *data, size_t size, track_info_t *track, bool *is_video) {
+    size_t tkhd_size, mdia_size, mdhd_size, hdlr_size;
+
+    const uint8_t *tkhd = find_box(data, size, "tkhd", &tkhd_size);
+    const uint8_t *mdia = find_box(data, size, "mdia", &mdia_size);
+    if (!tkhd || !mdia || tkhd_size < 4) {
+        return -1;
+    }
+
+    const uint8_t *mdhd = find_box(mdia, mdia_size, "mdhd", &mdhd_size);
+    const uint8_t *hdlr = find_box(mdia, mdia_size, "hdlr", &hdlr_size);
+    if (!mdhd || !hdlr || mdhd_size < 4 || hdlr_size < 12) {
+        return -1;
+    }
+
+    // Version 1 boxes have 64-bit creation and modification times
+    size_t id_offset = tkhd[0] == 1 ? 20 : 12;
+    size_t timescale_offset = mdhd[0] == 1 ? 20 : 12;
+    if (tkhd_size < id_offset + 4 || mdhd_size < timescale_offset + 4) {
+        return -1;
+    }
+
+    track->track_id = read_u32(tkhd + id_offset);
+    track->timescale = read_u32(mdhd + timescale_offset);
+    track->default_duration = 0;
+    *is_video = memcmp(hdlr + 8, "vide", 4) == 0;
+    return track->timescale > 0 ? 0 : -1;
+}
+
+/**
+ * Choose the track that times the fragments from a moov box
+ */
+static int parse_moov(const uint8_t *data, size_t size, track_info_t *track) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    const uint8_t *payload;
+    size_t payload_size;
+    char type[4];
+    bool found = false;
+
+    while (next_box(&p, end, type, &payload, &payload_size) == 0) {
+        if (memcmp(type, "trak", 4) != 0) {
+            continue;
+        }
+
+        track_info_t candidate;
+        bool is_video;
+        if (parse_trak(payload, payload_size, &candidate, &is_video) != 0) {
+            continue;
+        }
+
+        if (!found || is_video) {
+            *track = candidate;
+            found = true;
+            if (is_video) {
+                break;
+            }
+        }
+    }
+
+    if (!found) {
+        return -1;
+    }
+
+    // Default sample duration for fragments that do not carry their own
+    size_t mvex_size;
+    const uint8_t *mvex = find_box(data, size, "mvex", &mvex_size);
+    if (mvex) {
+        p = mvex;
+        end = mvex + mvex_size;
+        while (next_box(&p, end, type, &payload, &payload_size) == 0) {
+            if (memcmp(type, "trex", 4) == 0 && payload_size >= 20 &&
+                read_u32(payload + 4) == track->track_id) {
+                track->default_duration = read_u32(payload + 12);
+                break;
+            }
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Sum the sample durations of the track in a moof box
+ *
+ * @return Duration in timescale units, 0 if the track is not in the fragment
+ */
+static uint64_t parse_moof(const uint8_t *data, size_t size, const track_info_t *track) {
+    const uint8_t *p = data;
+    const uint8_t *end = data + size;
+    const uint8_t *traf;
+    size_t traf_size;
+    char type[4];
+    uint64_t duration = 0;
+
+    while (next_box(&p, end, type, &traf, &traf_size) == 0) {
+        if (memcmp(type, "traf", 4) != 0) {
+            continue;
+        }
+
+        size_t tfhd_size;
+        const uint8_t *tfhd = find_box(traf, traf_size, "tfhd", &tfhd_size);
+        if (!tfhd || tfhd_size < 8 || read_u32(tfhd + 4) != track->track_id) {
+            continue;
+        }
+
+        uint32_t tfhd_flags = read_u32(tfhd) & 0xFFFFFF;
+        uint32_t default_duration = track->default_duration;
+        size_t field = 8;
+        if (tfhd_flags & 0x01) field += 8;     // base-data-offset
+        if (tfhd_flags & 0x02) field += 4;     // sample-description-index
+        if ((tfhd_flags & 0x08) && tfhd_size >= field + 4) {
+            default_duration = read_u32(tfhd + field);
+        }
+
+        const uint8_t *q = traf;
+        const uint8_t *traf_end = traf + traf_size;
+        const uint8_t *trun;
+        size_t trun_size;
+        while (next_box(&q, traf_end, type, &trun, &trun_size) == 0) {
+            if (memcmp(type, "trun", 4) != 0 || trun_size < 8) {
+                continue;
+            }
+
+            uint32_t flags = read_u32(trun) & 0xFFFFFF;
+            uint32_t sample_count = read_u32(trun + 4);
+            size_t offset = 8;
+            if (flags & 0x001) offset += 4;    // data-offset
+            if (flags & 0x004) offset += 4;    // first-sample-flags
+
+            if (!(flags & 0x100)) {
+                duration += (uint64_t)sample_count * default_duration;
+                continue;
+            }
+
+            size_t sample_size = 4;
+            if (flags & 0x200) sample_size += 4;
+            if (flags & 0x400) sample_size += 4;
+            if (flags & 0x800) sample_size += 4;
+
+            for (uint32_t i = 0; i < sample_count && offset + 4 <= trun_size; i++) {
+                duration += read_u32(trun + offset);
+                offset += sample_size;
+            }
+        }
+        break;
+    }
+
+    return duration;
+}
+
+/**
+ * Read a box payload into a buffer
+ */
+static uint8_t *read_payload(FILE *file, off_t offset, uint64_t size) {
+    if (size > MAX_HEADER_BOX_SIZE) {
+        return NULL;
+    }
+
+    uint8_t *data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data) {
+        return NULL;
+    }
+
+    if (fseeko(file, offset, SEEK_SET) != 0 || fread(data, 1, (size_t)size, file) != (size_t)size) {
+        free(data);
+        return NULL;
+    }
+    return data;
+}
+
+/**
+ * Add a fragment to an index
+ */
+static mp4_fragment_t *add_fragment(mp4_fragment_index_t *index, int *capacity, uint64_t offset) {
+    if (index->count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 64;
+        mp4_fragment_t *fragments = realloc(index->fragments, new_capacity * sizeof(mp4_fragment_t));
+        if (!fragments) {
+            return NULL;
+        }
+        index->fragments = fragments;
+        *capacity = new_capacity;
+    }
+
+    mp4_fragment_t *fragment = &index->fragments[index->count++];
+    fragment->offset = offset;
+    fragment->size = 0;
+    fragment->duration = 0;
+    return fragment;
+}
+
+/**
+ * Index the fragments of an MP4 file
+ */
+int mp4_fragment_index_load(const char *path, mp4_fragment_index_t *index) {
+    memset(index, 0, sizeof(*index));
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        log_debug("Failed to open %s to index its fragments", path);
+        return -1;
+    }
+
+    if (fseeko(file, 0, SEEK_END) != 0) {
+        fclose(file);
+        return -1;
+    }
+    uint64_t file_size = (uint64_t)ftello(file);
+
+    track_info_t track;
+    bool have_moov = false;
+    int capacity = 0;
+    int result = 0;
+    uint64_t last_moof_size = 0;
+    uint64_t pos = 0;
+    uint8_t header[16];
+
+    while (pos + 8 <= file_size) {
+        if (fseeko(file, (off_t)pos, SEEK_SET) != 0 || fread(header, 1, 8, file) != 8) {
+            break;
+        }
+
+        uint64_t size = read_u32(header);
+        uint64_t header_size = 8;
+        if (size == 1) {
+            if (fread(header + 8, 1, 8, file) != 8) {
+                break;
+            }
+            size = read_u64(header + 8);
+            header_size = 16;
+        } else if (size == 0) {
+            size = file_size - pos;
+        }
+
+        // A box still being written ends the usable part of the file
+        if (size < header_size || size > file_size - pos) {
+            break;
+        }
+
+        uint64_t payload_size = size - header_size;
+
+        if (memcmp(header + 4, "moov", 4) == 0) {
+            uint8_t *moov = read_payload(file, (off_t)(pos + header_size), payload_size);
+            if (!moov || parse_moov(moov, (size_t)payload_size, &track) != 0) {
+                free(moov);
+                result = -1;
+                break;
+            }
+            free(moov);
+            have_moov = true;
+            index->init_size = pos + size;
+        } else if (memcmp(header + 4, "moof", 4) == 0) {
+            if (!have_moov) {
+                result = -1;
+                break;
+            }
+
+            uint8_t *moof = read_payload(file, (off_t)(pos + header_size), payload_size);
+            if (!moof) {
+                result = -1;
+                break;
+            }
+            uint64_t duration = parse_moof(moof, (size_t)payload_size, &track);
+            free(moof);
+
+            mp4_fragment_t *fragment = add_fragment(index, &capacity, pos);
+            if (!fragment) {
+                result = -1;
+                break;
+            }
+            fragment->size = size;
+            last_moof_size = size;
+            fragment->duration = (double)duration / track.timescale;
+        } else if (index->count > 0 && memcmp(header + 4, "mfra", 4) != 0) {
+            // The mdat (and anything else) after a moof belongs to its fragment
+            mp4_fragment_t *fragment = &index->fragments[index->count - 1];
+            fragment->size = pos + size - fragment->offset;
+        }
+
+        pos += size;
+    }
+
+    fclose(file);
+
+    if (result != 0 || index->count == 0) {
+        mp4_fragment_index_free(index);
+        return -1;
+    }
+
+    // A trailing moof whose mdat is missing cannot be played
+    if (index->fragments[index->count - 1].size == last_moof_size) {
+        index->count--;
+    }
+
+    if (index->count == 0) {
+        mp4_fragment_index_free(index);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * Free the fragments of an index
+ */
+void mp4_fragment_index_free(mp4_fragment_index_t *index) {
+    free(index->fragments);
+    index->fragments = NULL;
+    index->count = 0;
+    index->init_size = 0;
+}
@@ -151,6 +151,8 @@ static void *mp4_recording_thread(void *arg) {
     log_info("Set segment duration to %d seconds for MP4 writer for stream %s",
              segment_duration, stream_name);
 
+    mp4_writer_set_fragmented(ctx->mp4_writer, ctx->config.fragmented_mp4 ? 1 : 0);
+
     // Check if this stream is using go2rtc for recording
     char actual_url[MAX_PATH_LENGTH];
     bool using_go2rtc = false;
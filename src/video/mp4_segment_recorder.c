@@ -31,6 +31,7 @@
 #include "video/mp4_writer.h"
 #include "video/mp4_writer_internal.h"
 #include "video/mp4_segment_recorder.h"
+#include "video/packet_bus.h"
 
 // Note: We can't directly access internal FFmpeg structures
 // So we'll use the public API for cleanup
@@ -86,12 +87,13 @@ void mp4_segment_recorder_init(void) {
  * @param output_file The path to the output MP4 file
  * @param duration The duration to record in seconds
  * @param has_audio Flag indicating whether to include audio in the recording
+ * @param fragmented Flag indicating whether to write fragmented MP4
  * @param input_ctx_ptr Pointer to the input context for this stream (reused between segments)
  * @param segment_info_ptr Pointer to the segment info for this stream
  * @return 0 on success, negative value on error
  */
 int record_segment(const char *rtsp_url, const char *output_file, int duration, int has_audio,
-                   AVFormatContext **input_ctx_ptr, segment_info_t *segment_info_ptr,
+                   int fragmented, AVFormatContext **input_ctx_ptr, segment_info_t *segment_info_ptr,
                    record_segment_started_cb started_cb, void *cb_ctx) {
     int ret = 0;
     AVFormatContext *input_ctx = NULL;
@@ -186,7 +188,7 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         goto cleanup;
     }
 
-    log_debug("Input format: %s", input_ctx->iformat->name);
+    log_debug("Input format: %s", input_ctx->iformat ? input_ctx->iformat->name : "packet bus");
     log_debug("Number of streams: %d", input_ctx->nb_streams);
 
     // Find video and audio streams
@@ -292,10 +294,16 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         out_audio_stream->time_base = input_ctx->streams[audio_stream_idx]->time_base;
     }
 
-    // Use faststart to move moov atom to beginning for better compatibility
-    // This creates standard MP4 files that play in all applications
-    // The + prefix adds to existing flags rather than replacing them
-    av_dict_set(&out_opts, "movflags", "+faststart", 0);
+    if (fragmented) {
+        // Fragmented MP4 is written once, sequentially, and stays playable while
+        // recording; faststart would rewrite the whole file in av_write_trailer
+        av_dict_set(&out_opts, "movflags", MP4_FRAGMENTED_MOVFLAGS, 0);
+    } else {
+        // Use faststart to move moov atom to beginning for better compatibility
+        // This creates standard MP4 files that play in all applications
+        // The + prefix adds to existing flags rather than replacing them
+        av_dict_set(&out_opts, "movflags", "+faststart", 0);
+    }
 
     // CRITICAL FIX: Validate output_file parameter before attempting to open
     if (!output_file || output_file[0] == '\0') {
@@ -483,7 +491,7 @@ int record_segment(const char *rtsp_url, const char *output_file, int duration,
         }
 
         // Read packet
-        ret = av_read_frame(input_ctx, pkt);
+        ret = packet_bus_read_frame(input_ctx, pkt);
         if (ret < 0) {
             if (ret == AVERROR_EOF) {
                 log_info("End of stream reached");
@@ -1172,7 +1180,7 @@ cleanup:
             }
 
             // Close the input context
-            avformat_close_input(&input_ctx);
+            packet_bus_close_input(&input_ctx);
             input_ctx = NULL;  // Ensure the pointer is NULL after closing
         } else {
             log_debug("Input context is NULL, nothing to clean up");
@@ -51,6 +51,22 @@ void mp4_writer_set_audio(mp4_writer_t *writer, int enable) {
             enable ? "Enabled" : "Disabled", writer->stream_name);
 }
 
+/**
+ * Select fragmented MP4 output for the writer's segments
+ *
+ * @param writer The MP4 writer instance
+ * @param enable 1 for fragmented MP4, 0 for faststart MP4
+ */
+void mp4_writer_set_fragmented(mp4_writer_t *writer, int enable) {
+    if (!writer) {
+        return;
+    }
+
+    writer->fragmented = enable ? 1 : 0;
+    log_info("Using %s MP4 recordings for stream %s",
+            enable ? "fragmented" : "faststart", writer->stream_name);
+}
+
 /**
  * Get the current output path for the MP4 writer
  *
@@ -24,6 +24,7 @@
 #include <pthread.h>
 
 #include "database/database_manager.h"
+#include "storage/storage_manager_streams_cache.h"
 #include "core/config.h"
 #include "core/logger.h"
 #include "video/stream_manager.h"
@@ -174,6 +175,7 @@ void mp4_writer_close(mp4_writer_t *writer) {
 
             // Mark the recording as complete with the correct file size and end time
             update_recording_metadata(writer->current_recording_id, end_time, size_bytes, true);
+            stream_storage_cache_add_file(writer->output_path, size_bytes);
             log_info("Marked recording (ID: %llu) as complete during writer close",
                     (unsigned long long)writer->current_recording_id);
         } else if (writer->output_path) {
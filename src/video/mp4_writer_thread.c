@@ -30,8 +30,10 @@
 #include "video/mp4_writer_internal.h"
 #include "video/mp4_writer_thread.h"
 #include "video/mp4_segment_recorder.h"
+#include "video/packet_bus.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "storage/storage_manager_streams_cache.h"
 
 
 // Callback invoked by record_segment when the first keyframe is detected
@@ -148,7 +150,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
 
             // Close the current input context to force a fresh connection
             if (thread_ctx->input_ctx) {
-                avformat_close_input(&thread_ctx->input_ctx);
+                packet_bus_close_input(&thread_ctx->input_ctx);
                 thread_ctx->input_ctx = NULL;
             }
 
@@ -194,6 +196,14 @@ static void *mp4_writer_rtsp_thread(void *arg) {
                         has_audio ? "enabled" : "disabled");
                 thread_ctx->writer->has_audio = has_audio;
             }
+
+            // Update the container, the next segment picks it up
+            int fragmented = db_stream_config.fragmented_mp4 ? 1 : 0;
+            if (thread_ctx->writer->fragmented != fragmented) {
+                log_info("Updating recording container for stream %s to %s MP4 (from database)",
+                        stream_name, fragmented ? "fragmented" : "faststart");
+                thread_ctx->writer->fragmented = fragmented;
+            }
         }
 
         // Check if it's time to create a new segment based on segment duration
@@ -258,6 +268,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
 
                         // Mark the recording as complete with the correct file size and end time
                         update_recording_metadata(thread_ctx->writer->current_recording_id, end_time, size_bytes, true);
+                        stream_storage_cache_add_file(current_path, size_bytes);
                         log_info("Marked previous recording (ID: %llu) as complete for stream %s (size: %llu bytes)",
                                 (unsigned long long)thread_ctx->writer->current_recording_id, stream_name, (unsigned long long)size_bytes);
                     } else {
@@ -339,7 +350,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
 
                     // Close the input context - this will free all associated resources
                     // Let FFmpeg handle its own memory management
-                    avformat_close_input(&thread_ctx->input_ctx);
+                    packet_bus_close_input(&thread_ctx->input_ctx);
                     thread_ctx->input_ctx = NULL;
                 }
 
@@ -361,10 +372,15 @@ static void *mp4_writer_rtsp_thread(void *arg) {
                 thread_ctx->segment_info.segment_index, thread_ctx->segment_info.has_audio,
                 thread_ctx->segment_info.last_frame_was_key);
 
+        // Record from the stream's packet bus while its HLS reader is connected so the
+        // camera is only pulled once, otherwise record_segment opens its own connection
+        packet_bus_select_input(stream_name, &thread_ctx->input_ctx);
+
         // BUGFIX: Pass per-stream input context and segment info to record_segment
         // This prevents stream mixing when multiple streams are recording simultaneously
         ret = record_segment(thread_ctx->rtsp_url, thread_ctx->writer->output_path,
                            segment_duration, thread_ctx->writer->has_audio,
+                           thread_ctx->writer->fragmented,
                            &thread_ctx->input_ctx, &thread_ctx->segment_info,
                            on_segment_started_cb, thread_ctx);
 
@@ -402,7 +418,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
 
                 // BUGFIX: Force input context to be recreated
                 if (thread_ctx->input_ctx) {
-                    avformat_close_input(&thread_ctx->input_ctx);
+                    packet_bus_close_input(&thread_ctx->input_ctx);
                     thread_ctx->input_ctx = NULL;
                     log_info("Forcibly closed input context to ensure fresh connection on next attempt");
                 }
@@ -488,7 +504,7 @@ static void *mp4_writer_rtsp_thread(void *arg) {
         }
 
         // Now safely close the input context
-        avformat_close_input(&ctx_to_close);
+        packet_bus_close_input(&ctx_to_close);
 
         // Log that we've closed the input context to help with debugging
         log_info("Closed input context for stream %s to prevent memory leaks", stream_name);
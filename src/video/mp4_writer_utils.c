@@ -1069,9 +1069,13 @@ skip_audio_stream:
     av_dict_set(&writer->output_ctx->metadata, "title", writer->stream_name, 0);
     av_dict_set(&writer->output_ctx->metadata, "encoder", "LightNVR", 0);
 
-    // Set options for fast start - EXACTLY match rtsp_recorder.c
+    // Fragmented MP4 avoids the faststart rewrite at av_write_trailer
     AVDictionary *opts = NULL;
-    av_dict_set(&opts, "movflags", "+faststart", 0);  // This is the ONLY option in rtsp_recorder.c
+    if (writer->fragmented) {
+        av_dict_set(&opts, "movflags", MP4_FRAGMENTED_MOVFLAGS, 0);
+    } else {
+        av_dict_set(&opts, "movflags", "+faststart", 0);  // This is the ONLY option in rtsp_recorder.c
+    }
 
     // Open output file
     ret = avio_open(&writer->output_ctx->pb, writer->output_path, AVIO_FLAG_WRITE);
@@ -8,20 +8,18 @@
 #include "video/onvif_discovery_network.h"
 #include "video/onvif_discovery_probe.h"
 #include "video/onvif_discovery_response.h"
+#include "video/onvif_discovery_scan.h"
 #include "video/onvif_discovery_thread.h"
 #include <arpa/inet.h>
 #include <curl/curl.h>
 #include <errno.h>
-#include <fcntl.h>
 #include <netinet/in.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/select.h>
 #include <sys/socket.h>
-#include <sys/time.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -104,72 +102,25 @@ int get_discovered_onvif_devices(onvif_device_info_t *devices,
   return count;
 }
 
-// Check if a port is open on a given IP address
-static int is_port_open(const char *ip_addr, int port, int timeout_ms) {
-  int sock;
-  struct sockaddr_in addr;
-  struct timeval tv;
-  fd_set fdset;
-  int res;
-
-  // Create socket
-  sock = socket(AF_INET, SOCK_STREAM, 0);
-  if (sock < 0) {
-    return 0; // Failed to create socket
-  }
-
-  // Set non-blocking
-  long arg = fcntl(sock, F_GETFL, NULL);
-  arg |= O_NONBLOCK;
-  fcntl(sock, F_SETFL, arg);
-
-  // Set up address
-  memset(&addr, 0, sizeof(addr));
-  addr.sin_family = AF_INET;
-  addr.sin_port = htons(port);
+// Add a device to the discovered devices, or refresh it if already known
+static void publish_discovered_device(const onvif_device_info_t *device) {
+  pthread_mutex_lock(&g_discovery_mutex);
 
-  // Convert IP address
-  if (inet_aton(ip_addr, &addr.sin_addr) == 0) {
-    close(sock);
-    return 0; // Invalid IP address
+  int i;
+  for (i = 0; i < g_discovered_device_count; i++) {
+    if (strcmp(g_discovered_devices[i].ip_address, device->ip_address) == 0) {
+      break;
+    }
   }
 
-  // Try to connect
-  res = connect(sock, (struct sockaddr *)&addr, sizeof(addr));
-
-  if (res < 0) {
-    if (errno == EINPROGRESS) {
-      // Connection in progress, wait for result
-      tv.tv_sec = timeout_ms / 1000;
-      tv.tv_usec = (timeout_ms % 1000) * 1000;
-
-      FD_ZERO(&fdset);
-      FD_SET(sock, &fdset);
-
-      // Wait for socket to be writable (connected)
-      res = select(sock + 1, NULL, &fdset, NULL, &tv);
-
-      if (res > 0) {
-        // Socket is writable, check if there was an error
-        int so_error;
-        socklen_t len = sizeof(so_error);
-
-        getsockopt(sock, SOL_SOCKET, SO_ERROR, &so_error, &len);
-
-        if (so_error == 0) {
-          close(sock);
-          return 1; // Port is open
-        }
-      }
-    }
-  } else {
-    // Connected immediately
-    close(sock);
-    return 1; // Port is open
+  if (i < g_discovered_device_count) {
+    memcpy(&g_discovered_devices[i], device, sizeof(onvif_device_info_t));
+  } else if (g_discovered_device_count < MAX_DISCOVERED_DEVICES) {
+    memcpy(&g_discovered_devices[g_discovered_device_count++], device,
+           sizeof(onvif_device_info_t));
   }
 
-  close(sock);
-  return 0; // Port is closed or connection timed out
+  pthread_mutex_unlock(&g_discovery_mutex);
 }
 
 // Discover ONVIF devices on a specific network
@@ -227,6 +178,12 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
   uint32_t network_addr = base_addr & subnet_mask;
   uint32_t broadcast = network_addr | ~subnet_mask;
 
+  // Results of this scan replace those of the previous one and are published
+  // as they are found
+  pthread_mutex_lock(&g_discovery_mutex);
+  g_discovered_device_count = 0;
+  pthread_mutex_unlock(&g_discovery_mutex);
+
   // First scan for open ports on the network
   log_info("Scanning network for open ONVIF ports (3702 and 80)");
 
@@ -235,25 +192,13 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
   char candidate_ips[MAX_CANDIDATE_IPS][16];
   int candidate_count = 0;
 
-  // Scan all IPs in the range
-  for (uint32_t ip = network_addr + 1;
-       ip < broadcast && candidate_count < MAX_CANDIDATE_IPS; ip++) {
-    // Skip addresses too close to network or broadcast addresses
-    if (ip == network_addr + 1 || ip == broadcast - 1) {
-      continue;
-    }
-
-    addr.s_addr = htonl(ip);
-    strcpy(ip_addr, inet_ntoa(addr));
-
-    // Check if port 3702 (ONVIF) or port 80 (HTTP) is open with a reasonable
-    // timeout Increased timeout from 25ms to 200ms for better reliability
-    if (is_port_open(ip_addr, 3702, 200) || is_port_open(ip_addr, 80, 200)) {
-      log_debug("Found potential ONVIF device at %s", ip_addr);
-
-      // Add to candidate list
-      strncpy(candidate_ips[candidate_count], ip_addr, 16);
-      candidate_count++;
+  // Skip addresses too close to network or broadcast addresses
+  if (broadcast - network_addr > 4) {
+    static const int scan_ports[] = {3702, 80};
+    candidate_count = scan_open_ports(network_addr + 2, broadcast - 2, scan_ports, 2,
+                                      candidate_ips, MAX_CANDIDATE_IPS);
+    if (candidate_count < 0) {
+      candidate_count = 0;
     }
   }
 
@@ -398,16 +343,10 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
   }
 
   // Store the discovered devices for later retrieval
-  pthread_mutex_lock(&g_discovery_mutex);
-  g_discovered_device_count = 0;
-
-  for (int i = 0; i < count && i < MAX_DISCOVERED_DEVICES; i++) {
-    memcpy(&g_discovered_devices[i], &devices[i], sizeof(onvif_device_info_t));
-    g_discovered_device_count++;
+  for (int i = 0; i < count; i++) {
+    publish_discovered_device(&devices[i]);
   }
 
-  pthread_mutex_unlock(&g_discovery_mutex);
-
   // If we didn't find any devices with WS-Discovery, try direct HTTP probing
   if (count == 0 && candidate_count > 0) {
     log_info("No devices found with WS-Discovery, trying direct HTTP probing");
@@ -421,120 +360,211 @@ int discover_onvif_devices(const char *network, onvif_device_info_t *devices,
   return count < 0 ? 0 : count;
 }
 
+// Maximum number of candidate IPs probed over HTTP at once
+#define MAX_CONCURRENT_HTTP_PROBES 32
+
+// SOAP request for GetSystemDateAndTime (simple request that doesn't require
+// authentication)
+static const char *onvif_probe_request =
+    "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+    "<s:Envelope xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\">"
+    "  <s:Body xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
+    "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\">"
+    "    <GetSystemDateAndTime "
+    "xmlns=\"http://www.onvif.org/ver10/device/wsdl\"/>"
+    "  </s:Body>"
+    "</s:Envelope>";
+
+// Common ONVIF device service paths to try
+static const char *onvif_probe_paths[] = {"/onvif/device_service",
+                                          "/onvif/services",
+                                          "/onvif/service",
+                                          "/onvif/devices",
+                                          "/onvif/device",
+                                          "/device_service",
+                                          "/services",
+                                          "/service",
+                                          NULL};
+
+// An HTTP probe of one candidate IP, trying its paths one after another
+typedef struct {
+  CURL *curl;
+  int candidate; // Index of the candidate IP
+  int path;      // Index of the path being tried
+  char url[128];
+} http_probe_t;
+
 // Forward declaration of the callback function
 static size_t onvif_curl_write_callback(void *contents, size_t size,
                                         size_t nmemb, void *userp);
 
+// Start probing a path of a candidate IP
+static int start_http_probe(CURLM *multi, http_probe_t *probe,
+                            char candidate_ips[][16], int candidate, int path) {
+  probe->candidate = candidate;
+  probe->path = path;
+  snprintf(probe->url, sizeof(probe->url), "http://%s%s",
+           candidate_ips[candidate], onvif_probe_paths[path]);
+
+  log_debug("Trying URL: %s", probe->url);
+  curl_easy_setopt(probe->curl, CURLOPT_URL, probe->url);
+
+  if (curl_multi_add_handle(multi, probe->curl) != CURLM_OK) {
+    log_error("Failed to start HTTP probe of %s", probe->url);
+    return -1;
+  }
+  return 0;
+}
+
 // Try direct HTTP probing for ONVIF devices
 int try_direct_http_discovery(char candidate_ips[][16], int candidate_count,
                               onvif_device_info_t *devices, int max_devices) {
   int count = 0;
-  CURL *curl;
-  CURLcode res;
+  http_probe_t probes[MAX_CONCURRENT_HTTP_PROBES];
+  int probe_count = 0;
+  int running = 0;
+  int next_candidate = 0;
+
+  if (candidate_count <= 0 || max_devices <= 0) {
+    return 0;
+  }
 
   // Initialize CURL
   curl_global_init(CURL_GLOBAL_DEFAULT);
-  curl = curl_easy_init();
-  if (!curl) {
+  CURLM *multi = curl_multi_init();
+  if (!multi) {
     log_error("Failed to initialize CURL for direct HTTP discovery");
+    curl_global_cleanup();
     return 0;
   }
 
-  // SOAP request for GetSystemDateAndTime (simple request that doesn't require
-  // authentication)
-  const char *soap_request =
-      "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
-      "<s:Envelope xmlns:s=\"http://www.w3.org/2003/05/soap-envelope\">"
-      "  <s:Body xmlns:xsi=\"http://www.w3.org/2001/XMLSchema-instance\" "
-      "xmlns:xsd=\"http://www.w3.org/2001/XMLSchema\">"
-      "    <GetSystemDateAndTime "
-      "xmlns=\"http://www.onvif.org/ver10/device/wsdl\"/>"
-      "  </s:Body>"
-      "</s:Envelope>";
-
-  // Common ONVIF device service paths to try
-  const char *onvif_paths[] = {"/onvif/device_service",
-                               "/onvif/services",
-                               "/onvif/service",
-                               "/onvif/devices",
-                               "/onvif/device",
-                               "/device_service",
-                               "/services",
-                               "/service",
-                               NULL};
-
-  // Set up CURL options
-  curl_easy_setopt(curl, CURLOPT_TIMEOUT, 2L); // Short timeout
-  curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 1L);
-  curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
-  curl_easy_setopt(curl, CURLOPT_POST, 1L);
-  curl_easy_setopt(curl, CURLOPT_POSTFIELDS, soap_request);
-  curl_easy_setopt(curl, CURLOPT_NOBODY, 0L);
-
   // Set HTTP headers
   struct curl_slist *headers = NULL;
   headers = curl_slist_append(
       headers, "Content-Type: application/soap+xml; charset=utf-8");
-  curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-  // Disable verbose output and don't write response to stdout
-  curl_easy_setopt(curl, CURLOPT_VERBOSE, 0L);
-  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onvif_curl_write_callback);
 
   log_info("Starting direct HTTP probing for %d candidate IPs",
            candidate_count);
 
-  // Try each candidate IP
-  for (int i = 0; i < candidate_count && count < max_devices; i++) {
-    const char *ip = candidate_ips[i];
-    log_info("Probing IP %s for ONVIF services", ip);
+  // Probe several candidates at once; each handle tries the paths of its
+  // candidate in turn and then moves on to the next unprobed candidate
+  for (int i = 0; i < MAX_CONCURRENT_HTTP_PROBES && i < candidate_count; i++) {
+    http_probe_t *probe = &probes[probe_count];
+    probe->curl = curl_easy_init();
+    if (!probe->curl) {
+      log_error("Failed to initialize CURL handle for direct HTTP discovery");
+      break;
+    }
+    probe_count++;
+
+    // Set up CURL options
+    curl_easy_setopt(probe->curl, CURLOPT_TIMEOUT, 2L); // Short timeout
+    curl_easy_setopt(probe->curl, CURLOPT_CONNECTTIMEOUT, 1L);
+    curl_easy_setopt(probe->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(probe->curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(probe->curl, CURLOPT_POSTFIELDS, onvif_probe_request);
+    curl_easy_setopt(probe->curl, CURLOPT_HTTPHEADER, headers);
+    curl_easy_setopt(probe->curl, CURLOPT_VERBOSE, 0L);
+    curl_easy_setopt(probe->curl, CURLOPT_WRITEFUNCTION,
+                     onvif_curl_write_callback);
+    curl_easy_setopt(probe->curl, CURLOPT_PRIVATE, probe);
+
+    log_info("Probing IP %s for ONVIF services", candidate_ips[next_candidate]);
+    if (start_http_probe(multi, probe, candidate_ips, next_candidate++, 0) == 0) {
+      running++;
+    }
+  }
 
-    // Try each ONVIF path
-    for (int j = 0; onvif_paths[j] != NULL && count < max_devices; j++) {
-      char url[128];
-      snprintf(url, sizeof(url), "http://%s%s", ip, onvif_paths[j]);
+  while (running > 0) {
+    int still_running = 0;
+    if (curl_multi_perform(multi, &still_running) != CURLM_OK) {
+      log_error("Direct HTTP probing failed");
+      break;
+    }
 
-      log_debug("Trying URL: %s", url);
-      curl_easy_setopt(curl, CURLOPT_URL, url);
+    CURLMsg *msg;
+    int queued;
+    while ((msg = curl_multi_info_read(multi, &queued)) != NULL) {
+      if (msg->msg != CURLMSG_DONE) {
+        continue;
+      }
 
-      // Perform the request
-      res = curl_easy_perform(curl);
+      http_probe_t *probe = NULL;
+      curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&probe);
+      CURLcode res = msg->data.result;
+      curl_multi_remove_handle(multi, msg->easy_handle);
+      running--;
 
       // Check if successful
+      long http_code = 0;
       if (res == CURLE_OK) {
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-
-        if (http_code >= 200 && http_code < 300) {
-          log_info("Found ONVIF device at %s", url);
-
-          // Initialize device info
-          memset(&devices[count], 0, sizeof(onvif_device_info_t));
-
-          // Set device info
-          strncpy(devices[count].ip_address, ip,
-                  sizeof(devices[count].ip_address) - 1);
-          strncpy(devices[count].device_service, url,
-                  sizeof(devices[count].device_service) - 1);
-          strncpy(devices[count].endpoint, url,
-                  sizeof(devices[count].endpoint) - 1);
-          strncpy(devices[count].model, "Unknown (HTTP discovery)",
-                  sizeof(devices[count].model) - 1);
-
-          // Set discovery time and online status
-          devices[count].discovery_time = time(NULL);
-          devices[count].online = true;
-
-          count++;
-          break; // Found a working path for this IP, move to next IP
+        curl_easy_getinfo(probe->curl, CURLINFO_RESPONSE_CODE, &http_code);
+      }
+      bool found = http_code >= 200 && http_code < 300;
+
+      if (found && count < max_devices) {
+        const char *ip = candidate_ips[probe->candidate];
+        log_info("Found ONVIF device at %s", probe->url);
+
+        // Initialize device info
+        memset(&devices[count], 0, sizeof(onvif_device_info_t));
+
+        // Set device info
+        strncpy(devices[count].ip_address, ip,
+                sizeof(devices[count].ip_address) - 1);
+        strncpy(devices[count].device_service, probe->url,
+                sizeof(devices[count].device_service) - 1);
+        strncpy(devices[count].endpoint, probe->url,
+                sizeof(devices[count].endpoint) - 1);
+        strncpy(devices[count].model, "Unknown (HTTP discovery)",
+                sizeof(devices[count].model) - 1);
+
+        // Set discovery time and online status
+        devices[count].discovery_time = time(NULL);
+        devices[count].online = true;
+
+        // Make the device visible to get_discovered_onvif_devices right away
+        publish_discovered_device(&devices[count]);
+        count++;
+      }
+
+      if (count >= max_devices) {
+        continue;
+      }
+
+      // Try the next path, or move on to the next candidate
+      int candidate = probe->candidate;
+      int path = probe->path + 1;
+      if (found || onvif_probe_paths[path] == NULL) {
+        if (next_candidate >= candidate_count) {
+          continue;
         }
+        candidate = next_candidate++;
+        path = 0;
+        log_info("Probing IP %s for ONVIF services", candidate_ips[candidate]);
       }
+
+      if (start_http_probe(multi, probe, candidate_ips, candidate, path) == 0) {
+        running++;
+      }
+    }
+
+    if (count >= max_devices) {
+      break;
+    }
+
+    if (running > 0) {
+      curl_multi_wait(multi, NULL, 0, 1000, NULL);
     }
   }
 
   // Clean up
+  for (int i = 0; i < probe_count; i++) {
+    curl_multi_remove_handle(multi, probes[i].curl);
+    curl_easy_cleanup(probes[i].curl);
+  }
+  curl_multi_cleanup(multi);
   curl_slist_free_all(headers);
-  curl_easy_cleanup(curl);
   curl_global_cleanup();
 
   log_info("Direct HTTP probing completed, found %d devices", count);
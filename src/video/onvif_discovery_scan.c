@@ -0,0 +1,239 @@
+#define _GNU_SOURCE
+
+#include "video/onvif_discovery_scan.h"
+#include "core/logger.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+// Maximum number of events handled per wait
+#define MAX_SCAN_EVENTS 64
+
+// A connection attempt in flight
+typedef struct {
+    int fd;             // -1 when the slot is free
+    uint32_t ip;
+    int64_t deadline;   // Monotonic time in ms after which the attempt is abandoned
+} scan_slot_t;
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int compare_ips(const void *a, const void *b) {
+    uint32_t ip_a = *(const uint32_t *)a;
+    uint32_t ip_b = *(const uint32_t *)b;
+    return ip_a < ip_b ? -1 : ip_a > ip_b;
+}
+
+static bool is_host_found(const uint32_t *found, int found_count, uint32_t ip) {
+    for (int i = 0; i < found_count; i++) {
+        if (found[i] == ip) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Start a non-blocking connection attempt
+ *
+ * @return 1 if connected at once, 0 if in progress, -1 if it failed
+ */
+static int start_connect(int epoll_fd, scan_slot_t *slot, uint32_t slot_index,
+                         uint32_t ip, int port, int64_t deadline) {
+    int sock = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        log_debug("Failed to create scan socket: %s", strerror(errno));
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(ip);
+
+    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) == 0) {
+        close(sock);
+        return 1;
+    }
+
+    if (errno != EINPROGRESS) {
+        close(sock);
+        return -1;
+    }
+
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLOUT;
+    event.data.u32 = slot_index;
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event) != 0) {
+        log_debug("Failed to watch scan socket: %s", strerror(errno));
+        close(sock);
+        return -1;
+    }
+
+    slot->fd = sock;
+    slot->ip = ip;
+    slot->deadline = deadline;
+    return 0;
+}
+
+// Scan a range of addresses for hosts with any of the given TCP ports open
+int scan_open_ports(uint32_t first_ip, uint32_t last_ip, const int *ports, int port_count,
+                    char candidate_ips[][16], int max_candidates) {
+    if (!ports || port_count <= 0 || !candidate_ips || max_candidates <= 0 || last_ip < first_ip) {
+        log_error("Invalid parameters for scan_open_ports");
+        return -1;
+    }
+
+    uint32_t *found = malloc(max_candidates * sizeof(uint32_t));
+    if (!found) {
+        log_error("Failed to allocate memory for scan results");
+        return -1;
+    }
+
+    int epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd < 0) {
+        log_error("Failed to create epoll instance for network scan: %s", strerror(errno));
+        free(found);
+        return -1;
+    }
+
+    scan_slot_t slots[ONVIF_SCAN_MAX_CONCURRENT];
+    uint32_t free_slots[ONVIF_SCAN_MAX_CONCURRENT];
+    int free_count = ONVIF_SCAN_MAX_CONCURRENT;
+    for (int i = 0; i < ONVIF_SCAN_MAX_CONCURRENT; i++) {
+        slots[i].fd = -1;
+        free_slots[i] = ONVIF_SCAN_MAX_CONCURRENT - 1 - i;
+    }
+
+    // Attempts are ordered host by host, trying every port of a host together
+    uint64_t total = ((uint64_t)last_ip - first_ip + 1) * (uint64_t)port_count;
+    uint64_t next = 0;
+    int active = 0;
+    int found_count = 0;
+
+    // Token bucket limiting how fast attempts are started
+    double tokens = ONVIF_SCAN_MAX_CONCURRENT;
+    int64_t last_refill = now_ms();
+
+    while ((next < total || active > 0) && found_count < max_candidates) {
+        int64_t now = now_ms();
+        tokens += (double)(now - last_refill) * ONVIF_SCAN_RATE_PER_SECOND / 1000.0;
+        if (tokens > ONVIF_SCAN_MAX_CONCURRENT) {
+            tokens = ONVIF_SCAN_MAX_CONCURRENT;
+        }
+        last_refill = now;
+
+        while (next < total && free_count > 0 && tokens >= 1.0) {
+            uint32_t ip = first_ip + (uint32_t)(next / port_count);
+            int port = ports[next % port_count];
+            next++;
+
+            if (is_host_found(found, found_count, ip)) {
+                continue;
+            }
+
+            tokens -= 1.0;
+            uint32_t slot_index = free_slots[--free_count];
+            int result = start_connect(epoll_fd, &slots[slot_index], slot_index, ip, port,
+                                       now + ONVIF_SCAN_CONNECT_TIMEOUT_MS);
+            if (result == 0) {
+                active++;
+                continue;
+            }
+
+            free_slots[free_count++] = slot_index;
+            if (result > 0 && found_count < max_candidates) {
+                found[found_count++] = ip;
+            }
+        }
+
+        if (found_count >= max_candidates) {
+            break;
+        }
+
+        // Wake for the earliest deadline, or as soon as another attempt may start
+        int timeout = ONVIF_SCAN_CONNECT_TIMEOUT_MS;
+        if (next < total && free_count > 0) {
+            timeout = 1 + (int)((1.0 - tokens) * 1000.0 / ONVIF_SCAN_RATE_PER_SECOND);
+        }
+        for (int i = 0; i < ONVIF_SCAN_MAX_CONCURRENT; i++) {
+            if (slots[i].fd >= 0 && slots[i].deadline - now < timeout) {
+                timeout = slots[i].deadline > now ? (int)(slots[i].deadline - now) : 0;
+            }
+        }
+
+        struct epoll_event events[MAX_SCAN_EVENTS];
+        int event_count = epoll_wait(epoll_fd, events, MAX_SCAN_EVENTS, timeout);
+        if (event_count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            log_error("Failed to wait for scan connections: %s", strerror(errno));
+            break;
+        }
+
+        for (int i = 0; i < event_count; i++) {
+            uint32_t slot_index = events[i].data.u32;
+            scan_slot_t *slot = &slots[slot_index];
+            if (slot->fd < 0) {
+                continue;
+            }
+
+            int so_error = 0;
+            socklen_t len = sizeof(so_error);
+            if (getsockopt(slot->fd, SOL_SOCKET, SO_ERROR, &so_error, &len) == 0 && so_error == 0 &&
+                !(events[i].events & EPOLLERR) && found_count < max_candidates &&
+                !is_host_found(found, found_count, slot->ip)) {
+                found[found_count++] = slot->ip;
+            }
+
+            close(slot->fd);
+            slot->fd = -1;
+            free_slots[free_count++] = slot_index;
+            active--;
+        }
+
+        // Abandon attempts that ran out of time
+        now = now_ms();
+        for (int i = 0; i < ONVIF_SCAN_MAX_CONCURRENT; i++) {
+            if (slots[i].fd >= 0 && slots[i].deadline <= now) {
+                close(slots[i].fd);
+                slots[i].fd = -1;
+                free_slots[free_count++] = (uint32_t)i;
+                active--;
+            }
+        }
+    }
+
+    for (int i = 0; i < ONVIF_SCAN_MAX_CONCURRENT; i++) {
+        if (slots[i].fd >= 0) {
+            close(slots[i].fd);
+        }
+    }
+    close(epoll_fd);
+
+    qsort(found, found_count, sizeof(uint32_t), compare_ips);
+    for (int i = 0; i < found_count; i++) {
+        struct in_addr addr;
+        addr.s_addr = htonl(found[i]);
+        inet_ntop(AF_INET, &addr, candidate_ips[i], 16);
+        log_debug("Found potential ONVIF device at %s", candidate_ips[i]);
+    }
+
+    free(found);
+    return found_count;
+}
@@ -0,0 +1,631 @@
+/**
+ * Per-stream packet bus
+ *
+ * A bus records the stream layout of its source and a list of subscribers, each
+ * with a ring of cloned packets. Publishing clones the packet once per
+ * subscriber (av_packet_clone only takes a new reference on the payload) while
+ * holding the bus mutex, and signals the subscriber. Subscribers wait on their
+ * own condition variable, also under the bus mutex.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+
+#include "core/config.h"
+#include "core/logger.h"
+#include "video/packet_bus.h"
+
+// Identifies the opaque pointer of bus input contexts
+#define PACKET_BUS_INPUT_MAGIC 0x50425553u
+
+// Log a subscriber's drops once per this many packets
+#define PACKET_BUS_DROP_LOG_INTERVAL 500
+
+struct packet_bus_subscriber {
+    uint32_t magic;
+    packet_bus_t *bus;
+    packet_bus_drop_policy_t policy;
+    pthread_cond_t cond;
+
+    AVPacket **queue;           // Ring of max_packets cloned packets
+    int max_packets;
+    int head;
+    int count;
+
+    bool wait_keyframe;         // Skip packets until the next video keyframe
+    bool ended;                 // Source detached or replaced
+    uint64_t dropped;
+
+    AVFormatContext *input;     // Input context when opened with packet_bus_open_input
+};
+
+struct packet_bus {
+    bool in_use;
+    char stream_name[MAX_STREAM_NAME];
+    pthread_mutex_t mutex;
+
+    // Source stream layout, valid while active
+    bool active;
+    int nb_streams;
+    int video_index;
+    AVCodecParameters *codecpar[PACKET_BUS_MAX_SOURCE_STREAMS];
+    AVRational time_base[PACKET_BUS_MAX_SOURCE_STREAMS];
+    AVRational avg_frame_rate[PACKET_BUS_MAX_SOURCE_STREAMS];
+    AVRational r_frame_rate[PACKET_BUS_MAX_SOURCE_STREAMS];
+
+    packet_bus_subscriber_t *subscribers[PACKET_BUS_MAX_SUBSCRIBERS];
+    int num_subscribers;
+
+    uint64_t packets_published;
+    uint64_t packets_dropped;
+};
+
+static packet_bus_t buses[MAX_STREAMS];
+static pthread_mutex_t buses_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Find the bus of a stream without creating it
+ */
+static packet_bus_t *find_bus(const char *stream_name) {
+    packet_bus_t *bus = NULL;
+
+    pthread_mutex_lock(&buses_mutex);
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (buses[i].in_use && strcmp(buses[i].stream_name, stream_name) == 0) {
+            bus = &buses[i];
+            break;
+        }
+    }
+    pthread_mutex_unlock(&buses_mutex);
+
+    return bus;
+}
+
+/**
+ * Free the queued packets of a subscriber. Called with the bus mutex held.
+ */
+static void clear_queue(packet_bus_subscriber_t *sub) {
+    while (sub->count > 0) {
+        av_packet_free(&sub->queue[sub->head]);
+        sub->head = (sub->head + 1) % sub->max_packets;
+        sub->count--;
+    }
+    sub->head = 0;
+}
+
+/**
+ * End all subscribers and forget the source layout. Called with the bus mutex held.
+ */
+static void end_source(packet_bus_t *bus) {
+    for (int i = 0; i < bus->num_subscribers; i++) {
+        bus->subscribers[i]->ended = true;
+        pthread_cond_broadcast(&bus->subscribers[i]->cond);
+    }
+
+    for (int i = 0; i < bus->nb_streams; i++) {
+        avcodec_parameters_free(&bus->codecpar[i]);
+    }
+    bus->nb_streams = 0;
+    bus->video_index = -1;
+    bus->active = false;
+}
+
+/**
+ * Get the bus of a stream, creating it if needed
+ */
+packet_bus_t *packet_bus_get(const char *stream_name) {
+    if (!stream_name || stream_name[0] == '\0') {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&buses_mutex);
+
+    packet_bus_t *bus = NULL;
+    packet_bus_t *free_slot = NULL;
+    for (int i = 0; i < MAX_STREAMS; i++) {
+        if (buses[i].in_use) {
+            if (strcmp(buses[i].stream_name, stream_name) == 0) {
+                bus = &buses[i];
+                break;
+            }
+        } else if (!free_slot) {
+            free_slot = &buses[i];
+        }
+    }
+
+    if (!bus && free_slot) {
+        bus = free_slot;
+        memset(bus, 0, sizeof(*bus));
+        pthread_mutex_init(&bus->mutex, NULL);
+        strncpy(bus->stream_name, stream_name, MAX_STREAM_NAME - 1);
+        bus->video_index = -1;
+        bus->in_use = true;
+    }
+
+    pthread_mutex_unlock(&buses_mutex);
+
+    if (!bus) {
+        log_error("No free packet bus slot for stream %s", stream_name);
+    }
+    return bus;
+}
+
+/**
+ * Attach a source to a bus
+ */
+int packet_bus_attach_source(packet_bus_t *bus, const AVFormatContext *input_ctx) {
+    if (!bus || !input_ctx) {
+        return -1;
+    }
+
+    if (input_ctx->nb_streams == 0 || input_ctx->nb_streams > PACKET_BUS_MAX_SOURCE_STREAMS) {
+        log_warn("Not publishing %s on its packet bus: unsupported number of streams (%u)",
+                 bus->stream_name, input_ctx->nb_streams);
+        return -1;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+
+    if (bus->active) {
+        end_source(bus);
+    }
+
+    for (unsigned int i = 0; i < input_ctx->nb_streams; i++) {
+        const AVStream *st = input_ctx->streams[i];
+
+        bus->codecpar[i] = avcodec_parameters_alloc();
+        if (!bus->codecpar[i] || avcodec_parameters_copy(bus->codecpar[i], st->codecpar) < 0) {
+            bus->nb_streams = (int)i + 1;
+            end_source(bus);
+            pthread_mutex_unlock(&bus->mutex);
+            log_error("Failed to copy stream parameters for packet bus of %s", bus->stream_name);
+            return -1;
+        }
+        bus->time_base[i] = st->time_base;
+        bus->avg_frame_rate[i] = st->avg_frame_rate;
+        bus->r_frame_rate[i] = st->r_frame_rate;
+
+        if (bus->video_index < 0 && st->codecpar->codec_type == AVMEDIA_TYPE_VIDEO) {
+            bus->video_index = (int)i;
+        }
+    }
+    bus->nb_streams = (int)input_ctx->nb_streams;
+    bus->active = true;
+
+    pthread_mutex_unlock(&bus->mutex);
+
+    log_info("Packet bus for %s attached to source (%d streams)", bus->stream_name, bus->nb_streams);
+    return 0;
+}
+
+/**
+ * Publish a packet to all subscribers
+ */
+void packet_bus_publish(packet_bus_t *bus, const AVPacket *pkt) {
+    if (!bus || !pkt) {
+        return;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+
+    if (!bus->active || pkt->stream_index < 0 || pkt->stream_index >= bus->nb_streams) {
+        pthread_mutex_unlock(&bus->mutex);
+        return;
+    }
+    bus->packets_published++;
+
+    // Without a video stream every packet is a valid starting point
+    bool is_keyframe = bus->video_index < 0 ||
+                       (pkt->stream_index == bus->video_index && (pkt->flags & AV_PKT_FLAG_KEY));
+
+    for (int i = 0; i < bus->num_subscribers; i++) {
+        packet_bus_subscriber_t *sub = bus->subscribers[i];
+        if (sub->ended) {
+            continue;
+        }
+
+        if (sub->wait_keyframe) {
+            if (!is_keyframe) {
+                continue;
+            }
+            sub->wait_keyframe = false;
+        }
+
+        if (sub->count == sub->max_packets) {
+            uint64_t before = sub->dropped;
+            if (sub->policy == PACKET_BUS_DROP_TO_KEYFRAME) {
+                sub->dropped += (uint64_t)sub->count;
+                clear_queue(sub);
+                if (!is_keyframe) {
+                    sub->dropped++;
+                    sub->wait_keyframe = true;
+                }
+            } else {
+                av_packet_free(&sub->queue[sub->head]);
+                sub->head = (sub->head + 1) % sub->max_packets;
+                sub->count--;
+                sub->dropped++;
+            }
+            bus->packets_dropped += sub->dropped - before;
+
+            if (before / PACKET_BUS_DROP_LOG_INTERVAL != sub->dropped / PACKET_BUS_DROP_LOG_INTERVAL ||
+                before == 0) {
+                log_warn("Packet bus subscriber of %s is falling behind (%llu packets dropped)",
+                         bus->stream_name, (unsigned long long)sub->dropped);
+            }
+            if (sub->wait_keyframe) {
+                continue;
+            }
+        }
+
+        AVPacket *copy = av_packet_clone(pkt);
+        if (!copy) {
+            sub->dropped++;
+            bus->packets_dropped++;
+            continue;
+        }
+        sub->queue[(sub->head + sub->count) % sub->max_packets] = copy;
+        sub->count++;
+        pthread_cond_signal(&sub->cond);
+    }
+
+    pthread_mutex_unlock(&bus->mutex);
+}
+
+/**
+ * Detach the source of a bus
+ */
+void packet_bus_detach_source(packet_bus_t *bus) {
+    if (!bus) {
+        return;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    bool was_active = bus->active;
+    if (was_active) {
+        end_source(bus);
+    }
+    pthread_mutex_unlock(&bus->mutex);
+
+    if (was_active) {
+        log_info("Packet bus for %s detached from source", bus->stream_name);
+    }
+}
+
+/**
+ * Check whether a stream's bus has a source attached
+ */
+bool packet_bus_has_source(const char *stream_name) {
+    if (!stream_name) {
+        return false;
+    }
+
+    packet_bus_t *bus = find_bus(stream_name);
+    if (!bus) {
+        return false;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    bool active = bus->active;
+    pthread_mutex_unlock(&bus->mutex);
+
+    return active;
+}
+
+/**
+ * Create a subscriber and add it to an active bus. Called with the bus mutex held.
+ */
+static packet_bus_subscriber_t *subscribe_locked(packet_bus_t *bus, int max_packets,
+                                                 packet_bus_drop_policy_t policy) {
+    if (!bus->active || bus->num_subscribers >= PACKET_BUS_MAX_SUBSCRIBERS) {
+        return NULL;
+    }
+
+    packet_bus_subscriber_t *sub = calloc(1, sizeof(*sub));
+    if (!sub) {
+        return NULL;
+    }
+
+    sub->queue = calloc((size_t)max_packets, sizeof(AVPacket *));
+    if (!sub->queue) {
+        free(sub);
+        return NULL;
+    }
+
+    sub->magic = PACKET_BUS_INPUT_MAGIC;
+    sub->bus = bus;
+    sub->policy = policy;
+    sub->max_packets = max_packets;
+    sub->wait_keyframe = true;
+    pthread_cond_init(&sub->cond, NULL);
+
+    bus->subscribers[bus->num_subscribers++] = sub;
+    return sub;
+}
+
+/**
+ * Subscribe to a stream's bus
+ */
+packet_bus_subscriber_t *packet_bus_subscribe(const char *stream_name, int max_packets,
+                                              packet_bus_drop_policy_t policy) {
+    if (!stream_name || max_packets <= 0) {
+        return NULL;
+    }
+
+    packet_bus_t *bus = find_bus(stream_name);
+    if (!bus) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    packet_bus_subscriber_t *sub = subscribe_locked(bus, max_packets, policy);
+    int num_subscribers = bus->num_subscribers;
+    pthread_mutex_unlock(&bus->mutex);
+
+    if (sub) {
+        log_info("New packet bus subscriber for %s (%d subscribers)", stream_name, num_subscribers);
+    }
+    return sub;
+}
+
+/**
+ * Receive the next packet of a subscription
+ */
+int packet_bus_receive(packet_bus_subscriber_t *sub, AVPacket *pkt, int timeout_ms) {
+    if (!sub || !pkt) {
+        return AVERROR(EINVAL);
+    }
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    packet_bus_t *bus = sub->bus;
+    pthread_mutex_lock(&bus->mutex);
+
+    while (sub->count == 0 && !sub->ended) {
+        if (pthread_cond_timedwait(&sub->cond, &bus->mutex, &deadline) == ETIMEDOUT &&
+            sub->count == 0 && !sub->ended) {
+            pthread_mutex_unlock(&bus->mutex);
+            return AVERROR(EAGAIN);
+        }
+    }
+
+    if (sub->count == 0) {
+        pthread_mutex_unlock(&bus->mutex);
+        return AVERROR_EOF;
+    }
+
+    AVPacket *queued = sub->queue[sub->head];
+    sub->queue[sub->head] = NULL;
+    sub->head = (sub->head + 1) % sub->max_packets;
+    sub->count--;
+
+    pthread_mutex_unlock(&bus->mutex);
+
+    av_packet_unref(pkt);
+    av_packet_move_ref(pkt, queued);
+    av_packet_free(&queued);
+    return 0;
+}
+
+/**
+ * End a subscription and free its queue
+ */
+void packet_bus_unsubscribe(packet_bus_subscriber_t *sub) {
+    if (!sub) {
+        return;
+    }
+
+    packet_bus_t *bus = sub->bus;
+    pthread_mutex_lock(&bus->mutex);
+
+    for (int i = 0; i < bus->num_subscribers; i++) {
+        if (bus->subscribers[i] == sub) {
+            bus->subscribers[i] = bus->subscribers[--bus->num_subscribers];
+            bus->subscribers[bus->num_subscribers] = NULL;
+            break;
+        }
+    }
+    clear_queue(sub);
+    int num_subscribers = bus->num_subscribers;
+
+    pthread_mutex_unlock(&bus->mutex);
+
+    log_info("Packet bus subscriber for %s left (%d subscribers, %llu packets dropped)",
+             bus->stream_name, num_subscribers, (unsigned long long)sub->dropped);
+
+    pthread_cond_destroy(&sub->cond);
+    sub->magic = 0;
+    free(sub->queue);
+    free(sub);
+}
+
+/**
+ * Get the subscriber of a bus input context
+ */
+static packet_bus_subscriber_t *input_subscriber(const AVFormatContext *ctx) {
+    if (!ctx || !ctx->opaque || ctx->iformat) {
+        return NULL;
+    }
+
+    packet_bus_subscriber_t *sub = (packet_bus_subscriber_t *)ctx->opaque;
+    if (sub->magic != PACKET_BUS_INPUT_MAGIC || sub->input != ctx) {
+        return NULL;
+    }
+    return sub;
+}
+
+/**
+ * Open a stream's bus as a libavformat input
+ */
+int packet_bus_open_input(const char *stream_name, AVFormatContext **ctx) {
+    if (!stream_name || !ctx) {
+        return -1;
+    }
+
+    packet_bus_t *bus = find_bus(stream_name);
+    if (!bus) {
+        return -1;
+    }
+
+    AVFormatContext *input = avformat_alloc_context();
+    if (!input) {
+        log_error("Failed to allocate packet bus input for %s", stream_name);
+        return -1;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+
+    // Subscribe and copy the layout under one lock so both belong to the same source
+    packet_bus_subscriber_t *sub = subscribe_locked(bus, PACKET_BUS_INPUT_QUEUE_PACKETS,
+                                                    PACKET_BUS_DROP_TO_KEYFRAME);
+    if (!sub) {
+        pthread_mutex_unlock(&bus->mutex);
+        avformat_free_context(input);
+        return -1;
+    }
+
+    for (int i = 0; i < bus->nb_streams; i++) {
+        AVStream *st = avformat_new_stream(input, NULL);
+        if (!st || avcodec_parameters_copy(st->codecpar, bus->codecpar[i]) < 0) {
+            pthread_mutex_unlock(&bus->mutex);
+            packet_bus_unsubscribe(sub);
+            avformat_free_context(input);
+            log_error("Failed to set up packet bus input streams for %s", stream_name);
+            return -1;
+        }
+        st->time_base = bus->time_base[i];
+        st->avg_frame_rate = bus->avg_frame_rate[i];
+        st->r_frame_rate = bus->r_frame_rate[i];
+    }
+    int num_subscribers = bus->num_subscribers;
+
+    pthread_mutex_unlock(&bus->mutex);
+
+    sub->input = input;
+    input->opaque = sub;
+    *ctx = input;
+
+    log_info("Opened packet bus input for %s (%d subscribers)", stream_name, num_subscribers);
+    return 0;
+}
+
+/**
+ * Read the next packet from an input
+ */
+int packet_bus_read_frame(AVFormatContext *ctx, AVPacket *pkt) {
+    packet_bus_subscriber_t *sub = input_subscriber(ctx);
+    if (!sub) {
+        return av_read_frame(ctx, pkt);
+    }
+
+    int ret = packet_bus_receive(sub, pkt, PACKET_BUS_READ_TIMEOUT_MS);
+    if (ret == AVERROR(EAGAIN)) {
+        log_warn("No packets on packet bus of %s for %d ms", sub->bus->stream_name,
+                 PACKET_BUS_READ_TIMEOUT_MS);
+        return AVERROR(ETIMEDOUT);
+    }
+    return ret;
+}
+
+/**
+ * Close an input opened with packet_bus_open_input() or avformat_open_input()
+ */
+void packet_bus_close_input(AVFormatContext **ctx) {
+    if (!ctx || !*ctx) {
+        return;
+    }
+
+    packet_bus_subscriber_t *sub = input_subscriber(*ctx);
+    if (!sub) {
+        avformat_close_input(ctx);
+        return;
+    }
+
+    (*ctx)->opaque = NULL;
+    packet_bus_unsubscribe(sub);
+    avformat_free_context(*ctx);
+    *ctx = NULL;
+}
+
+/**
+ * Check whether an input context was opened with packet_bus_open_input()
+ */
+bool packet_bus_is_input(const AVFormatContext *ctx) {
+    return input_subscriber(ctx) != NULL;
+}
+
+/**
+ * Switch a consumer's input to the stream's bus when possible
+ */
+bool packet_bus_select_input(const char *stream_name, AVFormatContext **ctx) {
+    if (!stream_name || !ctx) {
+        return false;
+    }
+
+    packet_bus_subscriber_t *sub = input_subscriber(*ctx);
+    if (sub) {
+        pthread_mutex_lock(&sub->bus->mutex);
+        bool ended = sub->ended;
+        pthread_mutex_unlock(&sub->bus->mutex);
+
+        if (!ended) {
+            return true;
+        }
+        log_info("Packet bus source of %s went away, closing shared input", stream_name);
+        packet_bus_close_input(ctx);
+    }
+
+    if (!packet_bus_has_source(stream_name)) {
+        return false;
+    }
+
+    AVFormatContext *input = NULL;
+    if (packet_bus_open_input(stream_name, &input) != 0) {
+        return false;
+    }
+
+    if (*ctx) {
+        log_info("Replacing dedicated camera connection of %s with its packet bus", stream_name);
+        avformat_close_input(ctx);
+    }
+    *ctx = input;
+    return true;
+}
+
+/**
+ * Get packet bus statistics for a stream
+ */
+void packet_bus_get_stats(const char *stream_name, packet_bus_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+    memset(stats, 0, sizeof(*stats));
+
+    packet_bus_t *bus = stream_name ? find_bus(stream_name) : NULL;
+    if (!bus) {
+        return;
+    }
+
+    pthread_mutex_lock(&bus->mutex);
+    stats->active = bus->active;
+    stats->subscribers = bus->num_subscribers;
+    stats->packets_published = bus->packets_published;
+    stats->packets_dropped = bus->packets_dropped;
+    pthread_mutex_unlock(&bus->mutex);
+}
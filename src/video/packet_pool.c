@@ -0,0 +1,152 @@
+/**
+ * Packet Pool Implementation
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <errno.h>
+
+#include <libavcodec/avcodec.h>
+#include <libavutil/buffer.h>
+
+#include "video/packet_pool.h"
+#include "core/logger.h"
+
+struct packet_pool {
+    char name[256];
+    AVBufferPool *classes[PACKET_POOL_NUM_CLASSES];
+
+    atomic_uint_fast64_t packets_referenced;
+    atomic_uint_fast64_t packets_copied;
+    atomic_uint_fast64_t packets_unpooled;
+};
+
+static size_t class_size(int index) {
+    return (size_t)1 << (PACKET_POOL_MIN_CLASS_SHIFT + index);
+}
+
+/**
+ * Get the smallest size class that holds size bytes plus padding, or -1
+ */
+static int class_for_size(size_t size) {
+    for (int i = 0; i < PACKET_POOL_NUM_CLASSES; i++) {
+        if (size + AV_INPUT_BUFFER_PADDING_SIZE <= class_size(i)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Create a packet pool
+ */
+packet_pool_t *packet_pool_create(const char *name) {
+    packet_pool_t *pool = calloc(1, sizeof(packet_pool_t));
+    if (!pool) {
+        log_error("Failed to allocate packet pool");
+        return NULL;
+    }
+
+    if (name) {
+        strncpy(pool->name, name, sizeof(pool->name) - 1);
+    }
+
+    for (int i = 0; i < PACKET_POOL_NUM_CLASSES; i++) {
+        pool->classes[i] = av_buffer_pool_init(class_size(i), NULL);
+        if (!pool->classes[i]) {
+            log_error("Failed to create packet pool size class %zu for %s", class_size(i), pool->name);
+            packet_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    atomic_init(&pool->packets_referenced, 0);
+    atomic_init(&pool->packets_copied, 0);
+    atomic_init(&pool->packets_unpooled, 0);
+
+    return pool;
+}
+
+/**
+ * Destroy a packet pool
+ */
+void packet_pool_destroy(packet_pool_t *pool) {
+    if (!pool) {
+        return;
+    }
+
+    // Buffers still in use return to their pool and are freed with it
+    for (int i = 0; i < PACKET_POOL_NUM_CLASSES; i++) {
+        av_buffer_pool_uninit(&pool->classes[i]);
+    }
+
+    free(pool);
+}
+
+/**
+ * Store a reference to a packet
+ */
+int packet_pool_ref(packet_pool_t *pool, AVPacket *dst, const AVPacket *src) {
+    if (!pool || !dst || !src || src->size < 0) {
+        return AVERROR(EINVAL);
+    }
+
+    // Share the payload unless that would keep a much larger buffer alive
+    if (src->buf && src->buf->size <= (size_t)src->size * 2 + AV_INPUT_BUFFER_PADDING_SIZE) {
+        int ret = av_packet_ref(dst, src);
+        if (ret == 0) {
+            atomic_fetch_add(&pool->packets_referenced, 1);
+        }
+        return ret;
+    }
+
+    int index = class_for_size((size_t)src->size);
+    if (index < 0) {
+        atomic_fetch_add(&pool->packets_unpooled, 1);
+        return av_packet_ref(dst, src);
+    }
+
+    AVBufferRef *buf = av_buffer_pool_get(pool->classes[index]);
+    if (!buf) {
+        return AVERROR(ENOMEM);
+    }
+
+    int ret = av_packet_copy_props(dst, src);
+    if (ret < 0) {
+        av_buffer_unref(&buf);
+        return ret;
+    }
+
+    if (src->size > 0) {
+        memcpy(buf->data, src->data, src->size);
+    }
+    memset(buf->data + src->size, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+
+    dst->buf = buf;
+    dst->data = buf->data;
+    dst->size = src->size;
+
+    atomic_fetch_add(&pool->packets_copied, 1);
+    return 0;
+}
+
+/**
+ * Get packet pool statistics
+ */
+void packet_pool_get_stats(packet_pool_t *pool, packet_pool_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    memset(stats, 0, sizeof(*stats));
+    if (!pool) {
+        return;
+    }
+
+    stats->packets_referenced = atomic_load(&pool->packets_referenced);
+    stats->packets_copied = atomic_load(&pool->packets_copied);
+    stats->packets_unpooled = atomic_load(&pool->packets_unpooled);
+}
@@ -0,0 +1,1002 @@
+/**
+ * Stream-copy remux engine
+ *
+ * Packets are copied from the inputs to one MP4 output. Each input is rebased
+ * so that its first keyframe follows the last packet of the previous input, so
+ * the result plays as one continuous recording. Packets before the first
+ * keyframe of an input are dropped, which is what makes trimming keyframe
+ * aligned: nothing is written that the decoder could not display.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <errno.h>
+
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libavutil/avutil.h>
+#include <libavutil/mathematics.h>
+
+#include "core/logger.h"
+#include "video/ffmpeg_utils.h"
+#include "video/remux_engine.h"
+
+// Size of the AVIO buffer used for streamed output
+#define REMUX_IO_BUFFER_SIZE (64 * 1024)
+
+// Publish progress every this many packets
+#define REMUX_PROGRESS_INTERVAL 32
+
+typedef struct remux_job remux_job_t;
+
+struct remux_job {
+    bool in_use;
+    bool finished;
+    remux_job_info_t info;      // Protected by g_remux.mutex
+
+    // Request, owned by the job until it finishes
+    char **inputs;
+    int input_count;
+    double start_offset;
+    double duration;
+    bool streamed;
+    bool fragmented;
+    remux_write_cb_t write_cb;
+    remux_done_cb_t done_cb;
+    remux_cancel_cb_t cancel_cb;
+    void *opaque;
+
+    atomic_bool cancel;
+    remux_job_t *next;          // Next queued job
+};
+
+// Engine state, protected by mutex
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t work_cond;   // Signalled when a job is queued or on shutdown
+    pthread_cond_t done_cond;   // Signalled when a job finishes
+    bool running;
+    int num_workers;
+    pthread_t *workers;
+
+    remux_job_t jobs[REMUX_MAX_JOBS];
+    remux_job_t *queue_head;
+    remux_job_t *queue_tail;
+    int queued;
+    int active;
+    unsigned int next_id;
+
+    uint64_t completed;
+    uint64_t failed;
+    uint64_t rejected;
+} g_remux = {
+    .mutex = PTHREAD_MUTEX_INITIALIZER,
+    .work_cond = PTHREAD_COND_INITIALIZER,
+    .done_cond = PTHREAD_COND_INITIALIZER,
+};
+
+const char *remux_job_state_name(remux_job_state_t state) {
+    switch (state) {
+        case REMUX_JOB_QUEUED: return "queued";
+        case REMUX_JOB_RUNNING: return "running";
+        case REMUX_JOB_COMPLETE: return "complete";
+        case REMUX_JOB_FAILED: return "failed";
+        case REMUX_JOB_CANCELLED: return "cancelled";
+        default: return "unknown";
+    }
+}
+
+static void set_job_error(remux_job_t *job, const char *message) {
+    pthread_mutex_lock(&g_remux.mutex);
+    if (job->info.error_message[0] == '\0') {
+        snprintf(job->info.error_message, sizeof(job->info.error_message), "%s", message);
+    }
+    pthread_mutex_unlock(&g_remux.mutex);
+}
+
+/**
+ * Cancel a job. Called with the mutex held.
+ *
+ * A running job's writer may be blocked on its consumer and never look at the
+ * cancel flag, so it is woken through the cancellation callback. done_cb has
+ * not run while the job is still running, so the callback's data is valid.
+ */
+static void cancel_job_locked(remux_job_t *job) {
+    atomic_store(&job->cancel, true);
+    if (job->info.state == REMUX_JOB_RUNNING && job->cancel_cb) {
+        job->cancel_cb(job->opaque);
+    }
+}
+
+static int interrupt_cb(void *opaque) {
+    remux_job_t *job = (remux_job_t *)opaque;
+    return atomic_load(&job->cancel) ? 1 : 0;
+}
+
+#if LIBAVFORMAT_VERSION_MAJOR >= 61
+static int write_packet_cb(void *opaque, const uint8_t *buf, int size) {
+#else
+static int write_packet_cb(void *opaque, uint8_t *buf, int size) {
+#endif
+    remux_job_t *job = (remux_job_t *)opaque;
+
+    if (atomic_load(&job->cancel) || job->write_cb(job->opaque, buf, (size_t)size) != 0) {
+        return AVERROR_EXIT;
+    }
+    return size;
+}
+
+/**
+ * Check if the demuxer left out parameters the MP4 muxer needs. MP4 inputs
+ * carry everything in their header, so the slow stream info probe is only
+ * needed for formats like MPEG-TS.
+ */
+static bool needs_stream_info(const AVFormatContext *in) {
+    for (unsigned int i = 0; i < in->nb_streams; i++) {
+        const AVCodecParameters *par = in->streams[i]->codecpar;
+        if (par->codec_type == AVMEDIA_TYPE_VIDEO &&
+            (par->codec_id == AV_CODEC_ID_NONE || par->width <= 0 || par->extradata_size <= 0)) {
+            return true;
+        }
+        if (par->codec_type == AVMEDIA_TYPE_AUDIO &&
+            (par->codec_id == AV_CODEC_ID_NONE || par->sample_rate <= 0)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int add_output_stream(AVFormatContext *out, const AVStream *in_stream) {
+    AVStream *out_stream = avformat_new_stream(out, NULL);
+    if (!out_stream) {
+        return -1;
+    }
+
+    int ret = avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
+    if (ret < 0) {
+        log_ffmpeg_error(ret, "Failed to copy codec parameters");
+        return -1;
+    }
+    out_stream->codecpar->codec_tag = 0;
+    out_stream->time_base = in_stream->time_base;
+    return out_stream->index;
+}
+
+/**
+ * Publish progress for a job
+ */
+static void update_progress(remux_job_t *job, AVFormatContext *out, int inputs_done,
+                            double input_fraction, int64_t written_us, int64_t end_us) {
+    double progress;
+    if (end_us != INT64_MAX && end_us > 0) {
+        progress = (double)written_us / (double)end_us;
+    } else {
+        progress = (inputs_done + input_fraction) / (double)job->input_count;
+    }
+    if (progress > 1.0) {
+        progress = 1.0;
+    } else if (progress < 0.0) {
+        progress = 0.0;
+    }
+
+    int64_t bytes = (out && out->pb) ? avio_tell(out->pb) : 0;
+
+    pthread_mutex_lock(&g_remux.mutex);
+    job->info.inputs_done = inputs_done;
+    job->info.progress = progress;
+    job->info.output_seconds = (double)written_us / AV_TIME_BASE;
+    if (bytes > 0) {
+        job->info.bytes_written = (uint64_t)bytes;
+    }
+    job->info.updated_at = time(NULL);
+    pthread_mutex_unlock(&g_remux.mutex);
+}
+
+/**
+ * Remux the job's inputs into its output
+ *
+ * @return 0 on success, -1 on error
+ */
+static int execute_job(remux_job_t *job) {
+    AVFormatContext *out = NULL;
+    AVFormatContext *in = NULL;
+    AVPacket *pkt = NULL;
+    AVDictionary *opts = NULL;
+    bool output_created = false;
+    bool header_written = false;
+    bool reached_end = false;
+    int result = -1;
+    int ret;
+
+    // Output stream indexes and the last DTS written to each
+    int out_video = -1;
+    int out_audio = -1;
+    int64_t last_dts[2] = {AV_NOPTS_VALUE, AV_NOPTS_VALUE};
+
+    // Output timeline in AV_TIME_BASE units
+    int64_t next_offset_us = 0;
+    int64_t written_us = 0;
+    int64_t end_us = job->duration > 0 ? (int64_t)(job->duration * AV_TIME_BASE) : INT64_MAX;
+
+    const char *output_path = job->streamed ? NULL : job->info.output_path;
+    ret = avformat_alloc_output_context2(&out, NULL, "mp4", output_path);
+    if (ret < 0 || !out) {
+        log_ffmpeg_error(ret, "Failed to create remux output context");
+        set_job_error(job, "Failed to create output");
+        return -1;
+    }
+
+    if (job->streamed) {
+        uint8_t *io_buffer = av_malloc(REMUX_IO_BUFFER_SIZE);
+        if (!io_buffer) {
+            set_job_error(job, "Out of memory");
+            goto cleanup;
+        }
+        out->pb = avio_alloc_context(io_buffer, REMUX_IO_BUFFER_SIZE, 1, job,
+                                     NULL, write_packet_cb, NULL);
+        if (!out->pb) {
+            av_free(io_buffer);
+            set_job_error(job, "Out of memory");
+            goto cleanup;
+        }
+        out->flags |= AVFMT_FLAG_CUSTOM_IO;
+    }
+
+    pkt = av_packet_alloc();
+    if (!pkt) {
+        set_job_error(job, "Out of memory");
+        goto cleanup;
+    }
+
+    for (int i = 0; i < job->input_count && !reached_end; i++) {
+        const char *path = job->inputs[i];
+
+        if (atomic_load(&job->cancel)) {
+            goto cleanup;
+        }
+
+        in = avformat_alloc_context();
+        if (!in) {
+            set_job_error(job, "Out of memory");
+            goto cleanup;
+        }
+        in->interrupt_callback.callback = interrupt_cb;
+        in->interrupt_callback.opaque = job;
+
+        ret = avformat_open_input(&in, path, NULL, NULL);
+        if (ret < 0) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            log_warn("Remux: skipping %s, could not open it (%s)", path, err_buf);
+            goto skip_input;
+        }
+
+        if (needs_stream_info(in) && avformat_find_stream_info(in, NULL) < 0) {
+            log_warn("Remux: skipping %s, could not read stream info", path);
+            goto skip_input;
+        }
+
+        int in_video = av_find_best_stream(in, AVMEDIA_TYPE_VIDEO, -1, -1, NULL, 0);
+        int in_audio = av_find_best_stream(in, AVMEDIA_TYPE_AUDIO, -1, in_video, NULL, 0);
+        if (in_video < 0) {
+            log_warn("Remux: skipping %s, it has no video stream", path);
+            goto skip_input;
+        }
+
+        bool first_input = !header_written;
+        if (first_input) {
+            // The first usable input defines the output streams
+            out_video = add_output_stream(out, in->streams[in_video]);
+            if (out_video < 0) {
+                set_job_error(job, "Failed to create output video stream");
+                goto cleanup;
+            }
+
+            if (in_audio >= 0 &&
+                avformat_query_codec(out->oformat, in->streams[in_audio]->codecpar->codec_id,
+                                     FF_COMPLIANCE_NORMAL) == 1) {
+                out_audio = add_output_stream(out, in->streams[in_audio]);
+            }
+
+            if (job->fragmented) {
+                av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+            } else {
+                av_dict_set(&opts, "movflags", "+faststart", 0);
+            }
+
+            if (!job->streamed) {
+                ret = avio_open(&out->pb, output_path, AVIO_FLAG_WRITE);
+                if (ret < 0) {
+                    log_ffmpeg_error(ret, "Failed to open remux output file");
+                    set_job_error(job, "Failed to open output file");
+                    goto cleanup;
+                }
+                output_created = true;
+            }
+
+            ret = avformat_write_header(out, &opts);
+            av_dict_free(&opts);
+            if (ret < 0) {
+                log_ffmpeg_error(ret, "Failed to write remux header");
+                set_job_error(job, "Failed to write output header");
+                goto cleanup;
+            }
+            header_written = true;
+        } else {
+            if (in->streams[in_video]->codecpar->codec_id != out->streams[out_video]->codecpar->codec_id) {
+                log_warn("Remux: skipping %s, video codec %s differs from the output",
+                         path, avcodec_get_name(in->streams[in_video]->codecpar->codec_id));
+                goto skip_input;
+            }
+            if (in_audio >= 0 && (out_audio < 0 ||
+                in->streams[in_audio]->codecpar->codec_id != out->streams[out_audio]->codecpar->codec_id)) {
+                in_audio = -1;
+            }
+        }
+        if (out_audio < 0) {
+            in_audio = -1;
+        }
+
+        // Trim the start of the first input at the keyframe preceding the offset
+        int64_t file_start_us = in->start_time != AV_NOPTS_VALUE ? in->start_time : 0;
+        int64_t target_us = AV_NOPTS_VALUE;
+        if (first_input && job->start_offset > 0) {
+            target_us = file_start_us + (int64_t)(job->start_offset * AV_TIME_BASE);
+            ret = av_seek_frame(in, -1, target_us, AVSEEK_FLAG_BACKWARD);
+            if (ret < 0) {
+                log_warn("Remux: could not seek to %.1fs in %s, starting at the beginning",
+                         job->start_offset, path);
+            }
+        }
+
+        AVStream *video_in = in->streams[in_video];
+        AVRational frame_rate = video_in->avg_frame_rate.num > 0 ? video_in->avg_frame_rate
+                                                                 : video_in->r_frame_rate;
+        int64_t base_us = AV_NOPTS_VALUE;
+        int64_t offset[2] = {0, 0};   // Per output stream, in the input time base
+        int64_t input_duration_us = in->duration > 0 ? in->duration : 0;
+        int packets = 0;
+
+        while ((ret = av_read_frame(in, pkt)) >= 0) {
+            int out_idx = pkt->stream_index == in_video ? out_video :
+                          pkt->stream_index == in_audio ? out_audio : -1;
+            if (out_idx < 0) {
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            AVStream *in_stream = in->streams[pkt->stream_index];
+            AVStream *out_stream = out->streams[out_idx];
+
+            if (pkt->dts == AV_NOPTS_VALUE) {
+                pkt->dts = pkt->pts;
+            }
+            if (pkt->dts == AV_NOPTS_VALUE) {
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            int64_t dts_us = av_rescale_q(pkt->dts, in_stream->time_base, AV_TIME_BASE_Q);
+
+            // The input starts on the output timeline at its first video keyframe
+            if (base_us == AV_NOPTS_VALUE) {
+                if (out_idx != out_video || !(pkt->flags & AV_PKT_FLAG_KEY)) {
+                    av_packet_unref(pkt);
+                    continue;
+                }
+                base_us = dts_us;
+
+                // The duration counts from the requested start, not from the keyframe before it
+                if (target_us != AV_NOPTS_VALUE && end_us != INT64_MAX && target_us > base_us) {
+                    end_us += target_us - base_us;
+                }
+
+                offset[0] = av_rescale_q(next_offset_us - base_us, AV_TIME_BASE_Q,
+                                         in->streams[in_video]->time_base);
+                if (in_audio >= 0) {
+                    offset[1] = av_rescale_q(next_offset_us - base_us, AV_TIME_BASE_Q,
+                                             in->streams[in_audio]->time_base);
+                }
+            }
+
+            if (dts_us < base_us) {
+                // Audio from before the keyframe
+                av_packet_unref(pkt);
+                continue;
+            }
+
+            int64_t out_us = dts_us - base_us + next_offset_us;
+            if (out_us >= end_us) {
+                av_packet_unref(pkt);
+                if (out_idx == out_video) {
+                    reached_end = true;
+                    break;
+                }
+                continue;
+            }
+
+            if (pkt->duration <= 0 && out_idx == out_video && frame_rate.num > 0 && frame_rate.den > 0) {
+                pkt->duration = av_rescale_q(1, av_inv_q(frame_rate), in_stream->time_base);
+            }
+
+            int slot = out_idx == out_video ? 0 : 1;
+            pkt->dts += offset[slot];
+            if (pkt->pts != AV_NOPTS_VALUE) {
+                pkt->pts += offset[slot];
+            }
+            av_packet_rescale_ts(pkt, in_stream->time_base, out_stream->time_base);
+
+            // Keep DTS strictly increasing across input boundaries
+            if (last_dts[slot] != AV_NOPTS_VALUE && pkt->dts <= last_dts[slot]) {
+                pkt->dts = last_dts[slot] + 1;
+            }
+            if (pkt->pts != AV_NOPTS_VALUE && pkt->pts < pkt->dts) {
+                pkt->pts = pkt->dts;
+            }
+            last_dts[slot] = pkt->dts;
+
+            int64_t pkt_end_us = av_rescale_q(pkt->dts + (pkt->duration > 0 ? pkt->duration : 0),
+                                              out_stream->time_base, AV_TIME_BASE_Q);
+            if (pkt_end_us > written_us) {
+                written_us = pkt_end_us;
+            }
+
+            pkt->stream_index = out_idx;
+            pkt->pos = -1;
+            ret = av_interleaved_write_frame(out, pkt);
+            av_packet_unref(pkt);
+            if (ret < 0) {
+                if (!atomic_load(&job->cancel)) {
+                    log_ffmpeg_error(ret, "Remux: failed to write packet");
+                    set_job_error(job, job->streamed ? "Client disconnected" : "Failed to write output");
+                }
+                goto cleanup;
+            }
+
+            if (++packets % REMUX_PROGRESS_INTERVAL == 0) {
+                double fraction = input_duration_us > 0 ?
+                    (double)(dts_us - base_us) / (double)input_duration_us : 0.0;
+                update_progress(job, out, i, fraction, written_us, end_us);
+            }
+        }
+
+        if (atomic_load(&job->cancel)) {
+            goto cleanup;
+        }
+        if (ret < 0 && ret != AVERROR_EOF) {
+            char err_buf[AV_ERROR_MAX_STRING_SIZE] = {0};
+            av_strerror(ret, err_buf, sizeof(err_buf));
+            log_warn("Remux: read error in %s (%s), continuing with the next input", path, err_buf);
+        }
+
+        // The next input continues where this one ended
+        next_offset_us = written_us;
+        avformat_close_input(&in);
+        update_progress(job, out, i + 1, 0.0, written_us, end_us);
+        continue;
+
+skip_input:
+        avformat_close_input(&in);
+        pthread_mutex_lock(&g_remux.mutex);
+        job->info.inputs_skipped++;
+        pthread_mutex_unlock(&g_remux.mutex);
+        update_progress(job, out, i + 1, 0.0, written_us, end_us);
+    }
+
+    if (!header_written) {
+        set_job_error(job, "No playable recordings");
+        goto cleanup;
+    }
+
+    ret = av_write_trailer(out);
+    if (ret < 0) {
+        log_ffmpeg_error(ret, "Failed to write remux trailer");
+        set_job_error(job, "Failed to finish output");
+        goto cleanup;
+    }
+    if (out->pb) {
+        avio_flush(out->pb);
+    }
+
+    update_progress(job, out, job->input_count, 0.0, written_us, written_us);
+    result = 0;
+
+cleanup:
+    if (in) {
+        avformat_close_input(&in);
+    }
+    av_packet_free(&pkt);
+    av_dict_free(&opts);
+
+    if (out) {
+        if (job->streamed) {
+            if (out->pb) {
+                av_freep(&out->pb->buffer);
+                avio_context_free(&out->pb);
+            }
+        } else if (out->pb) {
+            avio_closep(&out->pb);
+        }
+        avformat_free_context(out);
+    }
+
+    // Never leave a truncated file behind
+    if (result != 0 && output_created) {
+        unlink(job->info.output_path);
+    }
+
+    return result;
+}
+
+/**
+ * Copy a request into a job
+ *
+ * @return 0 on success, -1 on error
+ */
+static int init_job(remux_job_t *job, const remux_request_t *request) {
+    memset(job, 0, sizeof(*job));
+
+    job->inputs = calloc((size_t)request->input_count, sizeof(char *));
+    if (!job->inputs) {
+        return -1;
+    }
+    for (int i = 0; i < request->input_count; i++) {
+        job->inputs[i] = strdup(request->inputs[i] ? request->inputs[i] : "");
+        if (!job->inputs[i]) {
+            for (int j = 0; j < i; j++) {
+                free(job->inputs[j]);
+            }
+            free(job->inputs);
+            job->inputs = NULL;
+            return -1;
+        }
+    }
+
+    job->input_count = request->input_count;
+    job->start_offset = request->start_offset;
+    job->duration = request->duration;
+    job->streamed = request->output_path == NULL;
+    job->fragmented = request->fragmented || job->streamed;
+    job->write_cb = request->write_cb;
+    job->done_cb = request->done_cb;
+    job->cancel_cb = request->cancel_cb;
+    job->opaque = request->opaque;
+    atomic_init(&job->cancel, false);
+
+    job->info.state = REMUX_JOB_QUEUED;
+    job->info.input_count = request->input_count;
+    if (request->output_path) {
+        snprintf(job->info.output_path, sizeof(job->info.output_path), "%s", request->output_path);
+    }
+    job->info.created_at = time(NULL);
+    job->info.updated_at = job->info.created_at;
+    return 0;
+}
+
+static void free_job_inputs(remux_job_t *job) {
+    if (job->inputs) {
+        for (int i = 0; i < job->input_count; i++) {
+            free(job->inputs[i]);
+        }
+        free(job->inputs);
+        job->inputs = NULL;
+    }
+}
+
+static bool validate_request(const remux_request_t *request) {
+    if (!request || !request->inputs || request->input_count <= 0) {
+        return false;
+    }
+    if (!request->output_path && !request->write_cb) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Find a job by ID. Called with the mutex held.
+ */
+static remux_job_t *find_job(const char *job_id) {
+    if (!job_id) {
+        return NULL;
+    }
+    for (int i = 0; i < REMUX_MAX_JOBS; i++) {
+        if (g_remux.jobs[i].in_use && strcmp(g_remux.jobs[i].info.job_id, job_id) == 0) {
+            return &g_remux.jobs[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * Get a free job slot, reusing the slot of the oldest finished job if needed.
+ * Called with the mutex held.
+ */
+static remux_job_t *allocate_job_slot(void) {
+    time_t now = time(NULL);
+    remux_job_t *oldest = NULL;
+
+    for (int i = 0; i < REMUX_MAX_JOBS; i++) {
+        remux_job_t *job = &g_remux.jobs[i];
+        if (!job->in_use) {
+            return job;
+        }
+        if (job->finished) {
+            if (now - job->info.updated_at > REMUX_JOB_RETENTION_TIME) {
+                job->in_use = false;
+                return job;
+            }
+            if (!oldest || job->info.updated_at < oldest->info.updated_at) {
+                oldest = job;
+            }
+        }
+    }
+
+    if (oldest) {
+        oldest->in_use = false;
+    }
+    return oldest;
+}
+
+/**
+ * Remux worker thread
+ */
+static void *remux_worker(void *arg) {
+    (void)arg;
+
+    pthread_mutex_lock(&g_remux.mutex);
+    while (true) {
+        while (g_remux.running && !g_remux.queue_head) {
+            pthread_cond_wait(&g_remux.work_cond, &g_remux.mutex);
+        }
+        if (!g_remux.running) {
+            break;
+        }
+
+        remux_job_t *job = g_remux.queue_head;
+        g_remux.queue_head = job->next;
+        if (!g_remux.queue_head) {
+            g_remux.queue_tail = NULL;
+        }
+        job->next = NULL;
+        g_remux.queued--;
+        g_remux.active++;
+        job->info.state = REMUX_JOB_RUNNING;
+        job->info.updated_at = time(NULL);
+        pthread_mutex_unlock(&g_remux.mutex);
+
+        log_info("Remux job %s started (%d inputs, output %s)", job->info.job_id,
+                 job->input_count, job->streamed ? "streamed" : job->info.output_path);
+
+        int ret = atomic_load(&job->cancel) ? -1 : execute_job(job);
+        free_job_inputs(job);
+
+        pthread_mutex_lock(&g_remux.mutex);
+        if (ret == 0) {
+            job->info.state = REMUX_JOB_COMPLETE;
+            job->info.progress = 1.0;
+            g_remux.completed++;
+        } else {
+            job->info.state = atomic_load(&job->cancel) ? REMUX_JOB_CANCELLED : REMUX_JOB_FAILED;
+            g_remux.failed++;
+        }
+        job->info.updated_at = time(NULL);
+        g_remux.active--;
+        remux_done_cb_t done_cb = job->done_cb;
+        void *opaque = job->opaque;
+        remux_job_info_t info = job->info;
+        pthread_mutex_unlock(&g_remux.mutex);
+
+        if (ret == 0) {
+            log_info("Remux job %s complete: %.1fs, %llu bytes, %d of %d inputs skipped",
+                     info.job_id, info.output_seconds, (unsigned long long)info.bytes_written,
+                     info.inputs_skipped, info.input_count);
+        } else {
+            log_warn("Remux job %s %s: %s", info.job_id, remux_job_state_name(info.state),
+                     info.error_message[0] ? info.error_message : "stopped");
+        }
+
+        if (done_cb) {
+            done_cb(opaque, ret == 0);
+        }
+
+        // Only now may waiters reuse the slot
+        pthread_mutex_lock(&g_remux.mutex);
+        job->finished = true;
+        pthread_cond_broadcast(&g_remux.done_cond);
+    }
+    pthread_mutex_unlock(&g_remux.mutex);
+
+    return NULL;
+}
+
+/**
+ * Start the remux worker pool
+ */
+int remux_engine_init(int num_workers) {
+    if (num_workers <= 0) {
+        num_workers = REMUX_DEFAULT_WORKERS;
+    }
+
+    pthread_mutex_lock(&g_remux.mutex);
+    if (g_remux.running) {
+        pthread_mutex_unlock(&g_remux.mutex);
+        return 0;
+    }
+
+    g_remux.workers = calloc((size_t)num_workers, sizeof(pthread_t));
+    if (!g_remux.workers) {
+        pthread_mutex_unlock(&g_remux.mutex);
+        log_error("Failed to allocate remux workers");
+        return -1;
+    }
+
+    memset(g_remux.jobs, 0, sizeof(g_remux.jobs));
+    g_remux.queue_head = NULL;
+    g_remux.queue_tail = NULL;
+    g_remux.queued = 0;
+    g_remux.active = 0;
+    g_remux.running = true;
+
+    int started = 0;
+    for (int i = 0; i < num_workers; i++) {
+        if (pthread_create(&g_remux.workers[i], NULL, remux_worker, NULL) != 0) {
+            log_error("Failed to create remux worker %d", i);
+            break;
+        }
+        started++;
+    }
+    g_remux.num_workers = started;
+
+    if (started == 0) {
+        g_remux.running = false;
+        free(g_remux.workers);
+        g_remux.workers = NULL;
+        pthread_mutex_unlock(&g_remux.mutex);
+        return -1;
+    }
+    pthread_mutex_unlock(&g_remux.mutex);
+
+    log_info("Remux engine started with %d workers", started);
+    return 0;
+}
+
+/**
+ * Stop the remux worker pool
+ */
+void remux_engine_shutdown(void) {
+    pthread_mutex_lock(&g_remux.mutex);
+    if (!g_remux.running) {
+        pthread_mutex_unlock(&g_remux.mutex);
+        return;
+    }
+
+    // Cancel everything, queued jobs are finished here, running ones by their worker.
+    // Their callbacks run after the lock is dropped, so they may call into the engine.
+    remux_job_t *cancelled[REMUX_MAX_JOBS];
+    int cancelled_count = 0;
+    for (remux_job_t *job = g_remux.queue_head; job; ) {
+        remux_job_t *next = job->next;
+        job->next = NULL;
+        atomic_store(&job->cancel, true);
+        job->info.state = REMUX_JOB_CANCELLED;
+        job->info.updated_at = time(NULL);
+        free_job_inputs(job);
+        cancelled[cancelled_count++] = job;
+        job = next;
+    }
+    g_remux.queue_head = NULL;
+    g_remux.queue_tail = NULL;
+    g_remux.queued = 0;
+
+    for (int i = 0; i < REMUX_MAX_JOBS; i++) {
+        if (g_remux.jobs[i].in_use) {
+            cancel_job_locked(&g_remux.jobs[i]);
+        }
+    }
+
+    g_remux.running = false;
+    pthread_cond_broadcast(&g_remux.work_cond);
+    pthread_cond_broadcast(&g_remux.done_cond);
+    int num_workers = g_remux.num_workers;
+    pthread_t *workers = g_remux.workers;
+    g_remux.workers = NULL;
+    g_remux.num_workers = 0;
+    pthread_mutex_unlock(&g_remux.mutex);
+
+    for (int i = 0; i < cancelled_count; i++) {
+        if (cancelled[i]->done_cb) {
+            cancelled[i]->done_cb(cancelled[i]->opaque, false);
+        }
+    }
+
+    // Only now may waiters reuse the slots
+    if (cancelled_count > 0) {
+        pthread_mutex_lock(&g_remux.mutex);
+        for (int i = 0; i < cancelled_count; i++) {
+            cancelled[i]->finished = true;
+        }
+        pthread_cond_broadcast(&g_remux.done_cond);
+        pthread_mutex_unlock(&g_remux.mutex);
+    }
+
+    for (int i = 0; i < num_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+
+    log_info("Remux engine stopped");
+}
+
+/**
+ * Queue a remux job
+ */
+int remux_submit(const remux_request_t *request, char *job_id_out) {
+    if (!validate_request(request)) {
+        log_error("Invalid remux request");
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_remux.mutex);
+
+    if (!g_remux.running) {
+        pthread_mutex_unlock(&g_remux.mutex);
+        log_error("Remux engine is not running");
+        return -1;
+    }
+
+    if (g_remux.queued >= REMUX_MAX_QUEUED_JOBS) {
+        g_remux.rejected++;
+        pthread_mutex_unlock(&g_remux.mutex);
+        log_warn("Remux queue full (%d jobs), rejecting request", REMUX_MAX_QUEUED_JOBS);
+        return -1;
+    }
+
+    remux_job_t *job = allocate_job_slot();
+    if (!job) {
+        g_remux.rejected++;
+        pthread_mutex_unlock(&g_remux.mutex);
+        log_warn("No free remux job slot, rejecting request");
+        return -1;
+    }
+
+    if (init_job(job, request) != 0) {
+        pthread_mutex_unlock(&g_remux.mutex);
+        log_error("Failed to allocate remux job");
+        return -1;
+    }
+
+    snprintf(job->info.job_id, sizeof(job->info.job_id), "%lx-%u",
+             (unsigned long)job->info.created_at, ++g_remux.next_id);
+    job->in_use = true;
+
+    if (g_remux.queue_tail) {
+        g_remux.queue_tail->next = job;
+    } else {
+        g_remux.queue_head = job;
+    }
+    g_remux.queue_tail = job;
+    g_remux.queued++;
+
+    if (job_id_out) {
+        strcpy(job_id_out, job->info.job_id);
+    }
+
+    pthread_cond_signal(&g_remux.work_cond);
+    pthread_mutex_unlock(&g_remux.mutex);
+    return 0;
+}
+
+/**
+ * Wait for a job to finish
+ */
+int remux_wait(const char *job_id, remux_job_info_t *info) {
+    pthread_mutex_lock(&g_remux.mutex);
+
+    remux_job_t *job = find_job(job_id);
+    while (job && !job->finished && g_remux.running) {
+        pthread_cond_wait(&g_remux.done_cond, &g_remux.mutex);
+        job = find_job(job_id);
+    }
+
+    int ret = -1;
+    if (job) {
+        if (info) {
+            *info = job->info;
+        }
+        ret = job->info.state == REMUX_JOB_COMPLETE ? 0 : -1;
+    }
+
+    pthread_mutex_unlock(&g_remux.mutex);
+    return ret;
+}
+
+/**
+ * Get the progress of a job
+ */
+int remux_get_job(const char *job_id, remux_job_info_t *info) {
+    if (!info) {
+        return -1;
+    }
+
+    pthread_mutex_lock(&g_remux.mutex);
+    remux_job_t *job = find_job(job_id);
+    if (job) {
+        *info = job->info;
+    }
+    pthread_mutex_unlock(&g_remux.mutex);
+
+    return job ? 0 : -1;
+}
+
+/**
+ * Ask a queued or running job to stop
+ */
+int remux_cancel(const char *job_id) {
+    pthread_mutex_lock(&g_remux.mutex);
+    remux_job_t *job = find_job(job_id);
+    int ret = -1;
+    if (job && (job->info.state == REMUX_JOB_QUEUED || job->info.state == REMUX_JOB_RUNNING)) {
+        cancel_job_locked(job);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&g_remux.mutex);
+    return ret;
+}
+
+/**
+ * Get remux engine statistics
+ */
+void remux_get_stats(remux_stats_t *stats) {
+    if (!stats) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_remux.mutex);
+    stats->num_workers = g_remux.num_workers;
+    stats->active_jobs = g_remux.active;
+    stats->queued_jobs = g_remux.queued;
+    stats->completed = g_remux.completed;
+    stats->failed = g_remux.failed;
+    stats->rejected = g_remux.rejected;
+    pthread_mutex_unlock(&g_remux.mutex);
+}
+
+/**
+ * Run a remux on the calling thread
+ */
+int remux_run(const remux_request_t *request) {
+    if (!validate_request(request)) {
+        log_error("Invalid remux request");
+        return -1;
+    }
+
+    // Not registered in the job table, progress is tracked but never queried
+    remux_job_t *job = malloc(sizeof(remux_job_t));
+    if (!job) {
+        log_error("Failed to allocate remux job");
+        return -1;
+    }
+    if (init_job(job, request) != 0) {
+        free(job);
+        log_error("Failed to allocate remux job");
+        return -1;
+    }
+    snprintf(job->info.job_id, sizeof(job->info.job_id), "direct");
+
+    int ret = execute_job(job);
+    if (ret != 0) {
+        log_error("Remux to %s failed: %s", job->streamed ? "stream" : job->info.output_path,
+                  job->info.error_message[0] ? job->info.error_message : "unknown error");
+    }
+
+    free_job_inputs(job);
+    free(job);
+    return ret;
+}
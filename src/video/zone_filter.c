@@ -1,8 +1,52 @@
 #include "video/zone_filter.h"
 #include "database/db_zones.h"
 #include "core/logger.h"
+#include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <math.h>
+#include <pthread.h>
+
+// Resolution of the precomputed inside/edge masks (cells per axis over 0.0-1.0)
+#define ZONE_MASK_SIZE 64
+
+// Maximum number of class names in a zone filter
+#define MAX_ZONE_CLASSES 16
+
+/**
+ * Zone prepared for fast point tests.
+ *
+ * Cells of the mask that no polygon edge touches are entirely inside or entirely
+ * outside the polygon, so a point there is classified by a single bit lookup.
+ * Only points in cells crossed by an edge need the exact ray casting test.
+ */
+typedef struct {
+    char id[MAX_ZONE_ID];
+    char name[MAX_ZONE_NAME];
+    zone_point_t polygon[MAX_ZONE_POINTS];
+    int polygon_count;
+    float min_x, min_y, max_x, max_y;       // Bounding box
+    uint64_t inside[ZONE_MASK_SIZE];        // Cells entirely inside, one row per entry
+    uint64_t edge[ZONE_MASK_SIZE];          // Cells touched by an edge
+    char classes[MAX_ZONE_CLASSES][MAX_LABEL_LENGTH];
+    int class_count;                        // 0 = all classes match
+    float min_confidence;
+} compiled_zone_t;
+
+/**
+ * Enabled zones of a stream
+ */
+typedef struct zone_cache_entry {
+    char stream_name[MAX_STREAM_NAME];
+    int zone_count;
+    compiled_zone_t *zones;
+    struct zone_cache_entry *next;
+} zone_cache_entry_t;
+
+static zone_cache_entry_t *zone_cache = NULL;
+static pthread_rwlock_t zone_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+// Bumped on every invalidation so a load racing with one is not cached
+static unsigned long zone_cache_generation = 0;
 
 /**
  * Check if a point is inside a polygon using ray casting algorithm
@@ -29,51 +73,174 @@ static bool point_in_polygon(float x, float y, const zone_point_t *polygon, int
 }
 
 /**
- * Check if a detection's center point is within a zone
+ * Check whether the segment (x0,y0)-(x1,y1) touches the rectangle
+ * [rx0,rx1] x [ry0,ry1] (Liang-Barsky clipping)
  */
-static bool detection_in_zone(const detection_t *detection, const detection_zone_t *zone) {
-    if (!detection || !zone || !zone->enabled) {
+static bool segment_touches_rect(float x0, float y0, float x1, float y1,
+                                 float rx0, float ry0, float rx1, float ry1) {
+    float t0 = 0.0f, t1 = 1.0f;
+    float dx = x1 - x0, dy = y1 - y0;
+    float p[4] = { -dx, dx, -dy, dy };
+    float q[4] = { x0 - rx0, rx1 - x0, y0 - ry0, ry1 - y0 };
+
+    for (int i = 0; i < 4; i++) {
+        if (p[i] == 0.0f) {
+            if (q[i] < 0.0f) {
+                return false;
+            }
+        } else {
+            float t = q[i] / p[i];
+            if (p[i] < 0.0f) {
+                if (t > t1) return false;
+                if (t > t0) t0 = t;
+            } else {
+                if (t < t0) return false;
+                if (t < t1) t1 = t;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Split a comma-separated class filter into the zone's class list
+ */
+static void compile_class_filter(compiled_zone_t *cz, const char *filter_classes) {
+    cz->class_count = 0;
+
+    const char *p = filter_classes;
+    while (p && *p && cz->class_count < MAX_ZONE_CLASSES) {
+        const char *comma = strchr(p, ',');
+        const char *end = comma ? comma : p + strlen(p);
+
+        // Trim whitespace
+        const char *start = p;
+        while (start < end && *start == ' ') start++;
+        while (end > start && end[-1] == ' ') end--;
+
+        size_t len = (size_t)(end - start);
+        if (len > 0) {
+            if (len >= MAX_LABEL_LENGTH) {
+                len = MAX_LABEL_LENGTH - 1;
+            }
+            memcpy(cz->classes[cz->class_count], start, len);
+            cz->classes[cz->class_count][len] = '\0';
+            cz->class_count++;
+        }
+
+        p = comma ? comma + 1 : NULL;
+    }
+}
+
+/**
+ * Prepare a zone for fast point tests
+ */
+static void compile_zone(compiled_zone_t *cz, const detection_zone_t *zone) {
+    memset(cz, 0, sizeof(*cz));
+    strncpy(cz->id, zone->id, sizeof(cz->id) - 1);
+    strncpy(cz->name, zone->name, sizeof(cz->name) - 1);
+    cz->min_confidence = zone->min_confidence;
+    compile_class_filter(cz, zone->filter_classes);
+
+    cz->polygon_count = zone->polygon_count;
+    if (cz->polygon_count > MAX_ZONE_POINTS) {
+        cz->polygon_count = MAX_ZONE_POINTS;
+    }
+    if (cz->polygon_count < 3) {
+        // Degenerate polygon, nothing can be inside (empty bounding box)
+        cz->polygon_count = 0;
+        cz->min_x = cz->min_y = 1.0f;
+        cz->max_x = cz->max_y = 0.0f;
+        return;
+    }
+    memcpy(cz->polygon, zone->polygon, cz->polygon_count * sizeof(zone_point_t));
+
+    cz->min_x = cz->max_x = cz->polygon[0].x;
+    cz->min_y = cz->max_y = cz->polygon[0].y;
+    for (int i = 1; i < cz->polygon_count; i++) {
+        cz->min_x = fminf(cz->min_x, cz->polygon[i].x);
+        cz->max_x = fmaxf(cz->max_x, cz->polygon[i].x);
+        cz->min_y = fminf(cz->min_y, cz->polygon[i].y);
+        cz->max_y = fmaxf(cz->max_y, cz->polygon[i].y);
+    }
+
+    // Cells are slightly enlarged so rounding can only add edge cells
+    const float cell = 1.0f / ZONE_MASK_SIZE;
+    const float margin = cell * 0.01f;
+
+    for (int row = 0; row < ZONE_MASK_SIZE; row++) {
+        float ry0 = row * cell - margin;
+        float ry1 = (row + 1) * cell + margin;
+
+        for (int col = 0; col < ZONE_MASK_SIZE; col++) {
+            float rx0 = col * cell - margin;
+            float rx1 = (col + 1) * cell + margin;
+
+            bool touched = false;
+            for (int i = 0, j = cz->polygon_count - 1; i < cz->polygon_count && !touched; j = i++) {
+                touched = segment_touches_rect(cz->polygon[j].x, cz->polygon[j].y,
+                                               cz->polygon[i].x, cz->polygon[i].y,
+                                               rx0, ry0, rx1, ry1);
+            }
+
+            if (touched) {
+                cz->edge[row] |= (uint64_t)1 << col;
+            } else if (point_in_polygon((col + 0.5f) * cell, (row + 0.5f) * cell,
+                                        cz->polygon, cz->polygon_count)) {
+                cz->inside[row] |= (uint64_t)1 << col;
+            }
+        }
+    }
+}
+
+/**
+ * Check if a point is inside a compiled zone
+ */
+static bool point_in_compiled_zone(float x, float y, const compiled_zone_t *cz) {
+    // Bounding box rejection
+    if (x < cz->min_x || x > cz->max_x || y < cz->min_y || y > cz->max_y) {
         return false;
     }
 
+    // Points outside the mask area use the exact test
+    if (x < 0.0f || x >= 1.0f || y < 0.0f || y >= 1.0f) {
+        return point_in_polygon(x, y, cz->polygon, cz->polygon_count);
+    }
+
+    int col = (int)(x * ZONE_MASK_SIZE);
+    int row = (int)(y * ZONE_MASK_SIZE);
+    uint64_t bit = (uint64_t)1 << col;
+
+    if (cz->edge[row] & bit) {
+        return point_in_polygon(x, y, cz->polygon, cz->polygon_count);
+    }
+    return (cz->inside[row] & bit) != 0;
+}
+
+/**
+ * Check if a detection's center point is within a zone
+ */
+static bool detection_in_zone(const detection_t *detection, const compiled_zone_t *zone) {
     // Calculate center point of detection bounding box
     float center_x = detection->x + (detection->width / 2.0f);
     float center_y = detection->y + (detection->height / 2.0f);
 
-    // Check if center is in polygon
-    return point_in_polygon(center_x, center_y, zone->polygon, zone->polygon_count);
+    return point_in_compiled_zone(center_x, center_y, zone);
 }
 
 /**
  * Check if a detection's class matches the zone's filter
  */
-static bool detection_class_matches(const detection_t *detection, const detection_zone_t *zone) {
+static bool detection_class_matches(const detection_t *detection, const compiled_zone_t *zone) {
     // If no filter is set, all classes match
-    if (!zone->filter_classes || zone->filter_classes[0] == '\0') {
+    if (zone->class_count == 0) {
         return true;
     }
 
-    // Check if detection label is in the comma-separated filter list
-    char filter_copy[256];
-    strncpy(filter_copy, zone->filter_classes, sizeof(filter_copy) - 1);
-    filter_copy[sizeof(filter_copy) - 1] = '\0';
-
-    char *token = strtok(filter_copy, ",");
-    while (token) {
-        // Trim whitespace
-        while (*token == ' ') token++;
-        char *end = token + strlen(token) - 1;
-        while (end > token && *end == ' ') {
-            *end = '\0';
-            end--;
-        }
-
-        // Check if it matches
-        if (strcmp(token, detection->label) == 0) {
+    for (int i = 0; i < zone->class_count; i++) {
+        if (strcmp(zone->classes[i], detection->label) == 0) {
             return true;
         }
-
-        token = strtok(NULL, ",");
     }
 
     return false;
@@ -82,7 +249,7 @@ static bool detection_class_matches(const detection_t *detection, const detectio
 /**
  * Check if a detection meets the zone's confidence threshold
  */
-static bool detection_meets_confidence(const detection_t *detection, const detection_zone_t *zone) {
+static bool detection_meets_confidence(const detection_t *detection, const compiled_zone_t *zone) {
     // If no minimum confidence is set (0.0), accept all
     if (zone->min_confidence <= 0.0f) {
         return true;
@@ -92,68 +259,119 @@ static bool detection_meets_confidence(const detection_t *detection, const detec
 }
 
 /**
- * Filter detections based on zones for a stream
+ * Find the cache entry of a stream. Must be called with the cache lock held.
  */
-int filter_detections_by_zones(const char *stream_name, detection_result_t *result) {
-    if (!stream_name || !result) {
-        log_error("Invalid parameters for filter_detections_by_zones");
-        return -1;
+static zone_cache_entry_t *find_cache_entry(const char *stream_name) {
+    for (zone_cache_entry_t *entry = zone_cache; entry; entry = entry->next) {
+        if (strcmp(entry->stream_name, stream_name) == 0) {
+            return entry;
+        }
     }
+    return NULL;
+}
 
-    // If no detections, nothing to filter
-    if (result->count == 0) {
-        return 0;
+static void free_cache_entry(zone_cache_entry_t *entry) {
+    if (entry) {
+        free(entry->zones);
+        free(entry);
     }
+}
 
-    // Get zones for this stream
-    detection_zone_t zones[MAX_ZONES_PER_STREAM];
-    int zone_count = get_detection_zones(stream_name, zones, MAX_ZONES_PER_STREAM);
+/**
+ * Load and compile the enabled zones of a stream from the database
+ *
+ * @return New cache entry, or NULL on error
+ */
+static zone_cache_entry_t *load_cache_entry(const char *stream_name) {
+    detection_zone_t *zones = malloc(MAX_ZONES_PER_STREAM * sizeof(detection_zone_t));
+    if (!zones) {
+        log_error("Failed to allocate memory for detection zones");
+        return NULL;
+    }
 
+    int zone_count = get_detection_zones(stream_name, zones, MAX_ZONES_PER_STREAM);
     if (zone_count < 0) {
         log_error("Failed to get detection zones for stream %s", stream_name);
-        return -1;
+        free(zones);
+        return NULL;
     }
 
-    // If no zones are configured, don't filter (allow all detections)
-    if (zone_count == 0) {
-        log_debug("No zones configured for stream %s, allowing all detections", stream_name);
-        return 0;
+    zone_cache_entry_t *entry = calloc(1, sizeof(zone_cache_entry_t));
+    if (!entry) {
+        free(zones);
+        return NULL;
     }
+    strncpy(entry->stream_name, stream_name, sizeof(entry->stream_name) - 1);
 
-    // Count enabled zones
-    int enabled_zone_count = 0;
+    int enabled_count = 0;
     for (int i = 0; i < zone_count; i++) {
         if (zones[i].enabled) {
-            enabled_zone_count++;
+            enabled_count++;
         }
     }
 
-    // If no enabled zones, don't filter (allow all detections)
-    if (enabled_zone_count == 0) {
-        log_debug("No enabled zones for stream %s, allowing all detections", stream_name);
-        return 0;
+    if (enabled_count > 0) {
+        entry->zones = malloc(enabled_count * sizeof(compiled_zone_t));
+        if (!entry->zones) {
+            free(entry);
+            free(zones);
+            return NULL;
+        }
+        for (int i = 0; i < zone_count; i++) {
+            if (zones[i].enabled) {
+                compile_zone(&entry->zones[entry->zone_count++], &zones[i]);
+            }
+        }
     }
 
-    log_info("Filtering %d detections using %d enabled zones for stream %s",
-             result->count, enabled_zone_count, stream_name);
+    free(zones);
+
+    log_info("Cached %d enabled detection zones for stream %s", entry->zone_count, stream_name);
+    return entry;
+}
+
+/**
+ * Invalidate cached zones
+ */
+void invalidate_zone_cache(const char *stream_name) {
+    pthread_rwlock_wrlock(&zone_cache_lock);
+
+    zone_cache_generation++;
+
+    zone_cache_entry_t **link = &zone_cache;
+    while (*link) {
+        zone_cache_entry_t *entry = *link;
+        if (!stream_name || strcmp(entry->stream_name, stream_name) == 0) {
+            *link = entry->next;
+            free_cache_entry(entry);
+        } else {
+            link = &entry->next;
+        }
+    }
+
+    pthread_rwlock_unlock(&zone_cache_lock);
+}
+
+/**
+ * Filter detections against the enabled zones of a cache entry.
+ * Must be called with the cache lock held.
+ */
+static void apply_zones(const zone_cache_entry_t *entry, detection_result_t *result) {
+    log_debug("Filtering %d detections using %d enabled zones for stream %s",
+              result->count, entry->zone_count, entry->stream_name);
 
     // Create a filtered result
     detection_result_t filtered;
-    memset(&filtered, 0, sizeof(detection_result_t));
+    filtered.count = 0;
 
     // Check each detection against all zones
     for (int i = 0; i < result->count; i++) {
         detection_t *det = &result->detections[i];
-        bool detection_accepted = false;
-        const char *matched_zone_id = NULL;
+        const compiled_zone_t *matched_zone = NULL;
 
         // Check if detection is in any enabled zone
-        for (int j = 0; j < zone_count; j++) {
-            detection_zone_t *zone = &zones[j];
-
-            if (!zone->enabled) {
-                continue;
-            }
+        for (int j = 0; j < entry->zone_count; j++) {
+            const compiled_zone_t *zone = &entry->zones[j];
 
             // Check if detection is in this zone
             if (!detection_in_zone(det, zone)) {
@@ -175,24 +393,21 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
             }
 
             // Detection passed all checks for this zone
-            detection_accepted = true;
-            matched_zone_id = zone->id;
-            log_info("Detection %s (%.2f%%) accepted by zone %s",
-                    det->label, det->confidence * 100.0f, zone->name);
+            matched_zone = zone;
+            log_debug("Detection %s (%.2f%%) accepted by zone %s",
+                     det->label, det->confidence * 100.0f, zone->name);
             break;
         }
 
         // If detection was accepted by at least one zone, add it to filtered result
-        if (detection_accepted) {
-            memcpy(&filtered.detections[filtered.count], det, sizeof(detection_t));
-            
+        if (matched_zone) {
+            detection_t *out = &filtered.detections[filtered.count];
+            memcpy(out, det, sizeof(detection_t));
+
             // Set the zone_id for this detection
-            if (matched_zone_id) {
-                strncpy(filtered.detections[filtered.count].zone_id, matched_zone_id,
-                       sizeof(filtered.detections[filtered.count].zone_id) - 1);
-                filtered.detections[filtered.count].zone_id[sizeof(filtered.detections[filtered.count].zone_id) - 1] = '\0';
-            }
-            
+            strncpy(out->zone_id, matched_zone->id, sizeof(out->zone_id) - 1);
+            out->zone_id[sizeof(out->zone_id) - 1] = '\0';
+
             filtered.count++;
         } else {
             log_debug("Detection %s (%.2f%%) at [%.2f, %.2f] rejected (not in any enabled zone)",
@@ -201,12 +416,66 @@ int filter_detections_by_zones(const char *stream_name, detection_result_t *resu
         }
     }
 
-    log_info("Zone filtering: %d detections -> %d detections (filtered out %d)",
-             result->count, filtered.count, result->count - filtered.count);
+    log_debug("Zone filtering: %d detections -> %d detections (filtered out %d)",
+              result->count, filtered.count, result->count - filtered.count);
 
     // Replace original result with filtered result
-    memcpy(result, &filtered, sizeof(detection_result_t));
+    result->count = filtered.count;
+    memcpy(result->detections, filtered.detections, filtered.count * sizeof(detection_t));
+}
+
+/**
+ * Filter detections based on zones for a stream
+ */
+int filter_detections_by_zones(const char *stream_name, detection_result_t *result) {
+    if (!stream_name || !result) {
+        log_error("Invalid parameters for filter_detections_by_zones");
+        return -1;
+    }
+
+    // If no detections, nothing to filter
+    if (result->count == 0) {
+        return 0;
+    }
+
+    pthread_rwlock_rdlock(&zone_cache_lock);
+    zone_cache_entry_t *entry = find_cache_entry(stream_name);
+    if (entry) {
+        // No enabled zones means no filtering (allow all detections)
+        if (entry->zone_count > 0) {
+            apply_zones(entry, result);
+        }
+        pthread_rwlock_unlock(&zone_cache_lock);
+        return 0;
+    }
+    unsigned long generation = zone_cache_generation;
+    pthread_rwlock_unlock(&zone_cache_lock);
+
+    // Cache miss, load the zones without holding the lock
+    zone_cache_entry_t *loaded = load_cache_entry(stream_name);
+    if (!loaded) {
+        return -1;
+    }
+
+    pthread_rwlock_wrlock(&zone_cache_lock);
+    entry = find_cache_entry(stream_name);
+    if (!entry && generation == zone_cache_generation) {
+        loaded->next = zone_cache;
+        zone_cache = loaded;
+        entry = loaded;
+        loaded = NULL;
+    } else if (!entry) {
+        // Zones changed while loading, use this copy once but don't cache it
+        entry = loaded;
+    }
+
+    if (entry->zone_count > 0) {
+        apply_zones(entry, result);
+    }
+    pthread_rwlock_unlock(&zone_cache_lock);
+
+    // Not cached: either another thread cached it first or zones changed
+    free_cache_entry(loaded);
 
     return 0;
 }
-
@@ -231,6 +231,31 @@ void mg_handle_auth_logout(struct mg_connection *c, struct mg_http_message *hm)
 
     bool is_api_request = is_post || is_json || requested_with != NULL || accepts_json;
 
+    // End the session on the server too, so the token stops working everywhere
+    struct mg_str *cookie = mg_http_get_header(hm, "Cookie");
+    if (cookie) {
+        char cookie_str[1024] = {0};
+        size_t cookie_len = cookie->len < sizeof(cookie_str) - 1 ? cookie->len : sizeof(cookie_str) - 1;
+        memcpy(cookie_str, cookie->buf, cookie_len);
+        cookie_str[cookie_len] = '\0';
+
+        char *session_start = strstr(cookie_str, "session=");
+        if (session_start) {
+            session_start += 8; // Skip "session="
+            char *session_end = strchr(session_start, ';');
+            if (!session_end) {
+                session_end = session_start + strlen(session_start);
+            }
+
+            char session_token[64] = {0};
+            size_t token_len = session_end - session_start;
+            if (token_len > 0 && token_len < sizeof(session_token)) {
+                memcpy(session_token, session_start, token_len);
+                db_auth_delete_session(session_token);
+            }
+        }
+    }
+
     if (is_api_request) {
         // For API requests, return a JSON success response
         cJSON *response = cJSON_CreateObject();
@@ -2,8 +2,11 @@
 #include "core/config.h"
 #include "core/logger.h"
 #include "database/db_recordings.h"
+#include "video/remux_engine.h"
 #include "web/api_handlers.h"
+#include "web/remux_http.h"
 #include <cjson/cJSON.h>
+#include <fcntl.h>
 #include <dirent.h>
 #include <errno.h>
 #include <stdio.h>
@@ -15,6 +18,19 @@
 
 #define EXPORTS_DIR "local/exports"
 
+// Maximum number of recordings joined into one exported clip
+#define MAX_CLIP_RECORDINGS 100
+
+/**
+ * Connection to answer once a clip job finishes
+ */
+typedef struct {
+  struct mg_mgr *mgr;
+  unsigned long conn_id;
+  bool reply;                // false for async requests, answered at submission
+  char filename[256];
+} clip_job_ctx_t;
+
 void init_clips_module(void) {
   struct stat st = {0};
   if (stat(EXPORTS_DIR, &st) == -1) {
@@ -90,6 +106,69 @@ void mg_handle_delete_clips(struct mg_connection *c,
   }
 }
 
+/**
+ * Completion callback for clip jobs, runs on a remux worker
+ */
+static void clip_job_done(void *opaque, bool success) {
+  clip_job_ctx_t *ctx = (clip_job_ctx_t *)opaque;
+
+  if (ctx->reply) {
+    char json[512];
+    if (success) {
+      snprintf(json, sizeof(json), "{\"success\":true, \"filename\":\"%s\"}",
+               ctx->filename);
+      remux_http_send_json(ctx->mgr, ctx->conn_id, 200, json);
+    } else {
+      log_error("Clip job for %s failed", ctx->filename);
+      remux_http_send_json(ctx->mgr, ctx->conn_id, 500,
+                           "{\"error\":\"Export encoding failed\"}");
+    }
+  }
+
+  free(ctx);
+}
+
+/**
+ * Queue a clip job and answer the request when it is done, or right away with
+ * 202 and the job ID when the client asked for "async": true
+ *
+ * Runs on the event loop, which is never blocked by the remux itself.
+ */
+static void submit_clip_job(struct mg_connection *c, remux_request_t *request,
+                            const char *out_filename, bool async) {
+  clip_job_ctx_t *ctx = calloc(1, sizeof(clip_job_ctx_t));
+  if (!ctx) {
+    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
+                  "{\"error\":\"Out of memory\"}");
+    return;
+  }
+  ctx->mgr = c->mgr;
+  ctx->conn_id = c->id;
+  ctx->reply = !async;
+  strncpy(ctx->filename, out_filename, sizeof(ctx->filename) - 1);
+
+  request->done_cb = clip_job_done;
+  request->opaque = ctx;
+
+  // ctx belongs to the job from here on, it may finish before we return
+  char job_id[64] = {0};
+  if (remux_submit(request, job_id) != 0) {
+    free(ctx);
+    mg_http_reply(c, 503,
+                  "Content-Type: application/json\r\nRetry-After: 5\r\n",
+                  "{\"error\":\"Too many exports in progress\"}");
+    return;
+  }
+
+  log_info("Queued clip job %s for %s", job_id, out_filename);
+
+  if (async) {
+    mg_http_reply(c, 202, "Content-Type: application/json\r\n",
+                  "{\"success\":true, \"filename\":\"%s\", \"job_id\":\"%s\"}",
+                  out_filename, job_id);
+  }
+}
+
 void mg_handle_post_clips_generate(struct mg_connection *c,
                                    struct mg_http_message *hm) {
   cJSON *body = mg_parse_json_body(hm);
@@ -111,9 +190,11 @@ void mg_handle_post_clips_generate(struct mg_connection *c,
     return;
   }
 
-  const char *stream_name = stream_name_json->valuestring;
+  char stream_name[MAX_STREAM_NAME] = {0};
+  strncpy(stream_name, stream_name_json->valuestring, sizeof(stream_name) - 1);
   long start_time = (long)start_time_json->valuedouble;
   long end_time = (long)end_time_json->valuedouble;
+  bool async = cJSON_IsTrue(cJSON_GetObjectItem(body, "async"));
 
   // Validate times
   if (end_time <= start_time) {
@@ -123,24 +204,7 @@ void mg_handle_post_clips_generate(struct mg_connection *c,
     return;
   }
 
-  // 1. Find the recording in DB that covers start_time
-  // We fetch a batch around the start time
-  int count = 0;
-  recording_metadata_t *recs = NULL;
-
-  // We'll define a simpler search: get all recordings for stream, iterate
-  // (inefficient but safe for now) Or use the limit/offset pagination but
-  // sorted by date desc? Let's rely on finding ONE segment.
-
-  // Assuming we have get_recording_metadata_paginated(stream, limit, offset,
-  // &count, &recs) We need to query by time. The current DB API might be
-  // limited. Let's assume we can get latest and search backwards, or use a
-  // custom query if possible? Actually, `get_recording_metadata_paginated`
-  // lists all. Better: let's assume the frontend passes the `recording_id` if
-  // known? The user prompts implies selection from timeline.
-  // PlaybackControlRoom has context. IF the frontend passes `recording_id`,
-  // it's much safer.
-
+  // The frontend passes the recording selected on the timeline
   cJSON *recording_id_json = cJSON_GetObjectItem(body, "recording_id");
 
   char source_path[512] = {0};
@@ -155,10 +219,6 @@ void mg_handle_post_clips_generate(struct mg_connection *c,
       rec_start_time = meta.start_time;
     }
   } else {
-    // Fallback: try to find it (harder without direct SQL access in this C file
-    // context) Let's implement a quick linear scan of recent recordings? No,
-    // that's too slow. Let's error if ID not provided for now, but update
-    // Frontend to provide it.
     cJSON_Delete(body);
     mg_http_reply(c, 400, "Content-Type: application/json\r\n",
                   "{\"error\":\"recording_id is required\"}");
@@ -199,33 +259,66 @@ void mg_handle_post_clips_generate(struct mg_connection *c,
   snprintf(out_full_path, sizeof(out_full_path), "%s/%s", EXPORTS_DIR,
            out_filename);
 
-  // Build FFmpeg command
-  // ffmpeg -ss [offset] -i [input] -t [duration] -c copy [output]
-  // Note: -ss before -i is faster (input seeking) but -ss after -i is more
-  // frame-accurate (output seeking). For "copy", input seeking is usually
-  // keyframe aligned. Output seeking decoding. If we want accurate clips
-  // without re-encoding, we might suffer from keyframe snapping. Re-encoding is
-  // slow on Pi. Let's try copy first. Command: ffmpeg -ss [offset] -i [input]
-  // -t [duration] -c copy -y [output]
+  // Stream copy starting at the keyframe at or before the requested time,
+  // re-encoding would be far too slow on small devices
+  const char *inputs[1] = {source_path};
+  remux_request_t request = {
+      .inputs = inputs,
+      .input_count = 1,
+      .start_offset = (double)ss_offset,
+      .duration = (double)duration,
+      .output_path = out_full_path,
+  };
+
+  submit_clip_job(c, &request, out_filename, async);
+}
 
-  char cmd[1024];
-  snprintf(cmd, sizeof(cmd),
-           "ffmpeg -ss %ld -i \"%s\" -t %ld -c copy -y \"%s\" > /dev/null 2>&1",
-           ss_offset, source_path, duration, out_full_path);
+/**
+ * Copy a file into a directory, keeping its name
+ *
+ * Blocks for the whole copy, so the export handler runs on a worker thread.
+ */
+static int copy_file_to_dir(const char *src_path, const char *filename,
+                            const char *dest_dir) {
+  char dest_path[1024];
+  snprintf(dest_path, sizeof(dest_path), "%s/%s", dest_dir, filename);
+
+  int src_fd = open(src_path, O_RDONLY);
+  if (src_fd < 0) {
+    log_error("Failed to open source file %s: %s", src_path, strerror(errno));
+    return -1;
+  }
 
-  log_info("Executing clip command: %s", cmd);
+  int dest_fd = open(dest_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (dest_fd < 0) {
+    log_error("Failed to open dest file %s: %s", dest_path, strerror(errno));
+    close(src_fd);
+    return -1;
+  }
 
-  int ret = system(cmd);
+  int ret = 0;
+  char buf[65536];
+  ssize_t n;
+  while ((n = read(src_fd, buf, sizeof(buf))) > 0) {
+    if (write(dest_fd, buf, (size_t)n) != n) {
+      log_error("Write error to %s: %s", dest_path, strerror(errno));
+      ret = -1;
+      break;
+    }
+  }
+  if (n < 0) {
+    log_error("Read error from %s: %s", src_path, strerror(errno));
+    ret = -1;
+  }
 
-  if (ret == 0) {
-    // Success
-    mg_http_reply(c, 200, "Content-Type: application/json\r\n",
-                  "{\"success\":true, \"filename\":\"%s\"}", out_filename);
-  } else {
-    log_error("Clipping failed with code %d", ret);
-    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
-                  "{\"error\":\"Encoding failed\"}");
+  close(src_fd);
+  if (close(dest_fd) != 0) {
+    ret = -1;
+  }
+  if (ret != 0) {
+    unlink(dest_path);
   }
+  return ret;
 }
 
 void mg_handle_post_clips_export(struct mg_connection *c,
@@ -262,16 +355,8 @@ void mg_handle_post_clips_export(struct mg_connection *c,
   snprintf(src_full_path, sizeof(src_full_path), "%s/%s", EXPORTS_DIR,
            filename);
 
-  char dest_full_path[1024];
-  snprintf(dest_full_path, sizeof(dest_full_path), "%s/%s", dest_path,
-           filename);
-
-  // Copy command: cp "src" "dest"
-  char cmd[2048];
-  snprintf(cmd, sizeof(cmd), "cp \"%s\" \"%s\"", src_full_path, dest_full_path);
-
-  log_info("Exporting clip: %s", cmd);
-  int ret = system(cmd);
+  log_info("Exporting clip %s to %s", src_full_path, dest_path);
+  int ret = copy_file_to_dir(src_full_path, filename, dest_path);
 
   cJSON_Delete(body);
 
@@ -305,22 +390,47 @@ void mg_handle_post_clips_export_range(struct mg_connection *c,
     return;
   }
 
-  const char *stream_name = stream_name_json->valuestring;
+  char stream_name[MAX_STREAM_NAME] = {0};
+  strncpy(stream_name, stream_name_json->valuestring, sizeof(stream_name) - 1);
   time_t start_time = (time_t)start_time_json->valuedouble;
   time_t end_time = (time_t)end_time_json->valuedouble;
+  bool async = cJSON_IsTrue(cJSON_GetObjectItem(body, "async"));
+  cJSON_Delete(body);
 
   if (end_time <= start_time) {
-    cJSON_Delete(body);
     mg_http_reply(c, 400, "Content-Type: application/json\r\n",
                   "{\"error\":\"Invalid time range: end_time must be after start_time\"}");
     return;
   }
 
-  recording_metadata_t recordings[100];
-  int rec_count = get_recording_metadata(start_time, end_time, stream_name, recordings, 100);
+  recording_metadata_t *recordings =
+      malloc(MAX_CLIP_RECORDINGS * sizeof(recording_metadata_t));
+  if (!recordings) {
+    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
+                  "{\"error\":\"Out of memory\"}");
+    return;
+  }
+
+  int rec_count = get_recording_metadata(start_time, end_time, stream_name,
+                                         recordings, MAX_CLIP_RECORDINGS);
 
-  if (rec_count <= 0) {
-    cJSON_Delete(body);
+  // Recordings come newest first, the clip plays oldest first
+  const char *inputs[MAX_CLIP_RECORDINGS];
+  int input_count = 0;
+  time_t first_start = 0;
+  for (int i = rec_count - 1; i >= 0; i--) {
+    if (access(recordings[i].file_path, F_OK) != 0) {
+      log_warn("Skipping missing file: %s", recordings[i].file_path);
+      continue;
+    }
+    if (input_count == 0) {
+      first_start = recordings[i].start_time;
+    }
+    inputs[input_count++] = recordings[i].file_path;
+  }
+
+  if (input_count == 0) {
+    free(recordings);
     mg_http_reply(c, 404, "Content-Type: application/json\r\n",
                   "{\"error\":\"No recordings found in the specified time range\"}");
     return;
@@ -333,85 +443,84 @@ void mg_handle_post_clips_export_range(struct mg_connection *c,
   char out_full_path[512];
   snprintf(out_full_path, sizeof(out_full_path), "%s/%s", EXPORTS_DIR, out_filename);
 
-  if (rec_count == 1) {
-    recording_metadata_t *rec = &recordings[0];
-    
-    if (access(rec->file_path, F_OK) != 0) {
-      cJSON_Delete(body);
-      log_error("Recording file not found: %s", rec->file_path);
-      mg_http_reply(c, 404, "Content-Type: application/json\r\n",
-                    "{\"error\":\"Recording file not found\"}");
-      return;
-    }
-
-    long ss_offset = start_time - rec->start_time;
-    if (ss_offset < 0) ss_offset = 0;
-    
-    long duration = end_time - start_time;
-    if (duration <= 0) duration = 1;
+  // Trim to the requested range, the cut points snap to keyframes
+  double start_offset = start_time > first_start ? (double)(start_time - first_start) : 0.0;
+  remux_request_t request = {
+      .inputs = inputs,
+      .input_count = input_count,
+      .start_offset = start_offset,
+      .duration = (double)(end_time - start_time),
+      .output_path = out_full_path,
+  };
+
+  log_info("Exporting %d recordings of %s to %s", input_count, stream_name, out_full_path);
+
+  // The request is copied by the engine, the recordings can go
+  submit_clip_job(c, &request, out_filename, async);
+  free(recordings);
+}
 
-    char cmd[1024];
-    snprintf(cmd, sizeof(cmd),
-             "ffmpeg -ss %ld -i \"%s\" -t %ld -c copy -y \"%s\" > /dev/null 2>&1",
-             ss_offset, rec->file_path, duration, out_full_path);
+/**
+ * Extract the job ID from /api/clips/jobs/:job_id
+ */
+static int extract_clip_job_id(struct mg_http_message *hm, char *job_id,
+                               size_t size) {
+  const char *prefix = "/api/clips/jobs/";
+  size_t prefix_len = strlen(prefix);
 
-    log_info("Executing single-file export command: %s", cmd);
-    int ret = system(cmd);
+  if (hm->uri.len <= prefix_len || hm->uri.len - prefix_len >= size) {
+    return -1;
+  }
 
-    cJSON_Delete(body);
+  size_t job_id_len = hm->uri.len - prefix_len;
+  memcpy(job_id, hm->uri.buf + prefix_len, job_id_len);
+  job_id[job_id_len] = '\0';
+  return 0;
+}
 
-    if (ret == 0) {
-      mg_http_reply(c, 200, "Content-Type: application/json\r\n",
-                    "{\"success\":true, \"filename\":\"%s\"}", out_filename);
-    } else {
-      log_error("Export failed with code %d", ret);
-      mg_http_reply(c, 500, "Content-Type: application/json\r\n",
-                    "{\"error\":\"Export encoding failed\"}");
-    }
+void mg_handle_get_clip_job(struct mg_connection *c,
+                            struct mg_http_message *hm) {
+  char job_id[64];
+  if (extract_clip_job_id(hm, job_id, sizeof(job_id)) != 0) {
+    mg_send_json_error(c, 400, "Missing or invalid job ID");
     return;
   }
 
-  char concat_list_path[512];
-  snprintf(concat_list_path, sizeof(concat_list_path), "%s/concat_%ld.txt", 
-           EXPORTS_DIR, (long)time(NULL));
-
-  FILE *concat_file = fopen(concat_list_path, "w");
-  if (!concat_file) {
-    cJSON_Delete(body);
-    log_error("Failed to create concat list file: %s", concat_list_path);
-    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
-                  "{\"error\":\"Failed to create temporary concat file\"}");
+  remux_job_info_t info;
+  if (remux_get_job(job_id, &info) != 0) {
+    mg_http_reply(c, 404, "Content-Type: application/json\r\n",
+                  "{\"error\":\"Job not found\"}");
     return;
   }
 
-  for (int i = 0; i < rec_count; i++) {
-    if (access(recordings[i].file_path, F_OK) == 0) {
-      fprintf(concat_file, "file '%s'\n", recordings[i].file_path);
-    } else {
-      log_warn("Skipping missing file: %s", recordings[i].file_path);
-    }
+  cJSON *json = remux_http_job_to_json(&info);
+  char *json_str = json ? cJSON_PrintUnformatted(json) : NULL;
+  if (!json_str) {
+    cJSON_Delete(json);
+    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
+                  "{\"error\":\"Out of memory\"}");
+    return;
   }
 
-  fclose(concat_file);
-
-  char cmd[1024];
-  snprintf(cmd, sizeof(cmd),
-           "ffmpeg -f concat -safe 0 -i \"%s\" -c copy -y \"%s\" > /dev/null 2>&1",
-           concat_list_path, out_full_path);
-
-  log_info("Executing multi-file export command: %s", cmd);
-  int ret = system(cmd);
-
-  unlink(concat_list_path);
+  mg_http_reply(c, 200, "Content-Type: application/json\r\n", "%s", json_str);
+  free(json_str);
+  cJSON_Delete(json);
+}
 
-  cJSON_Delete(body);
+void mg_handle_delete_clip_job(struct mg_connection *c,
+                               struct mg_http_message *hm) {
+  char job_id[64];
+  if (extract_clip_job_id(hm, job_id, sizeof(job_id)) != 0) {
+    mg_send_json_error(c, 400, "Missing or invalid job ID");
+    return;
+  }
 
-  if (ret == 0) {
-    mg_http_reply(c, 200, "Content-Type: application/json\r\n",
-                  "{\"success\":true, \"filename\":\"%s\"}", out_filename);
-  } else {
-    log_error("Multi-file export failed with code %d", ret);
-    mg_http_reply(c, 500, "Content-Type: application/json\r\n",
-                  "{\"error\":\"Export encoding failed\"}");
+  if (remux_cancel(job_id) != 0) {
+    mg_http_reply(c, 404, "Content-Type: application/json\r\n",
+                  "{\"error\":\"No running job with this ID\"}");
+    return;
   }
+
+  mg_http_reply(c, 200, "Content-Type: application/json\r\n",
+                "{\"success\":true}");
 }
@@ -9,7 +9,8 @@ void init_clips_module(void);
 // Handle clip generation request
 // POST /api/clips/generate
 // Body: { "stream_name": "...", "start_time": 1234567890, "end_time":
-// 1234567899 }
+// 1234567899, "recording_id": 42, "async": false }
+// Replies when the clip is written, or at once with 202 and a job_id if async
 void mg_handle_post_clips_generate(struct mg_connection *c,
                                    struct mg_http_message *hm);
 
@@ -26,10 +27,20 @@ void mg_handle_post_clips_export(struct mg_connection *c,
 
 // Handle time range video export (multiple segments)
 // POST /api/clips/export-range
-// Body: { "stream_name": "...", "start_time": 1234567890, "end_time": 1234567899 }
+// Body: { "stream_name": "...", "start_time": 1234567890, "end_time": 1234567899,
+// "async": false }
 void mg_handle_post_clips_export_range(struct mg_connection *c,
                                        struct mg_http_message *hm);
 
+// Handle clip job progress request
+// GET /api/clips/jobs/:job_id
+void mg_handle_get_clip_job(struct mg_connection *c, struct mg_http_message *hm);
+
+// Handle clip job cancellation
+// DELETE /api/clips/jobs/:job_id
+void mg_handle_delete_clip_job(struct mg_connection *c,
+                               struct mg_http_message *hm);
+
 void mg_handle_delete_clips(struct mg_connection *c,
                             struct mg_http_message *hm);
 
@@ -16,6 +16,7 @@
 #include "web/api_handlers.h"
 #include "web/api_handlers_timeline.h" // For get_timeline_segments
 #include "web/mongoose_adapter.h"
+#include "web/remux_http.h"
 
 // Function to handle getting removable storage devices
 void mg_handle_get_storage_removable(struct mg_connection *c,
@@ -102,6 +103,48 @@ void mg_handle_get_storage_removable(struct mg_connection *c,
                 "%s", response);
 }
 
+/**
+ * Export waiting for its remux job
+ */
+typedef struct {
+  struct mg_mgr *mgr;
+  unsigned long conn_id;
+  int total;
+  char destination[512];
+  char output[1024];
+} export_ctx_t;
+
+/**
+ * Completion callback for export jobs, runs on a remux worker
+ */
+static void export_done(void *opaque, bool success) {
+  export_ctx_t *ctx = (export_ctx_t *)opaque;
+
+  if (success) {
+    char response[2048];
+    snprintf(response, sizeof(response),
+             "{\"success\":true,\"copied\":1,\"failed\":0,\"total\":%d,"
+             "\"destination\":\"%s\",\"output\":\"%s\"}",
+             ctx->total, ctx->destination, ctx->output);
+    remux_http_send_json(ctx->mgr, ctx->conn_id, 200, response);
+
+    log_info("Export completed successfully: %d recordings concatenated into %s",
+             ctx->total, ctx->output);
+  } else {
+    remux_http_send_json(ctx->mgr, ctx->conn_id, 500,
+                         "{\"success\":false,\"error\":\"Concatenation failed\"}");
+    log_error("Export into %s failed", ctx->output);
+  }
+
+  log_info("*******************************************************************"
+           "****");
+  log_info("************************ EXPORT FINISHED "
+           "******************************");
+  log_info("*******************************************************************"
+           "****");
+  free(ctx);
+}
+
 // Function to handle video export
 void mg_handle_post_export(struct mg_connection *c,
                            struct mg_http_message *hm) {
@@ -205,86 +248,59 @@ void mg_handle_post_export(struct mg_connection *c,
 
   log_info("Found %d recordings to export for stream %s", count, stream_name);
 
-  // Create a file list for ffmpeg concat
-  char playlist_path[512];
-  snprintf(playlist_path, sizeof(playlist_path), "/tmp/export_playlist_%ld.txt",
-           (long)time(NULL));
-
-  FILE *fp = fopen(playlist_path, "w");
-  if (!fp) {
+  // Generate output filename with timestamp
+  export_ctx_t *ctx = calloc(1, sizeof(export_ctx_t));
+  const char **inputs = malloc((size_t)count * sizeof(char *));
+  if (!ctx || !inputs) {
+    free(ctx);
+    free(inputs);
     free(recordings);
     cJSON_Delete(json);
     free(body_str);
-    log_error("Failed to create playlist file: %s", playlist_path);
-    mg_send_json_error(c, 500, "Failed to create playlist file");
+    mg_send_json_error(c, 500, "Memory allocation failed");
     return;
   }
+  ctx->mgr = c->mgr;
+  ctx->conn_id = c->id;
+  ctx->total = count;
+  snprintf(ctx->destination, sizeof(ctx->destination), "%s", device_path);
+  snprintf(ctx->output, sizeof(ctx->output), "%s/%s_export_%ld_%ld.mp4",
+           device_path, stream_name, (long)start_time, (long)end_time);
 
-  // Write all recording file paths to the playlist
   for (int i = 0; i < count; i++) {
-    fprintf(fp, "file '%s'\n", recordings[i].file_path);
-    log_info("Adding to playlist [%d/%d]: %s", i + 1, count,
+    inputs[i] = recordings[i].file_path;
+    log_info("Adding to export [%d/%d]: %s", i + 1, count,
              recordings[i].file_path);
   }
-  fclose(fp);
-
-  // Generate output filename with timestamp
-  char output_filename[1024];
-  snprintf(output_filename, sizeof(output_filename), "%s/%s_export_%ld_%ld.mp4",
-           device_path, stream_name, (long)start_time, (long)end_time);
 
-  // Build ffmpeg command for concatenation
-  // Using -c copy for stream copy (no re-encoding, fast and lossless)
-  char cmd[4096];
-  snprintf(cmd, sizeof(cmd),
-           "ffmpeg -y -f concat -safe 0 -i \"%s\" -c copy \"%s\" 2>&1",
-           playlist_path, output_filename);
+  // Stream copy (no re-encoding, fast and lossless) on the remux pool, the
+  // response is sent from export_done once the file is written
+  remux_request_t request = {
+      .inputs = inputs,
+      .input_count = count,
+      .output_path = ctx->output,
+      .done_cb = export_done,
+      .opaque = ctx,
+  };
 
-  log_info("Running ffmpeg concat: %s", cmd);
+  log_info("Queueing export of %d recordings into %s", count, ctx->output);
 
-  // Execute ffmpeg
-  int result = system(cmd);
-
-  // Clean up playlist file
-  unlink(playlist_path);
+  char job_id[64] = {0};
+  int result = remux_submit(&request, job_id);
 
+  free(inputs);
   free(recordings);
   cJSON_Delete(json);
   free(body_str);
 
-  if (result == 0) {
-    // Success response
-    char response[1024];
-    snprintf(response, sizeof(response),
-             "{\"success\":true,\"copied\":1,\"failed\":0,\"total\":%d,"
-             "\"destination\":\"%s\",\"output\":\"%s\"}",
-             count, device_path, output_filename);
-
-    mg_http_reply(c, 200,
+  if (result != 0) {
+    free(ctx);
+    mg_http_reply(c, 503,
                   "Content-Type: application/json\r\n"
                   "Connection: close\r\n",
-                  "%s", response);
-
-    log_info(
-        "Export completed successfully: %d recordings concatenated into %s",
-        count, output_filename);
-  } else {
-    char response[512];
-    snprintf(response, sizeof(response),
-             "{\"success\":false,\"error\":\"FFmpeg concatenation failed\"}");
-
-    mg_http_reply(c, 500,
-                  "Content-Type: application/json\r\n"
-                  "Connection: close\r\n",
-                  "%s", response);
-
-    log_error("FFmpeg export failed with exit code: %d", result);
+                  "{\"success\":false,\"error\":\"Too many exports in progress\"}");
+    return;
   }
 
-  log_info("*******************************************************************"
-           "****");
-  log_info("************************ EXPORT FINISHED "
-           "******************************");
-  log_info("*******************************************************************"
-           "****");
+  log_info("Export queued as job %s", job_id);
 }
@@ -5,7 +5,6 @@
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
-#include <curl/curl.h>
 
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
@@ -20,34 +19,18 @@
 #include "video/go2rtc/go2rtc_stream.h"
 #include "web/mongoose_server_multithreading.h"
 #include "web/api_handlers_go2rtc_proxy.h"
+#include "web/go2rtc_proxy_stream.h"
 
 // Buffer size for URLs
 #define URL_BUFFER_SIZE 2048
 
-// Structure to hold response data from curl
-struct curl_response {
-    char *data;
-    size_t size;
-};
-
-// Callback function for curl to write response data
-static size_t write_callback(void *contents, size_t size, size_t nmemb, void *userp) {
-    size_t realsize = size * nmemb;
-    struct curl_response *resp = (struct curl_response *)userp;
-
-    char *ptr = realloc(resp->data, resp->size + realsize + 1);
-    if (!ptr) {
-        log_error("Failed to allocate memory for curl response");
-        return 0;
-    }
-
-    resp->data = ptr;
-    memcpy(&(resp->data[resp->size]), contents, realsize);
-    resp->size += realsize;
-    resp->data[resp->size] = 0;
-
-    return realsize;
-}
+// Response headers of proxied WebRTC requests
+#define WEBRTC_PROXY_HEADERS \
+    "Access-Control-Allow-Origin: *\r\n" \
+    "Access-Control-Allow-Methods: POST, OPTIONS\r\n" \
+    "Access-Control-Allow-Headers: Content-Type, Authorization, Origin, X-Requested-With, Accept\r\n" \
+    "Access-Control-Allow-Credentials: true\r\n" \
+    "Connection: close\r\n"
 
 /**
  * @brief Handler for POST /api/webrtc
@@ -67,16 +50,13 @@ void mg_handle_go2rtc_webrtc_offer(struct mg_connection *c, struct mg_http_messa
 /**
  * @brief Worker function for POST /api/webrtc
  *
- * This function is called by the multithreading system to handle WebRTC offer requests.
+ * Starts proxying WebRTC offer requests to go2rtc. Must be called on the
+ * event loop, which drives the proxied transfer.
  */
 void mg_handle_go2rtc_webrtc_offer_worker(struct mg_connection *c, struct mg_http_message *hm) {
     // Variables for resources that need cleanup
     struct mg_str *src_param = NULL;
     char *param_value = NULL;
-    char *offer = NULL;
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    struct curl_response response = {0};
 
     // Check authentication
     http_server_t *server = (http_server_t *)c->fn_data;
@@ -144,32 +124,9 @@ void mg_handle_go2rtc_webrtc_offer_worker(struct mg_connection *c, struct mg_htt
 
     log_info("Stream found: '%s'", trimmed_name);
 
-    // Get the request body (WebRTC offer)
-    log_info("WebRTC offer length: %zu", hm->body.len);
-
-    // Create a null-terminated copy of the request body
-    offer = malloc(hm->body.len + 1);
-    if (!offer) {
-        log_error("Failed to allocate memory for WebRTC offer");
-        mg_send_json_error(c, 500, "Internal server error");
-        goto cleanup;
-    }
-
-    memcpy(offer, hm->body.buf, hm->body.len);
-    offer[hm->body.len] = '\0';
-
     // Log the first 100 characters of the offer for debugging
-    char offer_preview[101] = {0};
-    strncpy(offer_preview, offer, 100);
-    log_info("WebRTC offer preview: %s", offer_preview);
-
-    // Proxy the request to go2rtc API
-    curl = curl_easy_init();
-    if (!curl) {
-        log_error("Failed to initialize curl");
-        mg_send_json_error(c, 500, "Failed to initialize curl");
-        goto cleanup;
-    }
+    log_info("WebRTC offer length: %zu", hm->body.len);
+    log_info("WebRTC offer preview: %.*s", (int)(hm->body.len < 100 ? hm->body.len : 100), hm->body.buf);
 
     // Construct the URL for the go2rtc API
     char url[URL_BUFFER_SIZE];
@@ -179,101 +136,14 @@ void mg_handle_go2rtc_webrtc_offer_worker(struct mg_connection *c, struct mg_htt
     mg_url_encode(trimmed_name, strlen(trimmed_name), encoded_name, sizeof(encoded_name));
     snprintf(url, sizeof(url), "http://localhost:1984/api/webrtc?src=%s", encoded_name);
 
-    // Set curl options
-    if (curl_easy_setopt(curl, CURLOPT_URL, url) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_URL");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set a connection timeout to prevent hanging on network issues
-    if (curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_CONNECTTIMEOUT");
-        mg_send_json_error(c, 500, "Failed to set curl options");
+    // Proxy the request to go2rtc API, the answer is streamed back as it arrives
+    if (go2rtc_proxy_stream_start(c, url, "application/sdp", hm->body.buf, hm->body.len,
+                                  10L, WEBRTC_PROXY_HEADERS) != 0) {
+        mg_send_json_error(c, 503, "Too many proxied requests");
         goto cleanup;
     }
 
-    // Set POST fields directly from the request body
-    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDS, offer) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_POSTFIELDS");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set POST field size
-    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)hm->body.len) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_POSTFIELDSIZE");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_WRITEFUNCTION");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_WRITEDATA");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L) != CURLE_OK) { // 10 second timeout
-        log_error("Failed to set CURLOPT_TIMEOUT");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set content type header only, let curl handle Content-Length
-    headers = curl_slist_append(headers, "Content-Type: application/sdp");
-
-    if (!headers) {
-        log_error("Failed to create headers list");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_HTTPHEADER");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Perform the request
-    CURLcode res = curl_easy_perform(curl);
-
-    // Check for errors
-    if (res != CURLE_OK) {
-        log_error("curl_easy_perform() failed: %s", curl_easy_strerror(res));
-        mg_send_json_error(c, 500, "Failed to proxy request to go2rtc API");
-        goto cleanup;
-    }
-
-    // Get HTTP response code
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-
-    // Send the response back to the client
-    if (http_code == 200 && response.data) {
-        // Log the response for debugging
-        log_info("Response from go2rtc: %s", response.data);
-
-        // Set CORS headers and send the response
-        mg_http_reply(c, 200,
-                     "Content-Type: application/sdp\r\n"
-                     "Access-Control-Allow-Origin: *\r\n"
-                     "Access-Control-Allow-Methods: POST, OPTIONS\r\n"
-                     "Access-Control-Allow-Headers: Content-Type, Authorization, Origin, X-Requested-With, Accept\r\n"
-                     "Access-Control-Allow-Credentials: true\r\n"
-                     "Connection: close\r\n",
-                     "%s", response.data ? response.data : "{}");
-    } else {
-        log_error("go2rtc API returned error: %ld", http_code);
-        mg_send_json_error(c, (int)http_code, response.data ? response.data : "Error from go2rtc API");
-    }
-
-    log_info("Successfully handled WebRTC offer request for stream: %s", trimmed_name);
+    log_info("Proxying WebRTC offer request for stream: %s", trimmed_name);
 
 cleanup:
     // Free all allocated resources
@@ -283,18 +153,6 @@ cleanup:
     if (param_value) {
         free(param_value);
     }
-    if (offer) {
-        free(offer);
-    }
-    if (headers) {
-        curl_slist_free_all(headers);
-    }
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
-    if (response.data) {
-        free(response.data);
-    }
 }
 
 /**
@@ -315,16 +173,13 @@ void mg_handle_go2rtc_webrtc_ice(struct mg_connection *c, struct mg_http_message
 /**
  * @brief Worker function for POST /api/webrtc/ice
  *
- * This function is called by the multithreading system to handle WebRTC ICE candidate requests.
+ * Starts proxying WebRTC ICE candidate requests to go2rtc. Must be called on the
+ * event loop, which drives the proxied transfer.
  */
 void mg_handle_go2rtc_webrtc_ice_worker(struct mg_connection *c, struct mg_http_message *hm) {
     // Variables for resources that need cleanup
     struct mg_str *src_param = NULL;
     char *param_value = NULL;
-    char *ice_candidate = NULL;
-    CURL *curl = NULL;
-    struct curl_slist *headers = NULL;
-    struct curl_response response = {0};
 
     // Check authentication
     http_server_t *server = (http_server_t *)c->fn_data;
@@ -415,32 +270,9 @@ void mg_handle_go2rtc_webrtc_ice_worker(struct mg_connection *c, struct mg_http_
 
     log_info("WebRTC ICE request for stream: %s", decoded_name);
 
-    // Get the request body (ICE candidate)
-    log_info("ICE candidate length: %zu", hm->body.len);
-
-    // Create a null-terminated copy of the request body
-    ice_candidate = malloc(hm->body.len + 1);
-    if (!ice_candidate) {
-        log_error("Failed to allocate memory for ICE candidate");
-        mg_send_json_error(c, 500, "Internal server error");
-        goto cleanup;
-    }
-
-    memcpy(ice_candidate, hm->body.buf, hm->body.len);
-    ice_candidate[hm->body.len] = '\0';
-
     // Log the first 100 characters of the ICE candidate for debugging
-    char ice_preview[101] = {0};
-    strncpy(ice_preview, ice_candidate, 100);
-    log_info("ICE candidate preview: %s", ice_preview);
-
-    // Proxy the request to go2rtc API
-    curl = curl_easy_init();
-    if (!curl) {
-        log_error("Failed to initialize curl");
-        mg_send_json_error(c, 500, "Failed to initialize curl");
-        goto cleanup;
-    }
+    log_info("ICE candidate length: %zu", hm->body.len);
+    log_info("ICE candidate preview: %.*s", (int)(hm->body.len < 100 ? hm->body.len : 100), hm->body.buf);
 
     // Construct the URL for the go2rtc API
     char url[URL_BUFFER_SIZE];
@@ -450,94 +282,14 @@ void mg_handle_go2rtc_webrtc_ice_worker(struct mg_connection *c, struct mg_http_
     mg_url_encode(decoded_name, strlen(decoded_name), encoded_name, sizeof(encoded_name));
     snprintf(url, sizeof(url), "http://localhost:1984/api/webrtc/ice?src=%s", encoded_name);
 
-    // Set curl options
-    if (curl_easy_setopt(curl, CURLOPT_URL, url) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_URL");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set POST fields directly from the request body
-    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDS, ice_candidate) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_POSTFIELDS");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set POST field size
-    if (curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)hm->body.len) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_POSTFIELDSIZE");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_WRITEFUNCTION");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_WRITEDATA");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_TIMEOUT, 5L) != CURLE_OK) { // 5 second timeout
-        log_error("Failed to set CURLOPT_TIMEOUT");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Set content type header only, let curl handle Content-Length
-    headers = curl_slist_append(headers, "Content-Type: application/json");
-
-    if (!headers) {
-        log_error("Failed to create headers list");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    if (curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers) != CURLE_OK) {
-        log_error("Failed to set CURLOPT_HTTPHEADER");
-        mg_send_json_error(c, 500, "Failed to set curl options");
-        goto cleanup;
-    }
-
-    // Perform the request
-    CURLcode res = curl_easy_perform(curl);
-
-    // Check for errors
-    if (res != CURLE_OK) {
-        log_error("curl_easy_perform() failed: %s", curl_easy_strerror(res));
-        mg_send_json_error(c, 500, "Failed to proxy request to go2rtc API");
+    // Proxy the request to go2rtc API, the answer is streamed back as it arrives
+    if (go2rtc_proxy_stream_start(c, url, "application/json", hm->body.buf, hm->body.len,
+                                  5L, WEBRTC_PROXY_HEADERS) != 0) {
+        mg_send_json_error(c, 503, "Too many proxied requests");
         goto cleanup;
     }
 
-    // Get HTTP response code
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-
-    // Send the response back to the client
-    if (http_code == 200) {
-        // Log the response for debugging
-        log_info("ICE response from go2rtc: %s", response.data ? response.data : "(empty)");
-
-        // Set CORS headers and send the response
-        mg_http_reply(c, 200,
-                     "Content-Type: application/json\r\n"
-                     "Access-Control-Allow-Origin: *\r\n"
-                     "Access-Control-Allow-Methods: POST, OPTIONS\r\n"
-                     "Access-Control-Allow-Headers: Content-Type, Authorization, Origin, X-Requested-With, Accept\r\n"
-                     "Access-Control-Allow-Credentials: true\r\n"
-                     "Connection: close\r\n",
-                     "%s", response.data ? response.data : "{}");
-    } else {
-        log_error("go2rtc API returned error: %ld", http_code);
-        mg_send_json_error(c, (int)http_code, response.data ? response.data : "Error from go2rtc API");
-    }
-
-    log_info("Successfully handled WebRTC ICE request for stream: %s", decoded_name);
+    log_info("Proxying WebRTC ICE request for stream: %s", decoded_name);
 
 cleanup:
     // Free all allocated resources
@@ -547,18 +299,6 @@ cleanup:
     if (param_value) {
         free(param_value);
     }
-    if (ice_candidate) {
-        free(ice_candidate);
-    }
-    if (headers) {
-        curl_slist_free_all(headers);
-    }
-    if (curl) {
-        curl_easy_cleanup(curl);
-    }
-    if (response.data) {
-        free(response.data);
-    }
 }
 
 /**
@@ -22,6 +22,8 @@
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
 #include "web/http_server.h"
+#include "web/mongoose_server_multithreading.h"
+#include "database/db_detection_ingest.h"
 #include "core/logger.h"
 #include "core/config.h"
 #include "mongoose.h"
@@ -175,6 +177,46 @@ void mg_handle_get_health(struct mg_connection *c, struct mg_http_message *hm) {
     cJSON_AddNumberToObject(health, "totalRequests", g_total_requests);
     cJSON_AddNumberToObject(health, "failedRequests", g_failed_requests);
 
+    // Add worker pool metrics
+    mg_worker_pool_stats_t pool_stats;
+    mg_worker_pool_get_stats(&pool_stats);
+    cJSON *pool = cJSON_CreateObject();
+    if (pool) {
+        cJSON_AddNumberToObject(pool, "threads", pool_stats.num_threads);
+        cJSON_AddNumberToObject(pool, "activeWorkers", pool_stats.active_workers);
+        cJSON_AddNumberToObject(pool, "queueDepth", pool_stats.queue_depth);
+        cJSON_AddNumberToObject(pool, "maxQueueDepth", pool_stats.max_queue_depth);
+        cJSON_AddNumberToObject(pool, "completed", (double)pool_stats.completed);
+        cJSON_AddNumberToObject(pool, "rejected", (double)pool_stats.rejected);
+        cJSON_AddNumberToObject(pool, "avgQueueWaitMs", pool_stats.avg_queue_wait_ms);
+        cJSON_AddNumberToObject(pool, "maxQueueWaitMs", pool_stats.max_queue_wait_ms);
+        cJSON_AddNumberToObject(pool, "avgExecMs", pool_stats.avg_exec_ms);
+        cJSON_AddNumberToObject(pool, "maxExecMs", pool_stats.max_exec_ms);
+        cJSON_AddItemToObject(health, "workerPool", pool);
+    }
+
+    // Add detection ingest metrics
+    detection_ingest_stats_t ingest_stats;
+    get_detection_ingest_stats(&ingest_stats);
+    cJSON *ingest = cJSON_CreateObject();
+    if (ingest) {
+        cJSON_AddBoolToObject(ingest, "running", ingest_stats.running != 0);
+        cJSON_AddNumberToObject(ingest, "queuedRows", ingest_stats.queued_rows);
+        cJSON_AddNumberToObject(ingest, "maxRows", ingest_stats.max_rows);
+        cJSON_AddNumberToObject(ingest, "rowsWritten", (double)ingest_stats.rows_written);
+        cJSON_AddNumberToObject(ingest, "batchesWritten", (double)ingest_stats.batches_written);
+        cJSON_AddNumberToObject(ingest, "failedBatches", (double)ingest_stats.failed_batches);
+        cJSON_AddNumberToObject(ingest, "overflowRows", (double)ingest_stats.overflow_rows);
+        cJSON_AddNumberToObject(ingest, "lastBatchRows", ingest_stats.last_batch_rows);
+        cJSON_AddNumberToObject(ingest, "maxBatchRows", ingest_stats.max_batch_rows);
+        cJSON_AddNumberToObject(ingest, "avgBatchRows", ingest_stats.avg_batch_rows);
+        cJSON_AddNumberToObject(ingest, "lagMs", ingest_stats.lag_ms);
+        cJSON_AddNumberToObject(ingest, "lastLagMs", ingest_stats.last_lag_ms);
+        cJSON_AddNumberToObject(ingest, "maxLagMs", ingest_stats.max_lag_ms);
+        cJSON_AddNumberToObject(ingest, "lastCommitMs", ingest_stats.last_commit_ms);
+        cJSON_AddItemToObject(health, "detectionIngest", ingest);
+    }
+
     // Add timestamp
     char timestamp[32];
     time_t now = time(NULL);
@@ -250,31 +250,11 @@ void mg_handle_onvif_discovery_worker(struct mg_connection *c, struct mg_http_me
 void mg_handle_post_discover_onvif_devices(struct mg_connection *c, struct mg_http_message *hm) {
     log_info("Handling POST /api/onvif/discovery/discover request");
     
-    // Create a thread data structure
-    struct mg_thread_data *data = calloc(1, sizeof(struct mg_thread_data));
-    if (!data) {
-        log_error("Failed to allocate memory for thread data");
-        mg_http_reply(c, 500, "", "Internal Server Error\n");
+    // Hand the request to the worker pool (errors, including 503, are answered by the call)
+    if (!mg_submit_request_to_worker(c, hm, mg_handle_onvif_discovery_worker, MG_TASK_PRIORITY_BULK)) {
         return;
     }
     
-    // Copy the HTTP message
-    data->message = mg_strdup(hm->message);
-    if (data->message.len == 0) {
-        log_error("Failed to duplicate HTTP message");
-        free(data);
-        mg_http_reply(c, 500, "", "Internal Server Error\n");
-        return;
-    }
-    
-    // Set connection ID, manager, and handler function
-    data->conn_id = c->id;
-    data->mgr = c->mgr;
-    data->handler_func = mg_handle_onvif_discovery_worker;
-    
-    // Start thread
-    mg_start_thread(mg_thread_function, data);
-    
     log_info("ONVIF discovery request is being handled in a worker thread");
 }
 
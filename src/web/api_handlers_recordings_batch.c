@@ -19,6 +19,7 @@
 #include "mongoose.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "storage/storage_manager_streams_cache.h"
 #include "web/mongoose_server_multithreading.h"
 #include <pthread.h>
 
@@ -98,6 +99,7 @@ static void *batch_delete_worker_thread(void *arg) {
                             // File deletion failed but DB entry is already removed
                         } else {
                             log_info("Deleted recording file: %s", file_path_copy);
+                            stream_storage_cache_remove_file(file_path_copy, (uint64_t)st.st_size);
                         }
                     } else {
                         log_warn("Recording file does not exist: %s (already deleted or never created)",
@@ -246,6 +248,7 @@ static void *batch_delete_worker_thread(void *arg) {
                         // File deletion failed but DB entry is already removed
                     } else {
                         log_info("Deleted recording file: %s", file_path_copy);
+                        stream_storage_cache_remove_file(file_path_copy, (uint64_t)st.st_size);
                     }
                 } else {
                     log_warn("Recording file does not exist: %s (already deleted or never created)",
@@ -18,6 +18,7 @@
 #include "mongoose.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "storage/storage_manager_streams_cache.h"
 #include "database/db_auth.h"
 #include "web/mongoose_server_multithreading.h"
 
@@ -129,6 +130,7 @@ void delete_recording_task_function(void *arg) {
             // This is acceptable - orphaned files can be cleaned up later
         } else {
             log_info("Deleted recording file: %s", file_path_copy);
+            stream_storage_cache_remove_file(file_path_copy, (uint64_t)st.st_size);
         }
     } else {
         log_warn("Recording file does not exist: %s (already deleted or never created)", file_path_copy);
@@ -264,32 +266,13 @@ void mg_handle_delete_recording(struct mg_connection *c, struct mg_http_message
     
     log_info("Handling DELETE /api/recordings/%llu request", (unsigned long long)id);
     
-    // Send an immediate response to the client before processing the request
-    mg_send_json_response(c, 202, "{\"success\":true,\"message\":\"Processing request\"}");
-    
-    // Create a thread data structure
-    struct mg_thread_data *data = calloc(1, sizeof(struct mg_thread_data));
-    if (!data) {
-        log_error("Failed to allocate memory for thread data");
-        mg_http_reply(c, 500, "", "Internal Server Error\n");
-        return;
-    }
-    
-    // Copy the HTTP message
-    data->message = mg_strdup(hm->message);
-    if (data->message.len == 0) {
-        log_error("Failed to duplicate HTTP message");
-        free(data);
+    // Hand the request to the worker pool (errors, including 503, are answered by the call)
+    if (!mg_submit_request_to_worker(c, hm, delete_recording_handler, MG_TASK_PRIORITY_BULK)) {
         return;
     }
-    
-    // Set connection ID, manager, and handler function
-    data->conn_id = c->id;
-    data->mgr = c->mgr;
-    data->handler_func = delete_recording_handler;
-    
-    // Start thread
-    mg_start_thread(mg_thread_function, data);
+
+    // Send an immediate response to the client while the request is processed
+    mg_send_json_response(c, 202, "{\"success\":true,\"message\":\"Processing request\"}");
     
     log_info("Delete recording task started in a worker thread");
 }
@@ -78,6 +78,7 @@ void mg_handle_get_streams(struct mg_connection *c, struct mg_http_message *hm)
         cJSON_AddNumberToObject(stream_obj, "post_detection_buffer", db_streams[i].post_detection_buffer);
         cJSON_AddNumberToObject(stream_obj, "protocol", (int)db_streams[i].protocol);
         cJSON_AddBoolToObject(stream_obj, "record_audio", db_streams[i].record_audio);
+        cJSON_AddBoolToObject(stream_obj, "fragmented_mp4", db_streams[i].fragmented_mp4);
         cJSON_AddBoolToObject(stream_obj, "isOnvif", db_streams[i].is_onvif);
         cJSON_AddBoolToObject(stream_obj, "backchannel_enabled", db_streams[i].backchannel_enabled);
         cJSON_AddNumberToObject(stream_obj, "retention_days", db_streams[i].retention_days);
@@ -211,6 +212,7 @@ void mg_handle_get_stream(struct mg_connection *c, struct mg_http_message *hm) {
     cJSON_AddNumberToObject(stream_obj, "post_detection_buffer", config.post_detection_buffer);
     cJSON_AddNumberToObject(stream_obj, "protocol", (int)config.protocol);
     cJSON_AddBoolToObject(stream_obj, "record_audio", config.record_audio);
+    cJSON_AddBoolToObject(stream_obj, "fragmented_mp4", config.fragmented_mp4);
     cJSON_AddBoolToObject(stream_obj, "isOnvif", config.is_onvif);
     cJSON_AddBoolToObject(stream_obj, "backchannel_enabled", config.backchannel_enabled);
     cJSON_AddNumberToObject(stream_obj, "retention_days", config.retention_days);
@@ -341,6 +343,7 @@ void mg_handle_get_stream_full(struct mg_connection *c, struct mg_http_message *
     cJSON_AddNumberToObject(stream_obj, "post_detection_buffer", config.post_detection_buffer);
     cJSON_AddNumberToObject(stream_obj, "protocol", (int)config.protocol);
     cJSON_AddBoolToObject(stream_obj, "record_audio", config.record_audio);
+    cJSON_AddBoolToObject(stream_obj, "fragmented_mp4", config.fragmented_mp4);
     cJSON_AddBoolToObject(stream_obj, "isOnvif", config.is_onvif);
     cJSON_AddBoolToObject(stream_obj, "backchannel_enabled", config.backchannel_enabled);
     cJSON_AddNumberToObject(stream_obj, "retention_days", config.retention_days);
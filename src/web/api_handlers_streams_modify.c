@@ -165,6 +165,11 @@ void mg_handle_post_stream(struct mg_connection *c, struct mg_http_message *hm)
                 config.record_audio ? "enabled" : "disabled", config.name);
     }
 
+    cJSON *fragmented_mp4 = cJSON_GetObjectItem(stream_json, "fragmented_mp4");
+    if (fragmented_mp4 && cJSON_IsBool(fragmented_mp4)) {
+        config.fragmented_mp4 = cJSON_IsTrue(fragmented_mp4);
+    }
+
     // Check if backchannel_enabled flag is set in the request
     cJSON *backchannel_enabled = cJSON_GetObjectItem(stream_json, "backchannel_enabled");
     if (backchannel_enabled && cJSON_IsBool(backchannel_enabled)) {
@@ -550,6 +555,19 @@ void mg_handle_put_stream(struct mg_connection *c, struct mg_http_message *hm) {
         }
     }
 
+    // Takes effect with the next segment, no restart needed
+    cJSON *fragmented_mp4 = cJSON_GetObjectItem(stream_json, "fragmented_mp4");
+    if (fragmented_mp4 && cJSON_IsBool(fragmented_mp4)) {
+        bool original_fragmented = config.fragmented_mp4;
+        config.fragmented_mp4 = cJSON_IsTrue(fragmented_mp4);
+        if (original_fragmented != config.fragmented_mp4) {
+            config_changed = true;
+            log_info("Recording container changed from %s to %s MP4",
+                    original_fragmented ? "fragmented" : "standard",
+                    config.fragmented_mp4 ? "fragmented" : "standard");
+        }
+    }
+
     cJSON *backchannel_enabled = cJSON_GetObjectItem(stream_json, "backchannel_enabled");
     if (backchannel_enabled && cJSON_IsBool(backchannel_enabled)) {
         bool original_backchannel = config.backchannel_enabled;
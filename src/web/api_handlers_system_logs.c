@@ -14,6 +14,7 @@
 #include "web/api_handlers.h"
 #include "web/mongoose_adapter.h"
 #include "core/logger.h"
+#include "core/logger_json.h"
 #include "core/config.h"
 #include "mongoose.h"
 
@@ -204,6 +205,94 @@ int log_level_meets_minimum(const char *log_level, const char *min_level) {
     return level_value <= min_value;
 }
 
+/**
+ * @brief Send log entries from the JSON log store
+ *
+ * Without "before" the newest entries (after "since", if given) come from
+ * memory; with "before" the store pages back through the log files. Entries
+ * are sent newest first, next_before is the cursor for the next older page.
+ *
+ * @return int 0 if a response was sent, -1 if the store is not available
+ */
+static int send_json_store_logs(struct mg_connection *c, struct mg_str *query, const char *level) {
+    char since[32] = {0};
+    char before[32] = {0};
+    char limit_buf[16] = {0};
+
+    mg_http_get_var(query, "since", since, sizeof(since));
+    mg_http_get_var(query, "before", before, sizeof(before));
+
+    int limit = 500;
+    if (mg_http_get_var(query, "limit", limit_buf, sizeof(limit_buf)) > 0) {
+        limit = atoi(limit_buf);
+        if (limit <= 0) {
+            limit = 500;
+        } else if (limit > 5000) {
+            limit = 5000;
+        }
+    }
+
+    log_level_t max_level = LOG_LEVEL_INFO;
+    if (strcmp(level, "error") == 0) {
+        max_level = LOG_LEVEL_ERROR;
+    } else if (strcmp(level, "warning") == 0 || strcmp(level, "warn") == 0) {
+        max_level = LOG_LEVEL_WARN;
+    } else if (strcmp(level, "debug") == 0) {
+        max_level = LOG_LEVEL_DEBUG;
+    }
+
+    json_log_entry_t *entries = NULL;
+    int count = 0;
+    int result = before[0] != '\0' ?
+        json_log_query_before(before, max_level, limit, &entries, &count) :
+        json_log_query_since(since[0] != '\0' ? since : NULL, max_level, limit, &entries, &count);
+    if (result != 0) {
+        return -1;
+    }
+
+    static const char *level_names[] = { "error", "warning", "info", "debug" };
+
+    cJSON *logs_obj = cJSON_CreateObject();
+    cJSON *logs_array = logs_obj ? cJSON_AddArrayToObject(logs_obj, "logs") : NULL;
+    if (!logs_array) {
+        cJSON_Delete(logs_obj);
+        json_log_free_entries(entries, count);
+        mg_send_json_error(c, 500, "Failed to create logs JSON");
+        return 0;
+    }
+
+    for (int i = 0; i < count; i++) {
+        cJSON *log_entry = cJSON_CreateObject();
+        if (log_entry) {
+            cJSON_AddStringToObject(log_entry, "timestamp", entries[i].timestamp);
+            cJSON_AddStringToObject(log_entry, "level", level_names[entries[i].level]);
+            cJSON_AddStringToObject(log_entry, "message", entries[i].message ? entries[i].message : "");
+            cJSON_AddItemToArray(logs_array, log_entry);
+        }
+    }
+
+    cJSON_AddStringToObject(logs_obj, "file", g_config.log_file);
+    cJSON_AddStringToObject(logs_obj, "level", level);
+    if (count > 0) {
+        cJSON_AddStringToObject(logs_obj, "next_before", entries[count - 1].timestamp);
+    }
+    cJSON_AddBoolToObject(logs_obj, "has_more", count >= limit);
+
+    json_log_free_entries(entries, count);
+
+    char *json_str = cJSON_PrintUnformatted(logs_obj);
+    cJSON_Delete(logs_obj);
+
+    if (!json_str) {
+        mg_send_json_error(c, 500, "Failed to convert logs JSON to string");
+        return 0;
+    }
+
+    mg_send_json_response(c, 200, json_str);
+    free(json_str);
+    return 0;
+}
+
 /**
  * @brief Direct handler for GET /api/system/logs
  */
@@ -222,6 +311,11 @@ void mg_handle_get_system_logs(struct mg_connection *c, struct mg_http_message *
         level[sizeof(level) - 1] = '\0';
     }
 
+    // Serve from the JSON log store, falling back to reading the text log
+    if (send_json_store_logs(c, &query, level) == 0) {
+        return;
+    }
+
     // Get system logs
     char **logs = NULL;
     int count = 250;
@@ -382,6 +476,7 @@ void mg_handle_post_system_logs_clear(struct mg_connection *c, struct mg_http_me
     int fd = open(log_file, O_WRONLY | O_TRUNC | O_CREAT, 0644);
     if (fd >= 0) {
         close(fd);
+        json_log_clear();
         log_info("Log file cleared via API: %s", log_file);
 
         // Create success response using cJSON
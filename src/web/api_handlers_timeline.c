@@ -4,10 +4,10 @@
 #include <ctype.h>
 #include <dirent.h>
 #include <pthread.h>
+#include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
 
@@ -15,10 +15,13 @@
 #include "core/logger.h"
 #include "database/database_manager.h"
 #include "database/db_recordings.h"
+#include "database/db_timeline_index.h"
 #include "mongoose.h"
+#include "video/mp4_fragment_index.h"
 #include "web/api_handlers.h"
 #include "web/api_handlers_timeline.h"
 #include "web/mongoose_adapter.h"
+#include "web/remux_http.h"
 
 // Maximum number of segments to return in a single request
 #define MAX_TIMELINE_SEGMENTS 5000
@@ -111,35 +114,7 @@ void mg_handle_get_playback_continuous(struct mg_connection *c,
     return;
   }
 
-  // Create temporary playlist file
-  char playlist_path[MAX_PATH_LENGTH];
-  snprintf(playlist_path, sizeof(playlist_path), "playlist_%ld_%ld.txt",
-           (long)time(NULL), (long)start_time);
-
-  FILE *fp = fopen(playlist_path, "w");
-  if (!fp) {
-    free(segments);
-    log_error("Failed to create playlist file: %s", playlist_path);
-    mg_send_json_error(c, 500, "Internal Server Error");
-    return;
-  }
-
-  // Find the exact starting segment and logical offset
-  // Since we are just concatenating files, actual seeking within the first file
-  // needs -ss parameter in ffmpeg, but that makes concat complex.
-  // Simplification: We start with the file containing the timestamp.
-  // The frontend "virtual seek" ensures we just reload.
-
-  // NOTE: A true specific-second seek with concat demuxer is tricky.
-  // We will just list all files. The user will see playback start at the
-  // beginning of the first segment. Ideally, we'd use -ss on just the first
-  // file, but concat demuxer handles file lists. For precise seeking,
-  // client-side adjustment or transcoding is needed. Given we want avoiding
-  // re-encoding ("copy"), we accept start-of-segment precision or handle it
-  // differently.
-
-  // Let's filter segments to only include those >= start_time (or containing
-  // it)
+  // Start with the segment containing start_time
   int start_idx = 0;
   for (int i = 0; i < count; i++) {
     if (segments[i].end_time > start_time) {
@@ -148,64 +123,91 @@ void mg_handle_get_playback_continuous(struct mg_connection *c,
     }
   }
 
+  const char **inputs = malloc((size_t)(count - start_idx) * sizeof(char *));
+  if (!inputs) {
+    free(segments);
+    mg_send_json_error(c, 500, "Memory allocation failed");
+    return;
+  }
+  int input_count = 0;
   for (int i = start_idx; i < count; i++) {
-    fprintf(fp, "file '%s'\n", segments[i].file_path);
+    inputs[input_count++] = segments[i].file_path;
   }
-  fclose(fp);
-  free(segments);
 
-  // Construct ffmpeg command
-  // -f concat -safe 0 -i playlist.txt -c copy -f mp4 -movflags
-  // frag_keyframe+empty_moov pipe:1 We use fragmented MP4 for streaming over
-  // HTTP pipe
-  char cmd[2048];
-  snprintf(cmd, sizeof(cmd),
-           "ffmpeg -hide_banner -loglevel error -f concat -safe 0 -i \"%s\" "
-           "-c copy -f mp4 -movflags "
-           "frag_keyframe+empty_moov+default_base_moof pipe:1 2>&1",
-           playlist_path);
-
-  log_info("Executing continuous playback command: %s", cmd);
-
-  // Open pipe
-  FILE *pipe = popen(cmd, "r");
-  if (!pipe) {
-    unlink(playlist_path);
-    mg_send_json_error(c, 500, "Failed to start stream");
-    return;
+  // Stream copy to fragmented MP4, cutting the first segment at the keyframe
+  // before start_time
+  double start_offset = 0.0;
+  if (start_time > segments[start_idx].start_time) {
+    start_offset = (double)(start_time - segments[start_idx].start_time);
   }
+  remux_request_t request = {
+      .inputs = inputs,
+      .input_count = input_count,
+      .start_offset = start_offset,
+      .duration = 0.0,
+  };
+
+  int ret = remux_http_stream_start(c, &request);
+  free(inputs);
+  free(segments);
 
-  // Send HTTP headers
-  mg_printf(c, "HTTP/1.1 200 OK\r\n"
-               "Content-Type: video/mp4\r\n"
-               "Connection: close\r\n"
-               "\r\n");
-
-  // Stream data
-  char buffer[32768];
-  size_t n;
-  while ((n = fread(buffer, 1, sizeof(buffer), pipe)) > 0) {
-    mg_send(c, buffer, n);
-    // Note: In a real async server, this blocking loop is bad.
-    // Mongoose handles this better if structured differently,
-    // but for this direct implementation we assume it works or rely on
-    // Mongoose's internal buffering. Ideally use a pipe update function or
-    // separate thread. Given current architecture, big writes might block.
+  if (ret != 0) {
+    mg_send_json_error(c, 503, "Too many playback streams, try again later");
+    return;
   }
 
-  pclose(pipe);
-  unlink(playlist_path); // Cleanup
-  log_info("Continuous playback finished");
+  log_info("Started continuous playback of %d segments for stream=%s offset=%.0fs",
+           input_count, stream_name, start_offset);
 }
 
 // Maximum number of segments to return in a single request
 #define MAX_TIMELINE_SEGMENTS 5000
 
+// Maximum number of detection buckets in a coverage response
+#define MAX_COVERAGE_BUCKETS 1440
+
 // Maximum number of segments in a manifest
 #define MAX_MANIFEST_SEGMENTS 5000
 
-// Mutex for manifest creation
+// Fragments of a fragmented recording are grouped into media segments of
+// about this many seconds
+#define MANIFEST_TARGET_SEGMENT_SECONDS 6.0
+
+// Number of manifests kept in memory
+#define MANIFEST_CACHE_SIZE 16
+
+// An open-ended manifest request ends at the next multiple of this many
+// seconds, so repeated requests share one cache entry
+#define MANIFEST_OPEN_END_ROUNDING 60
+
+/**
+ * Cached manifest of a stream and time range, valid while the recording
+ * generation of the stream is unchanged
+ */
+typedef struct {
+  char stream_name[MAX_STREAM_NAME];
+  time_t start_time;
+  time_t end_time;
+  uint64_t generation;
+  uint64_t last_used;
+  char *text;
+  size_t length;
+} manifest_cache_entry_t;
+
+// Mutex for the manifest cache
 static pthread_mutex_t manifest_mutex = PTHREAD_MUTEX_INITIALIZER;
+static manifest_cache_entry_t manifest_cache[MANIFEST_CACHE_SIZE];
+static uint64_t manifest_use_counter = 0;
+
+/**
+ * Growable text buffer for building manifests
+ */
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+  bool failed;
+} manifest_buffer_t;
 
 /**
  * Get timeline segments for a specific stream and time range
@@ -247,8 +249,9 @@ int get_timeline_segments(const char *stream_name, time_t start_time,
     segments[i].start_time = recordings[i].start_time;
     segments[i].end_time = recordings[i].end_time;
     segments[i].size_bytes = recordings[i].size_bytes;
-    segments[i].has_detection =
-        false; // Default to false, could be updated with detection info
+    segments[i].has_detection = timeline_index_has_detection(
+        recordings[i].stream_name, recordings[i].start_time,
+        recordings[i].end_time);
   }
 
   // Free recordings
@@ -547,15 +550,92 @@ void mg_handle_get_timeline_segments(struct mg_connection *c,
   log_info("Successfully handled GET /api/timeline/segments request");
 }
 
+/**
+ * Append formatted text to a manifest buffer
+ */
+static void manifest_append(manifest_buffer_t *buf, const char *format, ...) {
+  if (buf->failed) {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+  int needed = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+
+  if (needed < 0) {
+    buf->failed = true;
+    return;
+  }
+
+  if (buf->length + (size_t)needed + 1 > buf->capacity) {
+    size_t capacity = buf->capacity ? buf->capacity : 4096;
+    while (buf->length + (size_t)needed + 1 > capacity) {
+      capacity *= 2;
+    }
+    char *data = realloc(buf->data, capacity);
+    if (!data) {
+      buf->failed = true;
+      return;
+    }
+    buf->data = data;
+    buf->capacity = capacity;
+  }
+
+  va_start(args, format);
+  vsnprintf(buf->data + buf->length, buf->capacity - buf->length, format,
+            args);
+  va_end(args);
+  buf->length += (size_t)needed;
+}
+
+/**
+ * Append the media segments of a fragmented recording, addressed as byte
+ * ranges of the recording file
+ */
+static void append_fragmented_recording(manifest_buffer_t *buf,
+                                        const timeline_segment_t *segment,
+                                        const mp4_fragment_index_t *index,
+                                        double *max_duration) {
+  unsigned long long id = (unsigned long long)segment->id;
+
+  manifest_append(buf, "#EXT-X-MAP:URI=\"/api/recordings/play/%llu\","
+                       "BYTERANGE=\"%llu@0\"\n",
+                  id, (unsigned long long)index->init_size);
+
+  int first = 0;
+  double duration = 0;
+  for (int i = 0; i < index->count; i++) {
+    duration += index->fragments[i].duration;
+    if (duration < MANIFEST_TARGET_SEGMENT_SECONDS && i < index->count - 1) {
+      continue;
+    }
+
+    uint64_t offset = index->fragments[first].offset;
+    uint64_t length =
+        index->fragments[i].offset + index->fragments[i].size - offset;
+    manifest_append(buf,
+                    "#EXTINF:%.6f,\n#EXT-X-BYTERANGE:%llu@%llu\n"
+                    "/api/recordings/play/%llu\n",
+                    duration, (unsigned long long)length,
+                    (unsigned long long)offset, id);
+
+    if (duration > *max_duration) {
+      *max_duration = duration;
+    }
+    first = i + 1;
+    duration = 0;
+  }
+}
+
 /**
  * Create a playback manifest for a sequence of recordings
  */
-int create_timeline_manifest(const timeline_segment_t *segments,
-                             int segment_count, time_t start_time,
-                             char *manifest_path) {
-  if (!segments || segment_count <= 0 || !manifest_path) {
+char *create_timeline_manifest(const timeline_segment_t *segments,
+                               int segment_count, size_t *length) {
+  if (!segments || segment_count <= 0 || !length) {
     log_error("Invalid parameters for create_timeline_manifest");
-    return -1;
+    return NULL;
   }
 
   // Limit the number of segments
@@ -565,76 +645,137 @@ int create_timeline_manifest(const timeline_segment_t *segments,
     segment_count = MAX_MANIFEST_SEGMENTS;
   }
 
-  // Create a temporary directory for the manifest
-  char temp_dir[MAX_PATH_LENGTH];
-  snprintf(temp_dir, sizeof(temp_dir), "%s/timeline_manifests",
-           g_config.storage_path);
-
-  // Create directory if it doesn't exist
-  struct stat st = {0};
-  if (stat(temp_dir, &st) == -1) {
-    mkdir(temp_dir, 0755);
-  }
-
-  // Generate a unique manifest filename
-  char manifest_filename[MAX_PATH_LENGTH];
-  snprintf(manifest_filename, sizeof(manifest_filename),
-           "%s/manifest_%ld_%s_%ld.m3u8", temp_dir, (long)time(NULL),
-           segments[0].stream_name, (long)start_time);
+  manifest_buffer_t body = {0};
+  double max_duration = 0;
+  bool uses_map = false;
+  bool previous_fragmented = false;
 
-  // Lock mutex for manifest creation
-  pthread_mutex_lock(&manifest_mutex);
+  for (int i = 0; i < segment_count; i++) {
+    mp4_fragment_index_t index;
+    bool fragmented =
+        mp4_fragment_index_load(segments[i].file_path, &index) == 0;
+
+    // Every fragmented recording starts with its own initialization section
+    // and timestamps
+    if (i > 0 &&
+        (fragmented || previous_fragmented ||
+         difftime(segments[i].start_time, segments[i - 1].end_time) > 1.0)) {
+      manifest_append(&body, "#EXT-X-DISCONTINUITY\n");
+    }
 
-  // Create manifest file
-  FILE *manifest = fopen(manifest_filename, "w");
-  if (!manifest) {
-    log_error("Failed to create manifest file: %s", manifest_filename);
-    pthread_mutex_unlock(&manifest_mutex);
-    return -1;
+    if (fragmented) {
+      append_fragmented_recording(&body, &segments[i], &index, &max_duration);
+      mp4_fragment_index_free(&index);
+      uses_map = true;
+    } else {
+      // Recordings written with faststart are only addressable whole
+      double duration =
+          difftime(segments[i].end_time, segments[i].start_time);
+      manifest_append(&body, "#EXTINF:%.6f,\n/api/recordings/play/%llu\n",
+                      duration, (unsigned long long)segments[i].id);
+      if (duration > max_duration) {
+        max_duration = duration;
+      }
+    }
+    previous_fragmented = fragmented;
   }
 
-  // Write manifest header
-  fprintf(manifest, "#EXTM3U\n");
-  fprintf(manifest, "#EXT-X-VERSION:3\n");
-  fprintf(manifest, "#EXT-X-MEDIA-SEQUENCE:0\n");
-  fprintf(manifest, "#EXT-X-ALLOW-CACHE:YES\n");
+  manifest_buffer_t manifest = {0};
+  manifest_append(&manifest, "#EXTM3U\n");
+  manifest_append(&manifest, "#EXT-X-VERSION:%d\n", uses_map ? 7 : 3);
+  manifest_append(&manifest, "#EXT-X-TARGETDURATION:%d\n",
+                  (int)(max_duration + 0.999));
+  manifest_append(&manifest, "#EXT-X-MEDIA-SEQUENCE:0\n");
+  manifest_append(&manifest, "#EXT-X-PLAYLIST-TYPE:VOD\n");
+  if (!body.failed && body.length > 0) {
+    manifest_append(&manifest, "%s", body.data);
+  }
+  manifest_append(&manifest, "#EXT-X-ENDLIST\n");
+
+  bool failed = body.failed || manifest.failed;
+  free(body.data);
+  if (failed) {
+    log_error("Failed to allocate memory for timeline manifest");
+    free(manifest.data);
+    return NULL;
+  }
 
-  // Write segments
-  for (int i = 0; i < segment_count; i++) {
-    // Calculate duration
-    double duration = difftime(segments[i].end_time, segments[i].start_time);
+  *length = manifest.length;
+  return manifest.data;
+}
 
-    // Write segment info
-    fprintf(manifest, "#EXTINF:%.6f,\n", duration);
+/**
+ * Get a copy of a cached manifest, or NULL if there is no current one
+ */
+static char *get_cached_manifest(const char *stream_name, time_t start_time,
+                                 time_t end_time, uint64_t generation,
+                                 size_t *length) {
+  char *copy = NULL;
 
-    // Use the recording playback endpoint directly
-    fprintf(manifest, "/api/recordings/play/%llu\n",
-            (unsigned long long)segments[i].id);
+  pthread_mutex_lock(&manifest_mutex);
 
-    // Add discontinuity tag if there's a gap between segments
-    if (i < segment_count - 1) {
-      double gap = difftime(segments[i + 1].start_time, segments[i].end_time);
-      if (gap > 1.0) { // If gap is more than 1 second
-        fprintf(manifest, "#EXT-X-DISCONTINUITY\n");
+  for (int i = 0; i < MANIFEST_CACHE_SIZE; i++) {
+    manifest_cache_entry_t *entry = &manifest_cache[i];
+    if (entry->text && entry->generation == generation &&
+        entry->start_time == start_time && entry->end_time == end_time &&
+        strcmp(entry->stream_name, stream_name) == 0) {
+      copy = malloc(entry->length);
+      if (copy) {
+        memcpy(copy, entry->text, entry->length);
+        *length = entry->length;
+        entry->last_used = ++manifest_use_counter;
       }
+      break;
     }
   }
 
-  // Write manifest end
-  fprintf(manifest, "#EXT-X-ENDLIST\n");
+  pthread_mutex_unlock(&manifest_mutex);
+  return copy;
+}
 
-  // Close manifest file
-  fclose(manifest);
+/**
+ * Store a manifest in the cache, replacing the least recently used entry
+ */
+static void cache_manifest(const char *stream_name, time_t start_time,
+                           time_t end_time, uint64_t generation,
+                           const char *text, size_t length) {
+  char *copy = malloc(length);
+  if (!copy) {
+    return;
+  }
+  memcpy(copy, text, length);
 
-  // Copy manifest path to output
-  strncpy(manifest_path, manifest_filename, MAX_PATH_LENGTH - 1);
-  manifest_path[MAX_PATH_LENGTH - 1] = '\0';
+  pthread_mutex_lock(&manifest_mutex);
 
-  pthread_mutex_unlock(&manifest_mutex);
+  manifest_cache_entry_t *slot = &manifest_cache[0];
+  for (int i = 0; i < MANIFEST_CACHE_SIZE; i++) {
+    manifest_cache_entry_t *entry = &manifest_cache[i];
+    if (entry->text && entry->start_time == start_time &&
+        entry->end_time == end_time &&
+        strcmp(entry->stream_name, stream_name) == 0) {
+      slot = entry;
+      break;
+    }
+    if (!entry->text) {
+      if (slot->text) {
+        slot = entry;
+      }
+    } else if (slot->text && entry->last_used < slot->last_used) {
+      slot = entry;
+    }
+  }
 
-  log_info("Created timeline manifest: %s", manifest_filename);
+  free(slot->text);
+  strncpy(slot->stream_name, stream_name, sizeof(slot->stream_name) - 1);
+  slot->stream_name[sizeof(slot->stream_name) - 1] = '\0';
+  slot->start_time = start_time;
+  slot->end_time = end_time;
+  slot->generation = generation;
+  slot->last_used = ++manifest_use_counter;
+  slot->text = copy;
+  slot->length = length;
 
-  return 0;
+  pthread_mutex_unlock(&manifest_mutex);
 }
 
 /**
@@ -762,56 +903,67 @@ void mg_handle_timeline_manifest(struct mg_connection *c,
       log_error("Failed to parse end time string: %s", decoded_end_time);
     }
   } else {
-    // Default to now
-    end_time = time(NULL);
+    // Default to now, rounded up so the cache key is stable. Only completed
+    // recordings are listed and each completion changes the generation, so
+    // the rounded end never returns anything a request ending now would not.
+    time_t now = time(NULL);
+    end_time = (now / MANIFEST_OPEN_END_ROUNDING + 1) * MANIFEST_OPEN_END_ROUNDING;
   }
 
-  // Get timeline segments
-  timeline_segment_t *segments = (timeline_segment_t *)malloc(
-      MAX_TIMELINE_SEGMENTS * sizeof(timeline_segment_t));
-  if (!segments) {
-    log_error("Failed to allocate memory for timeline segments");
-    mg_send_json_error(c, 500,
-                       "Failed to allocate memory for timeline segments");
-    return;
-  }
+  // Read before the segments so a recording completing meanwhile is not
+  // cached as current
+  uint64_t generation = timeline_index_get_recording_generation(stream_name);
 
-  int count = get_timeline_segments(stream_name, start_time, end_time, segments,
-                                    MAX_TIMELINE_SEGMENTS);
+  size_t manifest_length = 0;
+  char *manifest = get_cached_manifest(stream_name, start_time, end_time,
+                                       generation, &manifest_length);
 
-  if (count <= 0) {
-    log_error("No timeline segments found for stream %s", stream_name);
-    free(segments);
-    mg_send_json_error(c, 404,
-                       "No recordings found for the specified time range");
-    return;
-  }
+  if (!manifest) {
+    // Get timeline segments
+    timeline_segment_t *segments = (timeline_segment_t *)malloc(
+        MAX_TIMELINE_SEGMENTS * sizeof(timeline_segment_t));
+    if (!segments) {
+      log_error("Failed to allocate memory for timeline segments");
+      mg_send_json_error(c, 500,
+                         "Failed to allocate memory for timeline segments");
+      return;
+    }
 
-  // Create manifest
-  char manifest_path[MAX_PATH_LENGTH];
-  if (create_timeline_manifest(segments, count, start_time, manifest_path) !=
-      0) {
-    log_error("Failed to create timeline manifest");
-    free(segments);
-    mg_send_json_error(c, 500, "Failed to create timeline manifest");
-    return;
-  }
+    int count = get_timeline_segments(stream_name, start_time, end_time,
+                                      segments, MAX_TIMELINE_SEGMENTS);
 
-  // Free segments
-  free(segments);
+    if (count <= 0) {
+      log_error("No timeline segments found for stream %s", stream_name);
+      free(segments);
+      mg_send_json_error(c, 404,
+                         "No recordings found for the specified time range");
+      return;
+    }
 
-  // Use Mongoose's built-in file serving capabilities
-  // This is more stable and handles all the HTTP headers properly
-  struct mg_http_serve_opts opts = {
-      .mime_types = "m3u8=application/vnd.apple.mpegurl",
-      .extra_headers = "Connection: close\r\nCache-Control: no-cache\r\n"};
+    // Create manifest
+    manifest = create_timeline_manifest(segments, count, &manifest_length);
+    free(segments);
 
-  log_info("Serving manifest file using mg_http_serve_file: %s", manifest_path);
-  mg_http_serve_file(c, hm, manifest_path, &opts);
+    if (!manifest) {
+      log_error("Failed to create timeline manifest");
+      mg_send_json_error(c, 500, "Failed to create timeline manifest");
+      return;
+    }
+
+    cache_manifest(stream_name, start_time, end_time, generation, manifest,
+                   manifest_length);
+  }
 
-  // Schedule manifest file for deletion after a while
-  // In a real implementation, you might want to keep it around for a bit
-  // and implement a cleanup mechanism
+  // Send the manifest from memory
+  mg_printf(c,
+            "HTTP/1.1 200 OK\r\n"
+            "Content-Type: application/vnd.apple.mpegurl\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Content-Length: %zu\r\n"
+            "\r\n",
+            manifest_length);
+  mg_send(c, manifest, manifest_length);
+  free(manifest);
 
   log_info("Successfully handled GET /api/timeline/manifest request");
 }
@@ -1025,3 +1177,161 @@ void mg_handle_get_recording_days(struct mg_connection *c,
   free(json);
   free_recording_days(days, count);
 }
+
+/**
+ * Parse a time query parameter given as unix seconds or an ISO 8601 UTC time
+ */
+static int parse_coverage_time(const char *str, time_t *result) {
+  char *endptr;
+  long long value = strtoll(str, &endptr, 10);
+  if (endptr != str && *endptr == '\0') {
+    *result = (time_t)value;
+    return 0;
+  }
+
+  // URL-decode the time string (replace %3A with :)
+  char decoded[64] = {0};
+  strncpy(decoded, str, sizeof(decoded) - 1);
+  char *pos = decoded;
+  while ((pos = strstr(pos, "%3A")) != NULL) {
+    *pos = ':';
+    memmove(pos + 1, pos + 3, strlen(pos + 3) + 1);
+  }
+
+  struct tm tm = {0};
+  if (strptime(decoded, "%Y-%m-%dT%H:%M:%S", &tm) == NULL &&
+      strptime(decoded, "%Y-%m-%d", &tm) == NULL) {
+    return -1;
+  }
+
+  tm.tm_isdst = 0; // No DST for UTC
+  *result = timegm(&tm);
+  return 0;
+}
+
+/**
+ * @brief Handler for GET /api/timeline/coverage
+ *
+ * Returns the recorded intervals of a stream and its detection density from
+ * the in-memory timeline index instead of the recordings table.
+ */
+void mg_handle_get_timeline_coverage(struct mg_connection *c,
+                                     struct mg_http_message *hm) {
+  char stream_name[MAX_STREAM_NAME] = {0};
+  char start_time_str[64] = {0};
+  char end_time_str[64] = {0};
+  char max_gap_str[16] = {0};
+  char buckets_str[16] = {0};
+
+  mg_http_get_var(&hm->query, "stream", stream_name, sizeof(stream_name));
+  mg_http_get_var(&hm->query, "start", start_time_str, sizeof(start_time_str));
+  mg_http_get_var(&hm->query, "end", end_time_str, sizeof(end_time_str));
+  mg_http_get_var(&hm->query, "max_gap", max_gap_str, sizeof(max_gap_str));
+  mg_http_get_var(&hm->query, "buckets", buckets_str, sizeof(buckets_str));
+
+  if (stream_name[0] == '\0') {
+    mg_send_json_error(c, 400, "Missing required parameter: stream");
+    return;
+  }
+
+  // Default to the last 24 hours
+  time_t end_time = time(NULL);
+  time_t start_time = end_time - (24 * 60 * 60);
+
+  if ((start_time_str[0] != '\0' &&
+       parse_coverage_time(start_time_str, &start_time) != 0) ||
+      (end_time_str[0] != '\0' &&
+       parse_coverage_time(end_time_str, &end_time) != 0)) {
+    mg_send_json_error(c, 400, "Invalid time format");
+    return;
+  }
+
+  if (end_time <= start_time) {
+    mg_send_json_error(c, 400, "End time must be after start time");
+    return;
+  }
+
+  int max_gap = max_gap_str[0] != '\0' ? atoi(max_gap_str) : 1;
+  if (max_gap < 0) {
+    max_gap = 0;
+  }
+
+  int buckets = buckets_str[0] != '\0' ? atoi(buckets_str) : 96;
+  if (buckets < 1) {
+    buckets = 1;
+  } else if (buckets > MAX_COVERAGE_BUCKETS) {
+    buckets = MAX_COVERAGE_BUCKETS;
+  }
+
+  timeline_interval_t *intervals = NULL;
+  int interval_count = 0;
+  if (timeline_index_get_coverage(stream_name, start_time, end_time, max_gap,
+                                  &intervals, &interval_count) != 0) {
+    mg_send_json_error(c, 500, "Failed to get timeline coverage");
+    return;
+  }
+
+  // Buckets are whole multiples of the index resolution
+  int bucket_seconds = (int)((end_time - start_time + buckets - 1) / buckets);
+  bucket_seconds = ((bucket_seconds + TIMELINE_DETECTION_BUCKET_SECONDS - 1) /
+                    TIMELINE_DETECTION_BUCKET_SECONDS) *
+                   TIMELINE_DETECTION_BUCKET_SECONDS;
+
+  uint32_t counts[MAX_COVERAGE_BUCKETS];
+  int bucket_count = timeline_index_get_detection_counts(
+      stream_name, start_time, end_time, bucket_seconds, counts,
+      MAX_COVERAGE_BUCKETS);
+  if (bucket_count < 0) {
+    free(intervals);
+    mg_send_json_error(c, 500, "Failed to get detection counts");
+    return;
+  }
+
+  cJSON *response = cJSON_CreateObject();
+  cJSON *intervals_array = cJSON_CreateArray();
+  cJSON *detections_array = cJSON_CreateArray();
+  if (!response || !intervals_array || !detections_array) {
+    cJSON_Delete(response);
+    cJSON_Delete(intervals_array);
+    cJSON_Delete(detections_array);
+    free(intervals);
+    mg_send_json_error(c, 500, "Failed to create response JSON");
+    return;
+  }
+
+  long long covered_seconds = 0;
+  for (int i = 0; i < interval_count; i++) {
+    cJSON *interval = cJSON_CreateArray();
+    if (interval) {
+      cJSON_AddItemToArray(interval,
+                           cJSON_CreateNumber((double)intervals[i].start));
+      cJSON_AddItemToArray(interval,
+                           cJSON_CreateNumber((double)intervals[i].end));
+      cJSON_AddItemToArray(intervals_array, interval);
+    }
+    covered_seconds += (long long)(intervals[i].end - intervals[i].start);
+  }
+  free(intervals);
+
+  for (int i = 0; i < bucket_count; i++) {
+    cJSON_AddItemToArray(detections_array, cJSON_CreateNumber(counts[i]));
+  }
+
+  cJSON_AddStringToObject(response, "stream", stream_name);
+  cJSON_AddNumberToObject(response, "start", (double)start_time);
+  cJSON_AddNumberToObject(response, "end", (double)end_time);
+  cJSON_AddItemToObject(response, "intervals", intervals_array);
+  cJSON_AddNumberToObject(response, "covered_seconds", (double)covered_seconds);
+  cJSON_AddNumberToObject(response, "bucket_seconds", bucket_seconds);
+  cJSON_AddItemToObject(response, "detections", detections_array);
+
+  char *json_str = cJSON_PrintUnformatted(response);
+  cJSON_Delete(response);
+  if (!json_str) {
+    mg_send_json_error(c, 500, "Failed to convert response JSON to string");
+    return;
+  }
+
+  mg_send_json_response(c, 200, json_str);
+  free(json_str);
+}
@@ -2,6 +2,7 @@
 #include "web/api_handlers.h"
 #include "web/mongoose_server_auth.h"
 #include "database/db_zones.h"
+#include "video/zone_filter.h"
 #include "core/logger.h"
 #include <cjson/cJSON.h>
 #include <string.h>
@@ -232,7 +233,13 @@ void mg_handle_post_zones(struct mg_connection *c, struct mg_http_message *hm) {
     cJSON_Delete(json);
 
     // Save zones to database
-    if (save_detection_zones(stream_name, zones, zone_count) != 0) {
+    int rc = save_detection_zones(stream_name, zones, zone_count);
+
+    // Detection threads pick up the new zones on their next frame (also after a
+    // partial failure, the database may no longer match the cache)
+    invalidate_zone_cache(stream_name);
+
+    if (rc != 0) {
         mg_send_json_error(c, 500, "Failed to save detection zones");
         return;
     }
@@ -285,7 +292,13 @@ void mg_handle_delete_zones(struct mg_connection *c, struct mg_http_message *hm)
     log_info("DELETE /api/streams/%s/zones", stream_name);
 
     // Delete zones from database
-    if (delete_detection_zones(stream_name) != 0) {
+    int rc = delete_detection_zones(stream_name);
+
+    // Detection threads pick up the new zones on their next frame (also after a
+    // partial failure, the database may no longer match the cache)
+    invalidate_zone_cache(stream_name);
+
+    if (rc != 0) {
         mg_send_json_error(c, 500, "Failed to delete detection zones");
         return;
     }
@@ -0,0 +1,300 @@
+/**
+ * @file go2rtc_proxy_stream.c
+ * @brief Streaming reverse proxy to the go2rtc API
+ *
+ * Everything here runs on the event loop, so the streams need no locking.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <curl/curl.h>
+
+#include "core/logger.h"
+#include "web/api_handlers.h"
+#include "web/go2rtc_proxy_stream.h"
+#include "video/go2rtc/go2rtc_client.h"
+
+// Time allowed to connect to go2rtc
+#define PROXY_CONNECT_TIMEOUT_SECONDS 5L
+
+typedef struct {
+    bool in_use;
+    struct mg_connection *c;
+    CURL *curl;
+    struct curl_slist *request_headers;
+    char response_headers[512];
+    bool headers_sent;
+    bool paused;                    // Write callback paused the transfer
+} proxy_stream_t;
+
+static proxy_stream_t g_streams[GO2RTC_PROXY_MAX_STREAMS];
+static int g_active_streams = 0;
+static CURLM *g_multi = NULL;
+static uint64_t g_last_perform_ms = 0;
+
+static const char *status_text(long status) {
+    switch (status) {
+        case 200: return "OK";
+        case 201: return "Created";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 401: return "Unauthorized";
+        case 404: return "Not Found";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default: return status < 400 ? "OK" : "Error";
+    }
+}
+
+static proxy_stream_t *find_stream(struct mg_connection *c) {
+    for (int i = 0; i < GO2RTC_PROXY_MAX_STREAMS; i++) {
+        if (g_streams[i].in_use && g_streams[i].c == c) {
+            return &g_streams[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Remove a stream's transfer and free the slot
+ */
+static void release_stream(proxy_stream_t *stream) {
+    if (stream->curl) {
+        curl_multi_remove_handle(g_multi, stream->curl);
+        go2rtc_client_release(stream->curl);
+    }
+    curl_slist_free_all(stream->request_headers);
+    memset(stream, 0, sizeof(*stream));
+    g_active_streams--;
+}
+
+/**
+ * @brief Send the response headers using go2rtc's status and content type
+ */
+static void send_response_headers(proxy_stream_t *stream) {
+    long status = 0;
+    char *content_type = NULL;
+    curl_easy_getinfo(stream->curl, CURLINFO_RESPONSE_CODE, &status);
+    curl_easy_getinfo(stream->curl, CURLINFO_CONTENT_TYPE, &content_type);
+    if (status <= 0) {
+        status = 502;
+    }
+
+    mg_printf(stream->c,
+              "HTTP/1.1 %ld %s\r\n"
+              "Content-Type: %s\r\n"
+              "%s"
+              "Transfer-Encoding: chunked\r\n"
+              "\r\n",
+              status, status_text(status),
+              content_type ? content_type : "application/octet-stream",
+              stream->response_headers);
+    stream->c->is_resp = 1;
+    stream->headers_sent = true;
+
+    if (status != 200) {
+        log_warn("go2rtc returned status %ld for proxied request", status);
+    }
+}
+
+/**
+ * @brief curl write callback, forwards a piece of the upstream body
+ */
+static size_t stream_write_cb(char *data, size_t size, size_t nmemb, void *userp) {
+    proxy_stream_t *stream = (proxy_stream_t *)userp;
+    size_t len = size * nmemb;
+
+    // curl hands the same data over again once the transfer is resumed
+    if (stream->c->send.len >= GO2RTC_PROXY_SEND_LIMIT) {
+        stream->paused = true;
+        return CURL_WRITEFUNC_PAUSE;
+    }
+
+    if (!stream->headers_sent) {
+        send_response_headers(stream);
+    }
+    if (len > 0) {
+        mg_http_write_chunk(stream->c, data, len);
+    }
+    return len;
+}
+
+/**
+ * @brief End the response of a finished transfer and free its slot
+ */
+static void finish_stream(proxy_stream_t *stream, CURLcode result) {
+    struct mg_connection *c = stream->c;
+
+    if (result == CURLE_OK) {
+        if (!stream->headers_sent) {
+            send_response_headers(stream);
+        }
+        mg_http_write_chunk(c, "", 0);
+    } else if (!stream->headers_sent) {
+        log_error("Proxied go2rtc request failed: %s", curl_easy_strerror(result));
+        mg_send_json_error(c, 500, "Failed to proxy request to go2rtc API");
+    } else {
+        // Ending without the terminating chunk tells the client the body is incomplete
+        log_warn("Proxied go2rtc response cut short: %s", curl_easy_strerror(result));
+        c->is_resp = 0;
+    }
+
+    c->is_draining = 1;
+    c->data[2] = 0;
+    release_stream(stream);
+}
+
+/**
+ * @brief Run the transfers once and finish the completed ones
+ *
+ * @param force Run even if the transfers already ran in this millisecond
+ */
+static void perform_transfers(bool force) {
+    if (!g_multi || g_active_streams == 0) {
+        return;
+    }
+
+    // Every proxied connection polls once per event loop iteration
+    uint64_t now = mg_millis();
+    if (!force && now == g_last_perform_ms) {
+        return;
+    }
+    g_last_perform_ms = now;
+
+    int running = 0;
+    if (curl_multi_perform(g_multi, &running) != CURLM_OK) {
+        log_error("Failed to run proxied go2rtc requests");
+    }
+
+    CURLMsg *msg;
+    int queued;
+    while ((msg = curl_multi_info_read(g_multi, &queued)) != NULL) {
+        if (msg->msg != CURLMSG_DONE) {
+            continue;
+        }
+
+        proxy_stream_t *stream = NULL;
+        curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&stream);
+        CURLcode result = msg->data.result;
+        if (stream && stream->in_use) {
+            finish_stream(stream, result);
+        }
+    }
+}
+
+/**
+ * @brief Start proxying a request to go2rtc
+ */
+int go2rtc_proxy_stream_start(struct mg_connection *c, const char *url,
+                              const char *content_type, const char *body, size_t body_len,
+                              long timeout_seconds, const char *response_headers) {
+    if (!c || !url) {
+        return -1;
+    }
+
+    if (!g_multi) {
+        g_multi = curl_multi_init();
+        if (!g_multi) {
+            log_error("Failed to initialize curl multi handle for go2rtc proxy");
+            return -1;
+        }
+    }
+
+    proxy_stream_t *stream = NULL;
+    for (int i = 0; i < GO2RTC_PROXY_MAX_STREAMS; i++) {
+        if (!g_streams[i].in_use) {
+            stream = &g_streams[i];
+            break;
+        }
+    }
+    if (!stream) {
+        log_warn("All %d go2rtc proxy slots are in use", GO2RTC_PROXY_MAX_STREAMS);
+        return -1;
+    }
+
+    CURL *curl = go2rtc_client_acquire();
+    if (!curl) {
+        return -1;
+    }
+
+    memset(stream, 0, sizeof(*stream));
+    stream->in_use = true;
+    stream->c = c;
+    stream->curl = curl;
+    g_active_streams++;
+
+    if (response_headers) {
+        size_t len = strlen(response_headers);
+        if (len >= sizeof(stream->response_headers)) {
+            log_error("Proxy response headers too long");
+            release_stream(stream);
+            return -1;
+        }
+        memcpy(stream->response_headers, response_headers, len + 1);
+    }
+
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, PROXY_CONNECT_TIMEOUT_SECONDS);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, stream_write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, stream);
+    curl_easy_setopt(curl, CURLOPT_PRIVATE, stream);
+
+    if (body) {
+        // The size must be set before the body is copied
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body_len);
+        curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, body);
+    }
+
+    if (content_type) {
+        char header[128];
+        snprintf(header, sizeof(header), "Content-Type: %s", content_type);
+        stream->request_headers = curl_slist_append(NULL, header);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, stream->request_headers);
+    }
+
+    if (curl_multi_add_handle(g_multi, curl) != CURLM_OK) {
+        log_error("Failed to start proxied go2rtc request to %s", url);
+        release_stream(stream);
+        return -1;
+    }
+
+    c->data[2] = GO2RTC_PROXY_CONN_MARK;
+
+    // Send the request right away rather than on the next poll
+    perform_transfers(true);
+    return 0;
+}
+
+/**
+ * @brief Advance proxied transfers and resume the one of a drained connection
+ */
+void go2rtc_proxy_stream_poll(struct mg_connection *c) {
+    proxy_stream_t *stream = find_stream(c);
+    if (!stream) {
+        c->data[2] = 0;
+        return;
+    }
+
+    if (stream->paused && c->send.len < GO2RTC_PROXY_SEND_LIMIT) {
+        stream->paused = false;
+        curl_easy_pause(stream->curl, CURLPAUSE_CONT);
+    }
+
+    perform_transfers(false);
+}
+
+/**
+ * @brief Abort the proxied transfer of a closing connection
+ */
+void go2rtc_proxy_stream_close(struct mg_connection *c) {
+    proxy_stream_t *stream = find_stream(c);
+    if (stream) {
+        log_debug("Connection %lu closed, aborting proxied go2rtc request", c->id);
+        release_stream(stream);
+    }
+    c->data[2] = 0;
+}
@@ -42,11 +42,16 @@ void mg_handle_get_playback_continuous(struct mg_connection *c,
 #include "web/api_handlers_timeline.h"
 #include "web/api_handlers_users.h"
 #include "web/api_handlers_zones.h"
+#include "web/go2rtc_proxy_stream.h"
+#include "web/remux_http.h"
+#include "web/static_cache.h"
 #include "web/mongoose_adapter.h"
 
 // Forward declarations for timeline API handlers
 void mg_handle_get_timeline_segments(struct mg_connection *c,
                                      struct mg_http_message *hm);
+void mg_handle_get_timeline_coverage(struct mg_connection *c,
+                                     struct mg_http_message *hm);
 void mg_handle_timeline_manifest(struct mg_connection *c,
                                  struct mg_http_message *hm);
 void mg_handle_timeline_playback(struct mg_connection *c,
@@ -103,7 +108,8 @@ static const mg_api_route_t s_api_routes[] = {
 
     // Export & Calendar API
     {"GET", "/api/storage/removable", mg_handle_get_storage_removable, false},
-    {"POST", "/api/export", mg_handle_post_export, false},
+    {"POST", "/api/export", mg_handle_post_export,
+     true}, // Replies from the remux pool when the export is written
     {"GET", "/api/recordings/days", mg_handle_get_recording_days, false},
 
     // User Management API
@@ -234,15 +240,19 @@ static const mg_api_route_t s_api_routes[] = {
 
     // Clips API
     {"POST", "/api/clips/generate", mg_handle_post_clips_generate, true},
-    {"POST", "/api/clips/export", mg_handle_post_clips_export, true},
+    {"POST", "/api/clips/export", mg_handle_post_clips_export,
+     false}, // Plain file copy, runs on a bulk worker
     {"POST", "/api/clips/export-range", mg_handle_post_clips_export_range,
      true},
+    {"GET", "/api/clips/jobs/#", mg_handle_get_clip_job, true},
+    {"DELETE", "/api/clips/jobs/#", mg_handle_delete_clip_job, true},
     {"GET", "/api/clips", mg_handle_get_clips, false},
     {"DELETE", "/api/clips", mg_handle_delete_clips, false},
 
     // Timeline API
     {"GET", "/api/timeline/segments", mg_handle_get_timeline_segments,
      true}, // Opt out of auto-threading to prevent hanging
+    {"GET", "/api/timeline/coverage", mg_handle_get_timeline_coverage, true},
     {"GET", "/api/timeline/manifest", mg_handle_timeline_manifest, true},
     {"GET", "/api/timeline/play", mg_handle_timeline_playback, false},
     {"GET", "/api/playback/continuous", mg_handle_get_playback_continuous,
@@ -269,6 +279,42 @@ static const mg_api_route_t s_api_routes[] = {
     // End of table marker
     {NULL, NULL, NULL, false}};
 
+/**
+ * @brief Get the worker queue priority of a request
+ *
+ * Bulk transfers (downloads, exports, backups, syncs) yield to interactive
+ * API calls so a large download cannot starve timeline or status requests.
+ *
+ * @param uri Request URI
+ * @return Worker queue priority
+ */
+static mg_task_priority_t request_priority(struct mg_str uri) {
+  // Checked in order, the first matching path prefix wins
+  static const struct {
+    const char *prefix;
+    mg_task_priority_t priority;
+  } priorities[] = {
+      // Progress polls of a bulk operation are interactive
+      {"/api/recordings/batch-delete/progress/", MG_TASK_PRIORITY_HIGH},
+      {"/api/recordings/download/", MG_TASK_PRIORITY_BULK},
+      {"/api/recordings/batch-", MG_TASK_PRIORITY_BULK},
+      {"/api/recordings/sync", MG_TASK_PRIORITY_BULK},
+      {"/api/export", MG_TASK_PRIORITY_BULK},
+      {"/api/clips/export", MG_TASK_PRIORITY_BULK},
+      {"/api/system/backup", MG_TASK_PRIORITY_BULK},
+      {"/api/storage/download", MG_TASK_PRIORITY_BULK},
+      {"/api/storage/export", MG_TASK_PRIORITY_BULK},
+  };
+
+  for (size_t i = 0; i < sizeof(priorities) / sizeof(priorities[0]); i++) {
+    size_t len = strlen(priorities[i].prefix);
+    if (uri.len >= len && memcmp(uri.buf, priorities[i].prefix, len) == 0) {
+      return priorities[i].priority;
+    }
+  }
+  return MG_TASK_PRIORITY_HIGH;
+}
+
 /**
  * @brief Handle API request using the routes table
  *
@@ -305,37 +351,16 @@ static bool handle_api_request(struct mg_connection *c,
 
     // Check if this handler should be automatically threaded
     if (use_threading && !s_api_routes[route_index].no_auto_threading) {
-      // Handle in a separate thread using mg_thread_function
+      // Handle on the worker pool
       log_info("Handling API request in a worker thread: %s %s", method_buf,
                uri_buf);
 
-      // Create a thread data structure
-      struct mg_thread_data *data = calloc(1, sizeof(struct mg_thread_data));
-      if (!data) {
-        log_error("Failed to allocate memory for thread data");
-        mg_http_reply(c, 500, "", "Internal Server Error\n");
-        return true;
-      }
-
-      // Copy the HTTP message
-      data->message = mg_strdup(hm->message);
-      if (data->message.len == 0) {
-        log_error("Failed to duplicate HTTP message");
-        free(data);
-        mg_http_reply(c, 500, "", "Internal Server Error\n");
-        return true;
+      // Errors (including 503 when the queue is full) are answered by the call
+      if (mg_submit_request_to_worker(c, hm, s_api_routes[route_index].handler,
+                                      request_priority(hm->uri))) {
+        log_info("API request queued for a worker thread: %s %s", method_buf,
+                 uri_buf);
       }
-
-      // Set connection ID, manager, and handler function
-      data->conn_id = c->id;
-      data->mgr = c->mgr;
-      data->handler_func = s_api_routes[route_index].handler;
-
-      // Start thread
-      mg_start_thread(mg_thread_function, data);
-
-      log_info("API request started in a worker thread: %s %s", method_buf,
-               uri_buf);
       return true;
     } else {
       // Either threading is disabled or this handler has opted out of
@@ -453,7 +478,7 @@ http_server_handle_t mongoose_server_init(const http_server_config_t *config) {
 
   // HTTP server initialization complete
 
-  log_info("Using per-request threading for all requests");
+  log_info("Using a worker pool for threaded requests");
 
   server->handler_capacity = INITIAL_HANDLER_CAPACITY;
   server->handler_count = 0;
@@ -630,6 +655,13 @@ int http_server_start(http_server_handle_t server) {
     mg_tls_init(c, &opts);
   }
 
+  // Start the worker pool before the event loop can offload requests to it
+  if (mg_worker_pool_init(server->config.worker_threads,
+                          server->config.max_queued_requests) != 0) {
+    log_warn("Failed to start HTTP worker pool, threaded requests will use "
+             "dedicated threads");
+  }
+
   server->running = true;
   log_info("HTTP server started on port %d", server->config.port);
 
@@ -640,6 +672,7 @@ int http_server_start(http_server_handle_t server) {
                      server) != 0) {
     log_error("Failed to create server thread");
     server->running = false;
+    mg_worker_pool_shutdown();
     c->is_closing = 1;
     mg_mgr_poll(server->mgr, 0);
     return -1;
@@ -670,6 +703,9 @@ void http_server_stop(http_server_handle_t server) {
   server->running = false;
   log_info("Stopping HTTP server");
 
+  // Workers wake up the manager when they finish, stop them before it is freed
+  mg_worker_pool_shutdown();
+
   // Give connections time to close gracefully
   usleep(250000); // 250ms for connections to close
 
@@ -861,6 +897,9 @@ void http_server_destroy(http_server_handle_t server) {
   // Free route table
   free_route_table();
 
+  // Free cached web interface files
+  static_cache_cleanup();
+
   // Finally free the server structure
   free(server);
   log_info("HTTP server destroyed");
@@ -1136,24 +1175,7 @@ static void mongoose_event_handler(struct mg_connection *c, int ev,
       // Check if index.html exists
       struct stat st;
       if (stat(index_path, &st) == 0 && S_ISREG(st.st_mode)) {
-        // Use Mongoose's built-in file serving capabilities
-        struct mg_http_serve_opts opts = {
-            .root_dir = server->config.web_root,
-            .mime_types =
-                "html=text/html,htm=text/html,css=text/css,js=application/"
-                "javascript,"
-                "json=application/json,jpg=image/jpeg,jpeg=image/"
-                "jpeg,png=image/png,"
-                "gif=image/gif,svg=image/svg+xml,ico=image/x-icon,mp4=video/"
-                "mp4,"
-                "webm=video/webm,ogg=video/ogg,mp3=audio/mpeg,wav=audio/wav,"
-                "txt=text/plain,xml=application/xml,pdf=application/pdf",
-            .extra_headers = "Connection: close\r\n"};
-
-        log_info(
-            "Serving index file for root path using mg_http_serve_file: %s",
-            index_path);
-        mg_http_serve_file(c, hm, index_path, &opts);
+        mongoose_server_handle_static_file(c, hm, server);
       } else {
         // If index.html doesn't exist, redirect to /index.html with query
         // parameters preserved
@@ -1192,7 +1214,8 @@ static void mongoose_event_handler(struct mg_connection *c, int ev,
     } else {
       // For other requests, handle directly
       log_debug("Handling non-API request directly: %s", uri);
-      handled = mg_handle_request_with_threading(c, hm, false);
+      handled = mg_handle_request_with_threading(c, hm, false,
+                                                 request_priority(hm->uri));
     }
 
     // If not handled by API handlers or multithreading, serve static file or
@@ -1205,9 +1228,9 @@ static void mongoose_event_handler(struct mg_connection *c, int ev,
       memcpy(uri_buf, hm->uri.buf, uri_len);
       uri_buf[uri_len] = '\0';
 
-      log_info("Request not handled by API or multithreading, passing to "
-               "static file handler: %s",
-               uri_buf);
+      log_debug("Request not handled by API or multithreading, passing to "
+                "static file handler: %s",
+                uri_buf);
 
       // Try to serve static file
       mongoose_server_handle_static_file(c, hm, server);
@@ -1216,16 +1239,45 @@ static void mongoose_event_handler(struct mg_connection *c, int ev,
     // Connection closed
     log_debug("Connection closed");
 
+    // Stop any remux job still streaming to this connection
+    if (c->data[2] == REMUX_HTTP_CONN_MARK) {
+      remux_http_stream_close(c);
+    }
+
+    // Release any cached file still being streamed to this connection
+    if (c->data[2] == STATIC_CACHE_CONN_MARK) {
+      static_cache_stream_close(c);
+    }
+
+    // Abort any go2rtc request still being proxied to this connection
+    if (c->data[2] == GO2RTC_PROXY_CONN_MARK) {
+      go2rtc_proxy_stream_close(c);
+    }
+
     // Connection cleanup
     log_debug("Connection closed and cleaned up");
   } else if (ev == MG_EV_ERROR) {
     // Connection error
     log_error("Connection error: %s", (char *)ev_data);
   } else if (ev == MG_EV_POLL) {
-    // Poll event - do nothing
+    // Feed streamed remux output and large cached files to their connections
+    if (c->data[2] == REMUX_HTTP_CONN_MARK) {
+      remux_http_stream_poll(c);
+    } else if (c->data[2] == GO2RTC_PROXY_CONN_MARK) {
+      go2rtc_proxy_stream_poll(c);
+    } else if (c->data[2] == STATIC_CACHE_CONN_MARK) {
+      static_cache_stream_poll(c);
+    }
   } else if (ev == MG_EV_READ || ev == MG_EV_WRITE) {
     // Read/write events - normal socket operations
     // No need to log these high-frequency events
+    if (ev == MG_EV_WRITE && c->data[2] == REMUX_HTTP_CONN_MARK) {
+      remux_http_stream_poll(c);
+    } else if (ev == MG_EV_WRITE && c->data[2] == GO2RTC_PROXY_CONN_MARK) {
+      go2rtc_proxy_stream_poll(c);
+    } else if (ev == MG_EV_WRITE && c->data[2] == STATIC_CACHE_CONN_MARK) {
+      static_cache_stream_poll(c);
+    }
   } else if (ev == 7) {
     // Event 7 - handle silently to avoid log spam
   } else if (ev == 8) {
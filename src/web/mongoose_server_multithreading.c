@@ -3,13 +3,18 @@
  * @brief Multithreading support for Mongoose server
  *
  * This file implements multithreading support for the Mongoose server,
- * allowing it to handle multiple requests in parallel.
+ * allowing it to handle multiple requests in parallel. Offloaded requests
+ * are executed by a fixed pool of worker threads fed from a bounded,
+ * two-level priority queue.
  */
 
+#define _GNU_SOURCE
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <pthread.h>
+#include <time.h>
 #include <unistd.h>
 
 #include "web/mongoose_server.h"
@@ -19,6 +24,380 @@
 
 // Thread data structure is defined in the header file
 
+// Seconds to wait for busy workers when the pool is stopped
+#define WORKER_POOL_SHUTDOWN_TIMEOUT 5
+
+// Worker pool state, protected by mutex
+static struct {
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  pthread_t *threads;
+  int num_threads;
+  int max_queue_depth;
+  bool running;
+  struct mg_thread_data *head[MG_TASK_PRIORITY_COUNT];
+  struct mg_thread_data *tail[MG_TASK_PRIORITY_COUNT];
+  int queue_depth;
+  int active_workers;
+  uint64_t completed;
+  uint64_t rejected;
+  double total_wait_ms;
+  double max_wait_ms;
+  double total_exec_ms;
+  double max_exec_ms;
+  // Bumped when the pool stops: the event manager may be freed from then on, so
+  // requests of an older generation must not be answered with mg_wakeup
+  unsigned int generation;
+} s_pool = {
+  .mutex = PTHREAD_MUTEX_INITIALIZER,
+  .cond = PTHREAD_COND_INITIALIZER,
+};
+
+static double elapsed_ms(const struct timespec *start, const struct timespec *end) {
+  return (double)(end->tv_sec - start->tv_sec) * 1000.0 +
+         (double)(end->tv_nsec - start->tv_nsec) / 1000000.0;
+}
+
+static void free_thread_data(struct mg_thread_data *data) {
+  free((void *) data->message.buf);
+  free(data);
+}
+
+/**
+ * @brief Hand a worker's response to the event loop, unless the pool stopped since
+ */
+static void deliver_response(struct mg_thread_data *data, const void *buf, size_t len) {
+  pthread_mutex_lock(&s_pool.mutex);
+  if (data->generation == s_pool.generation) {
+    mg_wakeup(data->mgr, data->conn_id, buf, len);
+  } else {
+    log_debug("Worker pool stopped, dropping response for connection ID %lu", data->conn_id);
+  }
+  pthread_mutex_unlock(&s_pool.mutex);
+}
+
+/**
+ * @brief Point a string of a parsed message at the same bytes in a copy of the message
+ */
+static struct mg_str rebase_str(struct mg_str s, const char *old_base, size_t len,
+                                const char *new_base) {
+  if (s.buf == NULL) {
+    return s;
+  }
+
+  uintptr_t start = (uintptr_t) old_base;
+  uintptr_t pos = (uintptr_t) s.buf;
+  if (pos < start || pos + s.len > start + len) {
+    // Not part of the message, drop it rather than keep a dangling pointer
+    return mg_str_n(NULL, 0);
+  }
+
+  return mg_str_n(new_base + (pos - start), s.len);
+}
+
+/**
+ * @brief Rebase a parsed HTTP message onto a copy of its raw bytes
+ */
+static void rebase_http_message(const struct mg_http_message *src, struct mg_str copy,
+                                struct mg_http_message *dst) {
+  const char *base = src->message.buf;
+  size_t len = src->message.len;
+
+  memset(dst, 0, sizeof(*dst));
+  dst->method = rebase_str(src->method, base, len, copy.buf);
+  dst->uri = rebase_str(src->uri, base, len, copy.buf);
+  dst->query = rebase_str(src->query, base, len, copy.buf);
+  dst->proto = rebase_str(src->proto, base, len, copy.buf);
+  for (int i = 0; i < MG_MAX_HTTP_HEADERS && src->headers[i].name.len > 0; i++) {
+    dst->headers[i].name = rebase_str(src->headers[i].name, base, len, copy.buf);
+    dst->headers[i].value = rebase_str(src->headers[i].value, base, len, copy.buf);
+  }
+  dst->body = rebase_str(src->body, base, len, copy.buf);
+  dst->head = rebase_str(src->head, base, len, copy.buf);
+  dst->message = copy;
+}
+
+/**
+ * @brief Take the next request off the queue, highest priority first
+ *
+ * Must be called with the pool mutex held and a non-empty queue.
+ */
+static struct mg_thread_data *dequeue_locked(void) {
+  for (int i = 0; i < MG_TASK_PRIORITY_COUNT; i++) {
+    struct mg_thread_data *data = s_pool.head[i];
+    if (data) {
+      s_pool.head[i] = data->next;
+      if (!s_pool.head[i]) {
+        s_pool.tail[i] = NULL;
+      }
+      data->next = NULL;
+      s_pool.queue_depth--;
+      return data;
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Worker pool thread: executes queued requests until the pool stops
+ */
+static void *worker_pool_thread(void *arg) {
+  (void) arg;
+
+  pthread_mutex_lock(&s_pool.mutex);
+  while (true) {
+    while (s_pool.running && s_pool.queue_depth == 0) {
+      pthread_cond_wait(&s_pool.cond, &s_pool.mutex);
+    }
+    if (!s_pool.running) {
+      break;
+    }
+
+    struct mg_thread_data *data = dequeue_locked();
+    s_pool.active_workers++;
+    pthread_mutex_unlock(&s_pool.mutex);
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double wait_ms = elapsed_ms(&data->enqueue_time, &start);
+
+    // mg_thread_function frees the request
+    mg_thread_function(data);
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double exec_ms = elapsed_ms(&start, &end);
+
+    pthread_mutex_lock(&s_pool.mutex);
+    s_pool.active_workers--;
+    s_pool.completed++;
+    s_pool.total_wait_ms += wait_ms;
+    s_pool.total_exec_ms += exec_ms;
+    if (wait_ms > s_pool.max_wait_ms) s_pool.max_wait_ms = wait_ms;
+    if (exec_ms > s_pool.max_exec_ms) s_pool.max_exec_ms = exec_ms;
+  }
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  return NULL;
+}
+
+/**
+ * @brief Start the worker pool used for offloaded requests
+ */
+int mg_worker_pool_init(int num_threads, int max_queue_depth) {
+  if (num_threads <= 0) {
+    num_threads = MG_WORKER_POOL_DEFAULT_THREADS;
+  }
+  if (max_queue_depth <= 0) {
+    max_queue_depth = MG_WORKER_POOL_DEFAULT_QUEUE_DEPTH;
+  }
+
+  pthread_mutex_lock(&s_pool.mutex);
+  if (s_pool.running) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    log_warn("Worker pool is already running");
+    return 0;
+  }
+
+  s_pool.threads = calloc(num_threads, sizeof(pthread_t));
+  if (!s_pool.threads) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    log_error("Failed to allocate memory for worker pool threads");
+    return -1;
+  }
+
+  s_pool.max_queue_depth = max_queue_depth;
+  s_pool.queue_depth = 0;
+  s_pool.active_workers = 0;
+  s_pool.completed = 0;
+  s_pool.rejected = 0;
+  s_pool.total_wait_ms = 0;
+  s_pool.max_wait_ms = 0;
+  s_pool.total_exec_ms = 0;
+  s_pool.max_exec_ms = 0;
+  s_pool.running = true;
+
+  int started = 0;
+  for (int i = 0; i < num_threads; i++) {
+    if (pthread_create(&s_pool.threads[i], NULL, worker_pool_thread, NULL) != 0) {
+      log_error("Failed to create worker pool thread %d", i);
+      break;
+    }
+    started++;
+  }
+  s_pool.num_threads = started;
+
+  if (started == 0) {
+    s_pool.running = false;
+    free(s_pool.threads);
+    s_pool.threads = NULL;
+    pthread_mutex_unlock(&s_pool.mutex);
+    return -1;
+  }
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  log_info("Started HTTP worker pool with %d threads (queue limit: %d)", started, max_queue_depth);
+  return 0;
+}
+
+/**
+ * @brief Stop the worker pool
+ */
+void mg_worker_pool_shutdown(void) {
+  pthread_mutex_lock(&s_pool.mutex);
+  if (!s_pool.running) {
+    // Requests on fallback threads must not reach the manager either
+    s_pool.generation++;
+    pthread_mutex_unlock(&s_pool.mutex);
+    return;
+  }
+  s_pool.running = false;
+
+  // Drop requests that never started, their clients get a 503
+  int dropped = 0;
+  struct mg_thread_data *data;
+  while ((data = dequeue_locked()) != NULL) {
+    static const char busy[] = "HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
+    mg_wakeup(data->mgr, data->conn_id, busy, sizeof(busy) - 1);
+    free_thread_data(data);
+    dropped++;
+  }
+
+  pthread_cond_broadcast(&s_pool.cond);
+  pthread_t *threads = s_pool.threads;
+  int num_threads = s_pool.num_threads;
+  s_pool.threads = NULL;
+  s_pool.num_threads = 0;
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  if (dropped > 0) {
+    log_info("Dropped %d queued requests while stopping the worker pool", dropped);
+  }
+
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += WORKER_POOL_SHUTDOWN_TIMEOUT;
+
+  for (int i = 0; i < num_threads; i++) {
+    if (pthread_timedjoin_np(threads[i], NULL, &deadline) != 0) {
+      log_warn("Worker pool thread %d did not finish in time, detaching it", i);
+      pthread_detach(threads[i]);
+    }
+  }
+  free(threads);
+
+  // Detached workers finish without answering, the caller frees the manager next
+  pthread_mutex_lock(&s_pool.mutex);
+  s_pool.generation++;
+  pthread_mutex_unlock(&s_pool.mutex);
+
+  log_info("HTTP worker pool stopped");
+}
+
+/**
+ * @brief Queue a request for execution on the worker pool
+ */
+bool mg_worker_pool_submit(struct mg_thread_data *data, mg_task_priority_t priority) {
+  if (priority < 0 || priority >= MG_TASK_PRIORITY_COUNT) {
+    priority = MG_TASK_PRIORITY_BULK;
+  }
+
+  data->priority = priority;
+  data->next = NULL;
+  clock_gettime(CLOCK_MONOTONIC, &data->enqueue_time);
+
+  pthread_mutex_lock(&s_pool.mutex);
+  data->generation = s_pool.generation;
+  if (!s_pool.running) {
+    pthread_mutex_unlock(&s_pool.mutex);
+    // No pool (e.g. during startup or in tools), fall back to a dedicated thread
+    mg_start_thread(mg_thread_function, data);
+    return true;
+  }
+
+  if (s_pool.queue_depth >= s_pool.max_queue_depth) {
+    s_pool.rejected++;
+    pthread_mutex_unlock(&s_pool.mutex);
+    return false;
+  }
+
+  if (s_pool.tail[priority]) {
+    s_pool.tail[priority]->next = data;
+  } else {
+    s_pool.head[priority] = data;
+  }
+  s_pool.tail[priority] = data;
+  s_pool.queue_depth++;
+
+  pthread_cond_signal(&s_pool.cond);
+  pthread_mutex_unlock(&s_pool.mutex);
+  return true;
+}
+
+/**
+ * @brief Copy a request and hand it to a worker with the given handler
+ */
+bool mg_submit_request_to_worker(struct mg_connection *c, struct mg_http_message *hm,
+                                 void (*handler_func)(struct mg_connection *c, struct mg_http_message *hm),
+                                 mg_task_priority_t priority) {
+  struct mg_thread_data *data = calloc(1, sizeof(*data));
+  if (!data) {
+    log_error("Failed to allocate memory for thread data");
+    mg_http_reply(c, 500, "", "Internal Server Error\n");
+    return false;
+  }
+
+  // Copy the HTTP message
+  data->message = mg_strdup(hm->message);
+  if (data->message.len == 0) {
+    log_error("Failed to duplicate HTTP message");
+    free(data);
+    mg_http_reply(c, 500, "", "Internal Server Error\n");
+    return false;
+  }
+
+  // Reuse the parse done by the event loop
+  rebase_http_message(hm, data->message, &data->hm);
+  data->has_parsed_message = true;
+
+  // Set connection ID, manager, and handler function
+  data->conn_id = c->id;
+  data->mgr = c->mgr;
+  data->handler_func = handler_func;
+
+  if (!mg_worker_pool_submit(data, priority)) {
+    log_warn("Worker queue full, rejecting request: %.*s %.*s",
+             (int)hm->method.len, hm->method.buf, (int)hm->uri.len, hm->uri.buf);
+    free_thread_data(data);
+    mg_http_reply(c, 503, "Content-Type: application/json\r\nRetry-After: 1\r\n",
+                  "{\"error\": \"Server busy, please retry\"}\n");
+    return false;
+  }
+
+  return true;
+}
+
+/**
+ * @brief Get worker pool statistics
+ */
+void mg_worker_pool_get_stats(mg_worker_pool_stats_t *stats) {
+  if (!stats) {
+    return;
+  }
+
+  pthread_mutex_lock(&s_pool.mutex);
+  stats->num_threads = s_pool.num_threads;
+  stats->active_workers = s_pool.active_workers;
+  stats->queue_depth = s_pool.queue_depth;
+  stats->max_queue_depth = s_pool.max_queue_depth;
+  stats->completed = s_pool.completed;
+  stats->rejected = s_pool.rejected;
+  stats->avg_queue_wait_ms = s_pool.completed ? s_pool.total_wait_ms / s_pool.completed : 0.0;
+  stats->max_queue_wait_ms = s_pool.max_wait_ms;
+  stats->avg_exec_ms = s_pool.completed ? s_pool.total_exec_ms / s_pool.completed : 0.0;
+  stats->max_exec_ms = s_pool.max_exec_ms;
+  pthread_mutex_unlock(&s_pool.mutex);
+}
+
 /**
  * @brief Start a thread
  *
@@ -57,9 +436,16 @@ void *mg_thread_function(void *param) {
   fake_conn.mgr = p->mgr;
   fake_conn.id = p->conn_id;
 
-  // Create HTTP message from the stored message
+  // Use the message parsed by the event loop when available
   struct mg_http_message hm = {0};
-  if (mg_http_parse((char *)p->message.buf, p->message.len, &hm) > 0) {
+  bool parsed = p->has_parsed_message;
+  if (parsed) {
+    hm = p->hm;
+  } else {
+    parsed = mg_http_parse((char *)p->message.buf, p->message.len, &hm) > 0;
+  }
+
+  if (parsed) {
     // Extract URI for logging
     char uri[256] = {0};
     if (hm.uri.len > 0) {
@@ -84,14 +470,14 @@ void *mg_thread_function(void *param) {
       if (fake_conn.send.buf && fake_conn.send.len > 0) {
         // Send the response back to the parent connection
         log_debug("Handler sent response of length %zu", fake_conn.send.len);
-        mg_wakeup(p->mgr, p->conn_id, fake_conn.send.buf, fake_conn.send.len);
+        deliver_response(p, fake_conn.send.buf, fake_conn.send.len);
 
         // Free the send buffer if it was allocated
         free((void *)fake_conn.send.buf);
       } else {
         // No response was sent, send a default response
         log_debug("Handler did not send a response, sending default");
-        mg_wakeup(p->mgr, p->conn_id, "Handler completed", 16);
+        deliver_response(p, "Handler completed", 16);
       }
     } else {
       // Try to find a handler for this URI
@@ -100,23 +486,22 @@ void *mg_thread_function(void *param) {
       // Special handling for root path
       if (strcmp(uri, "/") == 0) {
         log_info("Root path detected in thread function, sending redirect to static handler");
-        mg_wakeup(p->mgr, p->conn_id, "HTTP/1.1 302 Found\r\nLocation: /index.html\r\nContent-Length: 0\r\n\r\n", 65);
+        deliver_response(p, "HTTP/1.1 302 Found\r\nLocation: /index.html\r\nContent-Length: 0\r\n\r\n", 65);
       } else {
-        mg_wakeup(p->mgr, p->conn_id, "No handler for request", 21);
+        deliver_response(p, "No handler for request", 21);
       }
     }
   } else {
     // Failed to parse HTTP message
     log_error("Failed to parse HTTP message");
-    mg_wakeup(p->mgr, p->conn_id, "Failed to parse request", 22);
+    deliver_response(p, "Failed to parse request", 22);
   }
 
   // Save connection ID before freeing the structure
   unsigned long conn_id = p->conn_id;
 
   // Free resources
-  free((void *) p->message.buf);
-  free(p);
+  free_thread_data(p);
 
   log_debug("Worker thread completed for connection ID %lu", conn_id);
   return NULL;
@@ -128,12 +513,13 @@ void *mg_thread_function(void *param) {
  * @param c Mongoose connection
  * @param hm HTTP message
  * @param fast_path If true, handle the request in the main thread
- * @param handler_func Handler function to call
+ * @param priority Worker queue priority when the request is offloaded
  * @return true if the request was handled, false otherwise
  */
 bool mg_handle_request_with_threading(struct mg_connection *c,
                                      struct mg_http_message *hm,
-                                     bool fast_path) {
+                                     bool fast_path,
+                                     mg_task_priority_t priority) {
   if (fast_path) {
     // Fast path - handle in the main thread
     // This is useful for simple requests that don't need to be processed in a separate thread
@@ -143,43 +529,12 @@ bool mg_handle_request_with_threading(struct mg_connection *c,
     // Return false to let the normal request handling continue
     return false;
   } else {
-    // Multithreading path - spawn a thread to handle the request
-    log_debug("Spawning thread to handle request: %.*s",
+    // Multithreading path - queue the request for the worker pool
+    log_debug("Handling request with threading: %.*s",
              (int)hm->uri.len, hm->uri.buf);
 
-    // Extract URI for logging
-    char uri[256];
-    size_t uri_len = hm->uri.len < sizeof(uri) - 1 ? hm->uri.len : sizeof(uri) - 1;
-    memcpy(uri, hm->uri.buf, uri_len);
-    uri[uri_len] = '\0';
-
-    log_debug("Handling request with threading: %s", uri);
-
-    // Allocate thread data
-    struct mg_thread_data *data =
-        (struct mg_thread_data *) calloc(1, sizeof(*data));
-
-    if (!data) {
-      log_error("Failed to allocate memory for thread data");
-      mg_http_reply(c, 500, "", "Internal Server Error\n");
-      return true;
-    }
-
-    // Copy the HTTP message
-    data->message = mg_strdup(hm->message);
-    if (data->message.len == 0) {
-      log_error("Failed to duplicate HTTP message");
-      free(data);
-      mg_http_reply(c, 500, "", "Internal Server Error\n");
-      return true;
-    }
-
-    // Set connection ID, manager, and handler function
-    data->conn_id = c->id;
-    data->mgr = c->mgr;
-
-    // Start thread
-    mg_start_thread(mg_thread_function, data);
+    // Errors (including 503 when the queue is full) are answered by the call
+    mg_submit_request_to_worker(c, hm, NULL, priority);
 
     return true;
   }
@@ -8,6 +8,7 @@
 #include "web/mongoose_server_static.h"
 #include "web/mongoose_adapter.h"
 #include "web/mongoose_server_auth.h"
+#include "web/static_cache.h"
 #include "core/logger.h"
 #include "core/config.h"
 #include "video/streams.h"
@@ -20,6 +21,13 @@
 // Buffer size for URLs
 #define URL_BUFFER_SIZE 2048
 
+// Extra headers for scripts and stylesheets
+#define STATIC_SCRIPT_HEADERS \
+    "Connection: close\r\n" \
+    "Access-Control-Allow-Origin: *\r\n" \
+    "Access-Control-Allow-Methods: GET, OPTIONS\r\n" \
+    "Access-Control-Allow-Headers: Origin, Content-Type, Accept, Authorization\r\n"
+
 // Include Mongoose
 #include "mongoose.h"
 
@@ -34,34 +42,7 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
     memcpy(uri, hm->uri.buf, uri_len);
     uri[uri_len] = '\0';
     
-    // Check if this is a static asset that should bypass authentication
-    bool is_static_asset = false;
-    if (strncmp(uri, "/js/", 4) == 0 || 
-        strncmp(uri, "/css/", 5) == 0 || 
-        strncmp(uri, "/img/", 5) == 0 || 
-        strncmp(uri, "/fonts/", 7) == 0 ||
-        strstr(uri, ".js") != NULL ||
-        strstr(uri, ".css") != NULL ||
-        strstr(uri, ".map") != NULL ||
-        strstr(uri, ".ico") != NULL) {
-        is_static_asset = true;
-    }
-    
-    // Debug log to check URI
-    log_info("Processing request for URI: %s, is_static_asset: %d", uri, is_static_asset);
-    
-    // Always allow login page without authentication
-    if (strcmp(uri, "/login") == 0 || strcmp(uri, "/login.html") == 0) {
-        log_info("Login page requested, bypassing authentication");
-        // Continue processing without authentication check
-    }
-    // Skip authentication for static assets
-    else if (is_static_asset) {
-        log_debug("Bypassing authentication for static asset: %s", uri);
-        // Continue processing without authentication check
-    }
-    // Authentication is already checked in the main event handler
-    // No need to check it again here
+    log_debug("Processing static request for URI: %s", uri);
 
     // Check if this is an API request
     if (strncmp(uri, "/api/", 5) == 0) {
@@ -77,12 +58,12 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
         config_t *global_config = &g_config;
         
         // Check for authentication
-        log_info("Processing HLS request: %s", uri);
+        log_debug("Processing HLS request: %s", uri);
         
         // Log all headers for debugging
         for (int i = 0; i < MG_MAX_HTTP_HEADERS; i++) {
             if (hm->headers[i].name.len == 0) break;
-            log_info("HLS request header: %.*s: %.*s", 
+            log_debug("HLS request header: %.*s: %.*s", 
                     (int)hm->headers[i].name.len, hm->headers[i].name.buf,
                     (int)hm->headers[i].value.len, hm->headers[i].value.buf);
         }
@@ -127,7 +108,7 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
         char go2rtc_hls_url[URL_BUFFER_SIZE];
         if (go2rtc_integration_get_hls_url(decoded_stream_name, go2rtc_hls_url, sizeof(go2rtc_hls_url))) {
             // Stream is using go2rtc for HLS, but we'll serve the files directly
-            log_info("Stream %s is using go2rtc for HLS, but serving files directly from filesystem", decoded_stream_name);
+            log_debug("Stream %s is using go2rtc for HLS, but serving files directly from filesystem", decoded_stream_name);
             // No redirection needed as go2rtc writes HLS segments to our HLS directory
         }
         #endif
@@ -142,14 +123,14 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
         if (global_config->storage_path_hls[0] != '\0') {
             snprintf(hls_file_path, sizeof(hls_file_path), "%s/hls/%s/%s", 
                     global_config->storage_path_hls, decoded_stream_name, file_name);
-            log_info("Using HLS-specific storage path: %s", global_config->storage_path_hls);
+            log_debug("Using HLS-specific storage path: %s", global_config->storage_path_hls);
         } else {
             snprintf(hls_file_path, sizeof(hls_file_path), "%s/hls/%s/%s", 
                     global_config->storage_path, decoded_stream_name, file_name);
-            log_info("Using default storage path for HLS: %s", global_config->storage_path);
+            log_debug("Using default storage path for HLS: %s", global_config->storage_path);
         }
         
-        log_info("Serving HLS file directly: %s", hls_file_path);
+        log_debug("Serving HLS file directly: %s", hls_file_path);
         
         // Check if file exists
         struct stat st;
@@ -217,7 +198,7 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
             // File doesn't exist - let the client know
             // We don't need to create dummy files since FFmpeg integration 
             // is responsible for creating the actual HLS files
-            log_info("HLS file not found: %s (waiting for FFmpeg to create it)", hls_file_path);
+            log_debug("HLS file not found: %s (waiting for FFmpeg to create it)", hls_file_path);
             
             // Return a 404 with a message that indicates the file is being generated
             mg_http_reply(c, 404, "", "{\"error\": \"HLS file not found or still being generated by FFmpeg\"}\n");
@@ -227,7 +208,7 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
 
     // Special handling for login page - redirect /login to /login.html
     if (strcmp(uri, "/login") == 0) {
-        log_info("Redirecting /login to /login.html");
+        log_debug("Redirecting /login to /login.html");
         mg_printf(c, "HTTP/1.1 302 Found\r\n");
         mg_printf(c, "Location: /login.html\r\n");
         mg_printf(c, "Connection: close\r\n");
@@ -238,7 +219,7 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
 
     // Special handling for logout - redirect to login page
     if (strcmp(uri, "/logout") == 0) {
-        log_info("Redirecting /logout to /login.html");
+        log_debug("Redirecting /logout to /login.html");
         mg_printf(c, "HTTP/1.1 302 Found\r\n");
         mg_printf(c, "Location: /login.html?logout=1\r\n");
         mg_printf(c, "Set-Cookie: session=; Path=/; Max-Age=0\r\n");  // Clear session cookie
@@ -248,151 +229,70 @@ void mongoose_server_handle_static_file(struct mg_connection *c, struct mg_http_
         return;
     }
 
-    // Special handling for root path or index.html
-    if (strcmp(uri, "/") == 0 || strcmp(uri, "/index.html") == 0) {
-        // Check if WebRTC is disabled in the configuration
-        config_t *global_config = &g_config;
-        if (global_config->webrtc_disabled) {
-            // WebRTC is disabled, serve hls.html directly
-            log_info("WebRTC is disabled, serving hls.html instead of index.html");
-
-            // Use hls.html path instead
-            char index_path[MAX_PATH_LENGTH * 2];
-            snprintf(index_path, sizeof(index_path), "%s/hls.html", server->config.web_root);
+    // Serve hls.html in place of index.html when WebRTC is disabled
+    const char *rel_path = uri;
+    bool is_index = strcmp(uri, "/") == 0 || strcmp(uri, "/index.html") == 0;
+    if (is_index) {
+        rel_path = g_config.webrtc_disabled ? "/hls.html" : "/index.html";
+    }
 
-            // Log the path we're trying to serve
-            log_info("Serving hls.html: %s", index_path);
+    // Never serve anything outside the web root
+    if (strstr(rel_path, "..") != NULL) {
+        mg_http_reply(c, 404, "", "404 Not Found\n");
+        return;
+    }
 
-            // Use Mongoose's built-in file serving capabilities
-            struct mg_http_serve_opts opts = {
-                .root_dir = server->config.web_root,
-                .mime_types = "html=text/html",
-                .extra_headers = "Connection: close\r\n"
-            };
+    char file_path[MAX_PATH_LENGTH * 2];
+    snprintf(file_path, sizeof(file_path), "%s%s", server->config.web_root, rel_path);
 
-            mg_http_serve_file(c, hm, index_path, &opts);
-            return;
+    struct stat st;
+    if (stat(file_path, &st) != 0) {
+        if (is_index) {
+            log_error("Index file not found for root path: %s", file_path);
+            mg_http_reply(c, 404, "", "404 Not Found - Index file missing\n");
+        } else {
+            log_debug("Static file not found: %s", file_path);
+            mg_http_reply(c, 404, "", "404 Not Found\n");
         }
+        return;
+    }
 
-        // WebRTC is enabled, serve index.html as normal
-        char index_path[MAX_PATH_LENGTH * 2];
-
-        // Add debug logging to help diagnose the issue
-        log_info("Root path requested, web_root: %s", server->config.web_root);
-
-        // Use a direct path to index.html
-        snprintf(index_path, sizeof(index_path), "%s/index.html", server->config.web_root);
-
-        // Log the path we're trying to serve
-        log_info("Serving root path with index file: %s", index_path);
-
-        // Check if index.html exists
-        struct stat st;
-        if (stat(index_path, &st) == 0 && S_ISREG(st.st_mode)) {
-            // Use Mongoose's built-in file serving capabilities
-            struct mg_http_serve_opts opts = {
-                .root_dir = server->config.web_root,
-                .mime_types = "html=text/html,htm=text/html,css=text/css,js=application/javascript,"
-                             "json=application/json,jpg=image/jpeg,jpeg=image/jpeg,png=image/png,"
-                             "gif=image/gif,svg=image/svg+xml,ico=image/x-icon,mp4=video/mp4,"
-                             "webm=video/webm,ogg=video/ogg,mp3=audio/mpeg,wav=audio/wav,"
-                             "txt=text/plain,xml=application/xml,pdf=application/pdf",
-                .extra_headers = "Connection: close\r\n"
-            };
-
-            log_info("Serving index file for root path using mg_http_serve_file: %s", index_path);
-            mg_http_serve_file(c, hm, index_path, &opts);
-            return;
-        } else {
-            log_error("Index file not found for root path: %s", index_path);
-            mg_http_reply(c, 404, "", "404 Not Found - Index file missing\n");
+    if (S_ISDIR(st.st_mode)) {
+        // Try to serve index.html as the index
+        size_t len = strlen(file_path);
+        snprintf(file_path + len, sizeof(file_path) - len, "%sindex.html",
+                 file_path[len - 1] == '/' ? "" : "/");
+        if (stat(file_path, &st) != 0 || !S_ISREG(st.st_mode)) {
+            mg_http_reply(c, 403, "", "403 Forbidden\n");
             return;
         }
-    } else {
-        // For non-root paths, construct file path
-        char file_path[MAX_PATH_LENGTH * 2];
-        snprintf(file_path, sizeof(file_path), "%s%s", server->config.web_root, uri);
+    }
 
-        // Check if file exists
-        struct stat st;
-        if (stat(file_path, &st) == 0) {
-            // Check if it's a directory
-            if (S_ISDIR(st.st_mode)) {
-                // Try to serve index.html as the index
-                strncat(file_path, "index.html", sizeof(file_path) - strlen(file_path) - 1);
-                if (stat(file_path, &st) != 0 || !S_ISREG(st.st_mode)) {
-                    mg_http_reply(c, 403, "", "403 Forbidden\n");
-                    return;
-                }
-            }
+    // Scripts and stylesheets keep their CORS headers
+    const char *extra_headers = "Connection: close\r\n";
+    if (strstr(file_path, ".js") != NULL || strstr(file_path, ".css") != NULL) {
+        extra_headers = STATIC_SCRIPT_HEADERS;
+    }
 
-            // Serve the file without any locks
-            // This is a critical optimization for static content
-            
-            // Add special handling for JavaScript files to improve Firefox compatibility
-            if (strstr(file_path, ".js") != NULL) {
-                // For JavaScript files, add specific headers for Firefox
-                // Create a new opts struct for each request to avoid race conditions
-                const char js_headers[] = 
-                    "Content-Type: application/javascript\r\n"
-                    "Cache-Control: no-store\r\n"
-                    "Connection: close\r\n"
-                    "Access-Control-Allow-Origin: *\r\n"
-                    "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
-                    "Access-Control-Allow-Headers: Origin, Content-Type, Accept, Authorization\r\n";
-                
-                // Create a new struct for each request
-                struct mg_http_serve_opts js_opts = {
-                    .mime_types = "",
-                    .extra_headers = js_headers,
-                    .root_dir = server->config.web_root
-                };
-                
-                log_debug("Serving JavaScript file with Firefox-friendly headers: %s", file_path);
-                mg_http_serve_file(c, hm, file_path, &js_opts);
-            } 
-            // Add special handling for CSS files to improve Firefox compatibility
-            else if (strstr(file_path, ".css") != NULL) {
-                // For CSS files, add specific headers for Firefox
-                // Create a new opts struct for each request to avoid race conditions
-                const char css_headers[] = 
-                    "Content-Type: text/css\r\n"
-                    "Cache-Control: no-store\r\n"
-                    "Connection: close\r\n"
-                    "Access-Control-Allow-Origin: *\r\n"
-                    "Access-Control-Allow-Methods: GET, OPTIONS\r\n"
-                    "Access-Control-Allow-Headers: Origin, Content-Type, Accept, Authorization\r\n";
-                
-                // Create a new struct for each request
-                struct mg_http_serve_opts css_opts = {
-                    .mime_types = "",
-                    .extra_headers = css_headers,
-                    .root_dir = server->config.web_root
-                };
-                
-                log_debug("Serving CSS file with Firefox-friendly headers: %s", file_path);
-                mg_http_serve_file(c, hm, file_path, &css_opts);
-            } else {
-                // For other files, use standard options
-                // Create a new opts struct for each request to avoid race conditions
-                struct mg_http_serve_opts std_opts = {
-                    .mime_types = "html=text/html,htm=text/html,css=text/css,js=application/javascript,"
-                                "json=application/json,jpg=image/jpeg,jpeg=image/jpeg,png=image/png,"
-                                "gif=image/gif,svg=image/svg+xml,ico=image/x-icon,mp4=video/mp4,"
-                                "webm=video/webm,ogg=video/ogg,mp3=audio/mpeg,wav=audio/wav,"
-                                "txt=text/plain,xml=application/xml,pdf=application/pdf",
-                    .root_dir = server->config.web_root,
-                    .extra_headers = "Connection: close\r\n"
-                };
-                
-                mg_http_serve_file(c, hm, file_path, &std_opts);
-            }
-            return;
-        }
+    if (static_cache_serve(c, hm, file_path, extra_headers) == 0) {
+        return;
     }
 
-    // File not found
-    mg_http_reply(c, 404, "", "404 Not Found\n");
+    // Files too large for the cache are streamed from disk, with the same caching policy
+    char fallback_headers[512];
+    snprintf(fallback_headers, sizeof(fallback_headers), "%sCache-Control: %s\r\n",
+             extra_headers, static_cache_control(file_path));
+
+    struct mg_http_serve_opts opts = {
+        .mime_types = "html=text/html,htm=text/html,css=text/css,js=application/javascript,"
+                      "json=application/json,jpg=image/jpeg,jpeg=image/jpeg,png=image/png,"
+                      "gif=image/gif,svg=image/svg+xml,ico=image/x-icon,mp4=video/mp4,"
+                      "webm=video/webm,ogg=video/ogg,mp3=audio/mpeg,wav=audio/wav,"
+                      "txt=text/plain,xml=application/xml,pdf=application/pdf",
+        .root_dir = server->config.web_root,
+        .extra_headers = fallback_headers
+    };
+    mg_http_serve_file(c, hm, file_path, &opts);
 }
 
 /**
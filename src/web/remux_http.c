@@ -0,0 +1,323 @@
+/**
+ * @file remux_http.c
+ * @brief HTTP delivery of remux engine output
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "core/logger.h"
+#include "web/remux_http.h"
+
+/**
+ * @brief Buffer between a remux job (producer) and its connection (consumer)
+ *
+ * The slot is released once both sides are done with it: the job when its
+ * completion callback ran, the connection when it was closed or the response
+ * was finished.
+ */
+typedef struct {
+  bool in_use;
+  unsigned long conn_id;
+  char job_id[64];
+
+  uint8_t *buffer;    // Ring of REMUX_HTTP_BUFFER_SIZE bytes
+  size_t head;
+  size_t len;
+
+  bool job_done;      // Completion callback ran
+  bool job_success;
+  bool job_cancelled; // Job was cancelled, the writer must not wait for room
+  bool conn_done;     // Connection closed or response finished
+} remux_http_stream_t;
+
+static remux_http_stream_t g_streams[REMUX_HTTP_MAX_STREAMS];
+static pthread_mutex_t g_streams_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t g_space_cond = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief Release a slot once both sides are done. Called with the mutex held.
+ */
+static void release_if_done(remux_http_stream_t *stream) {
+  if (stream->job_done && stream->conn_done) {
+    free(stream->buffer);
+    memset(stream, 0, sizeof(*stream));
+  }
+}
+
+/**
+ * @brief Find the stream of a connection. Called with the mutex held.
+ */
+static remux_http_stream_t *find_stream(unsigned long conn_id) {
+  for (int i = 0; i < REMUX_HTTP_MAX_STREAMS; i++) {
+    if (g_streams[i].in_use && !g_streams[i].conn_done &&
+        g_streams[i].conn_id == conn_id) {
+      return &g_streams[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+ * @brief Remux output callback, runs on a remux worker
+ *
+ * Blocks while the buffer is full, which throttles the job to the speed of
+ * the client.
+ */
+static int stream_write_cb(void *opaque, const uint8_t *buf, size_t size) {
+  remux_http_stream_t *stream = (remux_http_stream_t *)opaque;
+
+  pthread_mutex_lock(&g_streams_mutex);
+  while (size > 0) {
+    while (stream->len == REMUX_HTTP_BUFFER_SIZE && !stream->conn_done &&
+           !stream->job_cancelled) {
+      pthread_cond_wait(&g_space_cond, &g_streams_mutex);
+    }
+    if (stream->conn_done || stream->job_cancelled) {
+      pthread_mutex_unlock(&g_streams_mutex);
+      return -1;
+    }
+
+    size_t tail = (stream->head + stream->len) % REMUX_HTTP_BUFFER_SIZE;
+    size_t space = REMUX_HTTP_BUFFER_SIZE - stream->len;
+    size_t contiguous = REMUX_HTTP_BUFFER_SIZE - tail;
+    size_t n = size < space ? size : space;
+    if (n > contiguous) {
+      n = contiguous;
+    }
+
+    memcpy(stream->buffer + tail, buf, n);
+    stream->len += n;
+    buf += n;
+    size -= n;
+  }
+  pthread_mutex_unlock(&g_streams_mutex);
+  return 0;
+}
+
+/**
+ * @brief Remux cancellation callback, wakes a writer waiting for room
+ *
+ * A stalled client never drains the buffer, so without this a cancelled job
+ * (or engine shutdown) would wait for it forever.
+ */
+static void stream_cancel_cb(void *opaque) {
+  remux_http_stream_t *stream = (remux_http_stream_t *)opaque;
+
+  pthread_mutex_lock(&g_streams_mutex);
+  stream->job_cancelled = true;
+  pthread_cond_broadcast(&g_space_cond);
+  pthread_mutex_unlock(&g_streams_mutex);
+}
+
+/**
+ * @brief Remux completion callback, runs on a remux worker
+ */
+static void stream_done_cb(void *opaque, bool success) {
+  remux_http_stream_t *stream = (remux_http_stream_t *)opaque;
+
+  pthread_mutex_lock(&g_streams_mutex);
+  stream->job_done = true;
+  stream->job_success = success;
+  release_if_done(stream);
+  pthread_mutex_unlock(&g_streams_mutex);
+}
+
+/**
+ * @brief Start streaming a remux job to a connection as fragmented MP4
+ */
+int remux_http_stream_start(struct mg_connection *c,
+                            const remux_request_t *request) {
+  if (!c || !request) {
+    return -1;
+  }
+
+  pthread_mutex_lock(&g_streams_mutex);
+
+  remux_http_stream_t *stream = NULL;
+  for (int i = 0; i < REMUX_HTTP_MAX_STREAMS; i++) {
+    if (!g_streams[i].in_use) {
+      stream = &g_streams[i];
+      break;
+    }
+  }
+  if (!stream) {
+    pthread_mutex_unlock(&g_streams_mutex);
+    log_warn("All %d remux stream slots are in use", REMUX_HTTP_MAX_STREAMS);
+    return -1;
+  }
+
+  stream->buffer = malloc(REMUX_HTTP_BUFFER_SIZE);
+  if (!stream->buffer) {
+    pthread_mutex_unlock(&g_streams_mutex);
+    log_error("Failed to allocate remux stream buffer");
+    return -1;
+  }
+  stream->in_use = true;
+  stream->conn_id = c->id;
+  pthread_mutex_unlock(&g_streams_mutex);
+
+  remux_request_t streamed = *request;
+  streamed.output_path = NULL;
+  streamed.write_cb = stream_write_cb;
+  streamed.done_cb = stream_done_cb;
+  streamed.cancel_cb = stream_cancel_cb;
+  streamed.opaque = stream;
+  streamed.fragmented = true;
+
+  char job_id[64] = {0};
+  if (remux_submit(&streamed, job_id) != 0) {
+    pthread_mutex_lock(&g_streams_mutex);
+    free(stream->buffer);
+    memset(stream, 0, sizeof(*stream));
+    pthread_mutex_unlock(&g_streams_mutex);
+    return -1;
+  }
+
+  pthread_mutex_lock(&g_streams_mutex);
+  if (stream->in_use) {
+    strncpy(stream->job_id, job_id, sizeof(stream->job_id) - 1);
+  }
+  pthread_mutex_unlock(&g_streams_mutex);
+
+  mg_printf(c, "HTTP/1.1 200 OK\r\n"
+               "Content-Type: video/mp4\r\n"
+               "Transfer-Encoding: chunked\r\n"
+               "Cache-Control: no-store\r\n"
+               "Connection: close\r\n"
+               "\r\n");
+  c->is_resp = 1;
+  c->data[2] = REMUX_HTTP_CONN_MARK;
+
+  log_info("Streaming remux job %s to connection %lu", job_id, c->id);
+  return 0;
+}
+
+/**
+ * @brief Move buffered remux output into a connection
+ */
+void remux_http_stream_poll(struct mg_connection *c) {
+  pthread_mutex_lock(&g_streams_mutex);
+
+  remux_http_stream_t *stream = find_stream(c->id);
+  if (!stream) {
+    pthread_mutex_unlock(&g_streams_mutex);
+    c->data[2] = 0;
+    return;
+  }
+
+  bool drained = false;
+  while (stream->len > 0 && c->send.len < REMUX_HTTP_SEND_LIMIT) {
+    size_t contiguous = REMUX_HTTP_BUFFER_SIZE - stream->head;
+    size_t n = stream->len < contiguous ? stream->len : contiguous;
+    mg_http_write_chunk(c, (const char *)stream->buffer + stream->head, n);
+    stream->head = (stream->head + n) % REMUX_HTTP_BUFFER_SIZE;
+    stream->len -= n;
+    drained = true;
+  }
+  if (drained) {
+    pthread_cond_broadcast(&g_space_cond);
+  }
+
+  if (stream->job_done && stream->len == 0) {
+    if (stream->job_success) {
+      mg_http_write_chunk(c, "", 0);
+    } else {
+      // Ending without the terminating chunk tells the client the body is incomplete
+      log_warn("Remux job %s failed, closing connection %lu", stream->job_id, c->id);
+      c->is_resp = 0;
+    }
+    c->is_draining = 1;
+    c->data[2] = 0;
+    stream->conn_done = true;
+    release_if_done(stream);
+  }
+
+  pthread_mutex_unlock(&g_streams_mutex);
+}
+
+/**
+ * @brief Release the remux stream of a closing connection
+ */
+void remux_http_stream_close(struct mg_connection *c) {
+  char job_id[64] = {0};
+
+  pthread_mutex_lock(&g_streams_mutex);
+  remux_http_stream_t *stream = find_stream(c->id);
+  if (stream) {
+    strncpy(job_id, stream->job_id, sizeof(job_id) - 1);
+    stream->conn_done = true;
+    pthread_cond_broadcast(&g_space_cond);
+    release_if_done(stream);
+  }
+  pthread_mutex_unlock(&g_streams_mutex);
+  c->data[2] = 0;
+
+  // Stop the job even if it is busy reading rather than writing
+  if (job_id[0] != '\0') {
+    log_info("Connection %lu closed, cancelling remux job %s", c->id, job_id);
+    remux_cancel(job_id);
+  }
+}
+
+/**
+ * @brief Send a JSON response to a connection from any thread
+ */
+bool remux_http_send_json(struct mg_mgr *mgr, unsigned long conn_id,
+                          int status_code, const char *json) {
+  if (!mgr || !json) {
+    return false;
+  }
+
+  const char *reason = status_code == 200   ? "OK"
+                       : status_code == 202 ? "Accepted"
+                       : status_code == 404 ? "Not Found"
+                       : status_code == 503 ? "Service Unavailable"
+                                            : "Internal Server Error";
+  size_t body_len = strlen(json);
+  size_t size = body_len + 160;
+  char *response = malloc(size);
+  if (!response) {
+    return false;
+  }
+
+  int len = snprintf(response, size,
+                     "HTTP/1.1 %d %s\r\n"
+                     "Content-Type: application/json\r\n"
+                     "Content-Length: %zu\r\n"
+                     "Connection: close\r\n"
+                     "\r\n"
+                     "%s",
+                     status_code, reason, body_len, json);
+  bool sent = len > 0 && (size_t)len < size &&
+              mg_wakeup(mgr, conn_id, response, (size_t)len);
+  free(response);
+  return sent;
+}
+
+/**
+ * @brief Convert a remux job's progress to JSON
+ */
+cJSON *remux_http_job_to_json(const remux_job_info_t *info) {
+  cJSON *json = cJSON_CreateObject();
+  if (!json) {
+    return NULL;
+  }
+
+  cJSON_AddStringToObject(json, "job_id", info->job_id);
+  cJSON_AddStringToObject(json, "status", remux_job_state_name(info->state));
+  cJSON_AddNumberToObject(json, "progress", (int)(info->progress * 100.0));
+  cJSON_AddNumberToObject(json, "inputs", info->input_count);
+  cJSON_AddNumberToObject(json, "inputs_done", info->inputs_done);
+  cJSON_AddNumberToObject(json, "inputs_skipped", info->inputs_skipped);
+  cJSON_AddNumberToObject(json, "bytes_written", (double)info->bytes_written);
+  cJSON_AddNumberToObject(json, "duration", info->output_seconds);
+  if (info->error_message[0] != '\0') {
+    cJSON_AddStringToObject(json, "error", info->error_message);
+  }
+  cJSON_AddNumberToObject(json, "created_at", (double)info->created_at);
+  cJSON_AddNumberToObject(json, "updated_at", (double)info->updated_at);
+  return json;
+}
@@ -0,0 +1,655 @@
+/**
+ * @file static_cache.c
+ * @brief In-memory cache of the web interface's static files
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <ctype.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#include "core/logger.h"
+#include "web/static_cache.h"
+
+// Length of the content hash the web bundler puts in file names
+#define CONTENT_HASH_LENGTH 8
+
+// Files smaller than this are not worth compressing
+#define MIN_COMPRESS_SIZE 256
+
+#define CACHE_CONTROL_IMMUTABLE "public, max-age=31536000, immutable"
+#define CACHE_CONTROL_REVALIDATE "no-cache"
+
+enum {
+    VARIANT_IDENTITY,
+    VARIANT_GZIP,
+    VARIANT_BROTLI,
+    VARIANT_COUNT
+};
+
+// Content-Encoding and ETag suffix of each variant
+static const char *const variant_encodings[VARIANT_COUNT] = {NULL, "gzip", "br"};
+static const char *const variant_etag_suffixes[VARIANT_COUNT] = {"", "-gz", "-br"};
+
+typedef struct {
+    char *data;                     // NULL if the variant is not available
+    size_t len;
+} variant_t;
+
+typedef struct {
+    char *path;
+    uint64_t path_hash;
+    time_t mtime;                   // Modification time and size the entry was loaded with
+    off_t size;
+    const char *content_type;
+    bool immutable;
+    char etag[40];                  // Identity ETag without quotes
+    variant_t variants[VARIANT_COUNT];
+    size_t memory;
+    atomic_int refs;                // The cache and every stream sending it
+} cache_entry_t;
+
+// A body being sent as its connection drains. Only used on the event loop.
+typedef struct {
+    struct mg_connection *c;        // NULL if the slot is free
+    cache_entry_t *entry;           // Referenced until the stream ends
+    const variant_t *body;
+    size_t offset;
+} cache_stream_t;
+
+typedef struct {
+    const char *extension;
+    const char *content_type;
+    bool compressible;
+} content_type_t;
+
+static const content_type_t content_types[] = {
+    {"html", "text/html; charset=utf-8", true},
+    {"htm", "text/html; charset=utf-8", true},
+    {"css", "text/css; charset=utf-8", true},
+    {"js", "application/javascript; charset=utf-8", true},
+    {"mjs", "application/javascript; charset=utf-8", true},
+    {"json", "application/json", true},
+    {"map", "application/json", true},
+    {"webmanifest", "application/manifest+json", true},
+    {"svg", "image/svg+xml", true},
+    {"xml", "application/xml", true},
+    {"txt", "text/plain; charset=utf-8", true},
+    {"wasm", "application/wasm", true},
+    {"ico", "image/x-icon", true},
+    {"ttf", "font/ttf", true},
+    {"otf", "font/otf", true},
+    {"woff", "font/woff", false},
+    {"woff2", "font/woff2", false},
+    {"png", "image/png", false},
+    {"jpg", "image/jpeg", false},
+    {"jpeg", "image/jpeg", false},
+    {"gif", "image/gif", false},
+    {"webp", "image/webp", false},
+    {"mp4", "video/mp4", false},
+    {"webm", "video/webm", false},
+    {"pdf", "application/pdf", false},
+};
+
+static const content_type_t default_content_type = {"", "application/octet-stream", false};
+
+static cache_entry_t *g_entries[STATIC_CACHE_MAX_ENTRIES];
+static int g_entry_count = 0;
+static size_t g_total_memory = 0;
+static pthread_rwlock_t g_cache_lock = PTHREAD_RWLOCK_INITIALIZER;
+static cache_stream_t g_streams[STATIC_CACHE_MAX_STREAMS];
+
+static uint64_t fnv1a_64(const void *data, size_t len) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= p[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+static const content_type_t *lookup_content_type(const char *path) {
+    const char *name = strrchr(path, '/');
+    const char *dot = strrchr(name ? name : path, '.');
+    if (!dot) {
+        return &default_content_type;
+    }
+
+    for (size_t i = 0; i < sizeof(content_types) / sizeof(content_types[0]); i++) {
+        if (strcasecmp(dot + 1, content_types[i].extension) == 0) {
+            return &content_types[i];
+        }
+    }
+    return &default_content_type;
+}
+
+/**
+ * @brief Check whether a file name ends in a bundler content hash
+ *
+ * Matches name-XXXXXXXX.ext, where the hash mixes at least two of lower case
+ * letters, upper case letters and digits so plain words are not taken for one.
+ */
+static bool has_content_hash(const char *path) {
+    const char *name = strrchr(path, '/');
+    name = name ? name + 1 : path;
+
+    const char *dot = strrchr(name, '.');
+    if (!dot || dot - name < CONTENT_HASH_LENGTH + 2) {
+        return false;
+    }
+
+    const char *hash = dot - CONTENT_HASH_LENGTH;
+    if (hash[-1] != '-' && hash[-1] != '.') {
+        return false;
+    }
+
+    bool lower = false, upper = false, digit = false;
+    for (int i = 0; i < CONTENT_HASH_LENGTH; i++) {
+        unsigned char ch = (unsigned char)hash[i];
+        if (islower(ch)) {
+            lower = true;
+        } else if (isupper(ch)) {
+            upper = true;
+        } else if (isdigit(ch)) {
+            digit = true;
+        } else if (ch != '-' && ch != '_') {
+            return false;
+        }
+    }
+    return lower + upper + digit >= 2;
+}
+
+/**
+ * @brief Read a whole file of known size
+ */
+static int read_file(const char *path, size_t size, variant_t *out) {
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        return -1;
+    }
+
+    // Keep empty files distinguishable from missing variants
+    char *data = malloc(size > 0 ? size : 1);
+    if (!data) {
+        fclose(fp);
+        return -1;
+    }
+
+    size_t read = fread(data, 1, size, fp);
+    int extra = fgetc(fp);
+    fclose(fp);
+
+    // The file changed while it was read
+    if (read != size || extra != EOF) {
+        free(data);
+        return -1;
+    }
+
+    out->data = data;
+    out->len = size;
+    return 0;
+}
+
+/**
+ * @brief Load a precompressed sibling (path + suffix) if it is usable
+ */
+static void load_sibling(const char *path, const char *suffix, const struct stat *st, variant_t *out) {
+    char sibling_path[4096];
+    if (snprintf(sibling_path, sizeof(sibling_path), "%s%s", path, suffix) >= (int)sizeof(sibling_path)) {
+        return;
+    }
+
+    // A sibling older than the file was built from a previous version of it
+    struct stat sibling_st;
+    if (stat(sibling_path, &sibling_st) != 0 || !S_ISREG(sibling_st.st_mode) ||
+        sibling_st.st_mtime < st->st_mtime || sibling_st.st_size >= st->st_size) {
+        return;
+    }
+
+    if (read_file(sibling_path, (size_t)sibling_st.st_size, out) != 0) {
+        log_warn("Failed to read precompressed file %s", sibling_path);
+    }
+}
+
+#ifdef HAVE_ZLIB
+/**
+ * @brief Gzip a file's contents, keeping the result only if it is smaller
+ */
+static void gzip_variant(const variant_t *identity, variant_t *out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+
+    size_t bound = deflateBound(&zs, identity->len);
+    char *data = malloc(bound);
+    if (!data) {
+        deflateEnd(&zs);
+        return;
+    }
+
+    zs.next_in = (Bytef *)identity->data;
+    zs.avail_in = (uInt)identity->len;
+    zs.next_out = (Bytef *)data;
+    zs.avail_out = (uInt)bound;
+    int result = deflate(&zs, Z_FINISH);
+    size_t len = zs.total_out;
+    deflateEnd(&zs);
+
+    // Not worth a Vary header and a second copy unless it saves an eighth
+    if (result != Z_STREAM_END || len > identity->len - identity->len / 8) {
+        free(data);
+        return;
+    }
+
+    out->data = data;
+    out->len = len;
+}
+#endif
+
+static void free_entry(cache_entry_t *entry) {
+    if (!entry) {
+        return;
+    }
+    for (int i = 0; i < VARIANT_COUNT; i++) {
+        free(entry->variants[i].data);
+    }
+    free(entry->path);
+    free(entry);
+}
+
+/**
+ * @brief Drop a reference to an entry, freeing it with the last one
+ */
+static void release_entry(cache_entry_t *entry) {
+    if (entry && atomic_fetch_sub(&entry->refs, 1) == 1) {
+        free_entry(entry);
+    }
+}
+
+/**
+ * @brief Load a file and build its variants and ETag
+ */
+static cache_entry_t *load_entry(const char *path, uint64_t path_hash, const struct stat *st) {
+    cache_entry_t *entry = calloc(1, sizeof(cache_entry_t));
+    if (!entry) {
+        log_error("Failed to allocate static cache entry");
+        return NULL;
+    }
+
+    atomic_init(&entry->refs, 1);
+    entry->path = strdup(path);
+    if (!entry->path || read_file(path, (size_t)st->st_size, &entry->variants[VARIANT_IDENTITY]) != 0) {
+        log_warn("Failed to read static file %s", path);
+        free_entry(entry);
+        return NULL;
+    }
+
+    const content_type_t *type = lookup_content_type(path);
+    const variant_t *identity = &entry->variants[VARIANT_IDENTITY];
+
+    entry->path_hash = path_hash;
+    entry->mtime = st->st_mtime;
+    entry->size = st->st_size;
+    entry->content_type = type->content_type;
+    entry->immutable = has_content_hash(path);
+    snprintf(entry->etag, sizeof(entry->etag), "%016llx-%llx",
+             (unsigned long long)fnv1a_64(identity->data, identity->len),
+             (unsigned long long)identity->len);
+
+    if (identity->len >= MIN_COMPRESS_SIZE) {
+        load_sibling(path, ".br", st, &entry->variants[VARIANT_BROTLI]);
+        load_sibling(path, ".gz", st, &entry->variants[VARIANT_GZIP]);
+#ifdef HAVE_ZLIB
+        if (!entry->variants[VARIANT_GZIP].data && type->compressible) {
+            gzip_variant(identity, &entry->variants[VARIANT_GZIP]);
+        }
+#endif
+    }
+
+    entry->memory = sizeof(cache_entry_t) + strlen(entry->path) + 1;
+    for (int i = 0; i < VARIANT_COUNT; i++) {
+        entry->memory += entry->variants[i].len;
+    }
+
+    log_debug("Loaded static file %s (%lu bytes, gzip %lu, br %lu%s)", path,
+              (unsigned long)identity->len,
+              (unsigned long)entry->variants[VARIANT_GZIP].len,
+              (unsigned long)entry->variants[VARIANT_BROTLI].len,
+              entry->immutable ? ", immutable" : "");
+    return entry;
+}
+
+static int find_entry_locked(const char *path, uint64_t path_hash) {
+    for (int i = 0; i < g_entry_count; i++) {
+        if (g_entries[i]->path_hash == path_hash && strcmp(g_entries[i]->path, path) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void remove_entry_locked(int index) {
+    g_total_memory -= g_entries[index]->memory;
+    release_entry(g_entries[index]);
+    g_entries[index] = g_entries[--g_entry_count];
+    g_entries[g_entry_count] = NULL;
+}
+
+/**
+ * @brief Add an entry, replacing a stale one for the same file
+ *
+ * @return true if the cache took a reference to the entry
+ */
+static bool store_entry_locked(cache_entry_t *entry) {
+    // Another thread may have loaded the file meanwhile; the newest load wins
+    int index = find_entry_locked(entry->path, entry->path_hash);
+    if (index >= 0) {
+        remove_entry_locked(index);
+    }
+
+    if (g_entry_count >= STATIC_CACHE_MAX_ENTRIES ||
+        g_total_memory + entry->memory > STATIC_CACHE_MAX_TOTAL_SIZE) {
+        log_debug("Static cache full, serving %s without caching it", entry->path);
+        return false;
+    }
+
+    atomic_fetch_add(&entry->refs, 1);
+    g_entries[g_entry_count++] = entry;
+    g_total_memory += entry->memory;
+    return true;
+}
+
+/**
+ * @brief Check whether a header lists a token, ignoring ones with q=0
+ */
+static bool accepts_encoding(const struct mg_str *header, const char *encoding) {
+    if (!header) {
+        return false;
+    }
+
+    size_t encoding_len = strlen(encoding);
+    const char *p = header->buf;
+    const char *end = header->buf + header->len;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+        const char *token = p;
+        while (p < end && *p != ',' && *p != ';' && *p != ' ' && *p != '\t') {
+            p++;
+        }
+        size_t token_len = (size_t)(p - token);
+
+        // Parameters up to the next comma
+        const char *params = p;
+        while (p < end && *p != ',') {
+            p++;
+        }
+
+        if (token_len != encoding_len || strncasecmp(token, encoding, encoding_len) != 0) {
+            continue;
+        }
+
+        const char *q = params;
+        while (q + 1 < p && !((q[0] == 'q' || q[0] == 'Q') && q[1] == '=')) {
+            q++;
+        }
+        if (q + 1 >= p) {
+            return true;
+        }
+
+        // q=0, q=0.0, q=0.00 and q=0.000 refuse the encoding
+        for (q += 2; q < p && *q != ' ' && *q != '\t' && *q != ';'; q++) {
+            if (*q != '0' && *q != '.') {
+                return true;
+            }
+        }
+        return false;
+    }
+    return false;
+}
+
+/**
+ * @brief Check whether If-None-Match lists an ETag
+ */
+static bool etag_matches(const struct mg_str *header, const char *etag) {
+    if (!header) {
+        return false;
+    }
+
+    size_t etag_len = strlen(etag);
+    const char *p = header->buf;
+    const char *end = header->buf + header->len;
+
+    while (p < end) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+        const char *start = p;
+        while (p < end && *p != ',') {
+            p++;
+        }
+        const char *stop = p;
+        while (stop > start && (stop[-1] == ' ' || stop[-1] == '\t')) {
+            stop--;
+        }
+
+        if (stop - start == 1 && *start == '*') {
+            return true;
+        }
+        // If-None-Match uses weak comparison
+        if (stop - start >= 2 && start[0] == 'W' && start[1] == '/') {
+            start += 2;
+        }
+        if ((size_t)(stop - start) == etag_len && memcmp(start, etag, etag_len) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Send the response for a cached file. Called with the lock held.
+ */
+static void send_entry(struct mg_connection *c, struct mg_http_message *hm,
+                       cache_entry_t *entry, const char *extra_headers) {
+    struct mg_str *accept_encoding = mg_http_get_header(hm, "Accept-Encoding");
+    int variant = VARIANT_IDENTITY;
+    if (entry->variants[VARIANT_BROTLI].data && accepts_encoding(accept_encoding, "br")) {
+        variant = VARIANT_BROTLI;
+    } else if (entry->variants[VARIANT_GZIP].data && accepts_encoding(accept_encoding, "gzip")) {
+        variant = VARIANT_GZIP;
+    }
+
+    char etag[48];
+    snprintf(etag, sizeof(etag), "\"%s%s\"", entry->etag, variant_etag_suffixes[variant]);
+
+    const char *cache_control = entry->immutable ? CACHE_CONTROL_IMMUTABLE : CACHE_CONTROL_REVALIDATE;
+    const char *vary = entry->variants[VARIANT_GZIP].data || entry->variants[VARIANT_BROTLI].data
+                           ? "Vary: Accept-Encoding\r\n" : "";
+    if (!extra_headers) {
+        extra_headers = "";
+    }
+
+    if (etag_matches(mg_http_get_header(hm, "If-None-Match"), etag)) {
+        mg_printf(c,
+                  "HTTP/1.1 304 Not Modified\r\n"
+                  "ETag: %s\r\n"
+                  "Cache-Control: %s\r\n"
+                  "%s%s\r\n",
+                  etag, cache_control, vary, extra_headers);
+        c->is_resp = 0;
+        return;
+    }
+
+    char content_encoding[48] = "";
+    if (variant_encodings[variant]) {
+        snprintf(content_encoding, sizeof(content_encoding), "Content-Encoding: %s\r\n",
+                 variant_encodings[variant]);
+    }
+
+    const variant_t *body = &entry->variants[variant];
+    mg_printf(c,
+              "HTTP/1.1 200 OK\r\n"
+              "Content-Type: %s\r\n"
+              "Content-Length: %lu\r\n"
+              "ETag: %s\r\n"
+              "Cache-Control: %s\r\n"
+              "%s%s%s\r\n",
+              entry->content_type, (unsigned long)body->len, etag, cache_control,
+              content_encoding, vary, extra_headers);
+
+    if (mg_match(hm->method, mg_str("HEAD"), NULL)) {
+        c->is_resp = 0;
+        return;
+    }
+
+    // Large bodies go out as the connection drains, the entry stays referenced meanwhile
+    if (body->len > STATIC_CACHE_SEND_CHUNK) {
+        for (int i = 0; i < STATIC_CACHE_MAX_STREAMS; i++) {
+            if (!g_streams[i].c) {
+                atomic_fetch_add(&entry->refs, 1);
+                g_streams[i].c = c;
+                g_streams[i].entry = entry;
+                g_streams[i].body = body;
+                g_streams[i].offset = 0;
+                c->data[2] = STATIC_CACHE_CONN_MARK;
+                static_cache_stream_poll(c);
+                return;
+            }
+        }
+        log_debug("All %d static stream slots are in use, sending %s at once",
+                  STATIC_CACHE_MAX_STREAMS, entry->path);
+    }
+
+    mg_send(c, body->data, body->len);
+    c->is_resp = 0;
+}
+
+/**
+ * @brief Serve a static file from the cache, loading it if needed
+ */
+int static_cache_serve(struct mg_connection *c, struct mg_http_message *hm,
+                       const char *path, const char *extra_headers) {
+    if (!c || !hm || !path) {
+        return -1;
+    }
+
+    // Revalidating costs a stat, far less than reading the file on every hit
+    struct stat st;
+    if (stat(path, &st) != 0 || !S_ISREG(st.st_mode) || st.st_size > STATIC_CACHE_MAX_FILE_SIZE) {
+        return -1;
+    }
+
+    uint64_t path_hash = fnv1a_64(path, strlen(path));
+
+    pthread_rwlock_rdlock(&g_cache_lock);
+    int index = find_entry_locked(path, path_hash);
+    if (index >= 0 && g_entries[index]->mtime == st.st_mtime && g_entries[index]->size == st.st_size) {
+        send_entry(c, hm, g_entries[index], extra_headers);
+        pthread_rwlock_unlock(&g_cache_lock);
+        return 0;
+    }
+    pthread_rwlock_unlock(&g_cache_lock);
+
+    cache_entry_t *entry = load_entry(path, path_hash, &st);
+    if (!entry) {
+        return -1;
+    }
+
+    pthread_rwlock_wrlock(&g_cache_lock);
+    store_entry_locked(entry);
+    send_entry(c, hm, entry, extra_headers);
+    pthread_rwlock_unlock(&g_cache_lock);
+
+    // The cache and any stream hold their own references
+    release_entry(entry);
+    return 0;
+}
+
+/**
+ * @brief Get the Cache-Control value the cache uses for a file
+ */
+const char *static_cache_control(const char *path) {
+    return path && has_content_hash(path) ? CACHE_CONTROL_IMMUTABLE : CACHE_CONTROL_REVALIDATE;
+}
+
+static cache_stream_t *find_stream(struct mg_connection *c) {
+    for (int i = 0; i < STATIC_CACHE_MAX_STREAMS; i++) {
+        if (g_streams[i].c == c) {
+            return &g_streams[i];
+        }
+    }
+    return NULL;
+}
+
+static void release_stream(cache_stream_t *stream) {
+    release_entry(stream->entry);
+    memset(stream, 0, sizeof(*stream));
+}
+
+/**
+ * @brief Send more of a streamed body
+ */
+void static_cache_stream_poll(struct mg_connection *c) {
+    cache_stream_t *stream = find_stream(c);
+    if (!stream) {
+        c->data[2] = 0;
+        return;
+    }
+
+    // Variants never change once loaded, the reference keeps them alive
+    const variant_t *body = stream->body;
+    while (stream->offset < body->len && c->send.len < STATIC_CACHE_SEND_LIMIT) {
+        size_t n = body->len - stream->offset;
+        if (n > STATIC_CACHE_SEND_CHUNK) {
+            n = STATIC_CACHE_SEND_CHUNK;
+        }
+        if (!mg_send(c, body->data + stream->offset, n)) {
+            break;
+        }
+        stream->offset += n;
+    }
+
+    if (stream->offset == body->len) {
+        release_stream(stream);
+        c->data[2] = 0;
+        c->is_resp = 0;
+    }
+}
+
+/**
+ * @brief Stop streaming to a closing connection
+ */
+void static_cache_stream_close(struct mg_connection *c) {
+    cache_stream_t *stream = find_stream(c);
+    if (stream) {
+        release_stream(stream);
+    }
+    c->data[2] = 0;
+}
+
+/**
+ * @brief Free all cached files
+ */
+void static_cache_cleanup(void) {
+    pthread_rwlock_wrlock(&g_cache_lock);
+    while (g_entry_count > 0) {
+        remove_entry_locked(g_entry_count - 1);
+    }
+    pthread_rwlock_unlock(&g_cache_lock);
+}
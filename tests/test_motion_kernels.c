@@ -0,0 +1,174 @@
+/**
+ * @file test_motion_kernels.c
+ * @brief Tests that the vectorized motion detection kernels match the scalar ones
+ *
+ * The kernels selected at runtime (SSE2, AVX2 or NEON) must produce bit-identical
+ * output to the scalar fallback on random frames of awkward sizes, including
+ * widths that are not a multiple of the vector width.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core/logger.h"
+#include "video/motion_detection_simd.h"
+
+// Test counters
+static int tests_passed = 0;
+static int tests_failed = 0;
+
+#define TEST_ASSERT(condition, message) do { \
+    if (condition) { \
+        printf("  ✓ PASS: %s\n", message); \
+        tests_passed++; \
+    } else { \
+        printf("  ✗ FAIL: %s\n", message); \
+        tests_failed++; \
+    } \
+} while(0)
+
+static unsigned int rng_state = 1;
+
+static unsigned char next_random(void) {
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (unsigned char)(rng_state >> 16);
+}
+
+static void fill_random(unsigned char *buf, size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        buf[i] = next_random();
+    }
+}
+
+/**
+ * Compare every kernel of the selected set against the scalar set on one frame size
+ */
+static int compare_kernels(const motion_kernels_t *ref, const motion_kernels_t *simd, int width, int height) {
+    size_t pixels = (size_t)width * height;
+    unsigned char *rgb = malloc(pixels * 3);
+    unsigned char *gray = malloc(pixels);
+    unsigned char *prev = malloc(pixels);
+    unsigned char *out_ref = malloc(pixels);
+    unsigned char *out_simd = malloc(pixels);
+    unsigned char *bg_ref = malloc(pixels);
+    unsigned char *bg_simd = malloc(pixels);
+    int ok = 1;
+
+    if (!rgb || !gray || !prev || !out_ref || !out_simd || !bg_ref || !bg_simd) {
+        ok = 0;
+        goto cleanup;
+    }
+
+    fill_random(rgb, pixels * 3);
+    fill_random(prev, pixels);
+    fill_random(bg_ref, pixels);
+    memcpy(bg_simd, bg_ref, pixels);
+
+    ref->rgb_to_gray(rgb, out_ref, pixels);
+    simd->rgb_to_gray(rgb, out_simd, pixels);
+    ok &= memcmp(out_ref, out_simd, pixels) == 0;
+    memcpy(gray, out_ref, pixels);
+
+    if (width >= 2 && height >= 2) {
+        ref->downscale_2x(gray, width, out_ref, width / 2, height / 2);
+        simd->downscale_2x(gray, width, out_simd, width / 2, height / 2);
+        ok &= memcmp(out_ref, out_simd, (size_t)(width / 2) * (height / 2)) == 0;
+    }
+
+    for (int radius = 1; radius <= 5; radius++) {
+        ref->blur_row(gray, out_ref, width, radius);
+        simd->blur_row(gray, out_simd, width, radius);
+        ok &= memcmp(out_ref, out_simd, width) == 0;
+    }
+
+    for (int nrows = 1; nrows <= 11 && nrows <= height; nrows++) {
+        ref->average_rows(gray, width, nrows, out_ref, width);
+        simd->average_rows(gray, width, nrows, out_simd, width);
+        ok &= memcmp(out_ref, out_simd, width) == 0;
+    }
+
+    for (int alpha = 0; alpha <= 256; alpha += 2) {
+        ref->update_background(bg_ref, gray, pixels, alpha);
+        simd->update_background(bg_simd, gray, pixels, alpha);
+    }
+    ok &= memcmp(bg_ref, bg_simd, pixels) == 0;
+
+    for (int threshold = 0; threshold <= 255; threshold += 5) {
+        int samples = (width + 1) / 2;
+        int changed_ref = 0, total_ref = 0;
+        int changed_simd = 0, total_simd = 0;
+        ref->accumulate_motion(gray, prev, bg_ref, samples, threshold, &changed_ref, &total_ref);
+        simd->accumulate_motion(gray, prev, bg_ref, samples, threshold, &changed_simd, &total_simd);
+        ok &= (changed_ref == changed_simd && total_ref == total_simd);
+    }
+
+cleanup:
+    free(rgb);
+    free(gray);
+    free(prev);
+    free(out_ref);
+    free(out_simd);
+    free(bg_ref);
+    free(bg_simd);
+    return ok;
+}
+
+/**
+ * Test 1: Selected kernels are bit-identical to the scalar kernels
+ */
+static void test_kernels_bit_identical(void) {
+    printf("\nTest 1: %s kernels match scalar kernels\n", motion_kernels_get()->name);
+
+    static const int sizes[][2] = {
+        {1, 1}, {7, 3}, {31, 5}, {33, 9}, {64, 32}, {97, 41}, {160, 90}, {319, 17}, {640, 360}
+    };
+    int all_ok = 1;
+
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        all_ok &= compare_kernels(motion_kernels_get_scalar(), motion_kernels_get(),
+                                  sizes[i][0], sizes[i][1]);
+    }
+
+    TEST_ASSERT(all_ok, "All kernels produce identical output for all frame sizes");
+}
+
+/**
+ * Test 2: Benchmark reports a sane speedup
+ */
+static void test_kernels_benchmark(void) {
+    printf("\nTest 2: Kernel benchmark\n");
+
+    float speedup = motion_kernels_benchmark(320, 240);
+    printf("  %s kernels are %.2fx faster than scalar\n", motion_kernels_get()->name, speedup);
+
+    TEST_ASSERT(speedup > 0.0f, "Benchmark returns a positive speedup");
+}
+
+int main(void) {
+    printf("===========================================\n");
+    printf("  Motion Detection Kernel Tests\n");
+    printf("===========================================\n");
+
+    // Initialize logger
+    init_logger();
+    set_log_level(LOG_LEVEL_ERROR);
+
+    // Run tests
+    test_kernels_bit_identical();
+    test_kernels_benchmark();
+
+    // Summary
+    printf("\n===========================================\n");
+    printf("  Test Summary\n");
+    printf("===========================================\n");
+    printf("  Passed: %d\n", tests_passed);
+    printf("  Failed: %d\n", tests_failed);
+    printf("  Total:  %d\n", tests_passed + tests_failed);
+    printf("===========================================\n");
+
+    // Cleanup
+    shutdown_logger();
+
+    return tests_failed > 0 ? 1 : 0;
+}
@@ -104,8 +104,15 @@ export function PlaybackControlRoom() {
     const segmentsRef = useRef([]);
     useEffect(() => { segmentsRef.current = segments; }, [segments]);
 
+    // Recorded intervals from the server-side timeline index, already merged
+    const coverageUrl = activeStreamName ? `/api/timeline/coverage?stream=${encodeURIComponent(activeStreamName)}&start=${encodeURIComponent(timeRange.start)}&end=${encodeURIComponent(timeRange.end)}` : null;
+    const { data: coverageData } = useQuery(['timelineCoverage', activeStreamName, selectedDate], coverageUrl, { enabled: !!activeStreamName });
+
     // Optimize Rendering: Merge adjacent segments into visual blocks
     const visualSegments = useMemo(() => {
+        if (coverageData?.intervals) {
+            return coverageData.intervals.map(([start, end]) => ({ start: start * 1000, end: end * 1000 }));
+        }
         if (!segments || segments.length === 0) return [];
 
         // Sort by start_time just in case
@@ -131,7 +138,7 @@ export function PlaybackControlRoom() {
         }
         if (currentBlock) merged.push(currentBlock);
         return merged;
-    }, [segments]);
+    }, [coverageData, segments]);
 
     // Video State Management
     // const [playingSegmentId, setPlayingSegmentId] = useState(null); // No longer needed
@@ -294,6 +294,10 @@ export function StreamConfigModal({
                       <input type="checkbox" id="stream-record-audio" name="recordAudio" className="w-5 h-5 rounded-lg border-white/10 bg-white/5 text-blue-600 focus:ring-0 cursor-pointer" checked={currentStream.recordAudio} onChange={onInputChange} />
                       <label htmlFor="stream-record-audio" className="text-[10px] font-black text-gray-400 uppercase tracking-widest cursor-pointer">Acoustic Logic</label>
                     </div>
+                    <div className="flex items-center space-x-3 border-l border-white/5 pl-6">
+                      <input type="checkbox" id="stream-fragmented-mp4" name="fragmentedMp4" className="w-5 h-5 rounded-lg border-white/10 bg-white/5 text-blue-600 focus:ring-0 cursor-pointer" checked={currentStream.fragmentedMp4} onChange={onInputChange} />
+                      <label htmlFor="stream-fragmented-mp4" className="text-[10px] font-black text-gray-400 uppercase tracking-widest cursor-pointer" title="Write segments once as fragmented MP4, playable while recording">Fragmented MP4</label>
+                    </div>
                     <div className="flex items-center space-x-3 border-l border-white/5 pl-6">
                       <input type="checkbox" id="stream-backchannel-enabled" name="backchannelEnabled" className="w-5 h-5 rounded-lg border-white/10 bg-white/5 text-blue-600 focus:ring-0 cursor-pointer" checked={currentStream.backchannelEnabled} onChange={onInputChange} />
                       <label htmlFor="stream-backchannel-enabled" className="text-[10px] font-black text-gray-400 uppercase tracking-widest cursor-pointer">Universal Intercom</label>
@@ -32,6 +32,7 @@ export function StreamsManagement() {
         protocol: '0',
         record: true,
         recordAudio: true,
+        fragmentedMp4: false,
         backchannelEnabled: false,
         isOnvif: false,
         onvifUsername: '',
@@ -135,6 +136,7 @@ export function StreamsManagement() {
                 pre_detection_buffer: parseInt(data.preBuffer, 10),
                 post_detection_buffer: parseInt(data.postBuffer, 10),
                 record_audio: data.recordAudio,
+                fragmented_mp4: data.fragmentedMp4,
                 backchannel_enabled: data.backchannelEnabled,
                 retention_days: parseInt(data.retentionDays, 10),
                 detection_retention_days: parseInt(data.detectionRetentionDays, 10),
@@ -182,6 +184,7 @@ export function StreamsManagement() {
             protocol: '0',
             record: true,
             recordAudio: true,
+            fragmentedMp4: false,
             backchannelEnabled: false,
             isOnvif: false,
             onvifUsername: '',
@@ -220,6 +223,7 @@ export function StreamsManagement() {
                 detectionEnabled: s.detection_based_recording || false,
                 detectionModel: s.detection_model || '',
                 recordAudio: s.record_audio ?? true,
+                fragmentedMp4: s.fragmented_mp4 ?? false,
                 backchannelEnabled: s.backchannel_enabled ?? false,
                 detectionThreshold: s.detection_threshold || 50,
                 detectionInterval: s.detection_interval || 10,
@@ -130,6 +130,7 @@ export function StreamsView() {
     segment: 30,
     record: true,
     recordAudio: true,
+    fragmentedMp4: false,
     backchannelEnabled: false,
     // ONVIF capability flag
     isOnvif: false,
@@ -354,6 +355,7 @@ export function StreamsView() {
       pre_detection_buffer: parseInt(currentStream.preBuffer, 10),
       post_detection_buffer: parseInt(currentStream.postBuffer, 10),
       record_audio: currentStream.recordAudio,
+      fragmented_mp4: currentStream.fragmentedMp4,
       backchannel_enabled: currentStream.backchannelEnabled,
       // PTZ control settings
       ptz_enabled: !!currentStream.ptzEnabled,
@@ -500,6 +502,7 @@ export function StreamsView() {
       segment: 30,
       record: true,
       recordAudio: true,
+      fragmentedMp4: false,
       backchannelEnabled: false,
       isOnvif: false,
       onvifUsername: '',
@@ -575,6 +578,7 @@ export function StreamsView() {
         detectionEnabled: stream.detection_based_recording || false,
         detectionModel: stream.detection_model || '',
         recordAudio: stream.record_audio !== undefined ? stream.record_audio : true,
+        fragmentedMp4: stream.fragmented_mp4 !== undefined ? stream.fragmented_mp4 : false,
         backchannelEnabled: stream.backchannel_enabled !== undefined ? stream.backchannel_enabled : false,
         // Motion config mapping
         motionRecordingEnabled: motion ? !!motion.enabled : false,
@@ -1195,6 +1199,18 @@ export function StreamsView() {
                   <label for="stream-record-audio" className="ml-2 block text-sm">Record Audio</label>
                   <span className="ml-2 text-xs text-muted-foreground">Include audio in recordings if available in the stream</span>
                 </div>
+                <div className="form-group flex items-center">
+                  <input
+                      type="checkbox"
+                      id="stream-fragmented-mp4"
+                      name="fragmentedMp4"
+                      className="h-4 w-4 border-gray-300 rounded" style={{accentColor: 'hsl(var(--primary))'}}
+                      checked={currentStream.fragmentedMp4}
+                      onChange={handleInputChange}
+                  />
+                  <label for="stream-fragmented-mp4" className="ml-2 block text-sm">Fragmented MP4</label>
+                  <span className="ml-2 text-xs text-muted-foreground">Write segments once, playable while still recording</span>
+                </div>
 
                 {/* Detection-based recording options */}
                 <div className="mt-6 mb-2 pb-1 border-b border-border">
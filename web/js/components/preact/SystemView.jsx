@@ -74,6 +74,8 @@ export function SystemView() {
     }
   });
   const [logs, setLogs] = useState([]);
+  const [olderLogs, setOlderLogs] = useState([]);
+  const [hasOlderLogs, setHasOlderLogs] = useState(true);
   const [logLevel, setLogLevel] = useState('debug');
   const logLevelRef = useRef('debug');
   const [logCount, setLogCount] = useState(100);
@@ -137,6 +139,7 @@ export function SystemView() {
     onSuccess: () => {
       showStatusMessage('Logs cleared successfully');
       setLogs([]);
+      setOlderLogs([]);
     },
     onError: (error) => {
       console.error('Error clearing logs:', error);
@@ -149,6 +152,8 @@ export function SystemView() {
     console.log(`SystemView: Setting log level from ${logLevel} to ${newLevel}`);
     setLogLevel(newLevel);
     logLevelRef.current = newLevel;
+    setOlderLogs([]);
+    setHasOlderLogs(true);
   };
 
   const handleLogsReceived = (newLogs) => {
@@ -158,6 +163,32 @@ export function SystemView() {
     setLogs(filteredLogs);
   };
 
+  // Page back from the oldest log shown, into rotated log files if needed
+  const loadOlderLogs = async () => {
+    const shown = olderLogs.length > 0 ? olderLogs : logs;
+    if (shown.length === 0) {
+      return;
+    }
+    const before = shown[shown.length - 1].timestamp;
+
+    try {
+      const response = await fetchJSON(
+        `/api/system/logs?level=${logLevel}&limit=${logCount}&before=${encodeURIComponent(before)}`,
+        { timeout: 10000, retries: 1 }
+      );
+      const page = (response && Array.isArray(response.logs)) ? response.logs : [];
+      setOlderLogs([...olderLogs, ...page.map(log => ({
+        timestamp: log.timestamp || 'Unknown',
+        level: (log.level || 'info').toLowerCase(),
+        message: log.message || ''
+      }))]);
+      setHasOlderLogs(Boolean(response && response.has_more));
+    } catch (error) {
+      console.error('Error loading older logs:', error);
+      showStatusMessage(`Error loading older logs: ${error.message}`);
+    }
+  };
+
   // Update hasData based on systemInfoData
   useEffect(() => {
     if (systemInfoData) {
@@ -292,7 +323,7 @@ export function SystemView() {
         </div>
 
         <LogsView
-          logs={logs}
+          logs={olderLogs.length > 0 ? [...logs, ...olderLogs] : logs}
           logLevel={logLevel}
           logCount={logCount}
           pollingInterval={pollingInterval}
@@ -306,6 +337,8 @@ export function SystemView() {
             window.dispatchEvent(event);
           }}
           clearLogs={clearLogs}
+          loadOlderLogs={loadOlderLogs}
+          hasOlderLogs={hasOlderLogs}
         />
 
         <LogsPoller
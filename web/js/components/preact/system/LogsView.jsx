@@ -70,9 +70,11 @@ function formatLogLevel(level) {
  * @param {Function} props.setPollingInterval Function to set polling interval
  * @param {Function} props.loadLogs Function to load logs
  * @param {Function} props.clearLogs Function to clear logs
+ * @param {Function} props.loadOlderLogs Function to load the page of logs before the oldest shown
+ * @param {boolean} props.hasOlderLogs Whether older logs may be available
  * @returns {JSX.Element} LogsView component
  */
-export function LogsView({ logs, logLevel, logCount, pollingInterval, setLogLevel, setLogCount, setPollingInterval, loadLogs, clearLogs }) {
+export function LogsView({ logs, logLevel, logCount, pollingInterval, setLogLevel, setLogCount, setPollingInterval, loadLogs, clearLogs, loadOlderLogs, hasOlderLogs }) {
   return (
     <div className="bg-card text-card-foreground rounded-lg shadow p-4 mb-4">
       <div className="flex justify-between items-center mb-4 pb-2 border-b border-border">
@@ -150,6 +152,14 @@ export function LogsView({ logs, logLevel, logCount, pollingInterval, setLogLeve
             </div>
           ))
         )}
+        {loadOlderLogs && hasOlderLogs && logs.length > 0 && (
+          <button
+            className="btn-secondary mt-2 focus:outline-none"
+            onClick={loadOlderLogs}
+          >
+            Load older
+          </button>
+        )}
       </div>
     </div>
   );